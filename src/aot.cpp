@@ -0,0 +1,261 @@
+/** @file */
+
+// MIT License
+
+// Copyright (c) 2023 malloc-nbytes
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "aot.hpp"
+#include "interpreter.hpp"
+#include "intrinsics.hpp"
+#include "common.hpp"
+#include "err.hpp"
+
+using namespace earl::value;
+
+int
+AOT::run(int argc, char **argv, void (*earl_main)(void)) {
+    for (int i = 0; i < argc; ++i)
+        earl_argv.push_back(std::string(argv[i]));
+    try {
+        earl_main();
+    } catch (const InterpreterException &e) {
+        std::cerr << "Interpreter error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+std::shared_ptr<Ctx> &
+AOT::ctx(void) {
+    static std::shared_ptr<Ctx> world = std::make_shared<WorldCtx>();
+    return world;
+}
+
+static void
+explicit_type_mismatch(const char *ty, const AOT::Obj &value) {
+    std::string msg = "explicit type of `"+std::string(ty)+"` does not match what was given `"+type_to_str(value->type())+"`";
+    throw InterpreterException(msg);
+}
+
+static void
+not_compatible(Type ty, const AOT::Obj &value) {
+    std::string msg = "value of type `"+type_to_str(ty)
+        +"` is not compatible with value of type `"+type_to_str(value->type())+"`";
+    throw InterpreterException(msg);
+}
+
+int
+AOT::unbox_int(const Obj &value) {
+    if (value->type() != Type::Int)
+        explicit_type_mismatch("int", value);
+    return static_cast<Int *>(value.get())->value();
+}
+
+double
+AOT::unbox_float(const Obj &value) {
+    if (value->type() != Type::Float)
+        explicit_type_mismatch("float", value);
+    return static_cast<Float *>(value.get())->value();
+}
+
+bool
+AOT::unbox_bool(const Obj &value) {
+    if (value->type() != Type::Bool)
+        explicit_type_mismatch("bool", value);
+    return static_cast<Bool *>(value.get())->value();
+}
+
+int
+AOT::mut_int(const Obj &value) {
+    switch (value->type()) {
+    case Type::Int: return static_cast<Int *>(value.get())->value();
+    case Type::Float: return static_cast<int>(static_cast<Float *>(value.get())->value());
+    default: not_compatible(Type::Int, value);
+    }
+    return 0; // unreachable
+}
+
+double
+AOT::mut_float(const Obj &value) {
+    switch (value->type()) {
+    case Type::Float: return static_cast<Float *>(value.get())->value();
+    case Type::Int: return static_cast<double>(static_cast<Int *>(value.get())->value());
+    default: not_compatible(Type::Float, value);
+    }
+    return 0; // unreachable
+}
+
+void
+AOT::typecheck(const Obj &value, uint64_t mask, const char *ty) {
+    if ((mask & (1ull << static_cast<int>(value->type()))) == 0)
+        explicit_type_mismatch(ty, value);
+}
+
+bool
+AOT::yields(const Obj &value) {
+    return value->type() != Type::Void && value->type() != Type::Return;
+}
+
+AOT::Obj
+AOT::list(Args values) {
+    return std::make_shared<List>(std::move(values));
+}
+
+AOT::Obj
+AOT::range(const Obj &start, const Obj &end, bool inclusive) {
+    if (start->type() != end->type()) {
+        std::string msg = "type mismatch for generating a range";
+        throw InterpreterException(msg);
+    }
+
+    int64_t s, e;
+    switch (start->type()) {
+    case Type::Int: {
+        s = static_cast<Int *>(start.get())->value();
+        e = static_cast<Int *>(end.get())->value();
+    } break;
+    case Type::Char: {
+        s = static_cast<Char *>(start.get())->value();
+        e = static_cast<Char *>(end.get())->value();
+    } break;
+    default: {
+        std::string msg = "invalid type "+type_to_str(start->type())+"` for type range";
+        throw InterpreterException(msg);
+    } break;
+    }
+
+    if (inclusive)
+        ++e;
+    size_t size = e > s ? static_cast<size_t>(e-s) : 0;
+    Range range = {static_cast<int>(s), size, start->type() == Type::Char};
+    return std::make_shared<List>(range);
+}
+
+std::string
+AOT::to_string(const Obj &value) {
+    return value->to_cxxstring();
+}
+
+AOT::Obj
+AOT::fstr(std::initializer_list<std::string> parts) {
+    size_t len = 0;
+    for (auto &part : parts)
+        len += part.size();
+    std::string result = "";
+    result.reserve(len);
+    for (auto &part : parts)
+        result += part;
+    return std::make_shared<Str>(std::move(result));
+}
+
+AOT::Obj
+AOT::binop(Token *op, const Obj &lhs, const Obj &rhs) {
+    return Interpreter::binop(op, lhs.get(), rhs.get());
+}
+
+AOT::Obj
+AOT::unaryop(Token *op, const Obj &value) {
+    return value->unaryop(op);
+}
+
+AOT::Obj
+AOT::index(const Obj &left, const Obj &idx, bool ref) {
+    Obj elem = nullptr;
+    switch (left->type()) {
+    case Type::List: {
+        Obj i = idx;
+        return static_cast<List *>(left.get())->nth(i, nullptr, ref);
+    }
+    case Type::Str: elem = static_cast<Str *>(left.get())->nth(idx.get(), nullptr); break;
+    case Type::Tuple: elem = static_cast<Tuple *>(left.get())->nth(idx.get(), nullptr); break;
+    case Type::DictInt: elem = static_cast<Dict<int> *>(left.get())->nth(idx.get(), nullptr); break;
+    case Type::DictStr: elem = static_cast<Dict<std::string> *>(left.get())->nth(idx.get(), nullptr); break;
+    case Type::DictChar: elem = static_cast<Dict<char> *>(left.get())->nth(idx.get(), nullptr); break;
+    case Type::DictFloat: elem = static_cast<Dict<double> *>(left.get())->nth(idx.get(), nullptr); break;
+    default: {
+        std::string msg = "cannot use `[]` on non-list, non-tuple, non-dict, or non-str type";
+        throw InterpreterException(msg);
+    }
+    }
+    return ref ? elem : elem->copy();
+}
+
+void
+AOT::mutate(const Obj &left, Token *equals, const Obj &right) {
+    if (equals->type() == TokenType::Equals)
+        left->mutate(right.get(), nullptr);
+    else
+        left->spec_mutate(equals, right.get(), nullptr);
+}
+
+AOT::Obj
+AOT::call(Intrinsics::IntrinsicFunction fn, Args args) {
+    Obj result = fn(args, ctx(), nullptr);
+    if (result->type() == Type::Return)
+        return unit();
+    return result;
+}
+
+AOT::Obj
+AOT::call_member(MemberSite &site, const Obj &accessor, Args args) {
+    int ty = static_cast<int>(accessor->type());
+    if (site.m_ty != ty) {
+        site.m_fn = Intrinsics::lookup_member(site.m_id, accessor->type());
+        site.m_ty = ty;
+    }
+    if (!site.m_fn) {
+        std::string msg = "method `"+std::string(site.m_id)+"` is not a part of the given type `"+type_to_str(accessor->type())+"`";
+        throw InterpreterException(msg);
+    }
+    return site.m_fn(accessor, args, ctx(), nullptr);
+}
+
+AOT::Args
+AOT::elements(const Obj &value, bool ref) {
+    Args elems = {};
+    switch (value->type()) {
+    case Type::List: {
+        auto &values = static_cast<List *>(value.get())->value();
+        elems.reserve(values.size());
+        for (auto &v : values)
+            elems.push_back(ref ? v : v->copy());
+    } break;
+    case Type::Str: {
+        for (auto &c : static_cast<Str *>(value.get())->value_as_earlchar())
+            elems.push_back(ref ? Obj(c) : c->copy());
+    } break;
+    default: {
+        std::string msg = "cannot iterate over a value of type `"+type_to_str(value->type())+"` in a compiled program";
+        throw InterpreterException(msg);
+    }
+    }
+    return elems;
+}
+
+void
+AOT::no_return(const char *fn) {
+    std::string msg = "function `"+std::string(fn)+"` did not return a value";
+    throw InterpreterException(msg);
+}
@@ -23,21 +23,36 @@
 // SOFTWARE.
 
 #include <vector>
+#include <memory>
 
 #include "arena.hpp"
 #include "utils.hpp"
 
-[[deprecated]]
-Arena::Arena(size_t bytes) : m_mem(bytes), m_len(0), m_cap(bytes) {}
-
-[[deprecated]]
-uint8_t *arena_alloc(Arena &arena, size_t bytes) {
-    if (arena.m_len + bytes > arena.m_cap) {
-        arena.m_cap *= 2;
-        arena.m_mem.resize(arena.m_cap); // Resize the vector
+Arena::Arena() : m_blocks(), m_cur(nullptr), m_left(0), m_len(0) {}
+
+void *
+Arena::alloc(size_t bytes, size_t align) {
+    size_t pad = (align - reinterpret_cast<uintptr_t>(m_cur) % align) % align;
+
+    if (pad + bytes > m_left) {
+        // Something big gets a block of its own so that
+        // the rest of the current block is not wasted.
+        size_t size = bytes + align > ARENA_BLOCK_SIZE / 4 ? bytes + align : ARENA_BLOCK_SIZE;
+        m_blocks.push_back(std::unique_ptr<uint8_t[]>(new uint8_t[size]));
+        uint8_t *block = m_blocks.back().get();
+        size_t block_pad = (align - reinterpret_cast<uintptr_t>(block) % align) % align;
+        if (size != ARENA_BLOCK_SIZE) {
+            m_len += bytes;
+            return block + block_pad;
+        }
+        m_cur = block;
+        m_left = size;
+        pad = block_pad;
     }
 
-    uint8_t *mem = &arena.m_mem[arena.m_len];
-    arena.m_len += bytes;
+    uint8_t *mem = m_cur + pad;
+    m_cur += pad + bytes;
+    m_left -= pad + bytes;
+    m_len += bytes;
     return mem;
 }
@@ -44,6 +44,11 @@ ClassCtx::ClassCtx(std::shared_ptr<Ctx> owner,
     m_funcs = std::move(funcs);
 }
 
+ClassCtx::ClassCtx(std::shared_ptr<Ctx> owner, ClassDesc *desc)
+    : m_owner(owner), m_desc(desc) {
+    m_members.assign(desc->m_ids.size(), nullptr);
+}
+
 CtxType
 ClassCtx::type(void) const {
     return CtxType::Class;
@@ -61,19 +66,28 @@ ClassCtx::pop_scope(void) {
 
 std::vector<std::shared_ptr<earl::variable::Obj>>
 ClassCtx::get_printable_members(void) {
-    std::vector<std::shared_ptr<earl::variable::Obj>> members = m_scope.extract_tovec();
+    std::vector<std::shared_ptr<earl::variable::Obj>> members = {};
+    for (auto &member : m_members)
+        if (member)
+            members.push_back(member);
+    for (auto &var : m_scope.extract_tovec())
+        members.push_back(var);
     return members;
 }
 
 void
 ClassCtx::variable_add(std::shared_ptr<earl::variable::Obj> var) {
     const std::string &id = var->id();
-    m_scope.add(id, var);
+    int slot = m_desc ? m_desc->slot(id) : -1;
+    if (slot != -1)
+        m_members[slot] = var;
+    else
+        m_scope.add(id, var);
 }
 
 bool
 ClassCtx::variable_exists(const std::string &id) {
-    bool res = m_scope.contains(id);
+    bool res = this->variable_exists_wo__m_class_constructor_tmp_args(id);
     // ONLY USED FOR THE CONSTRUCTOR IF IT NEEDS IT!
     if (!res)
         res = __m_class_constructor_tmp_args.find(id)
@@ -83,12 +97,20 @@ ClassCtx::variable_exists(const std::string &id) {
 
 bool
 ClassCtx::variable_exists_wo__m_class_constructor_tmp_args(const std::string &id) {
+    int slot = m_desc ? m_desc->slot(id) : -1;
+    if (slot != -1)
+        return m_members[slot] != nullptr;
     return m_scope.contains(id);
 }
 
 std::shared_ptr<earl::variable::Obj>
 ClassCtx::variable_get(const std::string &id) {
-    auto var = m_scope.get(id);
+    std::shared_ptr<earl::variable::Obj> var = nullptr;
+    int slot = m_desc ? m_desc->slot(id) : -1;
+    if (slot != -1)
+        var = m_members[slot];
+    else
+        var = m_scope.get(id);
 
     // ONLY USED FOR THE CONSTRUCTOR IF IT NEEDS IT!
     if (!var && __m_class_constructor_tmp_args.size() != 0) {
@@ -102,7 +124,11 @@ ClassCtx::variable_get(const std::string &id) {
 
 void ClassCtx::variable_remove(const std::string &id) {
     assert(this->variable_exists(id));
-    m_scope.remove(id);
+    int slot = m_desc ? m_desc->slot(id) : -1;
+    if (slot != -1)
+        m_members[slot] = nullptr;
+    else
+        m_scope.remove(id);
 }
 
 void
@@ -113,7 +139,9 @@ ClassCtx::function_add(std::shared_ptr<earl::function::Obj> func) {
 
 bool
 ClassCtx::function_exists(const std::string &id) {
-    bool res = m_funcs.contains(id);
+    bool res = m_desc && m_desc->m_methods.find(id) != m_desc->m_methods.end();
+    if (!res)
+        res = m_funcs.contains(id);
     if (!res && m_owner && m_owner->type() == CtxType::World)
         res = dynamic_cast<WorldCtx *>(m_owner.get())->function_exists(id);
     else if (!res && m_owner && m_owner->type() == CtxType::Function)
@@ -123,7 +151,14 @@ ClassCtx::function_exists(const std::string &id) {
 
 std::shared_ptr<earl::function::Obj>
 ClassCtx::function_get(const std::string &id) {
-    std::shared_ptr<earl::function::Obj> func = m_funcs.get(id);
+    std::shared_ptr<earl::function::Obj> func = nullptr;
+    if (m_desc) {
+        auto it = m_desc->m_methods.find(id);
+        if (it != m_desc->m_methods.end())
+            func = it->second;
+    }
+    if (!func)
+        func = m_funcs.get(id);
     if (!func && m_owner && m_owner->type() == CtxType::World)
         func = dynamic_cast<WorldCtx *>(m_owner.get())->function_get(id);
     else if (!func && m_owner && m_owner->type() == CtxType::Function)
@@ -195,7 +230,11 @@ ClassCtx::deep_copy(void) {
             funcs_copy.push();
     }
 
-    return std::make_shared<ClassCtx>(m_owner, std::move(scope_copy), std::move(funcs_copy));
+    auto copy = std::make_shared<ClassCtx>(m_owner, std::move(scope_copy), std::move(funcs_copy));
+    copy->m_desc = m_desc;
+    for (auto &member : m_members)
+        copy->m_members.push_back(member ? member->copy() : nullptr);
+    return copy;
 }
 
 std::shared_ptr<ClassCtx>
@@ -208,7 +247,10 @@ ClassCtx::shallow_copy(void) {
         if (i != m_scope.size())
             scope_copy.push();
     }
-    return std::make_shared<ClassCtx>(m_owner, std::move(scope_copy));
+    auto copy = std::make_shared<ClassCtx>(m_owner, std::move(scope_copy));
+    copy->m_desc = m_desc;
+    copy->m_members = m_members;
+    return copy;
 }
 
 WorldCtx *
@@ -222,6 +264,9 @@ std::vector<std::string>
 ClassCtx::get_available_function_names(void) {
     std::vector<std::shared_ptr<earl::function::Obj>> funcs = m_funcs.extract_tovec();
     std::vector<std::string> ids = {};
+    if (m_desc)
+        for (auto &method : m_desc->m_methods)
+            ids.push_back(method.first);
     for (auto &f : funcs)
         ids.push_back(f->id());
     if (m_owner) {
@@ -234,7 +279,7 @@ ClassCtx::get_available_function_names(void) {
 
 std::vector<std::string>
 ClassCtx::get_available_variable_names(void) {
-    std::vector<std::shared_ptr<earl::variable::Obj>> vars = m_scope.extract_tovec();
+    std::vector<std::shared_ptr<earl::variable::Obj>> vars = this->get_printable_members();
     std::vector<std::string> ids = {};
     for (auto &v : vars)
         ids.push_back(v->id());
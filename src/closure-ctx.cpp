@@ -29,8 +29,33 @@
 #include "utils.hpp"
 #include "err.hpp"
 
+static std::vector<std::shared_ptr<ClosureCtx>> pool = {};
+
 ClosureCtx::ClosureCtx(std::shared_ptr<Ctx> owner) : m_owner(owner) {}
 
+std::shared_ptr<ClosureCtx>
+ClosureCtx::acquire(std::shared_ptr<Ctx> owner) {
+    if (pool.size() == 0)
+        return std::make_shared<ClosureCtx>(std::move(owner));
+    auto ctx = std::move(pool.back());
+    pool.pop_back();
+    ctx->m_owner = std::move(owner);
+    return ctx;
+}
+
+void
+ClosureCtx::release(std::shared_ptr<ClosureCtx> &ctx) {
+    if (ctx.use_count() != 1 || pool.size() >= CTX_POOL_CAP) {
+        ctx = nullptr;
+        return;
+    }
+    ctx->m_scope.reset();
+    ctx->m_funcs.reset();
+    ctx->m_frame.clear();
+    ctx->m_owner = nullptr;
+    pool.push_back(std::move(ctx));
+}
+
 CtxType
 ClosureCtx::type(void) const {
     return CtxType::Closure;
@@ -0,0 +1,1131 @@
+/** @file */
+
+// MIT License
+
+// Copyright (c) 2023 malloc-nbytes
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cassert>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "err.hpp"
+#include "ast.hpp"
+#include "earl.hpp"
+#include "common.hpp"
+#include "intrinsics.hpp"
+#include "earl-to-cpp.hpp"
+
+#define CPPSTMT(s, ctx)                         \
+    do {                                        \
+        tabs(ctx);                              \
+        ctx.cpp_src += s "\n";                  \
+    } while (0)
+
+#define CPPSTMT_CONS(s, ctx)                    \
+    do {                                        \
+        tabs(ctx);                              \
+        ctx.cpp_src += s+"\n";                  \
+    } while (0)
+
+#define CPPTAB "    "
+
+// The type of a generated C++ expression. Only values whose type is
+// fixed by an annotation (or the enumerator of a `for`) are native,
+// everything else is an `AOT::Obj`.
+enum class CTy {
+    Int,
+    Float,
+    Bool,
+    Obj,
+};
+
+struct CExpr {
+    std::string code;
+    CTy ty;
+    // Whether evaluating it cannot have side effects (no calls)
+    bool pure;
+};
+
+struct Var {
+    std::string cname;
+    CTy ty;
+    bool _const;
+};
+
+struct Fn {
+    StmtDef *def;
+    std::vector<CTy> params;
+    CTy ret;
+};
+
+struct Context {
+    unsigned scope_depth;
+    std::string cpp_src;
+    std::string statics;
+    std::vector<std::unordered_map<std::string, Var>> scopes;
+    std::unordered_map<std::string, Fn> fns;
+    std::unordered_map<Token *, std::string> tokens;
+    // The function being compiled, nullptr for the top level
+    Fn *fn;
+    unsigned tmps;
+    // The label after the current top-level statement (see
+    // stmt_expr_to_cpp), -1 when not inside one
+    int stmt_end;
+    bool stmt_end_used;
+};
+
+static CExpr expr_to_cpp(Expr *expr, Context &ctx, bool ref);
+static void stmt_to_cpp(Stmt *stmt, Context &ctx);
+static void stmt_block_to_cpp(StmtBlock *stmt, Context &ctx, const std::vector<std::string> &prologue = {});
+
+// Names of intrinsics that only read their arguments, so they
+// do not need copies of them.
+static const std::unordered_map<std::string, bool>
+read_only_intrinsics = {
+    {"print", true},
+    {"println", true},
+    {"fprint", true},
+    {"fprintln", true},
+    {"len", true},
+    {"str", true},
+    {"int", true},
+    {"float", true},
+    {"bool", true},
+    {"type", true},
+    {"assert", true},
+    {"panic", true},
+    {"warn", true},
+};
+
+static void
+tabs(Context &ctx) {
+    for (unsigned i = 0; i < ctx.scope_depth; ++i)
+        ctx.cpp_src += CPPTAB;
+}
+
+static Token *
+expr_tok(Expr *expr) {
+    switch (expr->get_type()) {
+    case ExprType::Binary: return dynamic_cast<ExprBinary *>(expr)->m_op.get();
+    case ExprType::Unary: return dynamic_cast<ExprUnary *>(expr)->m_op.get();
+    default: break;
+    }
+    switch (dynamic_cast<ExprTerm *>(expr)->get_term_type()) {
+    case ExprTermType::Ident:         return dynamic_cast<ExprIdent *>(expr)->m_tok.get();
+    case ExprTermType::Int_Literal:   return dynamic_cast<ExprIntLit *>(expr)->m_tok.get();
+    case ExprTermType::Str_Literal:   return dynamic_cast<ExprStrLit *>(expr)->m_tok.get();
+    case ExprTermType::Char_Literal:  return dynamic_cast<ExprCharLit *>(expr)->m_tok.get();
+    case ExprTermType::Float_Literal: return dynamic_cast<ExprFloatLit *>(expr)->m_tok.get();
+    case ExprTermType::Func_Call:     return dynamic_cast<ExprFuncCall *>(expr)->m_tok.get();
+    case ExprTermType::List_Literal:  return dynamic_cast<ExprListLit *>(expr)->m_tok.get();
+    case ExprTermType::Range:         return dynamic_cast<ExprRange *>(expr)->m_tok.get();
+    case ExprTermType::Slice:         return dynamic_cast<ExprSlice *>(expr)->m_tok.get();
+    case ExprTermType::Get:           return dynamic_cast<ExprGet *>(expr)->m_tok.get();
+    case ExprTermType::Mod_Access:    return dynamic_cast<ExprModAccess *>(expr)->m_tok.get();
+    case ExprTermType::Array_Access:  return dynamic_cast<ExprArrayAccess *>(expr)->m_tok.get();
+    case ExprTermType::Bool:          return dynamic_cast<ExprBool *>(expr)->m_tok.get();
+    case ExprTermType::None:          return dynamic_cast<ExprNone *>(expr)->m_tok.get();
+    case ExprTermType::Closure:       return dynamic_cast<ExprClosure *>(expr)->m_tok.get();
+    case ExprTermType::Tuple:         return dynamic_cast<ExprTuple *>(expr)->m_tok.get();
+    case ExprTermType::Dict:          return dynamic_cast<ExprDict *>(expr)->m_tok.get();
+    case ExprTermType::FStr:          return dynamic_cast<ExprFStr *>(expr)->m_tok.get();
+    default: return nullptr;
+    }
+}
+
+[[noreturn]] static void
+unsupported(Token *tok, const std::string &what) {
+    Err::err_wtok(tok);
+    std::string msg = what+" cannot be compiled to C++";
+    throw InterpreterException(msg);
+}
+
+[[noreturn]] static void
+error(Token *tok, const std::string &msg) {
+    Err::err_wtok(tok);
+    throw InterpreterException(msg);
+}
+
+static std::string
+tmp(Context &ctx) {
+    return "tmp"+std::to_string(ctx.tmps++);
+}
+
+static std::string
+cpp_string(const std::string &s) {
+    std::string lit = "";
+    for (unsigned char ch : s) {
+        if (ch == '"' || ch == '\\') {
+            lit += '\\';
+            lit += ch;
+        }
+        else if (ch >= 0x20 && ch < 0x7f && ch != '?')
+            lit += ch;
+        else {
+            char oct[5];
+            std::snprintf(oct, sizeof(oct), "\\%03o", ch);
+            lit += oct;
+        }
+    }
+    return "std::string(\""+lit+"\", "+std::to_string(s.size())+")";
+}
+
+static const char *
+ctype(CTy ty) {
+    switch (ty) {
+    case CTy::Int:   return "int";
+    case CTy::Float: return "double";
+    case CTy::Bool:  return "bool";
+    default:         return "AOT::Obj";
+    }
+}
+
+static const char *
+earl_type(CTy ty) {
+    switch (ty) {
+    case CTy::Int:   return "int";
+    case CTy::Float: return "float";
+    case CTy::Bool:  return "bool";
+    default:         return "any";
+    }
+}
+
+static CTy
+annotated(__Type *ty) {
+    if (!ty || ty->m_sub_ty.has_value())
+        return CTy::Obj;
+    const std::string &id = ty->m_main_ty->lexeme();
+    if (id == "int")
+        return CTy::Int;
+    if (id == "float")
+        return CTy::Float;
+    if (id == "bool")
+        return CTy::Bool;
+    return CTy::Obj;
+}
+
+// Operators that the runtime applies (see Interpreter::binop) need a
+// token, which also gives runtime errors the location in the script.
+static std::string
+op_token(Token *tok, Context &ctx) {
+    auto it = ctx.tokens.find(tok);
+    if (it != ctx.tokens.end())
+        return it->second;
+    std::string id = "tok"+std::to_string(ctx.tokens.size());
+    ctx.statics += "static Token "+id+"("+cpp_string(tok->lexeme())+", static_cast<TokenType>("
+        +std::to_string(static_cast<int>(tok->type()))+"), "+std::to_string(tok->m_row)+", "
+        +std::to_string(tok->m_col)+", "+cpp_string(tok->fp())+");\n";
+    ctx.tokens[tok] = "&"+id;
+    return "&"+id;
+}
+
+static Var *
+var_lookup(const std::string &id, Context &ctx) {
+    for (auto it = ctx.scopes.rbegin(); it != ctx.scopes.rend(); ++it) {
+        auto var = it->find(id);
+        if (var != it->end())
+            return &var->second;
+    }
+    return nullptr;
+}
+
+static std::string
+var_add(Token *tok, CTy ty, bool _const, Context &ctx) {
+    const std::string &id = tok->lexeme();
+    if (var_lookup(id, ctx))
+        error(tok, "variable `"+id+"` is already declared");
+    std::string cname = "e_"+id;
+    ctx.scopes.back()[id] = Var{cname, ty, _const};
+    return cname;
+}
+
+static std::string
+boxed(const CExpr &e) {
+    switch (e.ty) {
+    case CTy::Int:   return "AOT::box_int("+e.code+")";
+    case CTy::Float: return "AOT::box_float("+e.code+")";
+    case CTy::Bool:  return "AOT::box_bool("+e.code+")";
+    default:         return e.code;
+    }
+}
+
+static std::string
+cond(const CExpr &e) {
+    if (e.ty == CTy::Bool)
+        return e.code;
+    return "AOT::truthy("+boxed(e)+")";
+}
+
+// Bind `e` to something annotated with `ty`, checking the type
+// like Interpreter::typecheck does.
+static std::string
+typed(const CExpr &e, CTy ty, Token *tok) {
+    if (e.ty == ty)
+        return e.code;
+    switch (ty) {
+    case CTy::Obj: return boxed(e);
+    case CTy::Int: if (e.ty == CTy::Obj) return "AOT::unbox_int("+e.code+")"; break;
+    case CTy::Float: if (e.ty == CTy::Obj) return "AOT::unbox_float("+e.code+")"; break;
+    case CTy::Bool: if (e.ty == CTy::Obj) return "AOT::unbox_bool("+e.code+")"; break;
+    }
+    error(tok, "explicit type of `"+std::string(earl_type(ty))+"` does not match what was given `"+earl_type(e.ty)+"`");
+}
+
+// Assign `e` to a native local of type `ty`, which converts
+// between int and float like Int::mutate and Float::mutate do.
+static std::string
+mutated(const CExpr &e, CTy ty, Token *tok) {
+    if (e.ty == ty)
+        return e.code;
+    if (ty == CTy::Int && e.ty == CTy::Float)
+        return "static_cast<int>("+e.code+")";
+    if (ty == CTy::Float && e.ty == CTy::Int)
+        return "static_cast<double>("+e.code+")";
+    if (e.ty == CTy::Obj) {
+        switch (ty) {
+        case CTy::Int:   return "AOT::mut_int("+e.code+")";
+        case CTy::Float: return "AOT::mut_float("+e.code+")";
+        case CTy::Bool:  return "AOT::unbox_bool("+e.code+")";
+        default: break;
+        }
+    }
+    error(tok, "value of type `"+std::string(earl_type(ty))+"` is not compatible with value of type `"+earl_type(e.ty)+"`");
+}
+
+// C++ does not order the evaluation of function arguments and most
+// operands, EARL evaluates them left to right. When more than one of
+// them has side effects they are evaluated in order into temporaries.
+static std::string
+sequence(const std::vector<std::string> &codes,
+         const std::vector<bool> &pure,
+         const std::function<std::string(const std::vector<std::string> &)> &build,
+         Context &ctx) {
+    size_t impure = 0;
+    for (bool p : pure)
+        impure += p ? 0 : 1;
+    if (impure < 2)
+        return build(codes);
+
+    std::string lambda = "[&]() { ";
+    std::vector<std::string> names = {};
+    for (auto &code : codes) {
+        names.push_back(tmp(ctx));
+        lambda += "auto &&"+names.back()+" = "+code+"; ";
+    }
+    return lambda+"return "+build(names)+"; }()";
+}
+
+static CExpr
+expr_term_ident_to_cpp(ExprIdent *expr, Context &ctx, bool ref) {
+    const std::string &id = expr->m_tok->lexeme();
+    Var *var = var_lookup(id, ctx);
+    if (!var) {
+        if (ctx.fns.find(id) != ctx.fns.end())
+            unsupported(expr->m_tok.get(), "using function `"+id+"` as a value");
+        unsupported(expr->m_tok.get(), "`"+id+"`, which is not a local variable (globals, enums and builtin identifiers),");
+    }
+    if (var->ty != CTy::Obj || ref)
+        return CExpr{var->cname, var->ty, true};
+    return CExpr{var->cname+"->copy()", CTy::Obj, true};
+}
+
+static CExpr
+expr_term_intlit_to_cpp(ExprIntLit *expr, Context &ctx) {
+    (void)ctx;
+    int value = dynamic_cast<earl::value::Int *>(expr->m_value.get())->value();
+    return CExpr{std::to_string(value), CTy::Int, true};
+}
+
+static CExpr
+expr_term_floatlit_to_cpp(ExprFloatLit *expr, Context &ctx) {
+    (void)ctx;
+    double value = dynamic_cast<earl::value::Float *>(expr->m_value.get())->value();
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%.17g", value);
+    std::string lit = buf;
+    if (lit.find_first_of(".eEn") == std::string::npos)
+        lit += ".0";
+    return CExpr{lit, CTy::Float, true};
+}
+
+static CExpr
+expr_term_strlit_to_cpp(ExprStrLit *expr, Context &ctx) {
+    (void)ctx;
+    std::string value = dynamic_cast<earl::value::Str *>(expr->m_value.get())->value();
+    return CExpr{"AOT::str("+cpp_string(value)+")", CTy::Obj, true};
+}
+
+static CExpr
+expr_term_charlit_to_cpp(ExprCharLit *expr, Context &ctx) {
+    (void)ctx;
+    char value = dynamic_cast<earl::value::Char *>(expr->m_value.get())->value();
+    return CExpr{"AOT::chr(static_cast<char>("+std::to_string(static_cast<int>(value))+"))", CTy::Obj, true};
+}
+
+static CExpr
+expr_term_boollit_to_cpp(ExprBool *expr, Context &ctx) {
+    (void)ctx;
+    return CExpr{expr->m_value ? "true" : "false", CTy::Bool, true};
+}
+
+static CExpr
+expr_term_none_to_cpp(ExprNone *expr, Context &ctx) {
+    (void)expr;
+    (void)ctx;
+    return CExpr{"AOT::none()", CTy::Obj, true};
+}
+
+// The arguments of an intrinsic as an `AOT::Args` initializer,
+// which C++ evaluates in order.
+static CExpr
+args_to_cpp(std::vector<std::unique_ptr<Expr>> &params, Context &ctx, bool ref) {
+    std::string args = "{";
+    bool pure = true;
+    for (size_t i = 0; i < params.size(); ++i) {
+        CExpr arg = expr_to_cpp(params[i].get(), ctx, ref);
+        args += boxed(arg);
+        pure = pure && arg.pure;
+        if (i != params.size()-1)
+            args += ", ";
+    }
+    return CExpr{args+"}", CTy::Obj, pure};
+}
+
+static CExpr
+expr_term_funccall_to_cpp(ExprFuncCall *expr, Context &ctx) {
+    if (expr->m_left->get_type() != ExprType::Term
+        || dynamic_cast<ExprTerm *>(expr->m_left.get())->get_term_type() != ExprTermType::Ident)
+        unsupported(expr->m_tok.get(), "calling something other than a function by name");
+
+    Token *tok = dynamic_cast<ExprIdent *>(expr->m_left.get())->m_tok.get();
+    const std::string &id = tok->lexeme();
+
+    if (const Intrinsics::Intrinsic *intrinsic = Intrinsics::lookup(id)) {
+        try {
+            Intrinsics::check_arity(id, *intrinsic, expr->m_params.size(), nullptr);
+        } catch (const InterpreterException &e) {
+            error(tok, e.what());
+        }
+        bool ref = read_only_intrinsics.find(id) != read_only_intrinsics.end();
+        CExpr args = args_to_cpp(expr->m_params, ctx, ref);
+        return CExpr{"AOT::call(&Intrinsics::intrinsic_"+id+", "+args.code+")", CTy::Obj, false};
+    }
+
+    auto it = ctx.fns.find(id);
+    if (it == ctx.fns.end()) {
+        if (var_lookup(id, ctx))
+            unsupported(tok, "calling the closure `"+id+"`");
+        unsupported(tok, "calling `"+id+"`, which is not a function of this file,");
+    }
+
+    Fn &fn = it->second;
+    auto &params = fn.def->m_args;
+    if (params.size() != expr->m_params.size())
+        error(tok, "function `"+id+"` expects "+std::to_string(params.size())+" arguments but "
+              +std::to_string(expr->m_params.size())+" were supplied");
+
+    std::vector<std::string> codes = {};
+    std::vector<bool> pure = {};
+    for (size_t i = 0; i < params.size(); ++i) {
+        Expr *param = expr->m_params[i].get();
+        bool ref = (params[i].second & static_cast<uint32_t>(Attr::Ref)) != 0;
+        // Arguments are copied by the callee, not here.
+        CExpr arg = expr_to_cpp(param, ctx, true);
+        if (ref && fn.params[i] != CTy::Obj) {
+            Var *var = param->get_type() == ExprType::Term
+                && dynamic_cast<ExprTerm *>(param)->get_term_type() == ExprTermType::Ident
+                ? var_lookup(dynamic_cast<ExprIdent *>(param)->m_tok->lexeme(), ctx) : nullptr;
+            if (!var || var->ty != fn.params[i])
+                unsupported(expr_tok(param), "passing anything but a local of the same native type to a native @ref parameter");
+        }
+        else if (ref && arg.ty != CTy::Obj)
+            unsupported(expr_tok(param), "passing a native local to a @ref parameter");
+        codes.push_back(typed(arg, fn.params[i], expr_tok(param)));
+        pure.push_back(arg.pure);
+    }
+
+    std::string call = sequence(codes, pure, [&](const std::vector<std::string> &args) {
+        std::string call = "earl_"+id+"(";
+        for (size_t i = 0; i < args.size(); ++i) {
+            call += args[i];
+            if (i != args.size()-1)
+                call += ", ";
+        }
+        return call+")";
+    }, ctx);
+    return CExpr{call, fn.ret, false};
+}
+
+static CExpr
+expr_term_listlit_to_cpp(ExprListLit *expr, Context &ctx) {
+    CExpr elems = args_to_cpp(expr->m_elems, ctx, false);
+    return CExpr{"AOT::list("+elems.code+")", CTy::Obj, elems.pure};
+}
+
+static CExpr
+expr_term_range_to_cpp(ExprRange *expr, Context &ctx) {
+    CExpr start = expr_to_cpp(expr->m_start.get(), ctx, true);
+    CExpr end = expr_to_cpp(expr->m_end.get(), ctx, true);
+    std::string incl = expr->m_inclusive ? "true" : "false";
+    std::string code = sequence({boxed(start), boxed(end)}, {start.pure, end.pure},
+                                [&](const std::vector<std::string> &v) {
+                                    return "AOT::range("+v[0]+", "+v[1]+", "+incl+")";
+                                }, ctx);
+    return CExpr{code, CTy::Obj, start.pure && end.pure};
+}
+
+static CExpr
+expr_term_get_to_cpp(ExprGet *expr, Context &ctx) {
+    if (!std::holds_alternative<std::unique_ptr<ExprFuncCall>>(expr->m_right))
+        unsupported(expr->m_tok.get(), "member access");
+
+    ExprFuncCall *call = std::get<std::unique_ptr<ExprFuncCall>>(expr->m_right).get();
+    Token *tok = dynamic_cast<ExprIdent *>(call->m_left.get())->m_tok.get();
+    const std::string &id = tok->lexeme();
+    if (!Intrinsics::is_member_intrinsic(id))
+        unsupported(tok, "calling the method `"+id+"`");
+
+    std::string site = "site"+std::to_string(ctx.tmps++);
+    ctx.statics += "static AOT::MemberSite "+site+"(\""+id+"\");\n";
+
+    CExpr accessor = expr_to_cpp(expr->m_left.get(), ctx, true);
+    CExpr args = args_to_cpp(call->m_params, ctx, false);
+    std::string code = sequence({boxed(accessor), args.code}, {accessor.pure, args.pure},
+                                [&](const std::vector<std::string> &v) {
+                                    return "AOT::call_member("+site+", "+v[0]+", "+(v[1] == args.code ? v[1] : "AOT::Args("+v[1]+")")+")";
+                                }, ctx);
+    return CExpr{code, CTy::Obj, false};
+}
+
+static CExpr
+expr_term_array_access_to_cpp(ExprArrayAccess *expr, Context &ctx, bool ref) {
+    CExpr left = expr_to_cpp(expr->m_left.get(), ctx, true);
+    CExpr idx = expr_to_cpp(expr->m_expr.get(), ctx, true);
+    std::string r = ref ? "true" : "false";
+    std::string code = sequence({boxed(left), boxed(idx)}, {left.pure, idx.pure},
+                                [&](const std::vector<std::string> &v) {
+                                    return "AOT::index("+v[0]+", "+v[1]+", "+r+")";
+                                }, ctx);
+    return CExpr{code, CTy::Obj, left.pure && idx.pure};
+}
+
+static CExpr
+expr_term_fstr_to_cpp(ExprFStr *expr, Context &ctx) {
+    std::string parts = "";
+    bool pure = true;
+    for (size_t i = 0; i < expr->m_parts.size(); ++i) {
+        auto &part = expr->m_parts[i];
+        if (std::holds_alternative<std::string>(part))
+            parts += cpp_string(std::get<std::string>(part));
+        else {
+            CExpr e = expr_to_cpp(std::get<std::unique_ptr<Expr>>(part).get(), ctx, true);
+            parts += "AOT::to_string("+boxed(e)+")";
+            pure = pure && e.pure;
+        }
+        if (i != expr->m_parts.size()-1)
+            parts += ", ";
+    }
+    return CExpr{"AOT::fstr({"+parts+"})", CTy::Obj, pure};
+}
+
+static CExpr
+expr_term_to_cpp(ExprTerm *expr, Context &ctx, bool ref) {
+    switch (expr->get_term_type()) {
+    case ExprTermType::Ident:         return expr_term_ident_to_cpp(dynamic_cast<ExprIdent *>(expr), ctx, ref);
+    case ExprTermType::Int_Literal:   return expr_term_intlit_to_cpp(dynamic_cast<ExprIntLit *>(expr), ctx);
+    case ExprTermType::Str_Literal:   return expr_term_strlit_to_cpp(dynamic_cast<ExprStrLit *>(expr), ctx);
+    case ExprTermType::Char_Literal:  return expr_term_charlit_to_cpp(dynamic_cast<ExprCharLit *>(expr), ctx);
+    case ExprTermType::Float_Literal: return expr_term_floatlit_to_cpp(dynamic_cast<ExprFloatLit *>(expr), ctx);
+    case ExprTermType::Func_Call:     return expr_term_funccall_to_cpp(dynamic_cast<ExprFuncCall *>(expr), ctx);
+    case ExprTermType::List_Literal:  return expr_term_listlit_to_cpp(dynamic_cast<ExprListLit *>(expr), ctx);
+    case ExprTermType::Range:         return expr_term_range_to_cpp(dynamic_cast<ExprRange *>(expr), ctx);
+    case ExprTermType::Get:           return expr_term_get_to_cpp(dynamic_cast<ExprGet *>(expr), ctx);
+    case ExprTermType::Array_Access:  return expr_term_array_access_to_cpp(dynamic_cast<ExprArrayAccess *>(expr), ctx, ref);
+    case ExprTermType::Bool:          return expr_term_boollit_to_cpp(dynamic_cast<ExprBool *>(expr), ctx);
+    case ExprTermType::None:          return expr_term_none_to_cpp(dynamic_cast<ExprNone *>(expr), ctx);
+    case ExprTermType::FStr:          return expr_term_fstr_to_cpp(dynamic_cast<ExprFStr *>(expr), ctx);
+    case ExprTermType::Mod_Access:    unsupported(expr_tok(expr), "module access");
+    case ExprTermType::Closure:       unsupported(expr_tok(expr), "a closure");
+    case ExprTermType::Tuple:         unsupported(expr_tok(expr), "a tuple literal");
+    case ExprTermType::Slice:         unsupported(expr_tok(expr), "a slice");
+    case ExprTermType::Dict:          unsupported(expr_tok(expr), "a dictionary literal");
+    default: {
+        std::string msg = "unknown term: `"+std::to_string((int)expr->get_term_type())+"`";
+        throw InterpreterException(msg);
+    }
+    }
+}
+
+static bool
+is_numeric(CTy ty) {
+    return ty == CTy::Int || ty == CTy::Float;
+}
+
+static CExpr
+expr_bin_to_cpp(ExprBinary *expr, Context &ctx) {
+    CExpr lhs = expr_to_cpp(expr->m_lhs.get(), ctx, true);
+    CExpr rhs = expr_to_cpp(expr->m_rhs.get(), ctx, true);
+    const TokenType op = expr->m_op->type();
+    const bool pure = lhs.pure && rhs.pure;
+
+    // `&&` and `||` give back one of their operands.
+    if (op == TokenType::Double_Ampersand || op == TokenType::Double_Pipe) {
+        const std::string cop = op == TokenType::Double_Ampersand ? " && " : " || ";
+        if (lhs.ty == CTy::Bool && rhs.ty == CTy::Bool)
+            return CExpr{"("+lhs.code+cop+rhs.code+")", CTy::Bool, pure};
+        std::string l = tmp(ctx);
+        std::string pick = op == TokenType::Double_Ampersand
+            ? "AOT::truthy("+l+") ? "+boxed(rhs)+" : "+l
+            : "AOT::truthy("+l+") ? "+l+" : "+boxed(rhs);
+        return CExpr{"[&]() { AOT::Obj "+l+" = "+boxed(lhs)+"; return "+pick+"; }()", CTy::Obj, pure};
+    }
+
+    std::string cop = "";
+    CTy ty = CTy::Obj;
+    switch (op) {
+    case TokenType::Plus:         cop = "+"; break;
+    case TokenType::Minus:        cop = "-"; break;
+    case TokenType::Asterisk:     cop = "*"; break;
+    case TokenType::Forwardslash: cop = "/"; break;
+    case TokenType::Percent:      cop = "%"; break;
+    case TokenType::Greaterthan:        cop = ">"; break;
+    case TokenType::Lessthan:           cop = "<"; break;
+    case TokenType::Greaterthan_Equals: cop = ">="; break;
+    case TokenType::Lessthan_Equals:    cop = "<="; break;
+    case TokenType::Double_Equals:      cop = "=="; break;
+    case TokenType::Bang_Equals:        cop = "!="; break;
+    case TokenType::Backtick_Pipe:      cop = "|"; break;
+    case TokenType::Backtick_Ampersand: cop = "&"; break;
+    case TokenType::Backtick_Caret:     cop = "^"; break;
+    case TokenType::Double_Lessthan:    cop = "<<"; break;
+    case TokenType::Double_Greaterthan: cop = ">>"; break;
+    default: break;
+    }
+
+    const bool cmp = op == TokenType::Greaterthan || op == TokenType::Lessthan
+        || op == TokenType::Greaterthan_Equals || op == TokenType::Lessthan_Equals
+        || op == TokenType::Double_Equals || op == TokenType::Bang_Equals;
+    const bool ints = lhs.ty == CTy::Int && rhs.ty == CTy::Int;
+
+    if (cop != "" && is_numeric(lhs.ty) && is_numeric(rhs.ty)) {
+        if (cmp)
+            ty = CTy::Bool;
+        else if (op == TokenType::Plus || op == TokenType::Minus
+                 || op == TokenType::Asterisk || op == TokenType::Forwardslash)
+            ty = ints ? CTy::Int : CTy::Float;
+        else if (ints)
+            ty = CTy::Int;
+    }
+    else if ((op == TokenType::Double_Equals || op == TokenType::Bang_Equals)
+             && lhs.ty == CTy::Bool && rhs.ty == CTy::Bool)
+        ty = CTy::Bool;
+
+    if (ty != CTy::Obj) {
+        std::string code = sequence({lhs.code, rhs.code}, {lhs.pure, rhs.pure},
+                                    [&](const std::vector<std::string> &v) {
+                                        return "("+v[0]+" "+cop+" "+v[1]+")";
+                                    }, ctx);
+        return CExpr{code, ty, pure};
+    }
+
+    std::string tok = op_token(expr->m_op.get(), ctx);
+    std::string code = sequence({boxed(lhs), boxed(rhs)}, {lhs.pure, rhs.pure},
+                                [&](const std::vector<std::string> &v) {
+                                    return "AOT::binop("+tok+", "+v[0]+", "+v[1]+")";
+                                }, ctx);
+    return CExpr{code, CTy::Obj, pure};
+}
+
+static CExpr
+expr_unary_to_cpp(ExprUnary *expr, Context &ctx) {
+    CExpr e = expr_to_cpp(expr->m_expr.get(), ctx, true);
+    const TokenType op = expr->m_op->type();
+    if (op == TokenType::Minus && is_numeric(e.ty))
+        return CExpr{"(-"+e.code+")", e.ty, e.pure};
+    if (op == TokenType::Bang && e.ty == CTy::Bool)
+        return CExpr{"(!"+e.code+")", CTy::Bool, e.pure};
+    if (op == TokenType::Backtick_Tilde && e.ty == CTy::Int)
+        return CExpr{"(~"+e.code+")", CTy::Int, e.pure};
+    return CExpr{"AOT::unaryop("+op_token(expr->m_op.get(), ctx)+", "+boxed(e)+")", CTy::Obj, e.pure};
+}
+
+static CExpr
+expr_to_cpp(Expr *expr, Context &ctx, bool ref) {
+    switch (expr->get_type()) {
+    case ExprType::Term:   return expr_term_to_cpp(dynamic_cast<ExprTerm *>(expr), ctx, ref);
+    case ExprType::Binary: return expr_bin_to_cpp(dynamic_cast<ExprBinary *>(expr), ctx);
+    case ExprType::Unary:  return expr_unary_to_cpp(dynamic_cast<ExprUnary *>(expr), ctx);
+    default: assert(false && "unreachable");
+    }
+    return CExpr{};
+}
+
+static void
+stmt_let_to_cpp(StmtLet *stmt, Context &ctx) {
+    if (stmt->m_ids.size() != 1)
+        unsupported(stmt->m_ids.at(0).get(), "destructuring `let`");
+
+    Token *id = stmt->m_ids.at(0).get();
+    const bool ref = (stmt->m_attrs & static_cast<uint32_t>(Attr::Ref)) != 0;
+    const bool _const = (stmt->m_attrs & static_cast<uint32_t>(Attr::Const)) != 0;
+    __Type *ty = stmt->m_tys.size() > 0 ? stmt->m_tys[0].get() : nullptr;
+    CExpr value = expr_to_cpp(stmt->m_expr.get(), ctx, ref);
+
+    if (id->lexeme() == "_") {
+        CPPSTMT_CONS("(void)"+value.code+";", ctx);
+        return;
+    }
+
+    if (ty && ty->m_mask == 0)
+        unsupported(ty->m_main_ty.get(), "a class type annotation");
+
+    CTy cty = ref ? CTy::Obj : annotated(ty);
+    if (ref && value.ty != CTy::Obj)
+        unsupported(id, "a @ref binding of a native value");
+
+    std::string code = typed(value, cty, expr_tok(stmt->m_expr.get()));
+    std::string cname = var_add(id, cty, _const, ctx);
+
+    if (cty != CTy::Obj) {
+        CPPSTMT_CONS((_const ? "const " : "")+std::string(ctype(cty))+" "+cname+" = "+code+";", ctx);
+        return;
+    }
+
+    CPPSTMT_CONS("AOT::Obj "+cname+" = AOT::let("+code+", "+(_const ? "true" : "false")+");", ctx);
+    if (ty && ty->m_mask != ~0ull)
+        CPPSTMT_CONS("AOT::typecheck("+cname+", "+std::to_string(ty->m_mask)+"ull, \""+ty->m_main_ty->lexeme()+"\");", ctx);
+}
+
+static void
+stmt_mut_to_cpp(StmtMut *stmt, Context &ctx) {
+    Token *eq = stmt->m_equals.get();
+    Expr *left = stmt->m_left.get();
+
+    if (left->get_type() == ExprType::Term
+        && dynamic_cast<ExprTerm *>(left)->get_term_type() == ExprTermType::Ident) {
+        Token *tok = dynamic_cast<ExprIdent *>(left)->m_tok.get();
+        Var *var = var_lookup(tok->lexeme(), ctx);
+        if (!var)
+            unsupported(tok, "`"+tok->lexeme()+"`, which is not a local variable,");
+
+        if (var->ty == CTy::Obj) {
+            CExpr right = expr_to_cpp(stmt->m_right.get(), ctx, false);
+            CPPSTMT_CONS("AOT::mutate("+var->cname+", "+op_token(eq, ctx)+", "+boxed(right)+");", ctx);
+            return;
+        }
+
+        if (var->_const)
+            error(tok, "cannot mutate value with attribute @const");
+
+        CExpr right = expr_to_cpp(stmt->m_right.get(), ctx, true);
+        const TokenType op = eq->type();
+        if (op == TokenType::Equals) {
+            CPPSTMT_CONS(var->cname+" = "+mutated(right, var->ty, expr_tok(stmt->m_right.get()))+";", ctx);
+            return;
+        }
+
+        // Int::spec_mutate truncates the right side first. Float only
+        // does `+=` and `*=` the usual way, see Float::spec_mutate.
+        const bool native = (var->ty == CTy::Int && op != TokenType::Equals)
+            || (var->ty == CTy::Float && (op == TokenType::Plus_Equals || op == TokenType::Asterisk_Equals));
+        if (native && right.ty != CTy::Bool) {
+            CPPSTMT_CONS(var->cname+" "+eq->lexeme().substr(eq->lexeme()[0] == '`' ? 1 : 0)+" "
+                         +mutated(right, var->ty, expr_tok(stmt->m_right.get()))+";", ctx);
+            return;
+        }
+
+        // Anything else goes through the value classes.
+        std::string t = tmp(ctx);
+        CPPSTMT("{", ctx);
+        ctx.scope_depth++;
+        CPPSTMT_CONS("AOT::Obj "+t+" = "+boxed(CExpr{var->cname, var->ty, true})+";", ctx);
+        CPPSTMT_CONS("AOT::mutate("+t+", "+op_token(eq, ctx)+", "+boxed(right)+");", ctx);
+        CPPSTMT_CONS(var->cname+" = "+mutated(CExpr{t, CTy::Obj, true}, var->ty, tok)+";", ctx);
+        ctx.scope_depth--;
+        CPPSTMT("}", ctx);
+        return;
+    }
+
+    if (left->get_type() == ExprType::Term
+        && dynamic_cast<ExprTerm *>(left)->get_term_type() == ExprTermType::Array_Access) {
+        CExpr elem = expr_to_cpp(left, ctx, true);
+        CExpr right = expr_to_cpp(stmt->m_right.get(), ctx, false);
+        std::string t = tmp(ctx);
+        CPPSTMT("{", ctx);
+        ctx.scope_depth++;
+        CPPSTMT_CONS("AOT::Obj "+t+" = "+elem.code+";", ctx);
+        CPPSTMT_CONS("AOT::mutate("+t+", "+op_token(eq, ctx)+", "+boxed(right)+");", ctx);
+        ctx.scope_depth--;
+        CPPSTMT("}", ctx);
+        return;
+    }
+
+    unsupported(expr_tok(left), "mutating this kind of expression");
+}
+
+// An expression statement that gives back a value returns it from the
+// enclosing function (with a warning) or, at the top level, ends the
+// enclosing statement, like Interpreter::eval_stmt_block does.
+static void
+stmt_expr_to_cpp(StmtExpr *stmt, Context &ctx) {
+    CExpr e = expr_to_cpp(stmt->m_expr.get(), ctx, false);
+
+    if (!ctx.fn && ctx.stmt_end < 0) {
+        CPPSTMT_CONS("(void)"+e.code+";", ctx);
+        return;
+    }
+
+    std::string leave = "";
+    if (!ctx.fn) {
+        leave = "goto stmt_end"+std::to_string(ctx.stmt_end)+";";
+        ctx.stmt_end_used = true;
+    }
+
+    if (e.ty != CTy::Obj) {
+        if (ctx.fn) {
+            Err::err_wexpr(stmt->m_expr.get());
+            Err::warn("Inplace expression will be evaluated and returned. Either explicitly `return` or assign the unused value to a unit binding: `let _ = <expr>;`");
+            CPPSTMT_CONS("return "+typed(e, ctx.fn->ret, expr_tok(stmt->m_expr.get()))+";", ctx);
+        }
+        else {
+            CPPSTMT_CONS("(void)"+e.code+";", ctx);
+            CPPSTMT_CONS(leave, ctx);
+        }
+        return;
+    }
+
+    std::string t = tmp(ctx);
+    CPPSTMT("{", ctx);
+    ctx.scope_depth++;
+    CPPSTMT_CONS("AOT::Obj "+t+" = "+e.code+";", ctx);
+    if (ctx.fn)
+        CPPSTMT_CONS("if (AOT::yields("+t+")) return "+typed(CExpr{t, CTy::Obj, true}, ctx.fn->ret, expr_tok(stmt->m_expr.get()))+";", ctx);
+    else
+        CPPSTMT_CONS("if (AOT::yields("+t+")) "+leave, ctx);
+    ctx.scope_depth--;
+    CPPSTMT("}", ctx);
+}
+
+static void
+stmt_block_to_cpp(StmtBlock *stmt, Context &ctx, const std::vector<std::string> &prologue) {
+    ctx.scope_depth++;
+    ctx.scopes.emplace_back();
+    for (auto &line : prologue)
+        CPPSTMT_CONS(line, ctx);
+    for (size_t i = 0; i < stmt->m_stmts.size(); ++i)
+        stmt_to_cpp(stmt->m_stmts.at(i).get(), ctx);
+    ctx.scopes.pop_back();
+    ctx.scope_depth--;
+}
+
+static void
+stmt_if_to_cpp(StmtIf *stmt, Context &ctx) {
+    CExpr e = expr_to_cpp(stmt->m_expr.get(), ctx, true);
+    CPPSTMT_CONS("if ("+cond(e)+") {", ctx);
+    stmt_block_to_cpp(stmt->m_block.get(), ctx);
+    if (stmt->m_else.has_value()) {
+        CPPSTMT("}", ctx);
+        CPPSTMT("else {", ctx);
+        stmt_block_to_cpp(stmt->m_else.value().get(), ctx);
+    }
+    CPPSTMT("}", ctx);
+}
+
+static void
+stmt_return_to_cpp(StmtReturn *stmt, Context &ctx) {
+    if (!ctx.fn)
+        unsupported(stmt->m_tok.get(), "`return` at the top level");
+
+    if (!stmt->m_expr.has_value()) {
+        if (ctx.fn->ret == CTy::Obj)
+            CPPSTMT("return AOT::unit();", ctx);
+        else
+            CPPSTMT_CONS("AOT::no_return(\""+ctx.fn->def->m_id->lexeme()+"\");", ctx);
+        return;
+    }
+
+    Expr *expr = stmt->m_expr.value().get();
+    CExpr e = expr_to_cpp(expr, ctx, false);
+    CPPSTMT_CONS("return "+typed(e, ctx.fn->ret, expr_tok(expr))+";", ctx);
+}
+
+static void
+stmt_while_to_cpp(StmtWhile *stmt, Context &ctx) {
+    CExpr e = expr_to_cpp(stmt->m_expr.get(), ctx, true);
+    CPPSTMT_CONS("while ("+cond(e)+") {", ctx);
+    stmt_block_to_cpp(stmt->m_block.get(), ctx);
+    CPPSTMT("}", ctx);
+}
+
+static void
+stmt_loop_to_cpp(StmtLoop *stmt, Context &ctx) {
+    CPPSTMT("for (;;) {", ctx);
+    stmt_block_to_cpp(stmt->m_block.get(), ctx);
+    CPPSTMT("}", ctx);
+}
+
+// The enumerator is a native int that counts towards the end, which is
+// read again every iteration when it is a variable (see eval_stmt_for).
+static void
+stmt_for_to_cpp(StmtFor *stmt, Context &ctx) {
+    CExpr start = expr_to_cpp(stmt->m_start.get(), ctx, false);
+    CExpr end = expr_to_cpp(stmt->m_end.get(), ctx, true);
+    const bool is_var = stmt->m_end->get_type() == ExprType::Term
+        && dynamic_cast<ExprTerm *>(stmt->m_end.get())->get_term_type() == ExprTermType::Ident;
+
+    CPPSTMT("{", ctx);
+    ctx.scope_depth++;
+    ctx.scopes.emplace_back();
+
+    std::string first = typed(start, CTy::Int, expr_tok(stmt->m_start.get()));
+    std::string last = typed(end, CTy::Int, expr_tok(stmt->m_end.get()));
+    if (!is_var) {
+        std::string t = tmp(ctx);
+        CPPSTMT_CONS("int "+t+" = "+first+";", ctx);
+        first = t;
+        t = tmp(ctx);
+        CPPSTMT_CONS("const int "+t+" = "+last+";", ctx);
+        last = t;
+    }
+    std::string cname = var_add(stmt->m_enumerator.get(), CTy::Int, false, ctx);
+    std::string up = tmp(ctx);
+    CPPSTMT_CONS("int "+cname+" = "+first+";", ctx);
+    CPPSTMT_CONS("const bool "+up+" = "+cname+" <= "+last+";", ctx);
+    CPPSTMT_CONS("for (; "+up+" ? "+cname+" < "+last+" : "+cname+" >= "+last+"; "+up+" ? ++"+cname+" : --"+cname+") {", ctx);
+    stmt_block_to_cpp(stmt->m_block.get(), ctx);
+    CPPSTMT("}", ctx);
+
+    ctx.scopes.pop_back();
+    ctx.scope_depth--;
+    CPPSTMT("}", ctx);
+}
+
+static void
+stmt_foreach_to_cpp(StmtForeach *stmt, Context &ctx) {
+    if (stmt->m_enumerators.size() != 1)
+        unsupported(stmt->m_enumerators.at(0).get(), "`foreach` with more than one enumerator");
+
+    const bool ref = (stmt->m_attrs & static_cast<uint32_t>(Attr::Ref)) != 0;
+    Token *enumerator = stmt->m_enumerators.at(0).get();
+    Expr *expr = stmt->m_expr.get();
+
+    // Ranges of ints count with a native int.
+    if (expr->get_type() == ExprType::Term
+        && dynamic_cast<ExprTerm *>(expr)->get_term_type() == ExprTermType::Range) {
+        auto range = dynamic_cast<ExprRange *>(expr);
+        CExpr start = expr_to_cpp(range->m_start.get(), ctx, true);
+        CExpr end = expr_to_cpp(range->m_end.get(), ctx, true);
+        if (start.ty == CTy::Int && end.ty == CTy::Int) {
+            std::string s = tmp(ctx), e = tmp(ctx), i = tmp(ctx);
+            CPPSTMT("{", ctx);
+            ctx.scope_depth++;
+            CPPSTMT_CONS("const int "+s+" = "+start.code+";", ctx);
+            CPPSTMT_CONS("const int "+e+" = "+end.code+";", ctx);
+            CPPSTMT_CONS("for (int "+i+" = "+s+"; "+i+(range->m_inclusive ? " <= " : " < ")+e+"; ++"+i+") {", ctx);
+            ctx.scopes.emplace_back();
+            std::string cname = var_add(enumerator, CTy::Int, false, ctx);
+            stmt_block_to_cpp(stmt->m_block.get(), ctx, {"int "+cname+" = "+i+";"});
+            ctx.scopes.pop_back();
+            CPPSTMT("}", ctx);
+            ctx.scope_depth--;
+            CPPSTMT("}", ctx);
+            return;
+        }
+    }
+
+    CExpr e = expr_to_cpp(expr, ctx, ref);
+    std::string t = tmp(ctx);
+    CPPSTMT_CONS("for (AOT::Obj &"+t+" : AOT::elements("+boxed(e)+", "+(ref ? "true" : "false")+")) {", ctx);
+    ctx.scopes.emplace_back();
+    std::string cname = var_add(enumerator, CTy::Obj, false, ctx);
+    stmt_block_to_cpp(stmt->m_block.get(), ctx, {"AOT::Obj "+cname+" = "+t+";"});
+    ctx.scopes.pop_back();
+    CPPSTMT("}", ctx);
+}
+
+static void
+stmt_to_cpp(Stmt *stmt, Context &ctx) {
+    switch (stmt->stmt_type()) {
+    case StmtType::Let:       stmt_let_to_cpp(dynamic_cast<StmtLet *>(stmt), ctx); break;
+    case StmtType::Mut:       stmt_mut_to_cpp(dynamic_cast<StmtMut *>(stmt), ctx); break;
+    case StmtType::Stmt_Expr: stmt_expr_to_cpp(dynamic_cast<StmtExpr *>(stmt), ctx); break;
+    case StmtType::If:        stmt_if_to_cpp(dynamic_cast<StmtIf *>(stmt), ctx); break;
+    case StmtType::Return:    stmt_return_to_cpp(dynamic_cast<StmtReturn *>(stmt), ctx); break;
+    case StmtType::Break:     CPPSTMT("break;", ctx); break;
+    case StmtType::Continue:  CPPSTMT("continue;", ctx); break;
+    case StmtType::While:     stmt_while_to_cpp(dynamic_cast<StmtWhile *>(stmt), ctx); break;
+    case StmtType::Loop:      stmt_loop_to_cpp(dynamic_cast<StmtLoop *>(stmt), ctx); break;
+    case StmtType::For:       stmt_for_to_cpp(dynamic_cast<StmtFor *>(stmt), ctx); break;
+    case StmtType::Foreach:   stmt_foreach_to_cpp(dynamic_cast<StmtForeach *>(stmt), ctx); break;
+    case StmtType::Mod:       break;
+    case StmtType::Block: {
+        CPPSTMT("{", ctx);
+        stmt_block_to_cpp(dynamic_cast<StmtBlock *>(stmt), ctx);
+        CPPSTMT("}", ctx);
+    } break;
+    case StmtType::Def:      unsupported(dynamic_cast<StmtDef *>(stmt)->m_id.get(), "a nested function"); break;
+    case StmtType::Import:   unsupported(expr_tok(dynamic_cast<StmtImport *>(stmt)->m_fp.get()), "`import`"); break;
+    case StmtType::Class:    unsupported(dynamic_cast<StmtClass *>(stmt)->m_id.get(), "a class"); break;
+    case StmtType::Enum:     unsupported(dynamic_cast<StmtEnum *>(stmt)->m_id.get(), "an enum"); break;
+    case StmtType::Match:    unsupported(nullptr, "`match`"); break;
+    case StmtType::Bash_Literal: unsupported(nullptr, "a bash literal"); break;
+    default: assert(false && "unreachable");
+    }
+}
+
+static std::string
+fn_signature(const std::string &id, Fn &fn) {
+    std::string sig = "static "+std::string(ctype(fn.ret))+" earl_"+id+"(";
+    auto &args = fn.def->m_args;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const bool ref = (args[i].second & static_cast<uint32_t>(Attr::Ref)) != 0;
+        const bool _const = (args[i].second & static_cast<uint32_t>(Attr::Const)) != 0;
+        const std::string &name = args[i].first.first->lexeme();
+        if (fn.params[i] == CTy::Obj)
+            sig += "AOT::Obj p_"+name;
+        else
+            sig += (_const ? "const " : "")+std::string(ctype(fn.params[i]))+(ref ? " &e_" : " e_")+name;
+        if (i != args.size()-1)
+            sig += ", ";
+    }
+    return sig+")";
+}
+
+static void
+stmt_def_to_cpp(StmtDef *stmt, Context &ctx) {
+    const std::string &id = stmt->m_id->lexeme();
+    Fn &fn = ctx.fns.at(id);
+    ctx.fn = &fn;
+    ctx.tmps = 0;
+
+    CPPSTMT_CONS(fn_signature(id, fn)+" {", ctx);
+    ctx.scope_depth++;
+    ctx.scopes.emplace_back();
+
+    // Boxed arguments are copied unless they are @ref, like
+    // earl::function::Obj::load_parameters does.
+    for (size_t i = 0; i < stmt->m_args.size(); ++i) {
+        Token *tok = stmt->m_args[i].first.first.get();
+        const uint32_t attrs = stmt->m_args[i].second;
+        const bool ref = (attrs & static_cast<uint32_t>(Attr::Ref)) != 0;
+        const bool _const = (attrs & static_cast<uint32_t>(Attr::Const)) != 0;
+        std::string cname = var_add(tok, fn.params[i], _const, ctx);
+        if (fn.params[i] != CTy::Obj)
+            continue;
+        if (stmt->m_args[i].first.second.has_value()) {
+            __Type *ty = stmt->m_args[i].first.second.value().get();
+            if (ty->m_mask == 0)
+                unsupported(ty->m_main_ty.get(), "a class type annotation");
+            if (ty->m_mask != ~0ull)
+                CPPSTMT_CONS("AOT::typecheck(p_"+tok->lexeme()+", "+std::to_string(ty->m_mask)+"ull, \""+ty->m_main_ty->lexeme()+"\");", ctx);
+        }
+        CPPSTMT_CONS("AOT::Obj "+cname+" = "+(ref ? "p_"+tok->lexeme() : "p_"+tok->lexeme()+"->copy()")+";", ctx);
+        if (_const)
+            CPPSTMT_CONS(cname+"->set_const();", ctx);
+    }
+
+    for (auto &s : stmt->m_block->m_stmts)
+        stmt_to_cpp(s.get(), ctx);
+
+    if (fn.ret == CTy::Obj)
+        CPPSTMT("return AOT::unit();", ctx);
+    else
+        CPPSTMT_CONS("AOT::no_return(\""+id+"\");", ctx);
+
+    ctx.scopes.pop_back();
+    ctx.scope_depth--;
+    CPPSTMT("}", ctx);
+    CPPSTMT("", ctx);
+    ctx.fn = nullptr;
+}
+
+std::string
+earl_to_cpp(std::unique_ptr<Program> program) {
+    Context ctx = {0, "", "", {}, {}, {}, nullptr, 0, -1, false};
+
+    // Functions can be called before they are defined, so collect
+    // their signatures first.
+    std::string prototypes = "";
+    for (auto &stmt : program->m_stmts) {
+        if (stmt->stmt_type() != StmtType::Def)
+            continue;
+        auto def = dynamic_cast<StmtDef *>(stmt.get());
+        const std::string &id = def->m_id->lexeme();
+        if (ctx.fns.find(id) != ctx.fns.end())
+            error(def->m_id.get(), "function `"+id+"` has already been declared");
+        Fn fn = {def, {}, annotated(def->m_ty.has_value() ? def->m_ty.value().get() : nullptr)};
+        for (auto &arg : def->m_args)
+            fn.params.push_back(annotated(arg.first.second.has_value() ? arg.first.second.value().get() : nullptr));
+        ctx.fns[id] = fn;
+        prototypes += fn_signature(id, ctx.fns[id])+";\n";
+    }
+
+    for (auto &stmt : program->m_stmts) {
+        if (stmt->stmt_type() == StmtType::Def)
+            stmt_def_to_cpp(dynamic_cast<StmtDef *>(stmt.get()), ctx);
+    }
+
+    CPPSTMT("static void", ctx);
+    CPPSTMT("earl_main(void) {", ctx);
+    ctx.scope_depth++;
+    ctx.scopes.emplace_back();
+    ctx.tmps = 0;
+    unsigned stmt_ends = 0;
+    for (auto &stmt : program->m_stmts) {
+        if (stmt->stmt_type() == StmtType::Def)
+            continue;
+        ctx.stmt_end = static_cast<int>(stmt_ends);
+        ctx.stmt_end_used = false;
+        if (stmt->stmt_type() == StmtType::Stmt_Expr) {
+            ctx.stmt_end = -1;
+            stmt_to_cpp(stmt.get(), ctx);
+            continue;
+        }
+        stmt_to_cpp(stmt.get(), ctx);
+        if (ctx.stmt_end_used)
+            CPPSTMT_CONS("stmt_end"+std::to_string(stmt_ends++)+":;", ctx);
+    }
+    ctx.stmt_end = -1;
+    ctx.scopes.pop_back();
+    ctx.scope_depth--;
+    CPPSTMT("}", ctx);
+
+    return "// Generated by `earl --"+std::string(COMMON_EARL2ARG_TOCPP)+"` from "+program->m_filepath+"\n"
+        + "\n"
+        + "#include \"aot.hpp\"\n"
+        + "\n"
+        + "uint32_t flags = 0x00;\n"
+        + "std::vector<std::string> earl_argv = {};\n"
+        + "\n"
+        + ctx.statics
+        + "\n"
+        + prototypes
+        + "\n"
+        + ctx.cpp_src
+        + "\n"
+        + "int\n"
+        + "main(int argc, char **argv) {\n"
+        + CPPTAB "return AOT::run(argc, argv, earl_main);\n"
+        + "}\n";
+}
@@ -183,7 +183,7 @@ void tabs(Context &ctx) {
 }
 
 bool ident_is_intrinsic_function(const std::string &id) {
-    const std::unordered_map<std::string, Intrinsics::IntrinsicFunction> &map =
+    const std::unordered_map<std::string, Intrinsics::Intrinsic> &map =
         Intrinsics::intrinsic_functions;
     return map.find(id) != map.end();
 }
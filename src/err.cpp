@@ -29,17 +29,26 @@
 #include "err.hpp"
 #include "token.hpp"
 
+// Errors found while parsing ahead of time are not printed,
+// they are found again (and printed) when the import runs.
+static thread_local bool quiet = false;
+
+void
+Err::set_quiet(bool q) {
+    quiet = q;
+}
+
 void
 Err::err_wtok(Token *tok) {
-    if (!tok)
+    if (!tok || quiet)
         return;
-    std::cerr << tok->m_fp << ':' << tok->m_row << ':' << tok->m_col << ":\n";
+    std::cerr << tok->fp() << ':' << tok->m_row << ':' << tok->m_col << ":\n";
     Token *it = tok;
     while (it && it->type() != TokenType::Semicolon) {
         std::cerr << it->lexeme();
         if (it->m_next && it->m_next->type() != TokenType::Semicolon)
             std::cerr << ' ';
-        it = it->m_next.get();
+        it = it->m_next;
     }
     if (it && it->type() == TokenType::Semicolon)
         std::cerr << ';';
@@ -54,19 +63,25 @@ static void err_wident(ExprIdent *expr, int s);
 
 void
 Err::err_w2tok(Token *tok1, Token *tok2) {
-    std::cerr << tok1->m_fp << ':' << tok1->m_row << ':' << tok1->m_col << ":\n";
-    std::cerr << tok2->m_fp << ':' << tok2->m_row << ':' << tok2->m_col << ":\n";
+    if (quiet)
+        return;
+    std::cerr << tok1->fp() << ':' << tok1->m_row << ':' << tok1->m_col << ":\n";
+    std::cerr << tok2->fp() << ':' << tok2->m_row << ':' << tok2->m_col << ":\n";
 }
 
 void
 Err::err_wconflict(Token *newtok, Token *orig) {
+    if (quiet)
+        return;
     err_wtok(newtok);
     if ((flags & __WATCH) == 0)
-        std::cerr << orig->m_fp << ':' << orig->m_row << ':' << orig->m_col << ": <---- conflict\n";
+        std::cerr << orig->fp() << ':' << orig->m_row << ':' << orig->m_col << ": <---- conflict\n";
 }
 
 void
 Err::warn(std::string msg, Token *tok) {
+    if (quiet)
+        return;
     if (tok)
         err_wtok(tok);
     std::cerr << "warning: " << msg << std::endl;
@@ -323,6 +338,8 @@ err_wstmtenum(StmtEnum *stmt) {
 
 void
 Err::err_wstmt(Stmt *stmt) {
+    if (!stmt)
+        return;
     switch (stmt->stmt_type()) {
     case StmtType::Def: assert(false); break;
     case StmtType::Let: assert(false); break;
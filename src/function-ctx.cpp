@@ -29,8 +29,16 @@
 #include "utils.hpp"
 #include "err.hpp"
 
-FunctionCtx::FunctionCtx(std::shared_ptr<Ctx> owner, uint32_t attrs)
-    : m_immediate_owner(owner), m_attrs(attrs) {
+static std::vector<std::shared_ptr<FunctionCtx>> pool = {};
+
+FunctionCtx::FunctionCtx(std::shared_ptr<Ctx> owner, uint32_t attrs) {
+    this->set_owner(std::move(owner), attrs);
+}
+
+void
+FunctionCtx::set_owner(std::shared_ptr<Ctx> owner, uint32_t attrs) {
+    m_immediate_owner = owner;
+    m_attrs = attrs;
     std::shared_ptr<Ctx> it = owner;
     while (1) {
         switch (it->type()) {
@@ -46,6 +54,34 @@ FunctionCtx::FunctionCtx(std::shared_ptr<Ctx> owner, uint32_t attrs)
     }
 }
 
+std::shared_ptr<FunctionCtx>
+FunctionCtx::acquire(std::shared_ptr<Ctx> owner, uint32_t attrs) {
+    if (pool.size() == 0)
+        return std::make_shared<FunctionCtx>(std::move(owner), attrs);
+    auto ctx = std::move(pool.back());
+    pool.pop_back();
+    ctx->set_owner(std::move(owner), attrs);
+    return ctx;
+}
+
+void
+FunctionCtx::release(std::shared_ptr<FunctionCtx> &ctx) {
+    if (ctx.use_count() != 1 || pool.size() >= CTX_POOL_CAP) {
+        ctx = nullptr;
+        return;
+    }
+    ctx->m_scope.reset();
+    ctx->m_funcs.reset();
+    ctx->m_frame.clear();
+    ctx->m_owner = nullptr;
+    ctx->m_immediate_owner = nullptr;
+    ctx->m_in_rec = false;
+    ctx->m_curfunc_id.clear();
+    ctx->m_tail_func = nullptr;
+    ctx->m_tail_params.clear();
+    pool.push_back(std::move(ctx));
+}
+
 void
 FunctionCtx::setrec(void) {
     m_in_rec = true;
@@ -209,6 +245,10 @@ std::shared_ptr<Ctx> &FunctionCtx::get_owner(void) {
     return m_owner;
 }
 
+std::shared_ptr<Ctx> &FunctionCtx::get_immediate_owner(void) {
+    return m_immediate_owner;
+}
+
 std::shared_ptr<Ctx> &FunctionCtx::get_outer_world_owner(void) {
     if (m_owner && m_owner->type() == CtxType::Function)
         return dynamic_cast<FunctionCtx *>(m_owner.get())->get_outer_world_owner();
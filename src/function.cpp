@@ -93,6 +93,7 @@ Obj::load_parameters(std::vector<std::shared_ptr<earl::value::Obj>> &values,
         if ((m_params.at(i).second & static_cast<uint32_t>(Attr::Const)) != 0)
             var->value()->set_const();
         new_ctx->variable_add(var);
+        new_ctx->m_frame.set(Slot{block(), static_cast<int>(i)}, var);
     }
 }
 
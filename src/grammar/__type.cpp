@@ -26,6 +26,33 @@
 #include <memory>
 
 #include "ast.hpp"
+#include "earl.hpp"
+#include "common.hpp"
+
+#define TYBIT(ty) (1ull << static_cast<int>(earl::value::Type::ty))
+
+static uint64_t
+type_mask(const std::string &tyname) {
+    if (tyname == COMMON_EARLTY_ANY)     return ~0ull;
+    if (tyname == COMMON_EARLTY_INT32)   return TYBIT(Int);
+    if (tyname == COMMON_EARLTY_FLOAT)   return TYBIT(Float);
+    if (tyname == COMMON_EARLTY_STR)     return TYBIT(Str);
+    if (tyname == COMMON_EARLTY_UNIT)    return TYBIT(Void) | TYBIT(Return);
+    if (tyname == COMMON_EARLTY_CHAR)    return TYBIT(Char);
+    if (tyname == COMMON_EARLTY_BOOL)    return TYBIT(Bool);
+    if (tyname == COMMON_EARLTY_LIST)    return TYBIT(List);
+    if (tyname == COMMON_EARLTY_TUPLE)   return TYBIT(Tuple);
+    if (tyname == COMMON_EARLTY_FILE)    return TYBIT(File);
+    if (tyname == COMMON_EARLTY_CLOSURE) return TYBIT(Closure);
+    if (tyname == COMMON_EARLTY_OPTION)  return TYBIT(Option);
+    if (tyname == COMMON_EARLTY_SLICE)   return TYBIT(Slice);
+    if (tyname == COMMON_EARLTY_DICT)
+        return TYBIT(DictInt) | TYBIT(DictStr) | TYBIT(DictFloat) | TYBIT(DictChar);
+    if (tyname == COMMON_EARLTY_TYPE)    return TYBIT(TypeKW);
+    if (tyname == COMMON_EARLTY_REAL)    return TYBIT(Int) | TYBIT(Float);
+    return 0;
+}
 
 __Type::__Type(std::shared_ptr<Token> main_ty, std::optional<std::shared_ptr<Token>> sub_ty)
-    : m_main_ty(main_ty), m_sub_ty(sub_ty) {}
+    : m_main_ty(main_ty), m_sub_ty(sub_ty),
+      m_mask(sub_ty.has_value() ? 0 : type_mask(main_ty->lexeme())) {}
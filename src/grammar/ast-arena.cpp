@@ -0,0 +1,62 @@
+/** @file */
+
+// MIT License
+
+// Copyright (c) 2023 malloc-nbytes
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "ast.hpp"
+#include "arena.hpp"
+
+static thread_local Arena *current = nullptr;
+
+// Every node is preceded by a byte saying whether it is in an
+// arena, so that deleting it knows if it was on the heap.
+static constexpr size_t HEADER = alignof(std::max_align_t);
+
+AstArena::AstArena(Arena *arena) : m_prev(current) {
+    current = arena;
+}
+
+AstArena::~AstArena() {
+    current = m_prev;
+}
+
+void *
+AstArena::alloc(size_t bytes) {
+    uint8_t *mem = current
+        ? static_cast<uint8_t *>(current->alloc(HEADER + bytes, HEADER))
+        : static_cast<uint8_t *>(::operator new(HEADER + bytes));
+    *mem = current ? 1 : 0;
+    return mem + HEADER;
+}
+
+void
+AstArena::free(void *node) {
+    if (!node)
+        return;
+    uint8_t *mem = static_cast<uint8_t *>(node) - HEADER;
+    if (*mem == 0)
+        ::operator delete(mem);
+}
@@ -0,0 +1,115 @@
+/** @file */
+
+// MIT License
+
+// Copyright (c) 2023 malloc-nbytes
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cassert>
+#include <memory>
+#include <stdexcept>
+
+#include "ast.hpp"
+#include "earl.hpp"
+#include "err.hpp"
+
+static int
+decode_int(Token *tok) {
+    try {
+        return std::stoi(tok->lexeme());
+    }
+    catch (const std::out_of_range &) {
+        Err::err_wtok(tok);
+        const std::string msg = "integer literal `"+tok->lexeme()+"` is out of range";
+        throw ParserException(msg);
+    }
+}
+
+static char
+decode_char(Token *tok) {
+    const std::string &lx = tok->lexeme();
+    if (lx == "\\n")  return '\n';
+    if (lx == "\\t")  return '\t';
+    if (lx == "\\r")  return '\r';
+    if (lx == "\\0")  return '\0';
+    if (lx == "\\\\") return '\\';
+    return lx[0];
+}
+
+std::shared_ptr<earl::value::Obj>
+ConstPool::find(char kind, const std::string &key) {
+    auto it = m_values.find(kind+key);
+    return it == m_values.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<earl::value::Obj>
+ConstPool::intern(char kind, const std::string &key, std::shared_ptr<earl::value::Obj> value) {
+    value->set_const();
+    m_values.emplace(kind+key, value);
+    return value;
+}
+
+std::shared_ptr<earl::value::Obj>
+ConstPool::get_int(Token *tok) {
+    if (auto value = find('i', tok->lexeme()))
+        return value;
+    return intern('i', tok->lexeme(), std::make_shared<earl::value::Int>(decode_int(tok)));
+}
+
+std::shared_ptr<earl::value::Obj>
+ConstPool::get_float(Token *tok) {
+    if (auto value = find('f', tok->lexeme()))
+        return value;
+    return intern('f', tok->lexeme(), std::make_shared<earl::value::Float>(std::stof(tok->lexeme())));
+}
+
+std::shared_ptr<earl::value::Obj>
+ConstPool::get_str(Token *tok) {
+    if (auto value = find('s', tok->lexeme()))
+        return value;
+    return intern('s', tok->lexeme(), std::make_shared<earl::value::Str>(tok->lexeme()));
+}
+
+std::shared_ptr<earl::value::Obj>
+ConstPool::get_char(Token *tok) {
+    if (auto value = find('c', tok->lexeme()))
+        return value;
+    return intern('c', tok->lexeme(), std::make_shared<earl::value::Char>(decode_char(tok)));
+}
+
+std::shared_ptr<earl::value::Obj>
+ConstPool::get_bool(bool b) {
+    const std::string key = b ? "true" : "false";
+    if (auto value = find('b', key))
+        return value;
+    return intern('b', key, std::make_shared<earl::value::Bool>(b));
+}
+
+std::shared_ptr<earl::value::Obj>
+ConstPool::add(std::shared_ptr<earl::value::Obj> value) {
+    value->set_const();
+    m_computed.push_back(value);
+    return value;
+}
+
+size_t
+ConstPool::size(void) const {
+    return m_values.size() + m_computed.size();
+}
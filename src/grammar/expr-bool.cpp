@@ -27,8 +27,8 @@
 
 #include "ast.hpp"
 
-ExprBool::ExprBool(std::shared_ptr<Token> tok, bool value)
-    : m_tok(tok), m_value(value) {}
+ExprBool::ExprBool(std::shared_ptr<Token> tok, bool value, std::shared_ptr<earl::value::Obj> constant)
+    : m_tok(tok), m_value(value), m_constant(std::move(constant)) {}
 
 ExprType
 ExprBool::get_type() const {
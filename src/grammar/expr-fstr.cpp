@@ -27,7 +27,8 @@
 
 #include "ast.hpp"
 
-ExprFStr::ExprFStr(std::shared_ptr<Token> tok) : m_tok(tok) {}
+ExprFStr::ExprFStr(std::shared_ptr<Token> tok, std::vector<std::variant<std::string, std::unique_ptr<Expr>>> parts)
+    : m_tok(tok), m_parts(std::move(parts)) {}
 
 ExprType
 ExprFStr::get_type() const {
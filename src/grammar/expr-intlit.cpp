@@ -27,7 +27,8 @@
 
 #include "ast.hpp"
 
-ExprIntLit::ExprIntLit(std::shared_ptr<Token> tok) : m_tok(tok) {}
+ExprIntLit::ExprIntLit(std::shared_ptr<Token> tok, std::shared_ptr<earl::value::Obj> value)
+    : m_tok(tok), m_value(std::move(value)) {}
 
 ExprType
 ExprIntLit::get_type() const {
@@ -27,7 +27,8 @@
 
 #include "ast.hpp"
 
-ExprStrLit::ExprStrLit(std::shared_ptr<Token> tok) : m_tok(tok) {}
+ExprStrLit::ExprStrLit(std::shared_ptr<Token> tok, std::shared_ptr<earl::value::Obj> value)
+    : m_tok(tok), m_value(std::move(value)) {}
 
 ExprType
 ExprStrLit::get_type() const {
@@ -27,6 +27,7 @@
 
 #include "ast.hpp"
 
-Program::Program(std::vector<std::unique_ptr<Stmt>> stmts, const std::string filepath)
-    : m_stmts(std::move(stmts)), m_filepath(filepath) {}
+Program::Program(std::vector<std::unique_ptr<Stmt>> stmts, const std::string filepath,
+                 std::unique_ptr<ConstPool> consts, std::unique_ptr<Arena> arena)
+    : m_arena(std::move(arena)), m_stmts(std::move(stmts)), m_filepath(filepath), m_consts(std::move(consts)) {}
 
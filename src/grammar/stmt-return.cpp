@@ -34,3 +34,17 @@ StmtReturn::stmt_type() const {
     return StmtType::Return;
 }
 
+
+ExprFuncCall *
+StmtReturn::tail_call(void) const {
+    if (!m_expr.has_value() || m_expr.value()->get_type() != ExprType::Term)
+        return nullptr;
+    auto term = dynamic_cast<ExprTerm *>(m_expr.value().get());
+    if (term->get_term_type() != ExprTermType::Func_Call)
+        return nullptr;
+    auto call = dynamic_cast<ExprFuncCall *>(term);
+    if (call->m_left->get_type() != ExprType::Term
+        || dynamic_cast<ExprTerm *>(call->m_left.get())->get_term_type() != ExprTermType::Ident)
+        return nullptr;
+    return call;
+}
@@ -0,0 +1,126 @@
+/** @file */
+
+// MIT License
+
+// Copyright (c) 2023 malloc-nbytes
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef AOT_H
+#define AOT_H
+
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "earl.hpp"
+#include "ctx.hpp"
+#include "token.hpp"
+#include "intrinsics.hpp"
+
+/**
+ * The runtime of programs compiled with `--to-cpp` (see earl-to-cpp.cpp).
+ * The generated C++ keeps values whose type is fixed by an annotation
+ * in native `int`, `double` and `bool` locals, everything else is an
+ * `earl::value::Obj` and goes through the functions below, which call
+ * into the same value classes and intrinsics as the interpreter.
+ *
+ * Compiled programs link against `libearlrt.a` and define `flags` and
+ * `earl_argv` themselves, as they do not have the `earl` main.
+ */
+
+namespace AOT {
+    using Obj = std::shared_ptr<earl::value::Obj>;
+    using Args = std::vector<Obj>;
+
+    /// @brief A call of an intrinsic member function, looked up
+    /// again only when the receiver changes type
+    struct MemberSite {
+        MemberSite(const char *id) : m_id(id) {}
+
+        const char *m_id;
+        int m_ty = -1;
+        Intrinsics::IntrinsicMemberFunction m_fn = nullptr;
+    };
+
+    /// @brief Run `earl_main` and report uncaught errors like `earl` does
+    int run(int argc, char **argv, void (*earl_main)(void));
+
+    /// @brief The context handed to intrinsics
+    std::shared_ptr<Ctx> &ctx(void);
+
+    inline Obj box_int(int value) {return std::make_shared<earl::value::Int>(value);}
+    inline Obj box_float(double value) {return std::make_shared<earl::value::Float>(value);}
+    inline Obj box_bool(bool value) {return std::make_shared<earl::value::Bool>(value);}
+    inline Obj str(std::string value) {return std::make_shared<earl::value::Str>(std::move(value));}
+    inline Obj chr(char value) {return std::make_shared<earl::value::Char>(value);}
+    inline Obj none(void) {return std::make_shared<earl::value::Option>();}
+    inline Obj unit(void) {return earl::value::Void::instance();}
+    inline bool truthy(const Obj &value) {return value->boolean();}
+
+    /// @brief The value of a `let`, tuples are always @const
+    inline Obj let(Obj value, bool _const) {
+        if (_const || value->type() == earl::value::Type::Tuple)
+            value->set_const();
+        return value;
+    }
+
+    /// @brief Unbox a value bound to an annotated int, float or bool
+    int unbox_int(const Obj &value);
+    double unbox_float(const Obj &value);
+    bool unbox_bool(const Obj &value);
+
+    /// @brief Unbox a value assigned to a native local (an int takes
+    /// a float by truncating it and the other way around)
+    int mut_int(const Obj &value);
+    double mut_float(const Obj &value);
+
+    /// @brief Throw unless the type of `value` is in `mask` (see __Type)
+    void typecheck(const Obj &value, uint64_t mask, const char *ty);
+
+    /// @brief Whether an expression statement gives back a value, in
+    /// which case the enclosing function returns it
+    bool yields(const Obj &value);
+
+    Obj list(Args values);
+    Obj range(const Obj &start, const Obj &end, bool inclusive);
+    std::string to_string(const Obj &value);
+    Obj fstr(std::initializer_list<std::string> parts);
+
+    Obj binop(Token *op, const Obj &lhs, const Obj &rhs);
+    Obj unaryop(Token *op, const Obj &value);
+    Obj index(const Obj &left, const Obj &idx, bool ref);
+
+    /// @brief `left = right` and the `op=` mutations
+    void mutate(const Obj &left, Token *equals, const Obj &right);
+
+    Obj call(Intrinsics::IntrinsicFunction fn, Args args);
+    Obj call_member(MemberSite &site, const Obj &accessor, Args args);
+
+    /// @brief The elements that `foreach` visits
+    Args elements(const Obj &value, bool ref);
+
+    /// @brief Throw for a function with an annotated return type
+    /// that finished without returning
+    [[noreturn]] void no_return(const char *fn);
+};
+
+#endif // AOT_H
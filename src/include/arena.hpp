@@ -34,25 +34,45 @@
 #define ARENA_H
 
 #include <vector>
+#include <memory>
+#include <cstddef>
 #include <stddef.h>
 #include <stdint.h>
 
+/// @brief The size of the blocks that an `Arena` hands out memory from
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
 /// @brief An Arena allocator for easiser memory
-/// management. Allocate a bunch of memory
-/// up-front first, and then have other
-/// heap-alloc'd objects use this pool
-/// for the required memory.
+/// management. Memory is handed out from large
+/// blocks by bumping a pointer, and all of it
+/// is freed at once when the arena is destroyed.
+/// Nothing is destructed by the arena itself.
 struct Arena {
-    std::vector<uint8_t> m_mem;
+    /// @brief The blocks of memory
+    std::vector<std::unique_ptr<uint8_t[]>> m_blocks;
+
+    /// @brief The next free byte in the current block
+    uint8_t *m_cur;
+
+    /// @brief The number of bytes left in the current block
+    size_t m_left;
+
+    /// @brief The number of bytes handed out
     size_t m_len;
-    size_t m_cap;
 
-    Arena(size_t bytes);
+    Arena();
     ~Arena() = default;
-};
 
-/// @brief Allocate `bytes` number of bytes in an arena.
-[[deprecated]]
-uint8_t *arena_alloc(Arena &arena, size_t bytes);
+    Arena(const Arena &other) = delete;
+
+    /// @brief Allocate `bytes` bytes aligned to `align`.
+    void *alloc(size_t bytes, size_t align = alignof(std::max_align_t));
+
+    /// @brief Allocate room for `n` objects of type `T`.
+    template <typename T> T *
+    alloc(size_t n = 1) {
+        return static_cast<T *>(alloc(sizeof(T) * n, alignof(T)));
+    }
+};
 
 #endif // ARENA_H
@@ -25,12 +25,16 @@
 #ifndef AST_H
 #define AST_H
 
+#include <cstdint>
 #include <variant>
 #include <vector>
 #include <memory>
 #include <optional>
+#include <string>
+#include <unordered_map>
 
 #include "token.hpp"
+#include "arena.hpp"
 
 /**
  * The grammar of EARL.
@@ -93,17 +97,128 @@ struct StmtDef;
 struct StmtBlock;
 struct ExprFuncCall;
 
+namespace VM { struct Chunk; };
+struct ClassDesc;
+namespace Memo { struct Cache; };
+namespace JIT { struct Region; };
+struct Ctx;
+namespace earl { namespace value { struct Obj; }; };
+
+/// @brief The literals of a Program, decoded once by the parser.
+/// Equal literals share the same value. These are set as constant
+/// and must never be mutated in place, only copied.
+struct ConstPool {
+    std::shared_ptr<earl::value::Obj> get_int(Token *tok);
+    std::shared_ptr<earl::value::Obj> get_float(Token *tok);
+    std::shared_ptr<earl::value::Obj> get_str(Token *tok);
+    std::shared_ptr<earl::value::Obj> get_char(Token *tok);
+    std::shared_ptr<earl::value::Obj> get_bool(bool value);
+
+    /// @brief Add a value that was computed ahead of time
+    /// (i.e. by the optimizer) and has no literal of its own
+    std::shared_ptr<earl::value::Obj> add(std::shared_ptr<earl::value::Obj> value);
+
+    /// @brief The number of distinct constants
+    size_t size(void) const;
+
+private:
+    std::shared_ptr<earl::value::Obj> find(char kind, const std::string &key);
+    std::shared_ptr<earl::value::Obj> intern(char kind, const std::string &key, std::shared_ptr<earl::value::Obj> value);
+
+    std::unordered_map<std::string, std::shared_ptr<earl::value::Obj>> m_values;
+    std::vector<std::shared_ptr<earl::value::Obj>> m_computed;
+};
+
+/// @brief Where a variable lives in the frame of the function body,
+/// closure body or program that declares it. Filled in by the resolver.
+struct Slot {
+    /// @brief The body this slot belongs to, nullptr if unresolved
+    const void *m_frame = nullptr;
+    int m_index = -1;
+};
+
+/// @brief How many times in a row a node must see the same operand
+/// types before it switches to the specialised variant for them.
+#define QUICKEN_AFTER 2
+
+/// @brief How many failed guards a node tolerates before it stays generic.
+#define QUICKEN_MAX_DEOPTS 4
+
+/// @brief Type feedback of a node in the tree walker. `K` is the
+/// enum of the node's variants and must have a `Generic` entry.
+template <typename K>
+struct Quickening {
+    K m_kind = K::Generic;
+
+    /// @brief Record the variant that fits the operands just seen
+    inline void observe(K kind) {
+        if (m_deopts >= QUICKEN_MAX_DEOPTS)
+            return;
+        if (kind != m_seen) {
+            m_seen = kind;
+            m_count = 0;
+        }
+        if (kind != K::Generic && ++m_count >= QUICKEN_AFTER)
+            m_kind = kind;
+    }
+
+    /// @brief Go back to the generic path after a guard failed
+    inline void deopt(void) {
+        m_kind = m_seen = K::Generic;
+        m_count = 0;
+        ++m_deopts;
+    }
+
+private:
+    K m_seen = K::Generic;
+    uint8_t m_count = 0;
+    uint8_t m_deopts = 0;
+};
+
+/// @brief The state of a loop for the JIT (`--jit`)
+struct JitSite {
+    /// @brief Iterations the interpreter ran since the last bailout
+    uint32_t m_hits = 0;
+    /// @brief The compiled loop, nullptr until it is hot
+    std::shared_ptr<JIT::Region> m_region;
+};
+
 struct __Type {
     std::shared_ptr<Token> m_main_ty;
     std::optional<std::shared_ptr<Token>> m_sub_ty;
+    /// @brief One bit per `earl::value::Type` accepted by this annotation,
+    /// 0 for class names which are checked by id.
+    uint64_t m_mask;
 
     __Type(std::shared_ptr<Token> main_ty, std::optional<std::shared_ptr<Token>> sub_ty);
 };
 
+/// @brief Makes the AST nodes that are created on this thread go
+/// into `arena` for as long as it lives. Without one, nodes are
+/// allocated on the heap.
+struct AstArena {
+    AstArena(Arena *arena);
+    ~AstArena();
+
+    AstArena(const AstArena &other) = delete;
+
+    /// @brief The arena that was in use before this one
+    Arena *m_prev;
+
+    /// @brief Allocate `bytes` for a node, see `Expr::operator new`
+    static void *alloc(size_t bytes);
+
+    /// @brief Free a node, which only gives heap nodes back
+    static void free(void *node);
+};
+
 /// @brief Base class for an expression
 struct Expr {
     virtual ~Expr() = default;
 
+    static void *operator new(size_t bytes) { return AstArena::alloc(bytes); }
+    static void operator delete(void *node) { AstArena::free(node); }
+
     /// @brief The get expression type
     /// @returns The type of the expression
     virtual ExprType get_type() const = 0;
@@ -142,6 +257,9 @@ struct ExprArrayAccess : public ExprTerm {
     std::unique_ptr<Expr> m_expr;
     std::shared_ptr<Token> m_tok;
 
+    enum class Quick { Generic, ListInt };
+    Quickening<Quick> m_quick;
+
     ExprArrayAccess(std::unique_ptr<Expr> left, std::unique_ptr<Expr> expr, std::shared_ptr<Token> tok);
     ExprType get_type() const override;
     ExprTermType get_term_type() const override;
@@ -152,6 +270,9 @@ struct ExprIdent : public ExprTerm {
     /// @brief The token of the identifier
     std::shared_ptr<Token> m_tok;
 
+    /// @brief The local variable this identifier refers to (if resolved)
+    Slot m_slot;
+
     ExprIdent(std::shared_ptr<Token> tok);
     ExprType get_type() const override;
     ExprTermType get_term_type() const override;
@@ -162,6 +283,13 @@ struct ExprGet : public ExprTerm {
     std::variant<std::unique_ptr<ExprIdent>, std::unique_ptr<ExprFuncCall>> m_right;
     std::shared_ptr<Token> m_tok;
 
+    /// @brief `ClassSlot` reads a member of a class instance straight
+    /// from its slot, for instances of `m_desc` only.
+    enum class Quick { Generic, ClassSlot };
+    Quickening<Quick> m_quick;
+    ClassDesc *m_desc = nullptr;
+    int m_slot = -1;
+
     ExprGet(std::unique_ptr<Expr> left,
             std::variant<std::unique_ptr<ExprIdent>, std::unique_ptr<ExprFuncCall>> right,
             std::shared_ptr<Token> tok);
@@ -186,7 +314,10 @@ struct ExprIntLit : public ExprTerm {
     /// @brief The token of the integer literal
     std::shared_ptr<Token> m_tok;
 
-    ExprIntLit(std::shared_ptr<Token> tok);
+    /// @brief The decoded value (from the ConstPool)
+    std::shared_ptr<earl::value::Obj> m_value;
+
+    ExprIntLit(std::shared_ptr<Token> tok, std::shared_ptr<earl::value::Obj> value);
     ExprType get_type() const override;
     ExprTermType get_term_type() const override;
 };
@@ -196,7 +327,10 @@ struct ExprFloatLit : public ExprTerm {
     /// @brief The token of the integer literal
     std::shared_ptr<Token> m_tok;
 
-    ExprFloatLit(std::shared_ptr<Token> tok);
+    /// @brief The decoded value (from the ConstPool)
+    std::shared_ptr<earl::value::Obj> m_value;
+
+    ExprFloatLit(std::shared_ptr<Token> tok, std::shared_ptr<earl::value::Obj> value);
     ExprType get_type() const override;
     ExprTermType get_term_type() const override;
 };
@@ -206,7 +340,10 @@ struct ExprStrLit : public ExprTerm {
     /// @brief The token of the string literal
     std::shared_ptr<Token> m_tok;
 
-    ExprStrLit(std::shared_ptr<Token> tok);
+    /// @brief The decoded value (from the ConstPool)
+    std::shared_ptr<earl::value::Obj> m_value;
+
+    ExprStrLit(std::shared_ptr<Token> tok, std::shared_ptr<earl::value::Obj> value);
     ExprType get_type() const override;
     ExprTermType get_term_type() const override;
 };
@@ -214,7 +351,10 @@ struct ExprStrLit : public ExprTerm {
 struct ExprFStr : public ExprTerm {
     std::shared_ptr<Token> m_tok;
 
-    ExprFStr(std::shared_ptr<Token> tok);
+    /// @brief The text and the `{expr}`s of the string, in order
+    std::vector<std::variant<std::string, std::unique_ptr<Expr>>> m_parts;
+
+    ExprFStr(std::shared_ptr<Token> tok, std::vector<std::variant<std::string, std::unique_ptr<Expr>>> parts);
     ExprType get_type() const override;
     ExprTermType get_term_type() const override;
 };
@@ -222,7 +362,10 @@ struct ExprFStr : public ExprTerm {
 struct ExprCharLit : public ExprTerm {
     std::shared_ptr<Token> m_tok;
 
-    ExprCharLit(std::shared_ptr<Token> tok);
+    /// @brief The decoded value (from the ConstPool)
+    std::shared_ptr<earl::value::Obj> m_value;
+
+    ExprCharLit(std::shared_ptr<Token> tok, std::shared_ptr<earl::value::Obj> value);
     ExprType get_type() const override;
     ExprTermType get_term_type() const override;
 };
@@ -232,7 +375,10 @@ struct ExprBool : public ExprTerm {
     std::shared_ptr<Token> m_tok;
     bool m_value;
 
-    ExprBool(std::shared_ptr<Token> tok, bool value);
+    /// @brief The decoded value (from the ConstPool)
+    std::shared_ptr<earl::value::Obj> m_constant;
+
+    ExprBool(std::shared_ptr<Token> tok, bool value, std::shared_ptr<earl::value::Obj> constant);
     ExprType get_type() const override;
     ExprTermType get_term_type() const override;
 };
@@ -270,6 +416,29 @@ struct ExprFuncCall : public ExprTerm {
 
     std::shared_ptr<Token> m_tok;
 
+    /// @brief What the callee is, found on the first evaluation
+    enum class Bind {
+        Unbound,
+        Intrinsic,
+        MemberIntrinsic,
+        Other,
+    };
+
+    Bind m_bind = Bind::Unbound;
+
+    /// @brief The function of an `Intrinsic` (see Intrinsics::IntrinsicFunction)
+    std::shared_ptr<earl::value::Obj> (*m_intrinsic)(std::vector<std::shared_ptr<earl::value::Obj>>&,
+                                                     std::shared_ptr<Ctx>&,
+                                                     Expr *) = nullptr;
+
+    /// @brief The function of a `MemberIntrinsic` for receivers of the type
+    /// `m_member_ty` (see Intrinsics::IntrinsicMemberFunction)
+    std::shared_ptr<earl::value::Obj> (*m_member)(std::shared_ptr<earl::value::Obj>,
+                                                  std::vector<std::shared_ptr<earl::value::Obj>>&,
+                                                  std::shared_ptr<Ctx>&,
+                                                  Expr *) = nullptr;
+    int m_member_ty = -1;
+
     ExprFuncCall(std::unique_ptr<Expr> id, std::vector<std::unique_ptr<Expr>> params, std::shared_ptr<Token> tok);
     ExprType get_type() const override;
     ExprTermType get_term_type() const override;
@@ -326,6 +495,9 @@ struct ExprBinary : public Expr {
     /// @brief The expression of the right hand side
     std::unique_ptr<Expr> m_rhs;
 
+    enum class Quick { Generic, Int, Float };
+    Quickening<Quick> m_quick;
+
     ExprBinary(std::unique_ptr<Expr> lhs, std::shared_ptr<Token> op, std::unique_ptr<Expr> rhs);
     ExprType get_type() const override;
 };
@@ -334,6 +506,9 @@ struct ExprBinary : public Expr {
 struct Stmt {
     virtual ~Stmt() = default;
 
+    static void *operator new(size_t bytes) { return AstArena::alloc(bytes); }
+    static void operator delete(void *node) { AstArena::free(node); }
+
     /// @brief Get the statement type
     /// @returns The type of the statement
     virtual StmtType stmt_type() const = 0;
@@ -363,6 +538,9 @@ struct StmtDef : public Stmt {
 
     uint32_t m_attrs;
 
+    /// @brief The results of previous calls (only if this is `@memo`)
+    std::shared_ptr<Memo::Cache> m_memo;
+
     StmtDef(std::shared_ptr<Token> id,
             std::vector<std::pair<std::pair<std::shared_ptr<Token>, std::optional<std::shared_ptr<__Type>>>, uint32_t>> args,
             std::optional<std::shared_ptr<__Type>> ty,
@@ -384,6 +562,9 @@ struct StmtLet : public Stmt {
 
     uint32_t m_attrs;
 
+    /// @brief The frame slots of the declared variables (if resolved)
+    std::vector<Slot> m_slots;
+
     StmtLet(std::vector<std::shared_ptr<Token>> ids, std::vector<std::shared_ptr<__Type>> tys, std::unique_ptr<Expr> expr, uint32_t attrs);
     StmtType stmt_type() const override;
 };
@@ -393,6 +574,13 @@ struct StmtBlock : public Stmt {
     /// @brief A vector of statements that is in the block
     std::vector<std::unique_ptr<Stmt>> m_stmts;
 
+    /// @brief The bytecode of this block (only compiled when using `--vm`)
+    std::shared_ptr<VM::Chunk> m_chunk;
+
+    /// @brief The number of frame slots needed if this is the
+    /// body of a function or closure
+    size_t m_frame_size = 0;
+
     StmtBlock(std::vector<std::unique_ptr<Stmt>> stmts);
     void add_stmt(std::unique_ptr<Stmt> stmt);
     StmtType stmt_type() const override;
@@ -447,6 +635,10 @@ struct StmtReturn : public Stmt {
 
     StmtReturn(std::optional<std::unique_ptr<Expr>> expr, std::shared_ptr<Token> tok);
     StmtType stmt_type() const override;
+
+    /// @brief Get the call if this is `return f(...)` (a possible
+    /// tail call), nullptr otherwise
+    ExprFuncCall *tail_call(void) const;
 };
 
 /// @brief The Statement Break class
@@ -471,6 +663,8 @@ struct StmtWhile : public Stmt {
     /// @brief The block of the while loop to loop
     std::unique_ptr<StmtBlock> m_block;
 
+    JitSite m_jit;
+
     StmtWhile(std::unique_ptr<Expr> expr, std::unique_ptr<StmtBlock> block);
     StmtType stmt_type() const override;
 };
@@ -479,6 +673,8 @@ struct StmtLoop : public Stmt {
     std::shared_ptr<Token> m_tok;
     std::unique_ptr<StmtBlock> m_block;
 
+    JitSite m_jit;
+
     StmtLoop(std::shared_ptr<Token> tok, std::unique_ptr<StmtBlock> block);
     StmtType stmt_type() const override;
 };
@@ -495,6 +691,9 @@ struct StmtForeach : public Stmt {
 
     uint32_t m_attrs;
 
+    /// @brief The frame slots of the enumerators (if resolved)
+    std::vector<Slot> m_slots;
+
     StmtForeach(std::vector<std::shared_ptr<Token>> enumerators,
                 std::unique_ptr<Expr> expr,
                 std::unique_ptr<StmtBlock> block,
@@ -516,6 +715,11 @@ struct StmtFor : public Stmt {
     /// @brief The block for the loop to execute
     std::unique_ptr<StmtBlock> m_block;
 
+    /// @brief The frame slot of the enumerator (if resolved)
+    Slot m_slot;
+
+    JitSite m_jit;
+
     StmtFor(std::shared_ptr<Token> enumerator,
             std::unique_ptr<Expr> start,
             std::unique_ptr<Expr> end,
@@ -555,6 +759,10 @@ struct StmtClass : public Stmt {
     std::vector<std::unique_ptr<StmtLet>> m_members;
     std::vector<std::unique_ptr<StmtDef>> m_methods;
 
+    /// @brief The methods and member layout shared by every
+    /// instance (built on the first instantiation)
+    std::shared_ptr<ClassDesc> m_desc;
+
     StmtClass(std::shared_ptr<Token> id,
               uint32_t attrs,
               std::vector<std::pair<std::shared_ptr<Token>, std::optional<std::shared_ptr<__Type>>>> constructor_args,
@@ -579,8 +787,21 @@ struct StmtMatch : public Stmt {
         std::unique_ptr<StmtBlock> m_block;
     };
 
+    /// @brief Where the constant patterns (literals and enum entries)
+    /// of unguarded branches jump to. Built on the first evaluation.
+    struct JumpTable {
+        std::unordered_map<int, size_t> m_ints;
+        std::unordered_map<char, size_t> m_chars;
+        std::unordered_map<std::string, size_t> m_strs;
+        std::unordered_map<bool, size_t> m_bools;
+
+        /// @brief The branches that still have to be tried in order
+        std::vector<size_t> m_rest;
+    };
+
     std::unique_ptr<Expr> m_expr;
     std::vector<std::unique_ptr<Branch>> m_branches;
+    std::unique_ptr<JumpTable> m_table;
 
     StmtMatch(std::unique_ptr<Expr> expr, std::vector<std::unique_ptr<Branch>> branches);
     StmtType stmt_type() const override;
@@ -601,11 +822,22 @@ struct StmtEnum : public Stmt {
 /// @brief The Program class. It is the starting point
 /// of the whole program.
 struct Program {
+    /// @brief Where the nodes of the program live. It is
+    /// destroyed last so that the nodes can still be destructed.
+    std::unique_ptr<Arena> m_arena;
+
     /// @brief A vector of statement to evaluate
     std::vector<std::unique_ptr<Stmt>> m_stmts;
     const std::string m_filepath;
 
-    Program(std::vector<std::unique_ptr<Stmt>> stmts, const std::string filepath);
+    /// @brief The number of frame slots needed for the @world variables
+    size_t m_frame_size = 0;
+
+    /// @brief The decoded literals of the program
+    std::unique_ptr<ConstPool> m_consts;
+
+    Program(std::vector<std::unique_ptr<Stmt>> stmts, const std::string filepath,
+            std::unique_ptr<ConstPool> consts, std::unique_ptr<Arena> arena);
 };
 
 #endif // AST_H
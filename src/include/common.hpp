@@ -44,6 +44,13 @@ extern uint32_t flags;
 #define __SHOWFUNS 1 << 4
 #define __CHECK 1 << 5
 #define __TOPY 1 << 6
+#define __VM 1 << 7
+#define __O1 1 << 8
+#define __SHOWPASSES 1 << 9
+#define __JIT 1 << 10
+#define __JITSTATS 1 << 11
+#define __TOCPP 1 << 12
+#define __NOCACHE 1 << 13
 
 #define COMMON_EARL2ARG_HELP           "help"
 #define COMMON_EARL2ARG_WITHOUT_STDLIB "without-stdlib"
@@ -53,24 +60,33 @@ extern uint32_t flags;
 #define COMMON_EARL2ARG_SHOWFUNS       "show-funs"
 #define COMMON_EARL2ARG_CHECK          "check"
 #define COMMON_EARL2ARG_TOPY           "to-py"
+#define COMMON_EARL2ARG_VM             "vm"
+#define COMMON_EARL2ARG_SHOWPASSES     "show-passes"
+#define COMMON_EARL2ARG_JIT            "jit"
+#define COMMON_EARL2ARG_JITSTATS       "jit-stats"
+#define COMMON_EARL2ARG_TOCPP          "to-cpp"
+#define COMMON_EARL2ARG_NOCACHE        "no-cache"
 
-#define COMMON_EARL2ARG_ASCPL {COMMON_EARL2ARG_HELP, COMMON_EARL2ARG_WITHOUT_STDLIB, COMMON_EARL2ARG_VERSION, COMMON_EARL2ARG_REPL_NOCOLOR, COMMON_EARL2ARG_WATCH, COMMON_EARL2ARG_SHOWFUNS, COMMON_EARL2ARG_CHECK}
+#define COMMON_EARL2ARG_ASCPL {COMMON_EARL2ARG_HELP, COMMON_EARL2ARG_WITHOUT_STDLIB, COMMON_EARL2ARG_VERSION, COMMON_EARL2ARG_REPL_NOCOLOR, COMMON_EARL2ARG_WATCH, COMMON_EARL2ARG_SHOWFUNS, COMMON_EARL2ARG_CHECK, COMMON_EARL2ARG_VM, COMMON_EARL2ARG_SHOWPASSES, COMMON_EARL2ARG_JIT, COMMON_EARL2ARG_JITSTATS, COMMON_EARL2ARG_TOCPP, COMMON_EARL2ARG_NOCACHE}
 
 #define COMMON_EARL1ARG_HELP     'h'
 #define COMMON_EARL1ARG_VERSION  'v'
 #define COMMON_EARL1ARG_CHECK    'c'
 #define COMMON_EARL1ARG_WATCH    'w'
+#define COMMON_EARL1ARG_OPTIMIZE 'O'
 
 #define COMMON_EARLATTR_WORLD "world"
 #define COMMON_EARLATTR_PUB   "pub"
 #define COMMON_EARLATTR_REF   "ref"
 #define COMMON_EARLATTR_CONST "const"
+#define COMMON_EARLATTR_MEMO  "memo"
 
 enum class Attr {
     World = 1 << 0,
     Pub = 1 << 1,
     Ref = 1 << 2,
     Const = 1 << 3,
+    Memo = 1 << 4,
 };
 
 // Keywords
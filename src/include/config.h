@@ -0,0 +1,4 @@
+#pragma once
+
+#define PREFIX "/usr/local"
+#define VERSION "0.6.1"
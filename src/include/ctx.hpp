@@ -31,6 +31,7 @@
 #ifndef CTX_H
 #define CTX_H
 
+#include <cassert>
 #include <vector>
 #include <unordered_map>
 
@@ -39,6 +40,9 @@
 #include "earl.hpp"
 #include "shared-scope.hpp"
 
+// How many finished function/closure contexts are kept for reuse.
+#define CTX_POOL_CAP 256
+
 enum class CtxType {
     World,
     Function,
@@ -48,6 +52,64 @@ enum class CtxType {
 
 struct WorldCtx;
 
+/// @brief Flat storage for the variables of a function body, closure
+/// body or program. Slots are handed out ahead of time by the resolver
+/// (see resolver.hpp) and are only valid for the body they were resolved
+/// against, everything else goes through the string keyed scopes.
+struct Frame {
+    const void *m_owner = nullptr;
+    std::vector<std::shared_ptr<earl::variable::Obj>> m_vars;
+
+    inline void init(const void *owner, size_t size) {
+        m_owner = owner;
+        m_vars.assign(size, nullptr);
+    }
+
+    /// @brief Whether `slot` belongs to this frame. A slot past the
+    /// end means the frame was sized for another resolve, so it is
+    /// caught in debug builds and left to the scopes otherwise.
+    inline bool owns(const Slot &slot) const {
+        if (!slot.m_frame || slot.m_frame != m_owner)
+            return false;
+        assert(static_cast<size_t>(slot.m_index) < m_vars.size());
+        return static_cast<size_t>(slot.m_index) < m_vars.size();
+    }
+
+    inline void set(const Slot &slot, const std::shared_ptr<earl::variable::Obj> &var) {
+        if (owns(slot))
+            m_vars[slot.m_index] = var;
+    }
+
+    inline earl::variable::Obj *get(const Slot &slot) {
+        if (owns(slot))
+            return m_vars[slot.m_index].get();
+        return nullptr;
+    }
+
+    /// @brief Drop the variables but keep the storage
+    inline void clear(void) {
+        m_owner = nullptr;
+        m_vars.clear();
+    }
+};
+
+/// @brief What every instance of a class has in common. The methods
+/// are only created once and each member `let` is given a slot so
+/// that instances only need to hold the member variables themselves.
+struct ClassDesc {
+    std::unordered_map<std::string, std::shared_ptr<earl::function::Obj>> m_methods;
+    std::unordered_map<std::string, size_t> m_slots;
+    /// @brief The member ids in declaration order
+    std::vector<std::string> m_ids;
+    bool m_has_constructor = false;
+
+    /// @brief Get the slot of the member `id` or -1
+    inline int slot(const std::string &id) const {
+        auto it = m_slots.find(id);
+        return it == m_slots.end() ? -1 : static_cast<int>(it->second);
+    }
+};
+
 struct Ctx {
     virtual ~Ctx() = default;
 
@@ -68,9 +130,19 @@ struct Ctx {
 
     SharedScope<std::string, earl::variable::Obj> m_scope;
     SharedScope<std::string, earl::function::Obj> m_funcs;
+    Frame m_frame;
 };
 
 struct WorldCtx : public Ctx {
+    /// @brief A module as seen by one importer. The module itself is
+    /// shared by every importer (see Interpreter::eval_stmt_import).
+    struct Import {
+        std::shared_ptr<Ctx> m_ctx;
+        std::optional<std::string> m_alias;
+        /// @brief COMMON_DEPTH_FULL or COMMON_DEPTH_ALMOST (no functions or classes)
+        uint32_t m_depth;
+    };
+
     WorldCtx(std::unique_ptr<Lexer> lexer, std::unique_ptr<Program> program);
     WorldCtx();
     ~WorldCtx() = default;
@@ -79,8 +151,8 @@ struct WorldCtx : public Ctx {
     Stmt *stmt_at(size_t idx);
     void set_mod(std::string id);
     const std::string &get_mod(void) const;
-    void add_import(std::shared_ptr<Ctx> ctx);
-    std::shared_ptr<Ctx> *get_import(const std::string &id);
+    void add_import(std::shared_ptr<Ctx> ctx, std::optional<std::string> alias, uint32_t depth);
+    Import *get_import(const std::string &id);
     bool import_is_defined(const std::string &id);
     void define_class(StmtClass *klass);
     bool class_is_defined(const std::string &id) const;
@@ -89,7 +161,6 @@ struct WorldCtx : public Ctx {
     void debug_dump_variables(void) const;
     bool enum_exists(const std::string &id) const;
     std::shared_ptr<earl::value::Enum> enum_get(const std::string &id);
-    void strip_funs_and_classes(void);
 
     CtxType type(void) const override;
     void push_scope(void) override;
@@ -107,9 +178,6 @@ struct WorldCtx : public Ctx {
     std::vector<std::string> get_available_function_names(void) override; // for errors
     std::vector<std::string> get_available_variable_names(void) override; // for errors
     std::string get_filepath(void) const;
-    void set_module_alias(const std::string &id);
-    bool has_module_alias(void) const;
-    const std::string &get_module_alias(void) const;
 
     // REPL
     void add_repl_lexer(std::unique_ptr<Lexer> lexer);
@@ -119,13 +187,12 @@ struct WorldCtx : public Ctx {
 
 private:
     std::string m_mod;
-    std::vector<std::shared_ptr<Ctx>> m_imports;
+    std::vector<Import> m_imports;
     std::unique_ptr<Lexer> m_lexer;
     std::unique_ptr<Program> m_program;
     std::unordered_map<std::string, StmtClass *> m_defined_classes;
     std::unordered_map<std::string, std::shared_ptr<earl::value::Enum>> m_enums;
     std::string m_filepath;
-    std::optional<std::string> m_module_alias;
 
     // REPL
     std::vector<std::unique_ptr<Lexer>> m_repl_lexers;
@@ -136,9 +203,17 @@ struct FunctionCtx : public Ctx {
     FunctionCtx(std::shared_ptr<Ctx> owner, uint32_t attrs);
     ~FunctionCtx() = default;
 
+    /// @brief Get a context for a new call, reusing a released one if possible
+    static std::shared_ptr<FunctionCtx> acquire(std::shared_ptr<Ctx> owner, uint32_t attrs);
+
+    /// @brief Give back the context of a finished call. It is only
+    /// reused if nothing else (e.g. a closure) still holds on to it.
+    static void release(std::shared_ptr<FunctionCtx> &ctx);
+
     bool in_class(void) const;
     std::shared_ptr<Ctx> &get_outer_class_owner_ctx(void);
     std::shared_ptr<Ctx> &get_owner(void);
+    std::shared_ptr<Ctx> &get_immediate_owner(void);
     std::shared_ptr<Ctx> &get_outer_world_owner(void);
     void debug_dump_variables(void) const;
 
@@ -161,11 +236,18 @@ struct FunctionCtx : public Ctx {
     void set_curfunc(const std::string &id);
     const std::string &get_curfuncid(void);
 
+    // Set by `return f(...)` so that the caller makes the call once
+    // this frame is finished instead of nesting it.
+    std::shared_ptr<earl::function::Obj> m_tail_func;
+    std::vector<std::shared_ptr<earl::value::Obj>> m_tail_params;
+
 private:
+    void set_owner(std::shared_ptr<Ctx> owner, uint32_t attrs);
+
     std::shared_ptr<Ctx> m_owner; // The MAIN owner
     std::shared_ptr<Ctx> m_immediate_owner;
     uint32_t m_attrs;
-    bool m_in_rec;
+    bool m_in_rec = false;
     std::string m_curfunc_id;
 };
 
@@ -173,6 +255,7 @@ struct ClassCtx : public Ctx {
     ClassCtx(std::shared_ptr<Ctx> owner);
     ClassCtx(std::shared_ptr<Ctx> owner, SharedScope<std::string, earl::variable::Obj> scope);
     ClassCtx(std::shared_ptr<Ctx> owner, SharedScope<std::string, earl::variable::Obj> scope, SharedScope<std::string, earl::function::Obj> funcs);
+    ClassCtx(std::shared_ptr<Ctx> owner, ClassDesc *desc);
     ~ClassCtx() = default;
 
     std::shared_ptr<Ctx> &get_owner(void);
@@ -186,6 +269,12 @@ struct ClassCtx : public Ctx {
     std::shared_ptr<ClassCtx> shallow_copy(void);
     std::vector<std::shared_ptr<earl::variable::Obj>> get_printable_members(void);
 
+    /// @brief The member layout of this instance (nullptr if none)
+    inline ClassDesc *desc(void) const { return m_desc; }
+
+    /// @brief The member in `slot` of `desc()` (nullptr if unset)
+    inline earl::variable::Obj *member(size_t slot) const { return m_members[slot].get(); }
+
     CtxType type(void) const override;
     void push_scope(void) override;
     void pop_scope(void) override;
@@ -205,6 +294,12 @@ struct ClassCtx : public Ctx {
 private:
     std::shared_ptr<Ctx> m_owner;
 
+    // The shared methods and member layout (nullptr if this context
+    // was not made for a class instance). Members with a slot live in
+    // m_members, anything else in m_scope.
+    ClassDesc *m_desc = nullptr;
+    std::vector<std::shared_ptr<earl::variable::Obj>> m_members;
+
     // Used in the [x, y, ..., N] arguments when creating a new class.
     // This should only be available for the duration of eval_class_instantiation()
     // for the class members as well as providing visibility to the constructor().
@@ -216,6 +311,12 @@ struct ClosureCtx : public Ctx {
     ClosureCtx(std::shared_ptr<Ctx> owner);
     ~ClosureCtx() = default;
 
+    /// @brief Same as FunctionCtx::acquire
+    static std::shared_ptr<ClosureCtx> acquire(std::shared_ptr<Ctx> owner);
+
+    /// @brief Same as FunctionCtx::release
+    static void release(std::shared_ptr<ClosureCtx> &ctx);
+
     std::shared_ptr<Ctx> &get_owner(void);
     std::shared_ptr<Ctx> &get_outer_world_owner(void);
     void assert_variable_does_not_exist_for_recursive_cl(const std::string &id);
@@ -25,7 +25,10 @@
 #ifndef EARL_H
 #define EARL_H
 
+#include <cstddef>
+#include <iterator>
 #include <memory>
+#include <optional>
 #include <unordered_map>
 #include <string>
 #include <vector>
@@ -147,13 +150,42 @@ namespace earl {
         struct Obj;
         struct Char;
 
+        /// @brief The elements of a list made from `a..b` or `a..=b`.
+        /// They are kept as bounds until they are actually needed.
+        struct Range {
+            int m_start;
+            size_t m_size;
+            /// @brief Whether the elements are Char, otherwise Int
+            bool m_chars;
+
+            /// @brief Make the element at `idx`
+            std::shared_ptr<Obj> at(size_t idx) const;
+        };
+
+        /// @brief Iterates over a Range without materializing it
+        struct RangeIterator {
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = std::shared_ptr<Obj>;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = void;
+            using reference         = std::shared_ptr<Obj>;
+
+            Range m_range;
+            size_t m_at;
+
+            std::shared_ptr<Obj> operator*(void) const {return m_range.at(m_at);}
+            RangeIterator &operator++(void) {++m_at; return *this;}
+            bool operator==(const RangeIterator &other) const {return m_at == other.m_at;}
+            bool operator!=(const RangeIterator &other) const {return m_at != other.m_at;}
+        };
+
         using ListIterator      = std::vector<std::shared_ptr<Obj>>::iterator;
         using StrIterator       = std::vector<std::shared_ptr<Char>>::iterator;
         using DictIntIterator   = std::unordered_map<int, std::shared_ptr<Obj>>::iterator;
         using DictCharIterator  = std::unordered_map<char, std::shared_ptr<Obj>>::iterator;
         using DictFloatIterator = std::unordered_map<double, std::shared_ptr<Obj>>::iterator;
         using DictStrIterator   = std::unordered_map<std::string, std::shared_ptr<Obj>>::iterator;
-        using Iterator          = std::variant<ListIterator, StrIterator, DictIntIterator, DictCharIterator, DictFloatIterator, DictStrIterator>;
+        using Iterator          = std::variant<ListIterator, StrIterator, DictIntIterator, DictCharIterator, DictFloatIterator, DictStrIterator, RangeIterator>;
 
         /// @brief The base abstract class that all
         /// EARL values inherit from
@@ -236,11 +268,113 @@ namespace earl {
             virtual std::shared_ptr<Obj> bitwise(Token *op, Obj *other);
             virtual std::shared_ptr<Obj> bitshift(Token *op, Obj *other);
 
+            /// @brief Check if a copy of a container holding this value
+            /// can share it instead of copying it (see `Cow`)
+            virtual bool shareable(void);
+
         protected:
             bool m_const = false;
             bool m_iterable = false;
         };
 
+        inline std::string
+        cow_deep_copy(const std::string &value) {
+            return value;
+        }
+
+        inline std::vector<std::shared_ptr<Obj>>
+        cow_deep_copy(const std::vector<std::shared_ptr<Obj>> &values) {
+            std::vector<std::shared_ptr<Obj>> copy;
+            copy.reserve(values.size());
+            for (auto &value : values)
+                copy.push_back(value->copy());
+            return copy;
+        }
+
+        template <typename K> std::unordered_map<K, std::shared_ptr<Obj>>
+        cow_deep_copy(const std::unordered_map<K, std::shared_ptr<Obj>> &values) {
+            std::unordered_map<K, std::shared_ptr<Obj>> copy;
+            for (auto &pair : values)
+                copy[pair.first] = pair.second->copy();
+            return copy;
+        }
+
+        inline bool
+        cow_unreferenced(const std::string &value) {
+            (void)value;
+            return true;
+        }
+
+        inline bool
+        cow_unreferenced(const std::shared_ptr<Obj> &value) {
+            return value.use_count() == 1 && !value->is_const() && value->shareable();
+        }
+
+        inline bool
+        cow_unreferenced(const std::vector<std::shared_ptr<Obj>> &values) {
+            for (auto &value : values)
+                if (!cow_unreferenced(value))
+                    return false;
+            return true;
+        }
+
+        template <typename K> bool
+        cow_unreferenced(const std::unordered_map<K, std::shared_ptr<Obj>> &values) {
+            for (auto &pair : values)
+                if (!cow_unreferenced(pair.second))
+                    return false;
+            return true;
+        }
+
+        /// @brief Copy-on-write storage for List, Tuple, Dict and Str.
+        /// Copies share the same buffer until one of them writes to
+        /// it. Use `get` for reading, `mut` before changing the container
+        /// and `leak` before handing out (or taking in) element references
+        /// as those could be held onto and mutated later.
+        template <typename T>
+        struct Cow {
+            Cow(T value = T(), bool deep = true)
+                : m_buf(std::make_shared<T>(std::move(value))), m_deep(deep) {}
+
+            const T &get(void) const {
+                return *m_buf;
+            }
+
+            T &mut(void) {
+                if (m_buf.use_count() > 1)
+                    m_buf = std::make_shared<T>(m_deep ? cow_deep_copy(*m_buf) : *m_buf);
+                return *m_buf;
+            }
+
+            T &leak(void) {
+                m_leaked = true;
+                return this->mut();
+            }
+
+            /// @brief Check if a copy can share the buffer, i.e. no
+            /// element can be reached from outside of the container
+            bool shareable(void) {
+                if (m_leaked && !cow_unreferenced(*m_buf))
+                    return false;
+                m_leaked = false;
+                return true;
+            }
+
+            /// @brief Get a copy that shares the buffer
+            Cow share(void) const {
+                Cow cow(*this);
+                cow.m_leaked = false;
+                return cow;
+            }
+
+        private:
+            std::shared_ptr<T> m_buf;
+            bool m_deep;
+
+            // Values coming from the outside may be referenced elsewhere.
+            bool m_leaked = true;
+        };
+
         struct TypeKW : public Obj {
             TypeKW(Type ty);
 
@@ -378,7 +512,11 @@ namespace earl {
         struct Void : public Obj {
             Void() = default;
 
+            /// @brief The shared unit value (it carries no data)
+            static std::shared_ptr<Obj> instance(void);
+
             // Implements
+            void set_const(void)                                                          override;
             Type type(void) const                                                         override;
             std::shared_ptr<Obj> binop(Token *op, Obj *other)                             override;
             bool boolean(void)                                                            override;
@@ -416,10 +554,18 @@ namespace earl {
         /// list = [int, str, str, int, list[int, str]]
         struct List : public Obj {
             List(std::vector<std::shared_ptr<Obj>> value = {});
+            List(Cow<std::vector<std::shared_ptr<Obj>>> value);
+            List(Range range);
 
             /// @brief Get the underlying list value
             std::vector<std::shared_ptr<Obj>> &value(void);
 
+            /// @brief Get the underlying list value for reading only
+            const std::vector<std::shared_ptr<Obj>> &elems(void) const;
+
+            /// @brief Get the number of elements (without materializing a range)
+            size_t size(void) const;
+
             /// @brief Get a sublist of the vector from `start` to `finish`
             std::vector<std::shared_ptr<Obj>> slice(Obj *start, Obj *end, Expr *expr);
 
@@ -427,12 +573,17 @@ namespace earl {
             /// @note This is called from the intrinsic `nth` member function
             /// @param idx The object that contains the index
             /// @note `idx` MUST BE an integer value
-            std::shared_ptr<Obj> nth(std::shared_ptr<Obj> &idx, Expr *expr);
+            /// @param ref Whether the element may be mutated through the
+            /// result. A range is only materialized if so.
+            std::shared_ptr<Obj> nth(std::shared_ptr<Obj> &idx, Expr *expr, bool ref = true);
+
+            /// @brief Same as `nth` with an index that is known to be in range
+            std::shared_ptr<Obj> at(size_t idx, bool ref = true);
 
             /// @brief Reverse a list
             std::shared_ptr<List> rev(void);
             void append_copy(std::shared_ptr<Obj> value);
-            void append_copy(std::vector<std::shared_ptr<Obj>> &values);
+            void append_copy(const std::vector<std::shared_ptr<Obj>> &values);
 
             /// @brief Append a list of values to a list
             /// @param values The values to append
@@ -462,9 +613,16 @@ namespace earl {
             void iter_next(Iterator &it)                                                  override;
             std::shared_ptr<Obj> add(Token *op, Obj *other)                               override;
             std::shared_ptr<Obj> equality(Token *op, Obj *other)                          override;
+            bool shareable(void)                                                          override;
 
         private:
-            std::vector<std::shared_ptr<Obj>> m_value;
+            /// @brief Turn a range into actual elements
+            void materialize(void) const;
+
+            mutable Cow<std::vector<std::shared_ptr<Obj>>> m_value;
+
+            /// @brief Set while the list is still a lazy range
+            mutable std::optional<Range> m_range;
         };
 
         struct Slice : public Obj {
@@ -487,8 +645,10 @@ namespace earl {
 
         struct Tuple : public Obj {
             Tuple(std::vector<std::shared_ptr<Obj>> values = {});
+            Tuple(Cow<std::vector<std::shared_ptr<Obj>>> values);
 
             std::vector<std::shared_ptr<Obj>> &value(void);
+            const std::vector<std::shared_ptr<Obj>> &elems(void) const;
             std::shared_ptr<Obj> nth(Obj *idx, Expr *expr);
             std::shared_ptr<Obj> back(void);
             std::shared_ptr<Tuple> filter(Obj *closure, std::shared_ptr<Ctx> &ctx);
@@ -508,9 +668,10 @@ namespace earl {
             void iter_next(Iterator &it)                                                  override;
             std::shared_ptr<Obj> add(Token *op, Obj *other)                               override;
             std::shared_ptr<Obj> equality(Token *op, Obj *other)                          override;
+            bool shareable(void)                                                          override;
 
         private:
-            std::vector<std::shared_ptr<Obj>> m_values;
+            Cow<std::vector<std::shared_ptr<Obj>>> m_values;
         };
 
         struct Time : public Obj {
@@ -543,6 +704,7 @@ namespace earl {
         /// @brief The structure that represents EARL strings
         struct Str : public Obj {
             Str(std::string value = "");
+            Str(Cow<std::string> value);
             Str(std::vector<std::shared_ptr<Char>> chars);
 
             std::string value(void);
@@ -577,9 +739,13 @@ namespace earl {
             void iter_next(Iterator &it)                                                  override;
             std::shared_ptr<Obj> add(Token *op, Obj *other)                               override;
             std::shared_ptr<Obj> equality(Token *op, Obj *other)                          override;
+            bool shareable(void)                                                          override;
 
         private:
-            std::string m_value;
+            /// @brief Get the chars handed out so far, sized to the str
+            std::vector<std::shared_ptr<Char>> &chars(void);
+
+            Cow<std::string> m_value;
             std::vector<std::shared_ptr<Char>> m_chars;
             std::vector<unsigned> m_changed;
         };
@@ -631,6 +797,7 @@ namespace earl {
         template <typename T>
         struct Dict : public Obj {
             Dict(Type kty);
+            Dict(Type kty, Cow<std::unordered_map<T, std::shared_ptr<Obj>>> map);
 
             void insert(T key, std::shared_ptr<Obj> value);
             Type ktype(void) const;
@@ -648,9 +815,10 @@ namespace earl {
             Iterator iter_begin(void)                                                     override;
             Iterator iter_end(void)                                                       override;
             void iter_next(Iterator &it)                                                  override;
+            bool shareable(void)                                                          override;
 
         private:
-            std::unordered_map<T, std::shared_ptr<Obj>> m_map;
+            Cow<std::unordered_map<T, std::shared_ptr<Obj>>> m_map;
             Type m_kty;
         };
 
@@ -735,6 +903,9 @@ namespace earl {
         struct Break : public Obj {
             Break() = default;
 
+            /// @brief The shared `break` signal
+            static std::shared_ptr<Obj> instance(void);
+
             // Implements
             Type type(void) const                                                         override;
         };
@@ -742,6 +913,9 @@ namespace earl {
         struct Continue : public Obj {
             Continue() = default;
 
+            /// @brief The shared `continue` signal
+            static std::shared_ptr<Obj> instance(void);
+
             // Implements
             Type type(void) const                                                         override;
         };
@@ -749,6 +923,9 @@ namespace earl {
         struct Return : public Obj {
             Return() = default;
 
+            /// @brief The shared signal for a `return` without a value
+            static std::shared_ptr<Obj> instance(void);
+
             // Implements
             Type type(void) const                                                         override;
             std::shared_ptr<Obj> copy(void)                                               override;
@@ -857,9 +1034,16 @@ earl::value::Dict<T>::Dict::Dict(earl::value::Type kty) {
     m_iterable = true;
 }
 
+template <typename T>
+earl::value::Dict<T>::Dict::Dict(earl::value::Type kty, Cow<std::unordered_map<T, std::shared_ptr<Obj>>> map)
+    : m_map(std::move(map)) {
+    m_kty = kty;
+    m_iterable = true;
+}
+
 template <typename T> void
 earl::value::Dict<T>::insert(T key, std::shared_ptr<earl::value::Obj> value) {
-    m_map[key] = value;
+    m_map.leak()[key] = value;
 }
 
 template <typename T> earl::value::Type
@@ -869,6 +1053,7 @@ earl::value::Dict<T>::ktype(void) const {
 
 template <typename T> std::shared_ptr<earl::value::Obj>
 earl::value::Dict<T>::nth(earl::value::Obj *key, Expr *expr) {
+    auto &map = m_map.leak();
     if constexpr (std::is_same_v<T, int>) {
         if (key->type() != earl::value::Type::Int) {
             Err::err_wexpr(expr);
@@ -876,8 +1061,8 @@ earl::value::Dict<T>::nth(earl::value::Obj *key, Expr *expr) {
             throw InterpreterException(msg);
         }
         int k = dynamic_cast<earl::value::Int *>(key)->value();
-        auto value = m_map.find(k);
-        if (value == m_map.end())
+        auto value = map.find(k);
+        if (value == map.end())
             return std::make_shared<earl::value::Option>();
         return std::make_shared<earl::value::Option>(value->second);
     }
@@ -888,8 +1073,8 @@ earl::value::Dict<T>::nth(earl::value::Obj *key, Expr *expr) {
             throw InterpreterException(msg);
         }
         std::string k = dynamic_cast<earl::value::Str *>(key)->value();
-        auto value = m_map.find(k);
-        if (value == m_map.end())
+        auto value = map.find(k);
+        if (value == map.end())
             return std::make_shared<earl::value::Option>();
         return std::make_shared<earl::value::Option>(value->second);
     }
@@ -900,8 +1085,8 @@ earl::value::Dict<T>::nth(earl::value::Obj *key, Expr *expr) {
             throw InterpreterException(msg);
         }
         double k = dynamic_cast<earl::value::Float *>(key)->value();
-        auto value = m_map.find(k);
-        if (value == m_map.end())
+        auto value = map.find(k);
+        if (value == map.end())
             return std::make_shared<earl::value::Option>();
         return std::make_shared<earl::value::Option>(value->second);
     }
@@ -912,8 +1097,8 @@ earl::value::Dict<T>::nth(earl::value::Obj *key, Expr *expr) {
             throw InterpreterException(msg);
         }
         char k = dynamic_cast<earl::value::Char *>(key)->value();
-        auto value = m_map.find(k);
-        if (value == m_map.end())
+        auto value = map.find(k);
+        if (value == map.end())
             return std::make_shared<earl::value::Option>();
         return std::make_shared<earl::value::Option>(value->second);
     }
@@ -923,17 +1108,17 @@ earl::value::Dict<T>::nth(earl::value::Obj *key, Expr *expr) {
 
 template <typename T> std::unordered_map<T, std::shared_ptr<earl::value::Obj>> &
 earl::value::Dict<T>::extract(void) {
-    return m_map;
+    return m_map.leak();
 }
 
 template <typename T> bool
 earl::value::Dict<T>::has_key(T key) const {
-    return m_map.find(key) != m_map.end();
+    return m_map.get().find(key) != m_map.get().end();
 }
 
 template <typename T> bool
 earl::value::Dict<T>::has_value(earl::value::Obj *value) const {
-    for (auto &pair : m_map)
+    for (auto &pair : m_map.get())
         if (pair.second->eq(value))
             return true;
     return false;
@@ -959,8 +1144,10 @@ earl::value::Dict<T>::mutate(earl::value::Obj *other, StmtMut *stmt) {
 
 template <typename T> std::shared_ptr<earl::value::Obj>
 earl::value::Dict<T>::copy(void) {
+    if (m_map.shareable())
+        return std::make_shared<Dict<T>>(m_kty, m_map.share());
     auto new_dict = std::make_shared<Dict<T>>(m_kty);
-    for (auto &pair : m_map)
+    for (auto &pair : m_map.get())
         new_dict->insert(pair.first, pair.second->copy());
     return new_dict;
 }
@@ -973,7 +1160,7 @@ earl::value::Dict<T>::eq(earl::value::Obj *other) {
 template <typename T> std::string
 earl::value::Dict<T>::to_cxxstring(void) {
     std::string res = "<" + earl::value::type_to_str(this->type()) + " { ";
-    auto map = this->extract();
+    auto &map = m_map.get();
     int i = 0;
     for (auto it = map.begin(); it != map.end(); ++it) {
         using Tx = std::decay_t<T>;
@@ -1003,7 +1190,7 @@ earl::value::Dict<T>::iter_begin(void) {
                   std::is_same_v<std::decay_t<T>, double> ||
                   std::is_same_v<std::decay_t<T>, char> ||
                   std::is_same_v<std::decay_t<T>, std::string>)
-        return m_map.begin();
+        return m_map.leak().begin();
     else
         static_assert("Dictionary Iterator: Unsupported BEGIN type");
     return {}; // unreachable
@@ -1015,7 +1202,7 @@ earl::value::Dict<T>::iter_end(void) {
                   std::is_same_v<std::decay_t<T>, double> ||
                   std::is_same_v<std::decay_t<T>, char> ||
                   std::is_same_v<std::decay_t<T>, std::string>)
-        return m_map.end();
+        return m_map.leak().end();
     else
         static_assert("Dictionary Iterator: Unsupported END type");
     return {}; // unreachable
@@ -1029,4 +1216,9 @@ earl::value::Dict<T>::iter_next(earl::value::Iterator &it) {
     }, it);
 }
 
+template <typename T> bool
+earl::value::Dict<T>::shareable(void) {
+    return m_map.shareable();
+}
+
 #endif // EARL_H
@@ -85,6 +85,9 @@ namespace Err {
     void err_wstmt(Stmt *stmt);
 
     void warn(std::string msg, Token *tok = nullptr);
+
+    /// @brief Do not print errors or warnings on the calling thread
+    void set_quiet(bool quiet);
 };
 
 /// \brief Prints a error message of type `errtype`
@@ -48,6 +48,8 @@ namespace Interpreter {
         FromStr = 1 << 11,
         FromEnum = 1 << 12,
         None = 1 << 13,
+        // A value from the ConstPool, it must be copied before it can escape.
+        Constant = 1 << 14,
     };
 
     struct ER {
@@ -70,6 +72,7 @@ namespace Interpreter {
         bool is_from_str(void);
         bool is_from_enum(void);
         bool is_none(void);
+        bool is_constant(void);
 
         std::shared_ptr<earl::value::Obj> value;
         uint32_t rt;
@@ -80,9 +83,17 @@ namespace Interpreter {
 
     std::shared_ptr<Ctx> interpret(std::unique_ptr<Program> program, std::unique_ptr<Lexer> lexer);
     ER eval_expr(Expr *expr, std::shared_ptr<Ctx> &ctx, bool ref);
+    std::shared_ptr<earl::value::Obj> unpack(ER &er, std::shared_ptr<Ctx> &ctx, bool ref);
     std::shared_ptr<earl::value::Obj> eval_stmt_block(StmtBlock *block, std::shared_ptr<Ctx> &ctx);
     std::shared_ptr<earl::value::Obj> eval_stmt(Stmt *stmt, std::shared_ptr<Ctx> &ctx);
     void typecheck(__Type *ty, earl::value::Obj *value, std::shared_ptr<Ctx> &ctx);
+
+    /// @brief Apply the binary operator `op` to two values
+    std::shared_ptr<earl::value::Obj> binop(Token *op, earl::value::Obj *lhs, earl::value::Obj *rhs);
+
+    /// @brief Forget the modules imported so far, so that the
+    /// next `import` of them runs them again (see --watch, `:reset`)
+    void forget_imports(void);
 };
 
 #endif // INTERPRETER_H
@@ -41,8 +41,9 @@
 ////////////////////////////////////////////
 // To add a new intrinsic, do the following:
 // 1. Add the function signature to this file.
-// 2. In intrinsics.cpp, add the name and the address
-//    of the function in the intrinsic_functions map.
+// 2. In intrinsics.cpp, add the name, the address of
+//    the function and the number of arguments it takes
+//    in the intrinsic_functions map.
 // 3. In intrinsics.cpp, implement the function.
 
 ////////////////////////////////////////////
@@ -53,6 +54,9 @@
 // 3. Add the implementation(s) for the appropriate type(s)
 //    in primitives/.
 
+/// @brief The arity of an intrinsic that takes any number of arguments
+#define INTR_VARIADIC -1
+
 #define __INTR_ARGS_MUSTBE_SIZE(args, sz, fn, expr)                     \
     do {                                                                \
         if (args.size() != sz) {                                        \
@@ -142,8 +146,16 @@ namespace Intrinsics {
                                               std::shared_ptr<Ctx>&,
                                               Expr *);
 
+    /// @brief An intrinsic function and the number of arguments it takes
+    /// (INTR_VARIADIC if it varies). The number is checked once per call
+    /// site instead of by the function on every call.
+    struct Intrinsic {
+        IntrinsicFunction m_fn;
+        int m_arity;
+    };
+
     /// @brief A map of all intrinsic functions in EARL
-    extern const std::unordered_map<std::string, IntrinsicFunction> intrinsic_functions;
+    extern const std::unordered_map<std::string, Intrinsic> intrinsic_functions;
 
     /// @brief A map of all intrinsic member functions in EARL
     extern const std::unordered_map<std::string, IntrinsicMemberFunction> intrinsic_member_functions;
@@ -166,6 +178,16 @@ namespace Intrinsics {
     /// @return true if intrinsic member, false if otherwise
     bool is_member_intrinsic(const std::string &id, int ty = -1);
 
+    /// @brief Get the intrinsic function `id`, or nullptr if there is none
+    const Intrinsic *lookup(const std::string &id);
+
+    /// @brief Throw if `intrinsic` does not take `nargs` arguments
+    void check_arity(const std::string &id, const Intrinsic &intrinsic, size_t nargs, Expr *expr);
+
+    /// @brief Get the intrinsic member function `id` of values of type `ty`,
+    /// or nullptr if there is none
+    IntrinsicMemberFunction lookup_member(const std::string &id, earl::value::Type ty);
+
     /// @brief Call an intrinsic function
     /// @note It is expected to call `is_intrinsic` before calling this function
     /// @param expr The AST node of the function call
@@ -329,6 +351,11 @@ namespace Intrinsics {
                   std::shared_ptr<Ctx> &ctx,
                   Expr *expr);
 
+    std::shared_ptr<earl::value::Obj>
+    intrinsic_memo_stats(std::vector<std::shared_ptr<earl::value::Obj>> &params,
+                         std::shared_ptr<Ctx> &ctx,
+                         Expr *expr);
+
     /*** INTERNAL INTRINSIC FUNCTION IMPLEMENTATIONS ***/
 
     std::shared_ptr<earl::value::Obj>
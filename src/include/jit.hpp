@@ -0,0 +1,96 @@
+/** @file */
+
+// MIT License
+
+// Copyright (c) 2023 malloc-nbytes
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef JIT_H
+#define JIT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ast.hpp"
+#include "ctx.hpp"
+
+/**
+ * An optional baseline JIT (`--jit`). The tree walker counts the
+ * iterations of `while`, `loop` and `for` loops and, once a loop is
+ * hot, tries to compile it to native code. Only loops that work on
+ * int and float locals of the current frame (arithmetic, comparisons,
+ * mutations, `if`, nested loops, `break` and `continue`) are compiled,
+ * anything else stays in the interpreter.
+ *
+ * Compiled code keeps the locals unboxed in a register file for the
+ * whole loop. The types of the locals are checked once when entering
+ * and the results are written back when the loop is done. If a check
+ * fails the loop bails out and the interpreter carries on, and a
+ * region that keeps bailing out is thrown away.
+ *
+ * Only Linux x86-64 is supported, elsewhere nothing is compiled.
+ */
+
+namespace JIT {
+    /// @brief The type of a value in compiled code
+    enum class Ty : uint8_t {
+        Int = 0,
+        Float,
+        Bool,
+    };
+
+    /// @brief A local of the frame that the region uses, kept in
+    /// `regs[m_reg]` while the native code runs
+    struct Local {
+        Slot m_slot;
+        Ty m_ty;
+        size_t m_reg;
+        /// @brief Whether the region mutates it
+        bool m_written;
+    };
+
+    /// @brief A compiled loop
+    struct Region {
+        Region() = default;
+        Region(const Region &) = delete;
+        ~Region();
+
+        std::vector<Local> m_locals;
+        /// @brief The size of the register file
+        size_t m_nregs = 0;
+        /// @brief For `for` loops, the registers of the end and the direction
+        size_t m_end_reg = 0, m_up_reg = 0;
+        void *m_code = nullptr;
+        size_t m_size = 0;
+        uint32_t m_bailouts = 0;
+    };
+
+    /// @brief Count an iteration of `loop` and, if it is hot, run the
+    /// rest of it natively. The `end` and `up` are those of a `for` loop.
+    /// @returns Whether the loop was finished natively
+    bool run(Stmt *loop, JitSite &site, std::shared_ptr<Ctx> &ctx, int end = 0, bool up = true);
+
+    /// @brief Print the number of compiled regions, native runs and bailouts
+    void report(void);
+};
+
+#endif // JIT_H
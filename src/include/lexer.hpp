@@ -36,19 +36,21 @@ struct Token;
 /**
  * A Lexer (for lexical analysis) https://en.wikipedia.org/wiki/Lexical_analysis
  * is a tool that splits up and catagorizes individual 'tokens' for parsers.
- * This implementation constructs a linked list of tokens for the parsers
- * to traverse. It starts at `m_hd` and ends at `m_tl`.
+ * This implementation keeps the tokens in an array for the parsers
+ * to traverse, starting at `m_pos`. Every token also points to the
+ * one after it (`Token::m_next`), which the lexer keeps alive.
  */
 /// @brief The API for lexical analysis of a document.
 struct Lexer {
-    /// @brief Head of the linked list
-    std::shared_ptr<Token> m_hd;
+    /// @brief All tokens, in order
+    std::vector<std::shared_ptr<Token>> m_toks;
 
-    /// @brief Tail of the linked list
-    Token *m_tl;
+    /// @brief The index of the current token
+    size_t m_pos;
 
-    /// @brief The number of tokens present
-    size_t m_len;
+    /// @brief Tokens that are not part of `m_toks`, but that
+    /// the AST still refers to (see `Lexer::keep`)
+    std::vector<std::shared_ptr<Token>> m_kept;
 
     Lexer();
 
@@ -57,8 +59,8 @@ struct Lexer {
     Lexer(const Lexer &other) = delete;
 
     /// @brief Get the current token, namely the one
-    /// that `m_hd` is currently at. It will
-    /// return that one and update the head accordingly.
+    /// that `m_pos` is currently at. It will
+    /// return that one and advance `m_pos`.
     std::shared_ptr<Token> next(void);
 
     /// @brief Peek `n` tokens into the lexer. This does not
@@ -71,7 +73,12 @@ struct Lexer {
     /// @param tok The token to append
     void append(std::shared_ptr<Token> tok);
 
-    void append(std::string lexeme, TokenType type, size_t row, size_t col, std::string fp);
+    void append(std::string lexeme, TokenType type, size_t row, size_t col, uint32_t file);
+
+    /// @brief Keep `toks` alive for as long as the lexer,
+    /// without adding them to the ones to traverse.
+    /// @param toks The tokens to keep
+    void keep(std::vector<std::shared_ptr<Token>> toks);
 
     /// @brief The same as `Lexer::next()` except it does not give
     /// back the token that was consumed.
@@ -84,20 +91,23 @@ struct Lexer {
 };
 
 /// @brief Produces a lexer with a list of tokens from the source
-/// code of `filepath`. Any prevalent keywords should be provided
-/// in `keywords`. The identifier(s) for a SINGLE LINE comment is
+/// code of `filepath`. Keywords are the fixed `COMMON_EARLKW_ASCPL`
+/// set. The identifier(s) for a SINGLE LINE comment is
 /// provided as `comment`.
 /// @param filepath The filepath to read the source code from
-/// @param keywords A vector of strings that are the keywords of the language
 /// @param types A vector of strings that specify the types in the language
 /// @param comment What a single line comment is in the language
 std::unique_ptr<Lexer>
 lex_file(std::string &src_code,
          std::string fp,
-         std::vector<std::string> &keywords,
          std::vector<std::string> &types,
          std::string &comment);
 
+/// @brief Get the file that `read_file` reads for `filepath`,
+/// which is looked for in the standard library first
+std::string
+resolve_filepath(const char *filepath);
+
 char *
 read_file(const char *filepath);
 
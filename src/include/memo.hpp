@@ -0,0 +1,79 @@
+/** @file */
+
+// MIT License
+
+// Copyright (c) 2023 malloc-nbytes
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MEMO_H
+#define MEMO_H
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "earl.hpp"
+
+/// @brief The most results a single `@memo` function keeps around
+#define MEMO_CACHE_CAP 1024
+
+/**
+ * The result cache of functions marked with `@memo`.
+ */
+namespace Memo {
+
+    /// @brief A bounded, least-recently-used cache from the
+    /// arguments of a call to its result.
+    struct Cache {
+        Cache(size_t cap = MEMO_CACHE_CAP);
+        ~Cache() = default;
+
+        /// @brief Get the result stored for `key` (marking it as the most
+        /// recently used), or nullptr if there is none.
+        std::shared_ptr<earl::value::Obj> get(const std::string &key);
+
+        /// @brief Store `value` for `key`, evicting the least
+        /// recently used result if the cache is full.
+        void put(const std::string &key, std::shared_ptr<earl::value::Obj> value);
+
+        size_t size(void) const;
+
+        size_t m_hits;
+        size_t m_misses;
+
+    private:
+        using Entry = std::pair<std::string, std::shared_ptr<earl::value::Obj>>;
+
+        size_t m_cap;
+        std::list<Entry> m_lru;
+        std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+    };
+
+    /// @brief Build the cache key for `args` into `key`. Returns false
+    /// if any argument is of a type that cannot be hashed by value
+    /// (classes, closures, files, ...), in which case the call is not cached.
+    bool make_key(const std::vector<std::shared_ptr<earl::value::Obj>> &args, std::string &key);
+};
+
+#endif // MEMO_H
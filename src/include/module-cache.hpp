@@ -0,0 +1,63 @@
+/** @file */
+
+// MIT License
+
+// Copyright (c) 2023 malloc-nbytes
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef MODULE_CACHE_H
+#define MODULE_CACHE_H
+
+#include <memory>
+#include <string>
+
+#include "ast.hpp"
+#include "lexer.hpp"
+
+/// @brief Bump whenever the layout of a `.earlc` file or the AST changes
+#define MODULE_CACHE_FORMAT 1
+
+/**
+ * The compiled-module cache. A parsed Program is written to
+ * `<dir>/<hash>.earlc` where the hash covers the source code and
+ * the interpreter version, so a cache entry is never used for a
+ * different source and stale entries are simply never looked up
+ * again. The directory is `$EARL_CACHE_DIR`, else
+ * `$XDG_CACHE_HOME/earl`, else `$HOME/.cache/earl`.
+ */
+namespace ModuleCache {
+    /// @brief Read, lex and parse `filepath` (see read_file), or load it from
+    /// the cache if it was parsed before. `lexer` is set to the lexer that
+    /// owns the tokens.
+    std::unique_ptr<Program> parse_file(const std::string &filepath,
+                                        std::unique_ptr<Lexer> &lexer,
+                                        std::string from = "");
+
+    /// @brief Get the Program cached for the source `src` of `filepath`,
+    /// nullptr if there is none (or it cannot be read). Its tokens are
+    /// kept alive by `lexer`.
+    std::unique_ptr<Program> load(const std::string &filepath, const std::string &src, Lexer &lexer);
+
+    /// @brief Cache `program`, parsed from the source `src`. Failing
+    /// to write the cache is not an error.
+    void store(const std::string &src, Program *program);
+};
+
+#endif // MODULE_CACHE_H
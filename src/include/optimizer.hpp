@@ -0,0 +1,116 @@
+/** @file */
+
+// MIT License
+
+// Copyright (c) 2023 malloc-nbytes
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "ast.hpp"
+
+/**
+ * Passes that simplify the AST of a program before it is ran
+ * (enabled with `-O1`). They run after parsing and before the
+ * resolver, and must never change what a valid program does.
+ */
+
+namespace Optimizer {
+    /// @brief The base class of every pass. The walker visits every
+    /// kind of statement and expression (like earl-to-py does) and
+    /// passes override the hooks of the nodes they rewrite. A hook
+    /// can replace the node it is given, a statement hook can also
+    /// remove it by setting it to nullptr.
+    struct Pass {
+        Pass(std::string name);
+        virtual ~Pass() = default;
+
+        /// @brief Run the pass over a whole program
+        /// @return The number of rewrites done by this run
+        virtual size_t run(Program *program);
+
+        /// @brief Print the statistics gathered over every run
+        void report(const std::string &filepath) const;
+
+        const std::string m_name;
+
+    protected:
+        virtual void visit_stmt(std::unique_ptr<Stmt> &stmt);
+        virtual void visit_expr(std::unique_ptr<Expr> &expr);
+
+        /// @brief Visit the children of a node
+        void walk_stmt(Stmt *stmt);
+        void walk_expr(Expr *expr);
+        void walk_block(StmtBlock *block);
+        void walk_stmts(std::vector<std::unique_ptr<Stmt>> &stmts);
+
+        /// @brief Record a rewrite under the statistic `what`
+        void count(const std::string &what);
+
+        Program *m_program;
+        size_t m_rewrites;
+        std::vector<std::pair<std::string, size_t>> m_stats;
+    };
+
+    /// @brief Folds operators applied to literals, i.e. `2 * 60 * 60`
+    struct ConstFold : public Pass {
+        ConstFold(void);
+    protected:
+        void visit_expr(std::unique_ptr<Expr> &expr) override;
+    };
+
+    /// @brief Replaces the uses of @const @world bindings that
+    /// are initialized with a literal with that literal
+    struct ConstProp : public Pass {
+        ConstProp(void);
+        size_t run(Program *program) override;
+    protected:
+        void visit_stmt(std::unique_ptr<Stmt> &stmt) override;
+        void visit_expr(std::unique_ptr<Expr> &expr) override;
+    private:
+        /// @brief Whether the uses in the current node can be replaced
+        bool m_visible;
+        std::unordered_set<std::string> m_candidates;
+        std::unordered_map<std::string, std::shared_ptr<earl::value::Obj>> m_known;
+        /// @brief Every binding that has been propagated so far
+        std::unordered_set<std::string> m_bound;
+    };
+
+    /// @brief Removes `if` and `while` branches whose
+    /// condition is a literal
+    struct DeadBranch : public Pass {
+        DeadBranch(void);
+    protected:
+        void visit_stmt(std::unique_ptr<Stmt> &stmt) override;
+    };
+
+    /// @brief Run the passes enabled by the optimization level
+    void optimize(Program *program);
+};
+
+#endif // OPTIMIZER_H
@@ -0,0 +1,55 @@
+/** @file */
+
+// MIT License
+
+// Copyright (c) 2023 malloc-nbytes
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <memory>
+#include <string>
+
+#include "ast.hpp"
+#include "lexer.hpp"
+
+/**
+ * Parsing of the import graph ahead of time. Before a program runs, the
+ * files it imports with a string literal (and the files those import)
+ * are lexed and parsed concurrently. `import` then only has to take the
+ * parsed module. Files that fail to parse are left to `import`, which
+ * reports the error at the same point as before.
+ */
+namespace Prefetch {
+    /// @brief The key of the module read for the import of `path`
+    /// (the canonical path of the file, see resolve_filepath)
+    std::string module_key(const std::string &path);
+
+    /// @brief Parse everything `program` imports, directly or not, and
+    /// keep it for `take`. Anything kept from an earlier call is dropped.
+    void imports(Program *program);
+
+    /// @brief Get the parsed module for `key` (see `module_key`) and its
+    /// lexer, nullptr if it was not parsed ahead of time
+    std::unique_ptr<Program> take(const std::string &key, std::unique_ptr<Lexer> &lexer);
+};
+
+#endif // PREFETCH_H
@@ -99,6 +99,10 @@ template <typename K, typename V> struct SharedScope {
     }
 
     inline void pop(void) {
+        // Values may outlive the scope (frames hold on to them as
+        // well), so do not rely on the cache entries expiring.
+        for (auto &entry : m_map.back())
+            m_cache.remove(entry.first);
         m_map.pop_back();
     }
 
@@ -154,8 +158,7 @@ template <typename K, typename V> struct SharedScope {
     }
 
     inline void remove(K key) {
-        // No need to remove from cache because its value
-        // will be set to null.
+        m_cache.remove(key);
 
         for (auto it = m_map.rbegin(); it != m_map.rend(); ++it) {
             auto &map = *it;
@@ -181,6 +184,14 @@ template <typename K, typename V> struct SharedScope {
         m_map.clear();
     }
 
+    /// @brief Drop everything but keep the outermost scope (and
+    /// its buckets) around so that it can be used again
+    inline void reset(void) {
+        m_map.resize(1);
+        m_map.front().clear();
+        m_cache.cache.clear();
+    }
+
     inline void debug_dump(void) const {
         int i = 1;
         for (const auto &map : m_map) {
@@ -32,6 +32,7 @@
 
 #include <string>
 #include <memory>
+#include <cstdint>
 
 //#include "lexer.hpp"
 
@@ -116,7 +117,9 @@ std::string tokentype_to_str(TokenType type);
 struct Token {
     Token(char *start, size_t len,
           TokenType type,
-          size_t row, size_t col, std::string &fp);
+          size_t row, size_t col, uint32_t file);
+
+    Token(std::string lexeme, TokenType type, size_t row, size_t col, uint32_t file);
 
     Token(std::string lexeme, TokenType type, size_t row, size_t col, std::string fp);
 
@@ -136,15 +139,18 @@ struct Token {
     /// @brief The column of the token
     size_t m_col;
 
-    /// @brief The filepath of the token
-    std::string m_fp;
+    /// @brief The id of the filepath of the token (see `token_intern_fp`)
+    uint32_t m_file;
 
-    /// @brief A pointer to the next token
-    std::shared_ptr<Token> m_next;
+    /// @brief A pointer to the next token, owned by the `Lexer`
+    Token *m_next;
 
     /// @brief Get the `lexeme` of the current token
     std::string &lexeme(void);
 
+    /// @brief Get the filepath of the current token
+    const std::string &fp(void) const;
+
     /// @brief Get the `type` of the current token
     TokenType type(void) const;
 };
@@ -156,8 +162,13 @@ struct Token {
 /// @param type The type of the token to create
 /// @param row The row of the token
 /// @param col The column of the token
-/// @param fp The filepath of the token
-std::shared_ptr<Token> token_alloc(Lexer &lexer, char *start, size_t len, TokenType type, size_t row, size_t col, std::string fp);
+/// @param file The id of the filepath of the token
+std::shared_ptr<Token> token_alloc(Lexer &lexer, char *start, size_t len, TokenType type, size_t row, size_t col, uint32_t file);
+
+/// @brief Get the id of `fp` so that tokens do not each
+/// keep their own copy of the filepath.
+/// @param fp The filepath to intern
+uint32_t token_intern_fp(const std::string &fp);
 
 /// @brief Prints tokens from the current token to the end of line.
 /// @param tok The token to start from
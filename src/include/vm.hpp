@@ -0,0 +1,156 @@
+/** @file */
+
+// MIT License
+
+// Copyright (c) 2023 malloc-nbytes
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef VM_H
+#define VM_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ast.hpp"
+#include "ctx.hpp"
+#include "earl.hpp"
+
+/**
+ * An alternative execution engine (`--vm`). Blocks are compiled
+ * lazily into a flat instruction stream and ran on a small stack
+ * machine. It uses the same runtime (earl::value::Obj and the Ctx
+ * scopes) as the tree walker. Anything the compiler does not know
+ * how to lower is delegated back to the interpreter so that both
+ * engines always agree.
+ */
+
+namespace VM {
+    enum class Opcode : uint8_t {
+        Const = 0,       // push consts[a] (copied if boxed)
+        Load,            // push the variable in p (ExprIdent), b = ref
+        Expr,            // fallback: eval + unpack the Expr in p
+        LValue,          // fallback: left side of a mutation (StmtMut in p)
+        Binop,           // pop rhs, lhs, push lhs <op> rhs (Token in p)
+        Unary,           // pop value, push <op> value (Token in p)
+        And,             // short-circuit &&, jump to a if false, b = copy
+        Or,              // short-circuit ||, jump to a if true, b = copy
+        Jump,            // jump to a
+        JumpFalse,       // pop condition, jump to a if false
+        PushScope,
+        PopScope,
+        LetCheck,        // make sure the StmtLet in p can be declared
+        Let,             // pop value and bind it (StmtLet in p)
+        Mut,             // pop rhs, lhs, mutate (StmtMut in p)
+        ExprStmt,        // pop value into the result (StmtExpr in p)
+        Stmt,            // fallback: run the Stmt in p through the interpreter
+        Propagate,       // act on a non-void result, loop a, exit b
+        Return,          // a = has value (or VM_RETURN_RESULT), exit to b
+        Unwind,          // unwind to scope depth a and for depth b
+        Signal,          // result = Break (a = 0) or Continue (a = 1), exit to b
+        ForInit,         // pop end, start, declare the enumerator (StmtFor in p)
+        ForTest,         // jump to a if the innermost `for` is done
+        ForStep,         // advance the innermost `for`
+        ForEnd,          // remove the innermost `for` enumerator
+        Exit,            // stop and return the result
+        Count,
+    };
+
+    /// @brief A single instruction
+    struct Instr {
+        Opcode op;
+        uint32_t a;
+        uint32_t b;
+        void *p;
+    };
+
+    /// @brief Where `break`, `continue` and unwinding go for a loop
+    struct LoopInfo {
+        uint32_t brk;
+        uint32_t cont;
+        uint32_t scope_depth;
+        uint32_t for_depth;
+    };
+
+    /// @brief A slot on the operand stack. Int, Float, Bool and Char
+    /// are carried inline and are only boxed into an earl::value::Obj
+    /// once they leave the VM (bindings, returns, fallbacks). Anything
+    /// else (and values that must keep their identity) stays boxed.
+    struct Value {
+        enum class Tag : uint8_t {
+            Obj = 0,
+            Int,
+            Float,
+            Bool,
+            Char,
+        };
+
+        Value(std::shared_ptr<earl::value::Obj> value = nullptr) : tag(Tag::Obj), i(0), obj(std::move(value)) {}
+        Value(int value) : tag(Tag::Int), i(value) {}
+        Value(double value) : tag(Tag::Float), f(value) {}
+        Value(bool value) : tag(Tag::Bool), b(value) {}
+        Value(char value) : tag(Tag::Char), c(value) {}
+
+        /// @brief Unbox a copy of `obj` if it is a scalar
+        static Value unboxed(earl::value::Obj *obj);
+
+        /// @brief Get the value as an earl::value::Obj, allocating
+        /// a new one if it is inline
+        std::shared_ptr<earl::value::Obj> box(void) const;
+
+        /// @brief Same as earl::value::Obj::boolean
+        bool boolean(void) const;
+
+        Tag tag;
+        union {
+            int i;
+            double f;
+            bool b;
+            char c;
+        };
+        std::shared_ptr<earl::value::Obj> obj;
+    };
+
+    /// @brief A compiled block
+    struct Chunk {
+        std::vector<Instr> code;
+        std::vector<Value> consts;
+        std::vector<LoopInfo> loops;
+    };
+
+    /// @brief Compile a list of statements
+    /// @param stmts The statements to compile
+    /// @param ctx The context (only used to pre-evaluate literals)
+    /// @param toplevel Whether the statements are those of the
+    /// world context (results are discarded and no scope is pushed)
+    std::shared_ptr<Chunk> compile(std::vector<Stmt *> &stmts, std::shared_ptr<Ctx> &ctx, bool toplevel);
+
+    /// @brief Run a compiled chunk
+    std::shared_ptr<earl::value::Obj> run(Chunk &chunk, std::shared_ptr<Ctx> &ctx);
+
+    /// @brief Same as Interpreter::eval_stmt_block, but using the VM.
+    /// The bytecode is cached on the block.
+    std::shared_ptr<earl::value::Obj> exec_block(StmtBlock *block, std::shared_ptr<Ctx> &ctx);
+
+    /// @brief Run the top-level statements of a program
+    void exec_toplevel(std::vector<Stmt *> &stmts, std::shared_ptr<Ctx> &ctx);
+};
+
+#endif // VM_H
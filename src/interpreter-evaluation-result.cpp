@@ -104,3 +104,8 @@ bool
 Interpreter::ER::is_none(void) {
     return (this->rt & ERT::None) != 0;
 }
+
+bool
+Interpreter::ER::is_constant(void) {
+    return (this->rt & ERT::Constant) != 0;
+}
@@ -29,6 +29,8 @@
 #include <optional>
 #include <functional>
 #include <variant>
+#include <type_traits>
+#include <unordered_map>
 
 #include "parser.hpp"
 #include "utils.hpp"
@@ -41,6 +43,16 @@
 #include "common.hpp"
 #include "earl.hpp"
 #include "lexer.hpp"
+#include "module-cache.hpp"
+#include "prefetch.hpp"
+#include "vm.hpp"
+#include "resolver.hpp"
+#include "optimizer.hpp"
+#include "memo.hpp"
+#include "jit.hpp"
+
+// The most argument vectors kept around for intrinsic calls
+#define ARGS_POOL_CAP 64
 
 using namespace Interpreter;
 
@@ -205,7 +217,7 @@ eval_stmt_let_wmultiple_vars_wcustom_buffer_in_class(StmtLet *stmt,
         ++i;
     }
 
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 static std::shared_ptr<earl::value::Obj>
@@ -246,12 +258,43 @@ eval_stmt_let_wcustom_buffer_in_class(StmtLet *stmt,
         typecheck(stmt->m_tys[0].get(), value.get(), ctx);
 
     if (id == "_")
-        return std::make_shared<earl::value::Void>();
+        return earl::value::Void::instance();
 
     std::shared_ptr<earl::variable::Obj> var
         = std::make_shared<earl::variable::Obj>(stmt->m_ids.at(0).get(), value, stmt->m_attrs);
     ctx->variable_add(var);
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
+}
+
+// Build what all instances of `class_stmt` share. `ctx` is where
+// the class is first instantiated and is only used for conflicts.
+static std::shared_ptr<ClassDesc>
+make_class_desc(StmtClass *class_stmt, std::shared_ptr<Ctx> &ctx) {
+    auto desc = std::make_shared<ClassDesc>();
+
+    for (auto &member : class_stmt->m_members) {
+        for (auto &tok : member->m_ids) {
+            const std::string &id = tok->lexeme();
+            if (id == "_" || desc->m_slots.find(id) != desc->m_slots.end())
+                continue;
+            desc->m_slots.emplace(id, desc->m_ids.size());
+            desc->m_ids.push_back(id);
+        }
+    }
+
+    // Evaluate the definitions into a scratch context so that
+    // the usual conflict checks still apply.
+    auto scratch = std::make_shared<ClassCtx>(ctx);
+    std::shared_ptr<Ctx> scratch_ctx = scratch;
+    for (auto &method : class_stmt->m_methods) {
+        (void)eval_stmt_def(method.get(), scratch_ctx);
+        const std::string &id = method->m_id->lexeme();
+        desc->m_methods.emplace(id, scratch->function_get(id));
+        if (id == "constructor")
+            desc->m_has_constructor = true;
+    }
+
+    return desc;
 }
 
 static std::shared_ptr<earl::value::Obj>
@@ -290,7 +333,10 @@ eval_class_instantiation(ExprFuncCall *expr,
     else
         class_stmt = dynamic_cast<WorldCtx *>(ctx.get())->class_get(id);
 
-    auto class_ctx = std::make_shared<ClassCtx>(ctx);
+    if (!class_stmt->m_desc)
+        class_stmt->m_desc = make_class_desc(class_stmt, ctx);
+
+    auto class_ctx = std::make_shared<ClassCtx>(ctx, class_stmt->m_desc.get());
 
     if (params.size() != class_stmt->m_constructor_args.size()) {
         std::string msg = "Class `" + id + "` expects " + std::to_string(class_stmt->m_constructor_args.size()) +
@@ -326,16 +372,9 @@ eval_class_instantiation(ExprFuncCall *expr,
                                                     true);
 
     const std::string constructor_id = "constructor";
-    bool has_constructor = false;
 
-    // Eval methods
-    for (size_t i = 0; i < class_stmt->m_methods.size(); ++i) {
-        (void)eval_stmt_def(class_stmt->m_methods[i].get(), klass->ctx());
-        if (class_stmt->m_methods[i]->m_id->lexeme() == constructor_id)
-            has_constructor = true;
-    }
-
-    if (has_constructor) {
+    // The methods themselves are shared through the class descriptor.
+    if (class_stmt->m_desc->m_has_constructor) {
         std::vector<std::shared_ptr<earl::value::Obj>> unused = {};
         (void)eval_user_defined_function(nullptr, constructor_id, unused, klass->ctx());
     }
@@ -346,17 +385,50 @@ eval_class_instantiation(ExprFuncCall *expr,
     return klass;
 }
 
-static std::vector<std::shared_ptr<earl::value::Obj>>
-evaluate_function_parameters(ExprFuncCall *funccall, std::shared_ptr<Ctx> ctx, bool ref) {
-    std::vector<std::shared_ptr<earl::value::Obj>> res = {};
+static void
+evaluate_function_parameters(ExprFuncCall *funccall,
+                             std::shared_ptr<Ctx> ctx,
+                             bool ref,
+                             std::vector<std::shared_ptr<earl::value::Obj>> &res) {
     PackedERPreliminary perp(nullptr, /*this_=*/false, /*errtok=*/funccall->m_tok.get());
+    res.reserve(funccall->m_params.size());
     for (size_t i = 0; i < funccall->m_params.size(); ++i) {
         ER er = Interpreter::eval_expr(funccall->m_params[i].get(), ctx, ref);
         res.push_back(unpack_ER(er, ctx, ref, /*perp=*/&perp));
     }
+}
+
+static std::vector<std::shared_ptr<earl::value::Obj>>
+evaluate_function_parameters(ExprFuncCall *funccall, std::shared_ptr<Ctx> ctx, bool ref) {
+    std::vector<std::shared_ptr<earl::value::Obj>> res = {};
+    evaluate_function_parameters(funccall, ctx, ref, res);
     return res;
 }
 
+// The argument vectors of finished intrinsic calls. They keep
+// their capacity, so most calls do not have to allocate one.
+static std::vector<std::vector<std::shared_ptr<earl::value::Obj>>> args_pool = {};
+
+// The arguments of one intrinsic call, borrowed from `args_pool`.
+struct PooledArgs {
+    PooledArgs(void) {
+        if (!args_pool.empty()) {
+            m_values = std::move(args_pool.back());
+            args_pool.pop_back();
+        }
+    }
+
+    ~PooledArgs() {
+        m_values.clear();
+        if (args_pool.size() < ARGS_POOL_CAP)
+            args_pool.push_back(std::move(m_values));
+    }
+
+    PooledArgs(const PooledArgs &) = delete;
+
+    std::vector<std::shared_ptr<earl::value::Obj>> m_values;
+};
+
 static std::vector<std::shared_ptr<earl::value::Obj>>
 evaluate_function_parameters_wrefs(ExprFuncCall *funccall,
                                    std::variant<std::shared_ptr<earl::function::Obj>, earl::value::Closure *> &func_proper,
@@ -413,6 +485,103 @@ evaluate_function_parameters_wrefs(ExprFuncCall *funccall,
     return res;
 }
 
+// Call the user defined function `func` from `ctx`. A `return g(...)`
+// in the body does not call `g` itself (see eval_stmt_return), it is
+// handed back here and ran in a new frame once the current one is
+// gone, so that tail calls use constant stack.
+static std::shared_ptr<earl::value::Obj>
+call_function(std::shared_ptr<earl::function::Obj> func,
+              std::vector<std::shared_ptr<earl::value::Obj>> params,
+              std::shared_ptr<Ctx> &ctx) {
+    std::vector<__Type *> types = {};
+    std::shared_ptr<earl::value::Obj> res = nullptr;
+    std::string caller_id = "";
+
+    // Only the result of the entry call is stored so that a
+    // chain of tail calls does not pile up pending keys.
+    Memo::Cache *memo = nullptr;
+    std::string memo_key = "";
+    bool entry = true;
+
+    if (ctx->type() == CtxType::Function)
+        caller_id = dynamic_cast<FunctionCtx *>(ctx.get())->get_curfuncid();
+
+    while (true) {
+        if ((func->attrs() & static_cast<uint32_t>(Attr::Memo)) != 0) {
+            auto &cache = func->get_stmtdef()->m_memo;
+            if (!cache)
+                cache = std::make_shared<Memo::Cache>();
+
+            std::string key = "";
+            if (Memo::make_key(params, key)) {
+                if (auto hit = cache->get(key)) {
+                    ++cache->m_hits;
+                    res = hit->copy();
+                    if (func->is_explicit_typed() && (types.size() == 0 || types.back() != func->get_explicit_type()))
+                        types.push_back(func->get_explicit_type());
+                    break;
+                }
+                ++cache->m_misses;
+                if (entry) {
+                    memo = cache.get();
+                    memo_key = std::move(key);
+                }
+            }
+        }
+        entry = false;
+
+        std::vector<bool> originally_was_const = {};
+        for (auto &p : params)
+            originally_was_const.push_back(p->is_const());
+
+        auto fctx = FunctionCtx::acquire(ctx, func->attrs());
+        fctx->m_frame.init(func->block(), func->block()->m_frame_size);
+        fctx->set_curfunc(func->id());
+        func->load_parameters(params, fctx, ctx);
+
+        // Recursion optimization
+        if (func->id() == caller_id)
+            fctx->setrec();
+
+        std::shared_ptr<Ctx> mask = fctx;
+        res = Interpreter::eval_stmt_block(func->block(), mask);
+
+        for (size_t i = 0; i < originally_was_const.size(); ++i) {
+            if (!originally_was_const[i])
+                params[i]->unset_const();
+        }
+
+        if (func->is_explicit_typed() && (types.size() == 0 || types.back() != func->get_explicit_type()))
+            types.push_back(func->get_explicit_type());
+
+        auto tail_func = std::move(fctx->m_tail_func);
+        auto tail_params = std::move(fctx->m_tail_params);
+        fctx->m_tail_func = nullptr;
+
+        mask = nullptr;
+        FunctionCtx::release(fctx);
+
+        if (!tail_func)
+            break;
+
+        if ((flags & __SHOWFUNS) != 0)
+            std::cout << "[EARL show-funs] " << tail_func->id() << '\n';
+
+        caller_id = func->id();
+        func = std::move(tail_func);
+        params = std::move(tail_params);
+    }
+
+    // Innermost first, like the nested calls would have.
+    for (auto it = types.rbegin(); it != types.rend(); ++it)
+        Interpreter::typecheck(*it, res.get(), ctx);
+
+    if (memo && res)
+        memo->put(memo_key, res->copy());
+
+    return res;
+}
+
 static std::shared_ptr<earl::value::Obj>
 eval_user_defined_function_wo_params(const std::string &id,
                                      ExprFuncCall *funccall,
@@ -420,8 +589,6 @@ eval_user_defined_function_wo_params(const std::string &id,
                                      std::shared_ptr<Ctx> &ctx,
                                      bool from_outside = false) {
     std::vector<std::shared_ptr<earl::value::Obj>> params = {};
-    std::vector<bool> originally_was_const = {};
-    std::vector<int> refs = {};
     std::variant<std::shared_ptr<earl::function::Obj>, earl::value::Closure *> v;
 
     if (ctx->function_exists(id)) {
@@ -438,12 +605,6 @@ eval_user_defined_function_wo_params(const std::string &id,
         }
 
         params = evaluate_function_parameters_wrefs(funccall, v, funccall_ctx);
-        for (auto &p : params) {
-            if (p->is_const())
-                originally_was_const.push_back(true);
-            else
-                originally_was_const.push_back(false);
-        }
 
         if (func->params_len() != params.size()) {
             const std::string msg = "function `"+func->id()+"` expects "+std::to_string(func->params_len())+" arguments but got "+std::to_string(params.size());
@@ -451,36 +612,13 @@ eval_user_defined_function_wo_params(const std::string &id,
             throw InterpreterException(msg);
         }
 
-        auto fctx = std::make_shared<FunctionCtx>(ctx, func->attrs());
-        fctx->set_curfunc(id);
-        func->load_parameters(params, fctx, ctx);
-
-        // Recursion optimization
-        if (ctx->type() == CtxType::Function) {
-            if (fctx->get_curfuncid() == dynamic_cast<FunctionCtx *>(ctx.get())->get_curfuncid()) {
-                fctx->setrec();
-            }
-        }
-
-        std::shared_ptr<Ctx> mask = fctx;
-        auto res = Interpreter::eval_stmt_block(func->block(), mask);
-
-        for (size_t i = 0; i < originally_was_const.size(); ++i) {
-            if (!originally_was_const[i])
-                params[i]->unset_const();
-        }
-
-        if (func->is_explicit_typed()) {
-            auto ty = func->get_explicit_type();
-            Interpreter::typecheck(ty, res.get(), ctx);
-        }
-
-        return res;
+        return call_function(func, params, ctx);
     }
     else if (ctx->closure_exists(id)) {
         auto cl = ctx->variable_get(id);
-        auto clctx = std::make_shared<ClosureCtx>(ctx);
+        auto clctx = ClosureCtx::acquire(ctx);
         earl::value::Closure *clvalue = dynamic_cast<earl::value::Closure *>(cl->value().get());
+        clctx->m_frame.init(clvalue->block(), clvalue->block()->m_frame_size);
         v = clvalue;
         params = evaluate_function_parameters_wrefs(funccall, v, funccall_ctx);
         if (clvalue->params_len() != params.size()) {
@@ -490,7 +628,10 @@ eval_user_defined_function_wo_params(const std::string &id,
         }
         clvalue->load_parameters(params, clctx);
         std::shared_ptr<Ctx> mask = clctx;
-        return Interpreter::eval_stmt_block(clvalue->block(), mask);
+        auto res = Interpreter::eval_stmt_block(clvalue->block(), mask);
+        mask = nullptr;
+        ClosureCtx::release(clctx);
+        return res;
     }
 
     Err::err_wexpr(funccall);
@@ -525,31 +666,13 @@ eval_user_defined_function(ExprFuncCall *expr,
                 Err::err_wexpr(expr);
             throw InterpreterException(msg);
         }
-        auto fctx = std::make_shared<FunctionCtx>(ctx, func->attrs());
-        func->load_parameters(params, fctx, ctx);
-        fctx->set_curfunc(id);
-        func->load_parameters(params, fctx, ctx);
-
-        if (ctx->type() == CtxType::Function) {
-            if (fctx->get_curfuncid() == dynamic_cast<FunctionCtx *>(ctx.get())->get_curfuncid()) {
-                fctx->setrec();
-            }
-        }
-
-        std::shared_ptr<Ctx> mask = fctx;
-        auto res = Interpreter::eval_stmt_block(func->block(), mask);
-
-        if (func->is_explicit_typed()) {
-            auto ty = func->get_explicit_type();
-            Interpreter::typecheck(ty, res.get(), ctx);
-        }
-
-        return res;
+        return call_function(func, params, ctx);
     }
     else if (ctx->closure_exists(id)) {
         auto cl = ctx->variable_get(id);
-        auto clctx = std::make_shared<ClosureCtx>(ctx);
+        auto clctx = ClosureCtx::acquire(ctx);
         auto clvalue = dynamic_cast<earl::value::Closure *>(cl->value().get());
+        clctx->m_frame.init(clvalue->block(), clvalue->block()->m_frame_size);
         if (clvalue->params_len() != params.size()) {
             const std::string msg = "closure `"+id+"` expects "+std::to_string(clvalue->params_len())+" arguments but got "+std::to_string(params.size());
             Err::err_wexpr(expr);
@@ -557,7 +680,10 @@ eval_user_defined_function(ExprFuncCall *expr,
         }
         clvalue->load_parameters(params, clctx);
         std::shared_ptr<Ctx> mask = clctx;
-        return Interpreter::eval_stmt_block(clvalue->block(), mask);
+        auto res = Interpreter::eval_stmt_block(clvalue->block(), mask);
+        mask = nullptr;
+        ClosureCtx::release(clctx);
+        return res;
     }
 
     Err::err_wexpr(expr);
@@ -573,7 +699,7 @@ eval_user_defined_function(ExprFuncCall *expr,
 static std::shared_ptr<earl::value::Obj>
 unpack_ER(ER &er, std::shared_ptr<Ctx> &ctx, bool ref, PackedERPreliminary *perp) {
     if (er.value && er.value->type() == earl::value::Type::Return)
-        er.value = std::make_shared<earl::value::Void>();
+        er.value = earl::value::Void::instance();
 
     // CLASSES
     if (er.is_class_instant()) {
@@ -584,32 +710,33 @@ unpack_ER(ER &er, std::shared_ptr<Ctx> &ctx, bool ref, PackedERPreliminary *perp
 
     // FUNCTIONS/MEMBERS/INTRINSICS
     if (er.is_function_ident()) {
-        auto params = evaluate_function_parameters(static_cast<ExprFuncCall *>(er.extra), er.ctx, ref);
+        auto funccall = static_cast<ExprFuncCall *>(er.extra);
+
         if (er.is_intrinsic()) {
-            Expr *expr = nullptr;
-            if (er.extra)
-                expr = static_cast<Expr *>(er.extra);
-            auto call = Intrinsics::call(er.id, params, ctx, expr);
+            PooledArgs args;
+            evaluate_function_parameters(funccall, er.ctx, ref, args.m_values);
+            auto call = funccall->m_intrinsic(args.m_values, ctx, funccall);
             if (call->type() == earl::value::Type::Return)
-                call = std::make_shared<earl::value::Void>();
+                call = earl::value::Void::instance();
             return call;
         }
 
         if (er.is_member_intrinsic() && (perp && perp->lhs_getter_accessor)) {
-            if (Intrinsics::is_member_intrinsic(er.id, static_cast<int>(perp->lhs_getter_accessor->type()))) {
-                Expr *expr = nullptr;
-                if (er.extra) expr = static_cast<Expr *>(er.extra);
-                auto res = Intrinsics::call_member(er.id,
-                                                   perp->lhs_getter_accessor->type(),
-                                                   perp->lhs_getter_accessor,
-                                                   params,
-                                                   ctx,
-                                                   expr);
-                return res;
+            // Only looked up again when the receiver changes type.
+            int ty = static_cast<int>(perp->lhs_getter_accessor->type());
+            if (funccall->m_member_ty != ty) {
+                funccall->m_member = Intrinsics::lookup_member(er.id, perp->lhs_getter_accessor->type());
+                funccall->m_member_ty = ty;
+            }
+            if (funccall->m_member) {
+                PooledArgs args;
+                evaluate_function_parameters(funccall, er.ctx, ref, args.m_values);
+                return funccall->m_member(perp->lhs_getter_accessor, args.m_values, ctx, funccall);
             }
         }
 
         if (ctx->type() == CtxType::Class) {
+            auto params = evaluate_function_parameters(funccall, er.ctx, ref);
             std::shared_ptr<earl::function::Obj> func = nullptr;
             if (ctx->function_exists(er.id))
                 func = ctx->function_get(er.id);
@@ -621,7 +748,7 @@ unpack_ER(ER &er, std::shared_ptr<Ctx> &ctx, bool ref, PackedERPreliminary *perp
 
             auto call = eval_user_defined_function(static_cast<ExprFuncCall *>(er.extra),er.id, params, ctx);
             if (call->type() == earl::value::Type::Return)
-                call = std::make_shared<earl::value::Void>();
+                call = earl::value::Void::instance();
             return call;
         }
 
@@ -639,13 +766,16 @@ unpack_ER(ER &er, std::shared_ptr<Ctx> &ctx, bool ref, PackedERPreliminary *perp
         // routine(s) above this may need this change as well.
         auto call = eval_user_defined_function_wo_params(er.id, static_cast<ExprFuncCall *>(er.extra), er.ctx, ctx);
         if (call->type() == earl::value::Type::Return)
-            call = std::make_shared<earl::value::Void>();
+            call = earl::value::Void::instance();
         return call;
     }
 
     // LITERAL
-    else if (er.is_literal())
+    else if (er.is_literal()) {
+        if (er.is_constant())
+            return er.value->copy();
         return er.value;
+    }
 
     // IDENTIFIER
     else if (er.is_ident()) {
@@ -656,6 +786,12 @@ unpack_ER(ER &er, std::shared_ptr<Ctx> &ctx, bool ref, PackedERPreliminary *perp
                 return lhs->get_entry(er.id)->value()->copy();
             }
         }
+        // Resolved locals are a plain index into the frame.
+        if (er.ctx == ctx && (!perp || !perp->lhs_getter_accessor)) {
+            earl::variable::Obj *var = ctx->m_frame.get(static_cast<ExprIdent *>(er.extra)->m_slot);
+            if (var)
+                return ref ? var->value() : var->value()->copy();
+        }
         if (ctx->variable_exists(er.id)) {
             auto var = ctx->variable_get(er.id);
             if ((!perp || !perp->this_) && (er.ctx != ctx && !var->is_pub())) {
@@ -697,7 +833,7 @@ unpack_ER(ER &er, std::shared_ptr<Ctx> &ctx, bool ref, PackedERPreliminary *perp
 
     // UNIT
     else if (er.is_wildcard())
-        return std::make_shared<earl::value::Void>();
+        return earl::value::Void::instance();
     else
         assert(false && "unreachable");
     return nullptr; // unreachable
@@ -715,15 +851,13 @@ eval_expr_term_ident(ExprIdent *expr, std::shared_ptr<Ctx> &ctx, bool ref) {
 // RETURNS ACTUAL EVALUATED VALUE IN ER
 static ER
 eval_expr_term_intlit(ExprIntLit *expr) {
-    auto value = std::make_shared<earl::value::Int>(std::stoi(expr->m_tok->lexeme()));
-    return ER(value, ERT::Literal);
+    return ER(expr->m_value, static_cast<ERT>(ERT::Literal|ERT::Constant));
 }
 
 // RETURNS ACTUAL EVALUATED VALUE IN ER
 static ER
 eval_expr_term_strlit(ExprStrLit *expr) {
-    auto value = std::make_shared<earl::value::Str>(expr->m_tok->lexeme());
-    return ER(value, ERT::Literal);
+    return ER(expr->m_value, static_cast<ERT>(ERT::Literal|ERT::Constant));
 }
 
 static ER
@@ -746,10 +880,30 @@ eval_expr_term_funccall(ExprFuncCall *expr, std::shared_ptr<Ctx> &ctx, bool ref)
     ER left = Interpreter::eval_expr(expr->m_left.get(), ctx, ref);
     const std::string &id = left.id;
 
-    if (Intrinsics::is_intrinsic(id))
+    // Intrinsics cannot be redefined, so a call by name
+    // is bound to one for good the first time it is seen.
+    ExprFuncCall::Bind bind = expr->m_bind;
+    if (bind == ExprFuncCall::Bind::Unbound) {
+        const Intrinsics::Intrinsic *intrinsic = Intrinsics::lookup(id);
+        if (intrinsic) {
+            Intrinsics::check_arity(id, *intrinsic, expr->m_params.size(), expr);
+            expr->m_intrinsic = intrinsic->m_fn;
+            bind = ExprFuncCall::Bind::Intrinsic;
+        }
+        else if (Intrinsics::is_member_intrinsic(id))
+            bind = ExprFuncCall::Bind::MemberIntrinsic;
+        else
+            bind = ExprFuncCall::Bind::Other;
+
+        if (expr->m_left->get_type() == ExprType::Term
+            && dynamic_cast<ExprTerm *>(expr->m_left.get())->get_term_type() == ExprTermType::Ident)
+            expr->m_bind = bind;
+    }
+
+    if (bind == ExprFuncCall::Bind::Intrinsic)
         return ER(nullptr, static_cast<ERT>(ERT::FunctionIdent|ERT::IntrinsicFunction), /*id=*/id, /*extra=*/static_cast<void *>(expr), /*ctx=*/ctx);
 
-    if (Intrinsics::is_member_intrinsic(id))
+    if (bind == ExprFuncCall::Bind::MemberIntrinsic)
         return ER(nullptr, static_cast<ERT>(ERT::FunctionIdent|ERT::IntrinsicMemberFunction), /*id=*/id, /*extra=*/static_cast<void *>(expr), /*ctx=*/ctx);
 
     std::shared_ptr<Ctx> ctx_wclass = check_if_is_class(id, ctx);
@@ -767,25 +921,26 @@ eval_expr_term_mod_access(ExprModAccess *expr, std::shared_ptr<Ctx> &ctx, bool r
     const auto    &left_id    = left_ident->m_tok->lexeme();
     ER right_er(std::shared_ptr<earl::value::Obj>{}, ERT::None);
 
-    std::shared_ptr<Ctx> *ctx_ptr = nullptr;
+    WorldCtx::Import *import = nullptr;
 
     if (ctx->type() == CtxType::World)
-        ctx_ptr = dynamic_cast<WorldCtx *>(ctx.get())->get_import(left_id);
+        import = dynamic_cast<WorldCtx *>(ctx.get())->get_import(left_id);
     else if (ctx->type() == CtxType::Function) {
         auto world = dynamic_cast<FunctionCtx *>(ctx.get())->get_outer_world_owner();
-        ctx_ptr = dynamic_cast<WorldCtx *>(world.get())->get_import(left_id);
+        import = dynamic_cast<WorldCtx *>(world.get())->get_import(left_id);
     }
     else if (ctx->type() == CtxType::Class) {
         auto klass = dynamic_cast<ClassCtx *>(ctx.get());
         auto world = dynamic_cast<WorldCtx *>(klass->get_world_owner().get());
-        ctx_ptr = world->get_import(left_id);
+        import = world->get_import(left_id);
     }
     else if (ctx->type() == CtxType::Closure) {
         auto world = dynamic_cast<ClosureCtx *>(ctx.get())->get_outer_world_owner();
-        ctx_ptr = dynamic_cast<WorldCtx *>(world.get())->get_import(left_id);
+        import = dynamic_cast<WorldCtx *>(world.get())->get_import(left_id);
     }
 
-    std::shared_ptr<Ctx> &other_ctx = *ctx_ptr;
+    std::shared_ptr<Ctx> &other_ctx = import->m_ctx;
+    const bool almost = import->m_depth == COMMON_DEPTH_ALMOST;
 
     std::visit([&](auto &&arg) {
         using T = std::decay_t<decltype(arg)>;
@@ -802,6 +957,11 @@ eval_expr_term_mod_access(ExprModAccess *expr, std::shared_ptr<Ctx> &ctx, bool r
     if (right_er.is_class_instant()) {
         assert(right_er.ctx->type() == CtxType::World);
         WorldCtx *world = dynamic_cast<WorldCtx *>(right_er.ctx.get());
+        if (almost && world->class_is_defined(right_er.id)) {
+            Err::err_wexpr(expr);
+            std::string msg = "class `"+right_er.id+"` in module `"+left_id+"` is not available as it was imported with `" COMMON_EARLKW_ALMOST "`";
+            throw InterpreterException(msg);
+        }
         if (world->class_is_defined(right_er.id)) {
             if ((world->class_get(right_er.id)->m_attrs & static_cast<uint32_t>(Attr::Pub)) == 0) {
                 Err::err_wexpr(expr);
@@ -816,6 +976,11 @@ eval_expr_term_mod_access(ExprModAccess *expr, std::shared_ptr<Ctx> &ctx, bool r
     if (right_er.is_function_ident()) {
         // Check if the function has @pub attribute
         if (right_er.ctx->function_exists(right_er.id)) {
+            if (almost) {
+                std::string msg = "function `"+right_er.id+"` in module `"+left_id+"` is not available as it was imported with `" COMMON_EARLKW_ALMOST "`";
+                Err::err_wexpr(left_ident);
+                throw InterpreterException(msg);
+            }
             if (!right_er.ctx->function_get(right_er.id)->is_pub()) {
                 std::string msg = "function `"+right_er.id+"` in module `"+left_id+"` does not contain the @pub attribute";
                 Err::err_wexpr(left_ident);
@@ -857,9 +1022,61 @@ eval_expr_term_mod_access(ExprModAccess *expr, std::shared_ptr<Ctx> &ctx, bool r
         assert(false && "unimplemented");
 }
 
+/// @brief The class instance that `this` refers to in a method, or nullptr
+static ClassCtx *
+this_class_ctx(std::shared_ptr<Ctx> &ctx) {
+    if (ctx->type() != CtxType::Function)
+        return nullptr;
+    auto fctx = static_cast<FunctionCtx *>(ctx.get());
+    if (!fctx->in_class())
+        return nullptr;
+    auto &owner = fctx->get_outer_class_owner_ctx();
+    return owner->type() == CtxType::Class ? static_cast<ClassCtx *>(owner.get()) : nullptr;
+}
+
+/// @brief Type feedback for `x.member`. Quickens when the member
+/// lives in a slot of the same class layout every time.
+static void
+class_slot_observe(ExprGet *expr, ClassCtx *cctx) {
+    if (!cctx || !cctx->desc() || !std::holds_alternative<std::unique_ptr<ExprIdent>>(expr->m_right)) {
+        expr->m_quick.observe(ExprGet::Quick::Generic);
+        return;
+    }
+    const std::string &id = std::get<std::unique_ptr<ExprIdent>>(expr->m_right)->m_tok->lexeme();
+    int slot = cctx->desc()->slot(id);
+    if (slot == -1 || !cctx->member(slot)) {
+        expr->m_quick.observe(ExprGet::Quick::Generic);
+        return;
+    }
+    if (cctx->desc() != expr->m_desc || slot != expr->m_slot) {
+        expr->m_desc = cctx->desc();
+        expr->m_slot = slot;
+        expr->m_quick.observe(ExprGet::Quick::Generic);
+    }
+    expr->m_quick.observe(ExprGet::Quick::ClassSlot);
+}
+
 ER
 eval_expr_term_get(ExprGet *expr, std::shared_ptr<Ctx> &ctx, bool ref) {
     ER left_er = Interpreter::eval_expr(expr->m_left.get(), ctx, ref);
+
+    // Only unpacked once, the left side may be a call.
+    std::shared_ptr<earl::value::Obj> left_value = nullptr;
+
+    if (expr->m_quick.m_kind == ExprGet::Quick::ClassSlot) {
+        bool this_ = left_er.id == "this";
+        ClassCtx *cctx = this_ ? this_class_ctx(ctx) : nullptr;
+        if (!this_) {
+            left_value = unpack_ER(left_er, ctx, true);
+            if (left_value->type() == earl::value::Type::Class)
+                cctx = dynamic_cast<ClassCtx *>(static_cast<earl::value::Class *>(left_value.get())->ctx().get());
+        }
+        earl::variable::Obj *var = cctx && cctx->desc() == expr->m_desc ? cctx->member(expr->m_slot) : nullptr;
+        if (var && (this_ || var->is_pub()))
+            return ER(ref || this_ ? var->value() : var->value()->copy(), ERT::Literal);
+        expr->m_quick.deopt();
+    }
+
     ER right_er(std::shared_ptr<earl::value::Obj>{}, ERT::None);
 
     std::visit([&](auto &&arg) {
@@ -908,6 +1125,7 @@ eval_expr_term_get(ExprGet *expr, std::shared_ptr<Ctx> &ctx, bool ref) {
 
             PackedERPreliminary perp(nullptr, true);
             value = unpack_ER(right_er, fctx->get_outer_class_owner_ctx(), /*ref=*/true, /*perp=*/&perp);
+            class_slot_observe(expr, this_class_ctx(ctx));
         }
         else {
             std::string msg = "Must be in a function in a class context to use the `this` keyword";
@@ -917,7 +1135,8 @@ eval_expr_term_get(ExprGet *expr, std::shared_ptr<Ctx> &ctx, bool ref) {
         return ER(value, ERT::Literal);
     }
     else {
-        auto left_value = unpack_ER(left_er, ctx, true);
+        if (!left_value)
+            left_value = unpack_ER(left_er, ctx, true);
         PackedERPreliminary perp(left_value, /*this=*/false, /*errtok=*/expr->m_tok.get());
         std::shared_ptr<earl::value::Obj> value = nullptr;
 
@@ -926,7 +1145,9 @@ eval_expr_term_get(ExprGet *expr, std::shared_ptr<Ctx> &ctx, bool ref) {
             // and we need the left (left_value)'s context with the preliminary value of (perp).
             // auto cctx = dynamic_cast<earl::value::Class *>(left_value.get())->ctx();
             // dynamic_cast<ClassCtx *>(cctx.get())->function_debug_dump();
-            value = unpack_ER(right_er, dynamic_cast<earl::value::Class *>(left_value.get())->ctx(), ref, &perp);
+            auto &cctx = dynamic_cast<earl::value::Class *>(left_value.get())->ctx();
+            value = unpack_ER(right_er, cctx, ref, &perp);
+            class_slot_observe(expr, dynamic_cast<ClassCtx *>(cctx.get()));
         }
         else
             // Function chaining and member intrinsics...
@@ -940,20 +1161,7 @@ eval_expr_term_get(ExprGet *expr, std::shared_ptr<Ctx> &ctx, bool ref) {
 
 static ER
 eval_expr_term_charlit(ExprCharLit *expr) {
-    std::shared_ptr<earl::value::Char> value = nullptr;
-    if (expr->m_tok->lexeme() == "\\n")
-        value = std::make_shared<earl::value::Char>('\n');
-    else if (expr->m_tok->lexeme() == "\\t")
-        value = std::make_shared<earl::value::Char>('\t');
-    else if (expr->m_tok->lexeme() == "\\r")
-        value = std::make_shared<earl::value::Char>('\r');
-    else if (expr->m_tok->lexeme() == "\\0")
-        value = std::make_shared<earl::value::Char>('\0');
-    else if (expr->m_tok->lexeme() == "\\\\")
-        value = std::make_shared<earl::value::Char>('\\');
-    else
-        value = std::make_shared<earl::value::Char>(expr->m_tok->lexeme()[0]);
-    return ER(value, ERT::Literal);
+    return ER(expr->m_value, static_cast<ERT>(ERT::Literal|ERT::Constant));
 }
 
 static ER
@@ -975,9 +1183,25 @@ eval_expr_term_array_access(ExprArrayAccess *expr, std::shared_ptr<Ctx> &ctx, bo
     auto left_value = unpack_ER(left_er, ctx, true);
     auto idx_value = unpack_ER(idx_er, ctx, true);
 
+    const bool list_int = left_value->type() == earl::value::Type::List
+        && idx_value->type() == earl::value::Type::Int;
+    if (expr->m_quick.m_kind == ExprArrayAccess::Quick::ListInt) {
+        if (list_int) {
+            auto list = static_cast<earl::value::List *>(left_value.get());
+            int idx = static_cast<earl::value::Int *>(idx_value.get())->value();
+            if (idx >= 0 && static_cast<size_t>(idx) < list->size())
+                return ER(list->at(idx, ref), static_cast<ERT>(ERT::Literal|ERT::ListAccess));
+            // Out of range, let the generic path report it.
+        }
+        else
+            expr->m_quick.deopt();
+    }
+    else
+        expr->m_quick.observe(list_int ? ExprArrayAccess::Quick::ListInt : ExprArrayAccess::Quick::Generic);
+
     if (left_value->type() == earl::value::Type::List) {
         auto list = dynamic_cast<earl::value::List *>(left_value.get());
-        return ER(list->nth(idx_value, expr), static_cast<ERT>(ERT::Literal|ERT::ListAccess));
+        return ER(list->nth(idx_value, expr, ref), static_cast<ERT>(ERT::Literal|ERT::ListAccess));
     }
     else if (left_value->type() == earl::value::Type::Str) {
         auto str = dynamic_cast<earl::value::Str *>(left_value.get());
@@ -1012,8 +1236,7 @@ eval_expr_term_array_access(ExprArrayAccess *expr, std::shared_ptr<Ctx> &ctx, bo
 
 static ER
 eval_expr_term_boollit(ExprBool *expr) {
-    auto value = std::make_shared<earl::value::Bool>(expr->m_value);
-    return ER(value, ERT::Literal);
+    return ER(expr->m_constant, static_cast<ERT>(ERT::Literal|ERT::Constant));
 }
 
 static ER
@@ -1037,8 +1260,7 @@ eval_expr_term_closure(ExprClosure *expr, std::shared_ptr<Ctx> &ctx, bool ref) {
 
 static ER
 eval_expr_term_floatlit(ExprFloatLit *expr) {
-    auto value = std::make_shared<earl::value::Float>(std::stof(expr->m_tok->lexeme()));
-    return ER(value, ERT::Literal);
+    return ER(expr->m_value, static_cast<ERT>(ERT::Literal|ERT::Constant));
 }
 
 static ER
@@ -1055,41 +1277,30 @@ eval_expr_term_range(ExprRange *expr, std::shared_ptr<Ctx> &ctx, bool ref) {
         throw InterpreterException(msg);
     }
 
-    std::vector<std::shared_ptr<earl::value::Obj>> values = {};
-
+    int64_t start, end;
     switch (lvalue->type()) {
     case earl::value::Type::Int: {
-        int start = dynamic_cast<earl::value::Int *>(lvalue.get())->value();
-        int end = dynamic_cast<earl::value::Int *>(rvalue.get())->value();
-        if (expr->m_inclusive) {
-            while (start <= end)
-                values.push_back(std::make_shared<earl::value::Int>(start++));
-        }
-        else {
-            while (start < end)
-                values.push_back(std::make_shared<earl::value::Int>(start++));
-        }
-        return ER(std::make_shared<earl::value::List>(std::move(values)), ERT::Literal);
+        start = dynamic_cast<earl::value::Int *>(lvalue.get())->value();
+        end = dynamic_cast<earl::value::Int *>(rvalue.get())->value();
     } break;
     case earl::value::Type::Char: {
-        char start = dynamic_cast<earl::value::Char *>(lvalue.get())->value();
-        char end = dynamic_cast<earl::value::Char *>(rvalue.get())->value();
-        if (expr->m_inclusive) {
-            while (start <= end)
-                values.push_back(std::make_shared<earl::value::Char>(start++));
-        }
-        else {
-            while (start < end)
-                values.push_back(std::make_shared<earl::value::Char>(start++));
-        }
-        return ER(std::make_shared<earl::value::List>(std::move(values)), ERT::Literal);
-    }
+        start = dynamic_cast<earl::value::Char *>(lvalue.get())->value();
+        end = dynamic_cast<earl::value::Char *>(rvalue.get())->value();
+    } break;
     default: {
         std::string msg = "invalid type "+earl::value::type_to_str(lvalue->type())+"` for type range";
         Err::err_wexpr(expr->m_start.get());
         throw InterpreterException(msg);
     } break;
     }
+
+    // Ranges are only turned into actual elements when something needs them.
+    if (expr->m_inclusive)
+        ++end;
+    size_t size = end > start ? static_cast<size_t>(end-start) : 0;
+    bool chars = lvalue->type() == earl::value::Type::Char;
+    earl::value::Range range = {static_cast<int>(start), size, chars};
+    return ER(std::make_shared<earl::value::List>(range), ERT::Literal);
 }
 
 static ER
@@ -1117,9 +1328,9 @@ eval_expr_term_slice(ExprSlice *expr, std::shared_ptr<Ctx> &ctx, bool ref) {
     }
 
     if (!s)
-        s = std::make_shared<earl::value::Void>();
+        s = earl::value::Void::instance();
     if (!e)
-        e = std::make_shared<earl::value::Void>();
+        e = earl::value::Void::instance();
 
     if (s->type() != earl::value::Type::Void && s->type() != earl::value::Type::Int) {
         if (expr->m_start.has_value())
@@ -1263,65 +1474,56 @@ eval_expr_term_dict(ExprDict *expr, std::shared_ptr<Ctx> &ctx, bool ref) {
 
 static ER
 eval_expr_term_fstr(ExprFStr *expr, std::shared_ptr<Ctx> &ctx, bool ref) {
-    const std::string &str = expr->m_tok->lexeme();
-    auto result = std::make_shared<earl::value::Str>();
-
-    auto until_closing = [](const std::string &s, size_t &it) -> std::string {
-        std::string buf = "";
-        while (it < s.size() && s[it] != '}') {
-            buf.push_back(s.at(it));
-            ++it;
+    (void)ref;
+    std::vector<std::string> strified = {};
+    strified.reserve(expr->m_parts.size());
+    size_t len = 0;
+
+    for (auto &part : expr->m_parts) {
+        if (std::holds_alternative<std::string>(part)) {
+            len += std::get<std::string>(part).size();
+            strified.emplace_back();
+            continue;
         }
-        return buf;
-    };
-
-    for (size_t i = 0; i < str.size(); ++i) {
-        char c = str.at(i);
-        if (c == '{') {
-            ++i;
-            std::string id = until_closing(str, i);
-            if (!ctx->variable_exists(id)) {
-                Err::err_wexpr(expr);
-
-                std::string msg = "variable `" + id + "` has not been defined\n";
-                auto avail = ctx->get_available_variable_names();
-                if (avail.size() != 0)
-                    msg += "did you mean: " + identifier_not_declared(id, avail) + "?";
+        ER er = Interpreter::eval_expr(std::get<std::unique_ptr<Expr>>(part).get(), ctx, false);
+        auto value = unpack_ER(er, ctx, true);
+        strified.push_back(value->to_cxxstring());
+        len += strified.back().size();
+    }
 
-                throw InterpreterException(msg);
-            }
-            auto var = ctx->variable_get(id);
-            std::string strified = var->value()->to_cxxstring();
-            result->append(strified);
-        }
+    std::string result = "";
+    result.reserve(len);
+    for (size_t i = 0; i < expr->m_parts.size(); ++i) {
+        if (std::holds_alternative<std::string>(expr->m_parts[i]))
+            result += std::get<std::string>(expr->m_parts[i]);
         else
-            result->append(c);
+            result += strified[i];
     }
 
-    return ER(result, ERT::Literal);
+    return ER(std::make_shared<earl::value::Str>(std::move(result)), ERT::Literal);
 }
 
 ER
 eval_expr_term(ExprTerm *expr, std::shared_ptr<Ctx> &ctx, bool ref) {
     switch (expr->get_term_type()) {
-    case ExprTermType::Ident:         return eval_expr_term_ident(dynamic_cast<ExprIdent *>(expr), ctx, ref);
-    case ExprTermType::Int_Literal:   return eval_expr_term_intlit(dynamic_cast<ExprIntLit *>(expr));
-    case ExprTermType::Str_Literal:   return eval_expr_term_strlit(dynamic_cast<ExprStrLit *>(expr));
-    case ExprTermType::Char_Literal:  return eval_expr_term_charlit(dynamic_cast<ExprCharLit *>(expr));
-    case ExprTermType::Float_Literal: return eval_expr_term_floatlit(dynamic_cast<ExprFloatLit *>(expr));
-    case ExprTermType::Func_Call:     return eval_expr_term_funccall(dynamic_cast<ExprFuncCall *>(expr), ctx, ref);
-    case ExprTermType::List_Literal:  return eval_expr_term_listlit(dynamic_cast<ExprListLit *>(expr), ctx, ref);
-    case ExprTermType::Get:           return eval_expr_term_get(dynamic_cast<ExprGet *>(expr), ctx, ref);
-    case ExprTermType::Mod_Access:    return eval_expr_term_mod_access(dynamic_cast<ExprModAccess *>(expr), ctx, ref);
-    case ExprTermType::Array_Access:  return eval_expr_term_array_access(dynamic_cast<ExprArrayAccess *>(expr), ctx, ref);
-    case ExprTermType::Bool:          return eval_expr_term_boollit(dynamic_cast<ExprBool *>(expr));
-    case ExprTermType::None:          return eval_expr_term_none(dynamic_cast<ExprNone *>(expr));
-    case ExprTermType::Closure:       return eval_expr_term_closure(dynamic_cast<ExprClosure *>(expr), ctx, ref);
-    case ExprTermType::Range:         return eval_expr_term_range(dynamic_cast<ExprRange *>(expr), ctx, ref);
-    case ExprTermType::Tuple:         return eval_expr_term_tuple(dynamic_cast<ExprTuple *>(expr), ctx, ref);
-    case ExprTermType::Slice:         return eval_expr_term_slice(dynamic_cast<ExprSlice *>(expr), ctx, ref);
-    case ExprTermType::Dict:          return eval_expr_term_dict(dynamic_cast<ExprDict *>(expr), ctx, ref);
-    case ExprTermType::FStr:          return eval_expr_term_fstr(dynamic_cast<ExprFStr *>(expr), ctx, ref);
+    case ExprTermType::Ident:         return eval_expr_term_ident(static_cast<ExprIdent *>(expr), ctx, ref);
+    case ExprTermType::Int_Literal:   return eval_expr_term_intlit(static_cast<ExprIntLit *>(expr));
+    case ExprTermType::Str_Literal:   return eval_expr_term_strlit(static_cast<ExprStrLit *>(expr));
+    case ExprTermType::Char_Literal:  return eval_expr_term_charlit(static_cast<ExprCharLit *>(expr));
+    case ExprTermType::Float_Literal: return eval_expr_term_floatlit(static_cast<ExprFloatLit *>(expr));
+    case ExprTermType::Func_Call:     return eval_expr_term_funccall(static_cast<ExprFuncCall *>(expr), ctx, ref);
+    case ExprTermType::List_Literal:  return eval_expr_term_listlit(static_cast<ExprListLit *>(expr), ctx, ref);
+    case ExprTermType::Get:           return eval_expr_term_get(static_cast<ExprGet *>(expr), ctx, ref);
+    case ExprTermType::Mod_Access:    return eval_expr_term_mod_access(static_cast<ExprModAccess *>(expr), ctx, ref);
+    case ExprTermType::Array_Access:  return eval_expr_term_array_access(static_cast<ExprArrayAccess *>(expr), ctx, ref);
+    case ExprTermType::Bool:          return eval_expr_term_boollit(static_cast<ExprBool *>(expr));
+    case ExprTermType::None:          return eval_expr_term_none(static_cast<ExprNone *>(expr));
+    case ExprTermType::Closure:       return eval_expr_term_closure(static_cast<ExprClosure *>(expr), ctx, ref);
+    case ExprTermType::Range:         return eval_expr_term_range(static_cast<ExprRange *>(expr), ctx, ref);
+    case ExprTermType::Tuple:         return eval_expr_term_tuple(static_cast<ExprTuple *>(expr), ctx, ref);
+    case ExprTermType::Slice:         return eval_expr_term_slice(static_cast<ExprSlice *>(expr), ctx, ref);
+    case ExprTermType::Dict:          return eval_expr_term_dict(static_cast<ExprDict *>(expr), ctx, ref);
+    case ExprTermType::FStr:          return eval_expr_term_fstr(static_cast<ExprFStr *>(expr), ctx, ref);
     default: {
         std::string msg = "unknown term: `"+std::to_string((int)expr->get_term_type())+"`";
         throw InterpreterException(msg);
@@ -1331,10 +1533,79 @@ eval_expr_term(ExprTerm *expr, std::shared_ptr<Ctx> &ctx, bool ref) {
     return ER(nullptr, ERT::None);
 }
 
+template <typename T, typename R>
+static std::shared_ptr<earl::value::Obj>
+numeric_kernel(TokenType op, T l, T r) {
+    switch (op) {
+    case TokenType::Plus:               return std::make_shared<R>(l + r);
+    case TokenType::Minus:              return std::make_shared<R>(l - r);
+    case TokenType::Asterisk:           return std::make_shared<R>(l * r);
+    case TokenType::Forwardslash:       return std::make_shared<R>(l / r);
+    case TokenType::Lessthan:           return std::make_shared<earl::value::Bool>(l < r);
+    case TokenType::Greaterthan:        return std::make_shared<earl::value::Bool>(l > r);
+    case TokenType::Lessthan_Equals:    return std::make_shared<earl::value::Bool>(l <= r);
+    case TokenType::Greaterthan_Equals: return std::make_shared<earl::value::Bool>(l >= r);
+    case TokenType::Double_Equals:      return std::make_shared<earl::value::Bool>(l == r);
+    case TokenType::Bang_Equals:        return std::make_shared<earl::value::Bool>(l != r);
+    case TokenType::Percent: {
+        if constexpr (std::is_integral_v<T>)
+            return std::make_shared<R>(l % r);
+        return nullptr;
+    }
+    default: return nullptr;
+    }
+}
+
+/// @brief Whether `numeric_kernel` handles `op` for operands of type `T`
+template <typename T>
+static bool
+numeric_kernel_has(TokenType op) {
+    switch (op) {
+    case TokenType::Plus:
+    case TokenType::Minus:
+    case TokenType::Asterisk:
+    case TokenType::Forwardslash:
+    case TokenType::Lessthan:
+    case TokenType::Greaterthan:
+    case TokenType::Lessthan_Equals:
+    case TokenType::Greaterthan_Equals:
+    case TokenType::Double_Equals:
+    case TokenType::Bang_Equals: return true;
+    case TokenType::Percent:     return std::is_integral_v<T>;
+    default:                     return false;
+    }
+}
+
+/// @brief Evaluate arithmetic and comparisons on two ints/floats
+/// without going through the virtual binop methods. Mirrors
+/// the semantics of Int/Float, returning nullptr for anything
+/// it does not handle so the caller falls back to them.
+static std::shared_ptr<earl::value::Obj>
+eval_numeric_binop(TokenType op, earl::value::Obj *lhs, earl::value::Obj *rhs) {
+    using earl::value::Type;
+    const Type lt = lhs->type(), rt = rhs->type();
+
+    if (lt == Type::Int && rt == Type::Int) {
+        int l = static_cast<earl::value::Int *>(lhs)->value();
+        int r = static_cast<earl::value::Int *>(rhs)->value();
+        return numeric_kernel<int, earl::value::Int>(op, l, r);
+    }
+
+    if ((lt != Type::Int && lt != Type::Float) || (rt != Type::Int && rt != Type::Float))
+        return nullptr;
+
+    double l = lt == Type::Int ? static_cast<earl::value::Int *>(lhs)->value()
+        : static_cast<earl::value::Float *>(lhs)->value();
+    double r = rt == Type::Int ? static_cast<earl::value::Int *>(rhs)->value()
+        : static_cast<earl::value::Float *>(rhs)->value();
+    return numeric_kernel<double, earl::value::Float>(op, l, r);
+}
+
 ER
 eval_expr_bin(ExprBinary *expr, std::shared_ptr<Ctx> &ctx, bool ref) {
+    // Operands are only read, so constants do not need to be copied.
     ER lhs = Interpreter::eval_expr(expr->m_lhs.get(), ctx, ref);
-    auto lhs_value = unpack_ER(lhs, ctx, true);
+    auto lhs_value = lhs.is_constant() ? lhs.value : unpack_ER(lhs, ctx, true);
 
     // Short-circuit evaluation for logical AND (&&)
     if (expr->m_op->type() == TokenType::Double_Ampersand) {
@@ -1355,60 +1626,99 @@ eval_expr_bin(ExprBinary *expr, std::shared_ptr<Ctx> &ctx, bool ref) {
     }
 
     ER rhs = Interpreter::eval_expr(expr->m_rhs.get(), ctx, ref);
-    auto rhs_value = unpack_ER(rhs, ctx, ref);
-    // auto result = lhs_value->binop(expr->m_op.get(), rhs_value);
-    std::shared_ptr<earl::value::Obj> result = nullptr;
-    switch (expr->m_op.get()->type()) {
+    auto rhs_value = rhs.is_constant() ? rhs.value : unpack_ER(rhs, ctx, ref);
+
+    const TokenType op = expr->m_op->type();
+    const earl::value::Type lt = lhs_value->type(), rt = rhs_value->type();
+
+    switch (expr->m_quick.m_kind) {
+    case ExprBinary::Quick::Int: {
+        if (lt == earl::value::Type::Int && rt == earl::value::Type::Int)
+            return ER(numeric_kernel<int, earl::value::Int>(op,
+                                                            static_cast<earl::value::Int *>(lhs_value.get())->value(),
+                                                            static_cast<earl::value::Int *>(rhs_value.get())->value()),
+                      ERT::Literal);
+        expr->m_quick.deopt();
+    } break;
+    case ExprBinary::Quick::Float: {
+        if (lt == earl::value::Type::Float && rt == earl::value::Type::Float)
+            return ER(numeric_kernel<double, earl::value::Float>(op,
+                                                                 static_cast<earl::value::Float *>(lhs_value.get())->value(),
+                                                                 static_cast<earl::value::Float *>(rhs_value.get())->value()),
+                      ERT::Literal);
+        expr->m_quick.deopt();
+    } break;
+    case ExprBinary::Quick::Generic: {
+        if (lt == earl::value::Type::Int && rt == earl::value::Type::Int && numeric_kernel_has<int>(op))
+            expr->m_quick.observe(ExprBinary::Quick::Int);
+        else if (lt == earl::value::Type::Float && rt == earl::value::Type::Float && numeric_kernel_has<double>(op))
+            expr->m_quick.observe(ExprBinary::Quick::Float);
+        else
+            expr->m_quick.observe(ExprBinary::Quick::Generic);
+    } break;
+    }
+
+    return ER(Interpreter::binop(expr->m_op.get(), lhs_value.get(), rhs_value.get()), ERT::Literal);
+}
+
+std::shared_ptr<earl::value::Obj>
+Interpreter::binop(Token *op, earl::value::Obj *lhs_value, earl::value::Obj *rhs_value) {
+    std::shared_ptr<earl::value::Obj> result
+        = eval_numeric_binop(op->type(), lhs_value, rhs_value);
+    if (result)
+        return result;
+
+    switch (op->type()) {
     case TokenType::Plus: {
-        result = lhs_value->add(expr->m_op.get(), rhs_value.get());
+        result = lhs_value->add(op, rhs_value);
     } break;
     case TokenType::Minus: {
-        result = lhs_value->sub(expr->m_op.get(), rhs_value.get());
+        result = lhs_value->sub(op, rhs_value);
     } break;
     case TokenType::Asterisk: {
-        result = lhs_value->multiply(expr->m_op.get(), rhs_value.get());
+        result = lhs_value->multiply(op, rhs_value);
     } break;
     case TokenType::Forwardslash: {
-        result = lhs_value->divide(expr->m_op.get(), rhs_value.get());
+        result = lhs_value->divide(op, rhs_value);
     } break;
     case TokenType::Percent: {
-        result = lhs_value->modulo(expr->m_op.get(), rhs_value.get());
+        result = lhs_value->modulo(op, rhs_value);
     } break;
     case TokenType::Double_Asterisk: {
-        result = lhs_value->power(expr->m_op.get(), rhs_value.get());
+        result = lhs_value->power(op, rhs_value);
     } break;
     case TokenType::Greaterthan:
     case TokenType::Lessthan:
     case TokenType::Greaterthan_Equals:
     case TokenType::Lessthan_Equals: {
-        result = lhs_value->gtequality(expr->m_op.get(), rhs_value.get());
+        result = lhs_value->gtequality(op, rhs_value);
     } break;
     case TokenType::Double_Equals:
     case TokenType::Bang_Equals: {
-        result = lhs_value->equality(expr->m_op.get(), rhs_value.get());
+        result = lhs_value->equality(op, rhs_value);
     } break;
     case TokenType::Backtick_Pipe:
     case TokenType::Backtick_Caret:
     case TokenType::Backtick_Ampersand: {
-        result = lhs_value->bitwise(expr->m_op.get(), rhs_value.get());
+        result = lhs_value->bitwise(op, rhs_value);
     } break;
     case TokenType::Double_Lessthan:
     case TokenType::Double_Greaterthan: {
-        result = lhs_value->bitshift(expr->m_op.get(), rhs_value.get());
+        result = lhs_value->bitshift(op, rhs_value);
     } break;
     default: {
-        Err::err_wtok(expr->m_op.get());
+        Err::err_wtok(op);
         const std::string msg = "invalid operator";
         throw InterpreterException(msg);
     } break;
     }
-    return ER(result, ERT::Literal);
+    return result;
 }
 
 ER
 eval_expr_unary(ExprUnary *expr, std::shared_ptr<Ctx> &ctx, bool ref) {
     ER rhs = Interpreter::eval_expr(expr->m_expr.get(), ctx, ref);
-    auto expr_value = unpack_ER(rhs, ctx, ref);
+    auto expr_value = rhs.is_constant() ? rhs.value : unpack_ER(rhs, ctx, ref);
     auto result = expr_value->unaryop(expr->m_op.get());
     return ER(result, ERT::Literal);
 }
@@ -1417,20 +1727,24 @@ ER
 Interpreter::eval_expr(Expr *expr, std::shared_ptr<Ctx> &ctx, bool ref) {
     switch (expr->get_type()) {
     case ExprType::Term: {
-        return eval_expr_term(dynamic_cast<ExprTerm *>(expr), ctx, ref);
+        return eval_expr_term(static_cast<ExprTerm *>(expr), ctx, ref);
     } break;
     case ExprType::Binary: {
-        return eval_expr_bin(dynamic_cast<ExprBinary *>(expr), ctx, ref);
+        return eval_expr_bin(static_cast<ExprBinary *>(expr), ctx, ref);
     } break;
     case ExprType::Unary: {
-        return eval_expr_unary(dynamic_cast<ExprUnary *>(expr), ctx, ref);
+        return eval_expr_unary(static_cast<ExprUnary *>(expr), ctx, ref);
     } break;
     default:
         assert(false && "unreachable");
     }
 }
 
-// TODO: optimize types by using numbers instead of std::strings.
+std::shared_ptr<earl::value::Obj>
+Interpreter::unpack(ER &er, std::shared_ptr<Ctx> &ctx, bool ref) {
+    return unpack_ER(er, ctx, ref);
+}
+
 void
 Interpreter::typecheck(__Type *ty, earl::value::Obj *value, std::shared_ptr<Ctx> &ctx) {
     if (ty->m_sub_ty.has_value()) {
@@ -1461,8 +1775,9 @@ Interpreter::typecheck(__Type *ty, earl::value::Obj *value, std::shared_ptr<Ctx>
             throw InterpreterException(msg);
         }
 
-        auto modctx = dynamic_cast<WorldCtx *>(wctx->get_import(modulename)->get());
-        if (!modctx->class_is_defined(classname)) {
+        WorldCtx::Import *import = wctx->get_import(modulename);
+        auto modctx = dynamic_cast<WorldCtx *>(import->m_ctx.get());
+        if (import->m_depth == COMMON_DEPTH_ALMOST || !modctx->class_is_defined(classname)) {
             Err::err_wtok(ty->m_sub_ty.value().get());
             const std::string msg = "class `"+classname+"` does not exist in module `"+modulename+"`";
             throw InterpreterException(msg);
@@ -1471,33 +1786,12 @@ Interpreter::typecheck(__Type *ty, earl::value::Obj *value, std::shared_ptr<Ctx>
         assert(false);
     }
 
+    if ((ty->m_mask & (1ull << static_cast<int>(value->type()))) != 0)
+        return;
+
     const std::string &tyname = ty->m_main_ty->lexeme();
 
-    if (tyname == COMMON_EARLTY_ANY)                                                         return;
-    else if (tyname == COMMON_EARLTY_INT32 && value->type() == earl::value::Type::Int)       return;
-    else if (tyname == COMMON_EARLTY_FLOAT && value->type() == earl::value::Type::Float)     return;
-    else if (tyname == COMMON_EARLTY_STR && value->type() == earl::value::Type::Str)         return;
-    else if (tyname == COMMON_EARLTY_UNIT
-             && (value->type() == earl::value::Type::Void
-                 || value->type() == earl::value::Type::Return))                             return;
-    else if (tyname == COMMON_EARLTY_CHAR && value->type() == earl::value::Type::Char)       return;
-    else if (tyname == COMMON_EARLTY_BOOL && value->type() == earl::value::Type::Bool)       return;
-    else if (tyname == COMMON_EARLTY_LIST && value->type() == earl::value::Type::List)       return;
-    else if (tyname == COMMON_EARLTY_TUPLE && value->type() == earl::value::Type::Tuple)     return;
-    else if (tyname == COMMON_EARLTY_FILE && value->type() == earl::value::Type::File)       return;
-    else if (tyname == COMMON_EARLTY_CLOSURE && value->type() == earl::value::Type::Closure) return;
-    else if (tyname == COMMON_EARLTY_OPTION && value->type() == earl::value::Type::Option)   return;
-    else if (tyname == COMMON_EARLTY_SLICE && value->type() == earl::value::Type::Slice)     return;
-    else if (tyname == COMMON_EARLTY_DICT
-             && (value->type() == earl::value::Type::DictInt
-                 || value->type() == earl::value::Type::DictStr
-                 || value->type() == earl::value::Type::DictFloat
-                 || value->type() == earl::value::Type::DictChar))                           return;
-    else if (tyname == COMMON_EARLTY_TYPE && value->type() == earl::value::Type::TypeKW)     return;
-    else if (tyname == COMMON_EARLTY_REAL
-             && (value->type() == earl::value::Type::Int
-                 || value->type() == earl::value::Type::Float))                              return;
-    else if (value->type() == earl::value::Type::Class) {
+    if (value->type() == earl::value::Type::Class) {
         auto klass = dynamic_cast<earl::value::Class *>(value);
         if (klass->id() == tyname)
             return;
@@ -1575,12 +1869,14 @@ eval_stmt_let_wmultiple_vars(StmtLet *stmt, std::shared_ptr<Ctx> &ctx) {
             std::shared_ptr<earl::variable::Obj> var
                 = std::make_shared<earl::variable::Obj>(stmt->m_ids.at(i).get(), tuple->value().at(i), stmt->m_attrs);
             ctx->variable_add(var);
+            if (stmt->m_slots.size() != 0)
+                ctx->m_frame.set(stmt->m_slots.at(i), var);
         }
         ++i;
     }
 
     stmt->m_evald = true;
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
@@ -1621,7 +1917,7 @@ eval_stmt_let(StmtLet *stmt, std::shared_ptr<Ctx> &ctx) {
         value = unpack_ER(rhs, ctx, ref);
 
     if (id == "_")
-        return std::make_shared<earl::value::Void>();
+        return earl::value::Void::instance();
 
     if (_const || value->type() == earl::value::Type::Tuple)
         value->set_const();
@@ -1632,8 +1928,10 @@ eval_stmt_let(StmtLet *stmt, std::shared_ptr<Ctx> &ctx) {
     std::shared_ptr<earl::variable::Obj> var
         = std::make_shared<earl::variable::Obj>(stmt->m_ids.at(0).get(), value, stmt->m_attrs);
     ctx->variable_add(var);
+    if (stmt->m_slots.size() != 0)
+        ctx->m_frame.set(stmt->m_slots.at(0), var);
     stmt->m_evald = true;
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
@@ -1650,6 +1948,9 @@ eval_stmt_expr(StmtExpr *stmt, std::shared_ptr<Ctx> &ctx) {
 
 std::shared_ptr<earl::value::Obj>
 Interpreter::eval_stmt_block(StmtBlock *block, std::shared_ptr<Ctx> &ctx) {
+    if ((flags & __VM) != 0)
+        return VM::exec_block(block, ctx);
+
     std::shared_ptr<earl::value::Obj> result = nullptr;
     ctx->push_scope();
 
@@ -1661,7 +1962,7 @@ Interpreter::eval_stmt_block(StmtBlock *block, std::shared_ptr<Ctx> &ctx) {
         //     break;
         if (block->m_stmts.at(i)->stmt_type() == StmtType::Return) {
             if (!result || result->type() == earl::value::Type::Void) {
-                result = std::make_shared<earl::value::Return>();
+                result = earl::value::Return::instance();
             }
             break;
         }
@@ -1670,7 +1971,7 @@ Interpreter::eval_stmt_block(StmtBlock *block, std::shared_ptr<Ctx> &ctx) {
     ctx->pop_scope();
     block->m_evald = true;
     if (!result)
-        result = std::make_shared<earl::value::Void>();
+        result = earl::value::Void::instance();
     return result;
 }
 
@@ -1700,7 +2001,7 @@ eval_stmt_def(StmtDef *stmt, std::shared_ptr<Ctx> &ctx) {
     auto func = std::make_shared<earl::function::Obj>(stmt, args, stmt->m_id.get(), explicit_type);
     ctx->function_add(func);
     stmt->m_evald = true;
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
@@ -1720,13 +2021,32 @@ eval_stmt_if(StmtIf *stmt, std::shared_ptr<Ctx> &ctx) {
 
 std::shared_ptr<earl::value::Obj>
 eval_stmt_return(StmtReturn *stmt, std::shared_ptr<Ctx> &ctx) {
+    ExprFuncCall *call = stmt->tail_call();
+    if (call && ctx->type() == CtxType::Function) {
+        const std::string &id = dynamic_cast<ExprIdent *>(call->m_left.get())->m_tok->lexeme();
+        auto fctx = dynamic_cast<FunctionCtx *>(ctx.get());
+        // Only a function that the caller of this one would find the
+        // same way can take its place.
+        if (!Intrinsics::is_intrinsic(id)
+            && !Intrinsics::is_member_intrinsic(id)
+            && !ctx->get_world()->class_is_defined(id)
+            && ctx->function_exists(id)
+            && ctx->function_get(id) == fctx->get_immediate_owner()->function_get(id)) {
+            std::variant<std::shared_ptr<earl::function::Obj>, earl::value::Closure *> v = ctx->function_get(id);
+            fctx->m_tail_params = evaluate_function_parameters_wrefs(call, v, ctx);
+            fctx->m_tail_func = std::get<std::shared_ptr<earl::function::Obj>>(v);
+            stmt->m_evald = true;
+            return earl::value::Return::instance();
+        }
+    }
+
     if (stmt->m_expr.has_value()) {
         ER er = Interpreter::eval_expr(stmt->m_expr.value().get(), ctx, false);
         stmt->m_evald = true;
         return unpack_ER(er, ctx, false);
     }
     stmt->m_evald = true;
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
@@ -1734,7 +2054,7 @@ eval_stmt_break(StmtBreak *stmt, std::shared_ptr<Ctx> &ctx) {
     (void)stmt;
     (void)ctx;
     stmt->m_evald = true;
-    return std::make_shared<earl::value::Break>();
+    return earl::value::Break::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
@@ -1773,7 +2093,7 @@ eval_stmt_mut(StmtMut *stmt, std::shared_ptr<Ctx> &ctx) {
     } break;
     }
     stmt->m_evald = true;
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
@@ -1786,6 +2106,11 @@ eval_stmt_while(StmtWhile *stmt, std::shared_ptr<Ctx> &ctx) {
     expr_result = unpack_ER(expr_er, ctx, /*ref=*/true);
 
     while (expr_result->boolean()) {
+        if ((flags & __JIT) != 0 && JIT::run(stmt, stmt->m_jit, ctx)) {
+            result = nullptr;
+            break;
+        }
+
         result = Interpreter::eval_stmt_block(stmt->m_block.get(), ctx);
 
         if (result && result->type() == earl::value::Type::Break) {
@@ -1793,10 +2118,8 @@ eval_stmt_while(StmtWhile *stmt, std::shared_ptr<Ctx> &ctx) {
             break;
         }
 
-        if (result && result->type() == earl::value::Type::Continue)
-            continue;
-
-        if (result && result->type() != earl::value::Type::Void) {
+        if (result && result->type() != earl::value::Type::Void
+            && result->type() != earl::value::Type::Continue) {
             break;
         }
 
@@ -1807,7 +2130,7 @@ eval_stmt_while(StmtWhile *stmt, std::shared_ptr<Ctx> &ctx) {
     }
 
     if (result && (result->type() == earl::value::Type::Continue || result->type() == earl::value::Type::Break))
-        result = std::make_shared<earl::value::Void>();
+        result = earl::value::Void::instance();
 
     stmt->m_evald = true;
     return result;
@@ -1898,6 +2221,10 @@ eval_stmt_foreach(StmtForeach *stmt, std::shared_ptr<Ctx> &ctx) {
         }
     }
 
+    // The elements of a lazy range must exist to be referenced.
+    if (ref && expr->type() == earl::value::Type::List)
+        (void)dynamic_cast<earl::value::List *>(expr.get())->value();
+
     std::vector<std::shared_ptr<earl::variable::Obj>> enumerators(stmt->m_enumerators.size(), nullptr);
     auto wrapped_iterator = expr->iter_begin(), wrapped_iterator_end = expr->iter_end();
 
@@ -1911,6 +2238,10 @@ eval_stmt_foreach(StmtForeach *stmt, std::shared_ptr<Ctx> &ctx) {
                           std::is_same_v<T, earl::value::StrIterator>) {
                 handle_enumerators(*it);
             }
+            else if constexpr (std::is_same_v<T, earl::value::RangeIterator>) {
+                auto value = *it;
+                handle_enumerators(value);
+            }
             else {
                 static_assert(std::is_same_v<T, earl::value::DictIntIterator> ||
                               std::is_same_v<T, earl::value::DictCharIterator> ||
@@ -1945,8 +2276,11 @@ eval_stmt_foreach(StmtForeach *stmt, std::shared_ptr<Ctx> &ctx) {
     iterator_reduce(wrapped_iterator, [&](auto &tuple){
         destructure_enumerators(stmt->m_enumerators, enumerators, tuple, stmt->m_attrs, stmt->m_expr.get());
     });
-    for (size_t i = 0; i < enumerators.size(); ++i)
+    for (size_t i = 0; i < enumerators.size(); ++i) {
         ctx->variable_add(enumerators[i]);
+        if (stmt->m_slots.size() != 0)
+            ctx->m_frame.set(stmt->m_slots.at(i), enumerators[i]);
+    }
 
     // Main loop
     while (true) {
@@ -1982,7 +2316,7 @@ eval_stmt_foreach(StmtForeach *stmt, std::shared_ptr<Ctx> &ctx) {
  done:
 
     if (result && (result->type() == earl::value::Type::Continue || result->type() == earl::value::Type::Break))
-        result = std::make_shared<earl::value::Void>();
+        result = earl::value::Void::instance();
 
     stmt->m_evald = true;
     return result;
@@ -2007,6 +2341,7 @@ eval_stmt_for(StmtFor *stmt, std::shared_ptr<Ctx> &ctx) {
         throw InterpreterException(msg);
     }
     ctx->variable_add(enumerator);
+    ctx->m_frame.set(stmt->m_slot, enumerator);
 
     earl::value::Int *start = dynamic_cast<earl::value::Int *>(start_expr.get());
     earl::value::Int *end = dynamic_cast<earl::value::Int *>(end_expr.get());
@@ -2015,6 +2350,11 @@ eval_stmt_for(StmtFor *stmt, std::shared_ptr<Ctx> &ctx) {
     bool gt = start->value() > end->value();
 
     while (true) {
+        if ((flags & __JIT) != 0 && JIT::run(stmt, stmt->m_jit, ctx, end->value(), lt)) {
+            result = nullptr;
+            break;
+        }
+
         if (lt && start->value() > end->value()-1)
             break;
         else if (gt && start->value() < end->value())
@@ -2047,7 +2387,7 @@ eval_stmt_for(StmtFor *stmt, std::shared_ptr<Ctx> &ctx) {
     ctx->variable_remove(enumerator->id());
 
     if (result && (result->type() == earl::value::Type::Continue || result->type() == earl::value::Type::Break))
-        result = std::make_shared<earl::value::Void>();
+        result = earl::value::Void::instance();
 
     stmt->m_evald = true;
     return result;
@@ -2057,14 +2397,24 @@ std::shared_ptr<earl::value::Obj>
 eval_stmt_class(StmtClass *stmt, std::shared_ptr<Ctx> &ctx) {
     dynamic_cast<WorldCtx *>(ctx.get())->define_class(stmt);
     stmt->m_evald = true;
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
 eval_stmt_mod(StmtMod *stmt, std::shared_ptr<Ctx> &ctx) {
     dynamic_cast<WorldCtx *>(ctx.get())->set_mod(stmt->m_id->lexeme());
     stmt->m_evald = true;
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
+}
+
+// The modules imported so far by their canonical path. Never
+// destroyed, the modules must not outlive the statics they use.
+static std::unordered_map<std::string, std::shared_ptr<Ctx>> &imported_modules =
+    *new std::unordered_map<std::string, std::shared_ptr<Ctx>>();
+
+void
+Interpreter::forget_imports(void) {
+    imported_modules.clear();
 }
 
 std::shared_ptr<earl::value::Obj>
@@ -2076,39 +2426,37 @@ eval_stmt_import(StmtImport *stmt, std::shared_ptr<Ctx> &ctx) {
         throw InterpreterException(msg);
     }
 
-    std::vector<std::string> keywords = COMMON_EARLKW_ASCPL;
-    std::vector<std::string> types    = {};
-    std::string comment               = COMMON_EARL_COMMENT;
-
     ER path_er = eval_expr(stmt->m_fp.get(), ctx, false);
     PackedERPreliminary perp;
     auto path_obj                     = unpack_ER(path_er, ctx, &perp);
     std::string path                  = path_obj->to_cxxstring();
-    std::string src_code              = read_file(path.c_str());
-    std::unique_ptr<Lexer> lexer      = lex_file(src_code,
-                                                 path,
-                                                 keywords,
-                                                 types,
-                                                 comment);
-    std::unique_ptr<Program> program = nullptr;
-    if ((flags & __CHECK) != 0)
-        program = Parser::parse_program(*lexer.get(), path, /*from=*/dynamic_cast<WorldCtx *>(ctx.get())->get_filepath());
-    else
-        program = Parser::parse_program(*lexer.get(), path);
 
-    std::shared_ptr<Ctx> child_ctx =
-        Interpreter::interpret(std::move(program), std::move(lexer));
-    if (stmt->m_as.has_value()) {
-        dynamic_cast<WorldCtx *>(child_ctx.get())
-            ->set_module_alias(stmt->m_as.value()->lexeme());
+    // A module runs once per process no matter how many files
+    // import it, every importer gets the same globals.
+    std::string key = Prefetch::module_key(path);
+
+    std::shared_ptr<Ctx> child_ctx = nullptr;
+    auto it = imported_modules.find(key);
+    if (it != imported_modules.end())
+        child_ctx = it->second;
+    else {
+        std::unique_ptr<Lexer> lexer      = nullptr;
+        std::unique_ptr<Program> program = Prefetch::take(key, lexer);
+        if (!program && (flags & __CHECK) != 0)
+            program = ModuleCache::parse_file(path, lexer, /*from=*/dynamic_cast<WorldCtx *>(ctx.get())->get_filepath());
+        else if (!program)
+            program = ModuleCache::parse_file(path, lexer);
+        child_ctx = Interpreter::interpret(std::move(program), std::move(lexer));
+        imported_modules[key] = child_ctx;
     }
 
-    if (stmt->__m_depth == COMMON_DEPTH_ALMOST)
-        dynamic_cast<WorldCtx *>(child_ctx.get())->strip_funs_and_classes();
+    std::optional<std::string> alias = {};
+    if (stmt->m_as.has_value())
+        alias = stmt->m_as.value()->lexeme();
 
-    dynamic_cast<WorldCtx *>(ctx.get())->add_import(std::move(child_ctx));
+    dynamic_cast<WorldCtx *>(ctx.get())->add_import(std::move(child_ctx), std::move(alias), stmt->__m_depth);
     stmt->m_evald = true;
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 static std::shared_ptr<earl::variable::Obj>
@@ -2137,74 +2485,217 @@ handle_match_some_branch(ExprFuncCall *expr, std::shared_ptr<earl::value::Obj> i
     return var;
 }
 
-std::shared_ptr<earl::value::Obj>
-eval_stmt_match(StmtMatch *stmt, std::shared_ptr<Ctx> &ctx) {
-    ER match_er = Interpreter::eval_expr(stmt->m_expr.get(), ctx, true);
-    auto match_value = unpack_ER(match_er, ctx, true);
-
-    // Go through the branches
-    for (size_t i = 0; i < stmt->m_branches.size(); ++i) {
-        StmtMatch::Branch *branch = stmt->m_branches[i].get();
+// Try one branch of a match statement. `res` is set to
+// the result of its block if one of its patterns matched.
+static bool
+eval_match_branch(StmtMatch *stmt,
+                  StmtMatch::Branch *branch,
+                  std::shared_ptr<earl::value::Obj> &match_value,
+                  std::shared_ptr<Ctx> &ctx,
+                  std::shared_ptr<earl::value::Obj> &res) {
+    // Go through the different expressions that are separated by `|`
+    for (size_t j = 0; j < branch->m_expr.size(); ++j) {
+        std::shared_ptr<earl::value::Obj>
+            potential_match = nullptr,
+            guard = nullptr;
+
+        if (branch->m_expr[j]->get_type() == ExprType::Term &&
+            (dynamic_cast<ExprTerm *>(branch->m_expr[j].get())->get_term_type() == ExprTermType::Func_Call)) {
+
+            auto test2 = dynamic_cast<ExprFuncCall *>(branch->m_expr[j].get());
+            ER possible_id = Interpreter::eval_expr(test2->m_left.get(), ctx, true);
+            const std::string &id = possible_id.id;
+            if (id == "some" && match_value->type() == earl::value::Type::Option) {
+                auto tmp_var = handle_match_some_branch(test2, match_value, ctx);
+
+                if (tmp_var) {
+                    ctx->variable_add(tmp_var);
 
-        // Go through the different expressions that are separated by `|`
-        for (size_t j = 0; j < branch->m_expr.size(); ++j) {
-            std::shared_ptr<earl::value::Obj>
-                potential_match = nullptr,
-                guard = nullptr;
-
-            if (branch->m_expr[j]->get_type() == ExprType::Term &&
-                (dynamic_cast<ExprTerm *>(branch->m_expr[j].get())->get_term_type() == ExprTermType::Func_Call)) {
-
-                auto test2 = dynamic_cast<ExprFuncCall *>(branch->m_expr[j].get());
-                ER possible_id = Interpreter::eval_expr(test2->m_left.get(), ctx, true);
-                const std::string &id = possible_id.id;
-                if (id == "some" && match_value->type() == earl::value::Type::Option) {
-                    auto tmp_var = handle_match_some_branch(test2, match_value, ctx);
-
-                    if (tmp_var) {
-                        ctx->variable_add(tmp_var);
-
-                        if (branch->m_when.has_value()) {
-                            ER _guard = Interpreter::eval_expr(branch->m_when.value().get(), ctx, true);
-                            guard = unpack_ER(_guard, ctx, true);
-                        }
-
-                        if (guard == nullptr || guard->boolean()) {
-                            auto res = Interpreter::eval_stmt_block(branch->m_block.get(), ctx);
-                            ctx->variable_remove(tmp_var->id());
-                            stmt->m_evald = true;
-                            return res;
-                        }
-                        else
-                            ctx->variable_remove(tmp_var->id());
-                    }
-                    else
-                        // It is `some`, but it does not have a variable
-                        goto not_some;
-                }
-                else
-                    // It is not `some`
-                    goto not_some;
-            }
-            else {
-            not_some:
-                ER _potential_match = Interpreter::eval_expr(branch->m_expr[j].get(), ctx, true);
-                potential_match = unpack_ER(_potential_match, ctx, true);
-                if (match_value->eq(potential_match.get()) || potential_match->type() == earl::value::Type::Void) {
                     if (branch->m_when.has_value()) {
                         ER _guard = Interpreter::eval_expr(branch->m_when.value().get(), ctx, true);
                         guard = unpack_ER(_guard, ctx, true);
                     }
+
                     if (guard == nullptr || guard->boolean()) {
+                        res = Interpreter::eval_stmt_block(branch->m_block.get(), ctx);
+                        ctx->variable_remove(tmp_var->id());
                         stmt->m_evald = true;
-                        return Interpreter::eval_stmt_block(branch->m_block.get(), ctx);
+                        return true;
                     }
+                    else
+                        ctx->variable_remove(tmp_var->id());
                 }
+                else
+                    // It is `some`, but it does not have a variable
+                    goto not_some;
+            }
+            else
+                // It is not `some`
+                goto not_some;
+        }
+        else {
+        not_some:
+            ER _potential_match = Interpreter::eval_expr(branch->m_expr[j].get(), ctx, true);
+            potential_match = unpack_ER(_potential_match, ctx, true);
+            if (match_value->eq(potential_match.get()) || potential_match->type() == earl::value::Type::Void) {
+                if (branch->m_when.has_value()) {
+                    ER _guard = Interpreter::eval_expr(branch->m_when.value().get(), ctx, true);
+                    guard = unpack_ER(_guard, ctx, true);
+                }
+                if (guard == nullptr || guard->boolean()) {
+                    stmt->m_evald = true;
+                    res = Interpreter::eval_stmt_block(branch->m_block.get(), ctx);
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+// The value of a pattern that is the same every time the match
+// is evaluated, i.e. a literal or an entry of a @world enum.
+static std::shared_ptr<earl::value::Obj>
+match_pattern_constant(Expr *expr, std::shared_ptr<Ctx> &ctx) {
+    if (expr->get_type() != ExprType::Term)
+        return nullptr;
+
+    auto term = dynamic_cast<ExprTerm *>(expr);
+    switch (term->get_term_type()) {
+    case ExprTermType::Int_Literal:  return dynamic_cast<ExprIntLit *>(term)->m_value;
+    case ExprTermType::Str_Literal:  return dynamic_cast<ExprStrLit *>(term)->m_value;
+    case ExprTermType::Char_Literal: return dynamic_cast<ExprCharLit *>(term)->m_value;
+    case ExprTermType::Bool:         return dynamic_cast<ExprBool *>(term)->m_constant;
+    case ExprTermType::Get: {
+        auto get = dynamic_cast<ExprGet *>(term);
+        if (get->m_left->get_type() != ExprType::Term
+            || dynamic_cast<ExprTerm *>(get->m_left.get())->get_term_type() != ExprTermType::Ident
+            || !std::holds_alternative<std::unique_ptr<ExprIdent>>(get->m_right))
+            return nullptr;
+
+        const std::string &id = dynamic_cast<ExprIdent *>(get->m_left.get())->m_tok->lexeme();
+        const std::string &entry = std::get<std::unique_ptr<ExprIdent>>(get->m_right)->m_tok->lexeme();
+
+        // A variable of the same name would be found before the enum.
+        WorldCtx *world = ctx->type() == CtxType::World ? dynamic_cast<WorldCtx *>(ctx.get()) : ctx->get_world();
+        if (ctx->variable_exists(id) || !world->enum_exists(id))
+            return nullptr;
+        auto enum_ = world->enum_get(id);
+        if (!enum_->has_entry(entry))
+            return nullptr;
+        return enum_->get_entry(entry)->value();
+    } break;
+    default: return nullptr;
+    }
+}
+
+// Only these types compare equal to nothing but their own type,
+// so they are the only ones that can be looked up in the table.
+static bool
+match_table_type(earl::value::Type ty) {
+    return ty == earl::value::Type::Int
+        || ty == earl::value::Type::Char
+        || ty == earl::value::Type::Str
+        || ty == earl::value::Type::Bool;
+}
+
+static std::unique_ptr<StmtMatch::JumpTable>
+build_match_table(StmtMatch *stmt, std::shared_ptr<Ctx> &ctx) {
+    auto table = std::make_unique<StmtMatch::JumpTable>();
+
+    for (size_t i = 0; i < stmt->m_branches.size(); ++i) {
+        StmtMatch::Branch *branch = stmt->m_branches[i].get();
+
+        std::vector<std::shared_ptr<earl::value::Obj>> constants = {};
+        if (!branch->m_when.has_value()) {
+            for (auto &expr : branch->m_expr) {
+                auto value = match_pattern_constant(expr.get(), ctx);
+                if (!value || !match_table_type(value->type()))
+                    break;
+                constants.push_back(value);
+            }
+        }
+
+        if (constants.size() != branch->m_expr.size()) {
+            table->m_rest.push_back(i);
+            continue;
+        }
+
+        // An earlier branch with the same pattern wins.
+        for (auto &value : constants) {
+            switch (value->type()) {
+            case earl::value::Type::Int:  table->m_ints.emplace(dynamic_cast<earl::value::Int *>(value.get())->value(), i); break;
+            case earl::value::Type::Char: table->m_chars.emplace(dynamic_cast<earl::value::Char *>(value.get())->value(), i); break;
+            case earl::value::Type::Str:  table->m_strs.emplace(dynamic_cast<earl::value::Str *>(value.get())->value(), i); break;
+            case earl::value::Type::Bool: table->m_bools.emplace(dynamic_cast<earl::value::Bool *>(value.get())->value(), i); break;
+            default: assert(false && "unreachable");
             }
         }
     }
 
+    return table;
+}
+
+// The branch that the table jumps to for `value`, or the
+// number of branches if no constant pattern matches it.
+static size_t
+match_table_lookup(StmtMatch *stmt, earl::value::Obj *value) {
+    const StmtMatch::JumpTable *table = stmt->m_table.get();
+    size_t none = stmt->m_branches.size();
+
+    switch (value->type()) {
+    case earl::value::Type::Int: {
+        auto it = table->m_ints.find(dynamic_cast<earl::value::Int *>(value)->value());
+        return it == table->m_ints.end() ? none : it->second;
+    } break;
+    case earl::value::Type::Char: {
+        auto it = table->m_chars.find(dynamic_cast<earl::value::Char *>(value)->value());
+        return it == table->m_chars.end() ? none : it->second;
+    } break;
+    case earl::value::Type::Str: {
+        auto it = table->m_strs.find(dynamic_cast<earl::value::Str *>(value)->value());
+        return it == table->m_strs.end() ? none : it->second;
+    } break;
+    case earl::value::Type::Bool: {
+        auto it = table->m_bools.find(dynamic_cast<earl::value::Bool *>(value)->value());
+        return it == table->m_bools.end() ? none : it->second;
+    } break;
+    default: assert(false && "unreachable");
+    }
+    return none;
+}
+
+std::shared_ptr<earl::value::Obj>
+eval_stmt_match(StmtMatch *stmt, std::shared_ptr<Ctx> &ctx) {
+    ER match_er = Interpreter::eval_expr(stmt->m_expr.get(), ctx, true);
+    auto match_value = unpack_ER(match_er, ctx, true);
+    std::shared_ptr<earl::value::Obj> res = nullptr;
+
+    if (!stmt->m_table)
+        stmt->m_table = build_match_table(stmt, ctx);
+
+    if (!match_table_type(match_value->type())) {
+        // Go through the branches
+        for (size_t i = 0; i < stmt->m_branches.size(); ++i)
+            if (eval_match_branch(stmt, stmt->m_branches[i].get(), match_value, ctx, res))
+                return res;
+        stmt->m_evald = true;
+        return nullptr;
+    }
+
+    // Only the branches before the one the table
+    // jumps to could have matched first.
+    size_t jump = match_table_lookup(stmt, match_value.get());
+    for (size_t i : stmt->m_table->m_rest) {
+        if (i > jump)
+            break;
+        if (eval_match_branch(stmt, stmt->m_branches[i].get(), match_value, ctx, res))
+            return res;
+    }
+
     stmt->m_evald = true;
+    if (jump < stmt->m_branches.size())
+        return Interpreter::eval_stmt_block(stmt->m_branches[jump]->m_block.get(), ctx);
     return nullptr;
 }
 
@@ -2267,7 +2758,7 @@ eval_stmt_enum(StmtEnum *stmt, std::shared_ptr<Ctx> &ctx) {
     auto _enum = std::make_shared<earl::value::Enum>(stmt, std::move(elems), stmt->m_attrs);
     wctx->enum_add(std::move(_enum));
     stmt->m_evald = true;
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 static std::shared_ptr<earl::value::Obj>
@@ -2275,7 +2766,7 @@ eval_stmt_continue(Stmt *stmt, std::shared_ptr<Ctx> &ctx) {
     (void)stmt;
     (void)ctx;
     stmt->m_evald = true;
-    return std::make_shared<earl::value::Continue>();
+    return earl::value::Continue::instance();
 }
 
 static std::shared_ptr<earl::value::Obj>
@@ -2283,6 +2774,11 @@ eval_stmt_loop(StmtLoop *stmt, std::shared_ptr<Ctx> &ctx) {
     std::shared_ptr<earl::value::Obj> result = nullptr;
 
     while (1) {
+        if ((flags & __JIT) != 0 && JIT::run(stmt, stmt->m_jit, ctx)) {
+            result = nullptr;
+            break;
+        }
+
         result = Interpreter::eval_stmt_block(stmt->m_block.get(), ctx);
 
         if (result && result->type() == earl::value::Type::Break) {
@@ -2298,7 +2794,7 @@ eval_stmt_loop(StmtLoop *stmt, std::shared_ptr<Ctx> &ctx) {
     }
 
     if (result && (result->type() == earl::value::Type::Continue || result->type() == earl::value::Type::Break))
-        result = std::make_shared<earl::value::Void>();
+        result = earl::value::Void::instance();
 
     stmt->m_evald = true;
 
@@ -2315,31 +2811,31 @@ eval_stmt_bash_lit(StmtBashLiteral *stmt, std::shared_ptr<Ctx> ctx) {
         const std::string msg = "bash cmd failed with exit code "+std::to_string(x);
         throw InterpreterException(msg);
     }
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
 Interpreter::eval_stmt(Stmt *stmt, std::shared_ptr<Ctx> &ctx) {
     switch (stmt->stmt_type()) {
-    case StmtType::Def:          return eval_stmt_def(dynamic_cast<StmtDef *>(stmt), ctx);
-    case StmtType::Let:          return eval_stmt_let(dynamic_cast<StmtLet *>(stmt), ctx);
-    case StmtType::Block:        return Interpreter::eval_stmt_block(dynamic_cast<StmtBlock *>(stmt), ctx);
-    case StmtType::Mut:          return eval_stmt_mut(dynamic_cast<StmtMut *>(stmt), ctx);
-    case StmtType::Stmt_Expr:    return eval_stmt_expr(dynamic_cast<StmtExpr *>(stmt), ctx);
-    case StmtType::If:           return eval_stmt_if(dynamic_cast<StmtIf *>(stmt), ctx);
-    case StmtType::Return:       return eval_stmt_return(dynamic_cast<StmtReturn *>(stmt), ctx);
-    case StmtType::Break:        return eval_stmt_break(dynamic_cast<StmtBreak *>(stmt), ctx);
-    case StmtType::While:        return eval_stmt_while(dynamic_cast<StmtWhile *>(stmt), ctx);
-    case StmtType::Foreach:      return eval_stmt_foreach(dynamic_cast<StmtForeach *>(stmt), ctx);
-    case StmtType::For:          return eval_stmt_for(dynamic_cast<StmtFor *>(stmt), ctx);
-    case StmtType::Import:       return eval_stmt_import(dynamic_cast<StmtImport *>(stmt), ctx);
-    case StmtType::Mod:          return eval_stmt_mod(dynamic_cast<StmtMod *>(stmt), ctx);
-    case StmtType::Class:        return eval_stmt_class(dynamic_cast<StmtClass *>(stmt), ctx);
-    case StmtType::Match:        return eval_stmt_match(dynamic_cast<StmtMatch *>(stmt), ctx);
-    case StmtType::Enum:         return eval_stmt_enum(dynamic_cast<StmtEnum *>(stmt), ctx);
-    case StmtType::Continue:     return eval_stmt_continue(dynamic_cast<StmtContinue *>(stmt), ctx);
-    case StmtType::Loop:         return eval_stmt_loop(dynamic_cast<StmtLoop *>(stmt), ctx);
-    case StmtType::Bash_Literal: return eval_stmt_bash_lit(dynamic_cast<StmtBashLiteral *>(stmt), ctx);
+    case StmtType::Def:          return eval_stmt_def(static_cast<StmtDef *>(stmt), ctx);
+    case StmtType::Let:          return eval_stmt_let(static_cast<StmtLet *>(stmt), ctx);
+    case StmtType::Block:        return Interpreter::eval_stmt_block(static_cast<StmtBlock *>(stmt), ctx);
+    case StmtType::Mut:          return eval_stmt_mut(static_cast<StmtMut *>(stmt), ctx);
+    case StmtType::Stmt_Expr:    return eval_stmt_expr(static_cast<StmtExpr *>(stmt), ctx);
+    case StmtType::If:           return eval_stmt_if(static_cast<StmtIf *>(stmt), ctx);
+    case StmtType::Return:       return eval_stmt_return(static_cast<StmtReturn *>(stmt), ctx);
+    case StmtType::Break:        return eval_stmt_break(static_cast<StmtBreak *>(stmt), ctx);
+    case StmtType::While:        return eval_stmt_while(static_cast<StmtWhile *>(stmt), ctx);
+    case StmtType::Foreach:      return eval_stmt_foreach(static_cast<StmtForeach *>(stmt), ctx);
+    case StmtType::For:          return eval_stmt_for(static_cast<StmtFor *>(stmt), ctx);
+    case StmtType::Import:       return eval_stmt_import(static_cast<StmtImport *>(stmt), ctx);
+    case StmtType::Mod:          return eval_stmt_mod(static_cast<StmtMod *>(stmt), ctx);
+    case StmtType::Class:        return eval_stmt_class(static_cast<StmtClass *>(stmt), ctx);
+    case StmtType::Match:        return eval_stmt_match(static_cast<StmtMatch *>(stmt), ctx);
+    case StmtType::Enum:         return eval_stmt_enum(static_cast<StmtEnum *>(stmt), ctx);
+    case StmtType::Continue:     return eval_stmt_continue(static_cast<StmtContinue *>(stmt), ctx);
+    case StmtType::Loop:         return eval_stmt_loop(static_cast<StmtLoop *>(stmt), ctx);
+    case StmtType::Bash_Literal: return eval_stmt_bash_lit(static_cast<StmtBashLiteral *>(stmt), ctx);
     default: assert(false && "unreachable");
     }
     std::string msg = "A serious internal error has ocured and has gotten to an unreachable case. Something is very wrong";
@@ -2349,6 +2845,11 @@ Interpreter::eval_stmt(Stmt *stmt, std::shared_ptr<Ctx> &ctx) {
 
 std::shared_ptr<Ctx>
 Interpreter::interpret(std::unique_ptr<Program> program, std::unique_ptr<Lexer> lexer) {
+    {
+        AstArena scope(program->m_arena.get());
+        Optimizer::optimize(program.get());
+    }
+    Resolver::resolve(program.get());
     std::shared_ptr<Ctx> ctx = std::make_shared<WorldCtx>(std::move(lexer), std::move(program));
     WorldCtx *wctx = dynamic_cast<WorldCtx *>(ctx.get());
 
@@ -2373,14 +2874,20 @@ Interpreter::interpret(std::unique_ptr<Program> program, std::unique_ptr<Lexer>
             || stmt->stmt_type() == StmtType::Mod)
             (void)Interpreter::eval_stmt(wctx->stmt_at(i), ctx);
     }
+    std::vector<Stmt *> rest = {};
     for (size_t i = 0; i < wctx->stmts_len(); ++i) {
         Stmt *stmt = wctx->stmt_at(i);
         if (stmt->stmt_type() != StmtType::Def
             && stmt->stmt_type() != StmtType::Class
             && stmt->stmt_type() != StmtType::Mod) {
-            (void)Interpreter::eval_stmt(stmt, ctx);
+            if ((flags & __VM) != 0)
+                rest.push_back(stmt);
+            else
+                (void)Interpreter::eval_stmt(stmt, ctx);
         }
     }
+    if ((flags & __VM) != 0)
+        VM::exec_toplevel(rest, ctx);
 
     return ctx;
 }
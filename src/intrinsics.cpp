@@ -38,45 +38,47 @@
 #include "ctx.hpp"
 #include "earl.hpp"
 #include "common.hpp"
+#include "memo.hpp"
 
-const std::unordered_map<std::string, Intrinsics::IntrinsicFunction>
+const std::unordered_map<std::string, Intrinsics::Intrinsic>
 Intrinsics::intrinsic_functions = {
-    {"print", &Intrinsics::intrinsic_print},
-    {"println", &Intrinsics::intrinsic_println},
-    {"assert", &Intrinsics::intrinsic_assert},
-    {"len", &Intrinsics::intrinsic_len},
-    {"open", &Intrinsics::intrinsic_open},
-    {"type", &Intrinsics::intrinsic_type},
-    {"typeof", &Intrinsics::intrinsic_typeof},
-    {"unimplemented", &Intrinsics::intrinsic_unimplemented},
-    {"exit", &Intrinsics::intrinsic_exit},
-    {"warn", &Intrinsics::intrinsic_warn},
-    {"panic", &Intrinsics::intrinsic_panic},
-    {"some", &Intrinsics::intrinsic_some},
-    {"argv", &Intrinsics::intrinsic_argv},
-    {"input", &Intrinsics::intrinsic_input},
-    {"init_seed", &Intrinsics::intrinsic_init_seed},
-    {"random", &Intrinsics::intrinsic_random},
-    {"__internal_move__", &Intrinsics::intrinsic___internal_move__},
-    {"__internal_mkdir__", &Intrinsics::intrinsic___internal_mkdir__},
-    {"__internal_ls__", &Intrinsics::intrinsic___internal_ls__},
-    {"__internal_cd__", &Intrinsics::intrinsic___internal_cd__},
-    {"__internal_unix_system__", &Intrinsics::intrinsic___internal_unix_system__},
-    {"__internal_unix_system_woutput__", &Intrinsics::intrinsic___internal_unix_system_woutput__},
-    {"fprintln", &Intrinsics::intrinsic_fprintln},
-    {"fprint", &Intrinsics::intrinsic_fprint},
+    {"print", {&Intrinsics::intrinsic_print, INTR_VARIADIC}},
+    {"println", {&Intrinsics::intrinsic_println, INTR_VARIADIC}},
+    {"assert", {&Intrinsics::intrinsic_assert, INTR_VARIADIC}},
+    {"len", {&Intrinsics::intrinsic_len, 1}},
+    {"open", {&Intrinsics::intrinsic_open, 2}},
+    {"type", {&Intrinsics::intrinsic_type, 1}},
+    {"typeof", {&Intrinsics::intrinsic_typeof, 1}},
+    {"unimplemented", {&Intrinsics::intrinsic_unimplemented, INTR_VARIADIC}},
+    {"exit", {&Intrinsics::intrinsic_exit, INTR_VARIADIC}},
+    {"warn", {&Intrinsics::intrinsic_warn, INTR_VARIADIC}},
+    {"panic", {&Intrinsics::intrinsic_panic, INTR_VARIADIC}},
+    {"some", {&Intrinsics::intrinsic_some, 1}},
+    {"argv", {&Intrinsics::intrinsic_argv, 0}},
+    {"input", {&Intrinsics::intrinsic_input, INTR_VARIADIC}},
+    {"init_seed", {&Intrinsics::intrinsic_init_seed, 1}},
+    {"random", {&Intrinsics::intrinsic_random, 0}},
+    {"__internal_move__", {&Intrinsics::intrinsic___internal_move__, 2}},
+    {"__internal_mkdir__", {&Intrinsics::intrinsic___internal_mkdir__, 1}},
+    {"__internal_ls__", {&Intrinsics::intrinsic___internal_ls__, 1}},
+    {"__internal_cd__", {&Intrinsics::intrinsic___internal_cd__, 1}},
+    {"__internal_unix_system__", {&Intrinsics::intrinsic___internal_unix_system__, 1}},
+    {"__internal_unix_system_woutput__", {&Intrinsics::intrinsic___internal_unix_system_woutput__, 1}},
+    {"fprintln", {&Intrinsics::intrinsic_fprintln, INTR_VARIADIC}},
+    {"fprint", {&Intrinsics::intrinsic_fprint, INTR_VARIADIC}},
     // Casting Functions
-    {"str", &Intrinsics::intrinsic_str},
-    {"int", &Intrinsics::intrinsic_int},
-    {"float", &Intrinsics::intrinsic_float},
-    {"bool", &Intrinsics::intrinsic_bool},
-    {"tuple", &Intrinsics::intrinsic_tuple},
-    {"list", &Intrinsics::intrinsic_list},
-    {"unit", &Intrinsics::intrinsic_unit},
-    {"Dict", &Intrinsics::intrinsic_Dict},
-    {"datetime", &Intrinsics::intrinsic_datetime},
-    {"sleep", &Intrinsics::intrinsic_sleep},
-    {"env", &Intrinsics::intrinsic_env},
+    {"str", {&Intrinsics::intrinsic_str, 1}},
+    {"int", {&Intrinsics::intrinsic_int, 1}},
+    {"float", {&Intrinsics::intrinsic_float, 1}},
+    {"bool", {&Intrinsics::intrinsic_bool, 1}},
+    {"tuple", {&Intrinsics::intrinsic_tuple, INTR_VARIADIC}},
+    {"list", {&Intrinsics::intrinsic_list, INTR_VARIADIC}},
+    {"unit", {&Intrinsics::intrinsic_unit, INTR_VARIADIC}},
+    {"Dict", {&Intrinsics::intrinsic_Dict, 1}},
+    {"datetime", {&Intrinsics::intrinsic_datetime, 0}},
+    {"sleep", {&Intrinsics::intrinsic_sleep, 1}},
+    {"env", {&Intrinsics::intrinsic_env, 1}},
+    {"memo_stats", {&Intrinsics::intrinsic_memo_stats, 1}},
 };
 
 const std::unordered_map<std::string, Intrinsics::IntrinsicMemberFunction>
@@ -129,7 +131,9 @@ Intrinsics::call(const std::string &id,
                  std::vector<std::shared_ptr<earl::value::Obj>> &params,
                  std::shared_ptr<Ctx> &ctx,
                  Expr *expr) {
-    return intrinsic_functions.at(id)(params, ctx, expr);
+    const Intrinsic &intrinsic = intrinsic_functions.at(id);
+    check_arity(id, intrinsic, params.size(), expr);
+    return intrinsic.m_fn(params, ctx, expr);
 }
 
 bool
@@ -137,28 +141,54 @@ Intrinsics::is_intrinsic(const std::string &id) {
     return Intrinsics::intrinsic_functions.find(id) != Intrinsics::intrinsic_functions.end();
 }
 
+// The member intrinsics of values of type `ty`.
+static const std::unordered_map<std::string, Intrinsics::IntrinsicMemberFunction> *
+member_functions_of(earl::value::Type ty) {
+    switch (ty) {
+    case earl::value::Type::Char: return &Intrinsics::intrinsic_char_member_functions;
+    case earl::value::Type::Str: return &Intrinsics::intrinsic_str_member_functions;
+    case earl::value::Type::List: return &Intrinsics::intrinsic_list_member_functions;
+    case earl::value::Type::Option: return &Intrinsics::intrinsic_option_member_functions;
+    case earl::value::Type::File: return &Intrinsics::intrinsic_file_member_functions;
+    case earl::value::Type::Tuple: return &Intrinsics::intrinsic_tuple_member_functions;
+    case earl::value::Type::DictInt:
+    case earl::value::Type::DictStr:
+    case earl::value::Type::DictChar:
+    case earl::value::Type::DictFloat: return &Intrinsics::intrinsic_dict_member_functions;
+    case earl::value::Type::Time: return &Intrinsics::intrinsic_time_member_functions;
+    default: return nullptr;
+    }
+}
+
 bool
 Intrinsics::is_member_intrinsic(const std::string &id, int ty) {
     if (ty == -1)
         return Intrinsics::intrinsic_member_functions.find(id) != Intrinsics::intrinsic_member_functions.end();
+    return lookup_member(id, static_cast<earl::value::Type>(ty)) != nullptr;
+}
 
-    switch (static_cast<earl::value::Type>(ty)) {
-    case earl::value::Type::Int: return false;
-    case earl::value::Type::Char: return Intrinsics::intrinsic_char_member_functions.find(id) != Intrinsics::intrinsic_char_member_functions.end();
-    case earl::value::Type::Str: return Intrinsics::intrinsic_str_member_functions.find(id) != Intrinsics::intrinsic_str_member_functions.end();
-    case earl::value::Type::Bool: return false;
-    case earl::value::Type::List: return Intrinsics::intrinsic_list_member_functions.find(id) != Intrinsics::intrinsic_list_member_functions.end();
-    case earl::value::Type::Option: return Intrinsics::intrinsic_option_member_functions.find(id) != Intrinsics::intrinsic_option_member_functions.end();
-    case earl::value::Type::File: return Intrinsics::intrinsic_file_member_functions.find(id) != Intrinsics::intrinsic_file_member_functions.end();
-    case earl::value::Type::Tuple: return Intrinsics::intrinsic_tuple_member_functions.find(id) != Intrinsics::intrinsic_tuple_member_functions.end();
-    case earl::value::Type::DictInt:
-    case earl::value::Type::DictStr:
-    case earl::value::Type::DictChar:
-    case earl::value::Type::DictFloat: return Intrinsics::intrinsic_dict_member_functions.find(id) != Intrinsics::intrinsic_dict_member_functions.end();
-    case earl::value::Type::Time: return Intrinsics::intrinsic_time_member_functions.find(id) != Intrinsics::intrinsic_time_member_functions.end();
-    default: return false;
-    }
-    return Intrinsics::intrinsic_member_functions.find(id) != Intrinsics::intrinsic_member_functions.end();
+const Intrinsics::Intrinsic *
+Intrinsics::lookup(const std::string &id) {
+    auto it = intrinsic_functions.find(id);
+    return it == intrinsic_functions.end() ? nullptr : &it->second;
+}
+
+void
+Intrinsics::check_arity(const std::string &id, const Intrinsic &intrinsic, size_t nargs, Expr *expr) {
+    if (intrinsic.m_arity == INTR_VARIADIC || static_cast<size_t>(intrinsic.m_arity) == nargs)
+        return;
+    Err::err_wexpr(expr);
+    std::string msg = "function `"+id+"` expects "+std::to_string(intrinsic.m_arity)+" arguments but "+std::to_string(nargs)+" were supplied";
+    throw InterpreterException(msg);
+}
+
+Intrinsics::IntrinsicMemberFunction
+Intrinsics::lookup_member(const std::string &id, earl::value::Type ty) {
+    auto *functions = member_functions_of(ty);
+    if (!functions)
+        return nullptr;
+    auto it = functions->find(id);
+    return it == functions->end() ? nullptr : it->second;
 }
 
 std::shared_ptr<earl::value::Obj>
@@ -168,23 +198,9 @@ Intrinsics::call_member(const std::string &id,
                         std::vector<std::shared_ptr<earl::value::Obj>> &params,
                         std::shared_ptr<Ctx> &ctx,
                         Expr *expr) {
-
-    switch (type) {
-    case earl::value::Type::Int: assert(false);
-    case earl::value::Type::Char: return Intrinsics::intrinsic_char_member_functions.at(id)(accessor, params, ctx, expr);
-    case earl::value::Type::Str: return Intrinsics::intrinsic_str_member_functions.at(id)(accessor, params, ctx, expr);
-    case earl::value::Type::Bool: assert(false);
-    case earl::value::Type::List: return Intrinsics::intrinsic_list_member_functions.at(id)(accessor, params, ctx, expr);
-    case earl::value::Type::Option: return Intrinsics::intrinsic_option_member_functions.at(id)(accessor, params, ctx, expr);
-    case earl::value::Type::File: return Intrinsics::intrinsic_file_member_functions.at(id)(accessor, params, ctx, expr);
-    case earl::value::Type::Tuple: return Intrinsics::intrinsic_tuple_member_functions.at(id)(accessor, params, ctx, expr);
-    case earl::value::Type::DictInt:
-    case earl::value::Type::DictStr:
-    case earl::value::Type::DictChar:
-    case earl::value::Type::DictFloat: return Intrinsics::intrinsic_dict_member_functions.at(id)(accessor, params, ctx, expr);
-    case earl::value::Type::Time: return Intrinsics::intrinsic_time_member_functions.at(id)(accessor, params, ctx, expr);
-    default: assert(false);
-    }
+    auto *functions = member_functions_of(type);
+    assert(functions);
+    return functions->at(id)(accessor, params, ctx, expr);
 }
 
 std::shared_ptr<earl::value::Obj>
@@ -192,7 +208,6 @@ Intrinsics::intrinsic_str(std::vector<std::shared_ptr<earl::value::Obj>> &params
                           std::shared_ptr<Ctx> &ctx,
                           Expr *expr) {
     (void)ctx;
-    __INTR_ARGS_MUSTBE_SIZE(params, 1, "str", expr);
     return std::make_shared<earl::value::Str>(params[0]->to_cxxstring());
 }
 
@@ -201,7 +216,6 @@ Intrinsics::intrinsic_int(std::vector<std::shared_ptr<earl::value::Obj>> &params
                           std::shared_ptr<Ctx> &ctx,
                           Expr *expr) {
     (void)ctx;
-    __INTR_ARGS_MUSTBE_SIZE(params, 1, "int", expr);
     {
         std::vector<earl::value::Type> tys = {
             earl::value::Type::Int,
@@ -246,7 +260,6 @@ Intrinsics::intrinsic_float(std::vector<std::shared_ptr<earl::value::Obj>> &para
                             std::shared_ptr<Ctx> &ctx,
                             Expr *expr) {
     (void)ctx;
-    __INTR_ARGS_MUSTBE_SIZE(params, 1, "float", expr);
     {
         std::vector<earl::value::Type> tys = {
             earl::value::Type::Int,
@@ -282,7 +295,6 @@ Intrinsics::intrinsic_bool(std::vector<std::shared_ptr<earl::value::Obj>> &param
                            std::shared_ptr<Ctx> &ctx,
                            Expr *expr) {
     (void)ctx;
-    __INTR_ARGS_MUSTBE_SIZE(params, 1, "bool", expr);
     {
         std::vector<earl::value::Type> tys = {
             earl::value::Type::Int,
@@ -340,7 +352,7 @@ Intrinsics::intrinsic_unit(std::vector<std::shared_ptr<earl::value::Obj>> &param
                            Expr *expr) {
     (void)ctx;
     (void)params;
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
@@ -348,7 +360,6 @@ Intrinsics::intrinsic_Dict(std::vector<std::shared_ptr<earl::value::Obj>> &param
                            std::shared_ptr<Ctx> &ctx,
                            Expr *expr) {
     (void)ctx;
-    __INTR_ARGS_MUSTBE_SIZE(params, 1, "Dict", expr);
     __INTR_ARG_MUSTBE_TYPE_COMPAT(params[0], earl::value::Type::TypeKW, 1, "Dict", expr);
 
     auto value = dynamic_cast<earl::value::TypeKW *>(params[0].get());
@@ -375,14 +386,13 @@ Intrinsics::intrinsic_len(std::vector<std::shared_ptr<earl::value::Obj>> &params
                           std::shared_ptr<Ctx> &ctx,
                           Expr *expr) {
     (void)ctx;
-    __INTR_ARGS_MUSTBE_SIZE(params, 1, "len", expr);
     {
         std::vector<earl::value::Type> lst = {earl::value::Type::List, earl::value::Type::Str, earl::value::Type::Tuple};
         __MEMBER_INTR_ARG_MUSTBE_TYPE_COMPAT_OR_LST(params[0], lst, 1, "len", expr);
     }
     auto &item = params[0];
     if (item->type() == earl::value::Type::List) {
-        size_t sz = dynamic_cast<earl::value::List *>(item.get())->value().size();
+        size_t sz = dynamic_cast<earl::value::List *>(item.get())->size();
         return std::make_shared<earl::value::Int>(static_cast<int>(sz));
     }
     else if (item->type() == earl::value::Type::Str) {
@@ -390,7 +400,7 @@ Intrinsics::intrinsic_len(std::vector<std::shared_ptr<earl::value::Obj>> &params
         return std::make_shared<earl::value::Int>(static_cast<int>(sz));
     }
     else if (item->type() == earl::value::Type::Tuple) {
-        size_t sz = dynamic_cast<earl::value::Tuple *>(item.get())->value().size();
+        size_t sz = dynamic_cast<earl::value::Tuple *>(item.get())->elems().size();
         return std::make_shared<earl::value::Int>(static_cast<int>(sz));
     }
     assert(false && "unreachable");
@@ -402,7 +412,6 @@ Intrinsics::intrinsic_argv(std::vector<std::shared_ptr<earl::value::Obj>> &param
                            std::shared_ptr<Ctx> &ctx,
                            Expr *expr) {
     (void)ctx;
-    __INTR_ARGS_MUSTBE_SIZE(params, 0, "argv", expr);
     std::vector<std::shared_ptr<earl::value::Obj>> args = {};
     for (size_t i = 0; i < earl_argv.size(); ++i)
         args.push_back(std::make_shared<earl::value::Str>(earl_argv.at(i)));
@@ -414,7 +423,6 @@ Intrinsics::intrinsic___internal_mkdir__(std::vector<std::shared_ptr<earl::value
                                          std::shared_ptr<Ctx> &ctx,
                                          Expr *expr) {
     (void)ctx;
-    __INTR_ARGS_MUSTBE_SIZE(params, 1, "__internal_mkdir__", expr);
     auto obj = params[0];
     std::string path = obj->to_cxxstring();
     if (!std::filesystem::exists(path))
@@ -423,7 +431,7 @@ Intrinsics::intrinsic___internal_mkdir__(std::vector<std::shared_ptr<earl::value
             std::string msg = "could not create directory `"+path+"`";
             throw InterpreterException(msg);
         }
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
@@ -431,7 +439,6 @@ Intrinsics::intrinsic___internal_move__(std::vector<std::shared_ptr<earl::value:
                                          std::shared_ptr<Ctx> &ctx,
                                          Expr *expr) {
     (void)ctx;
-    __INTR_ARGS_MUSTBE_SIZE(params, 2, "__internal_move__", expr);
     __INTR_ARG_MUSTBE_TYPE_COMPAT(params[0], earl::value::Type::Str, 1, "__internal_move__", expr);
     __INTR_ARG_MUSTBE_TYPE_COMPAT(params[1], earl::value::Type::Str, 2, "__internal_move__", expr);
 
@@ -449,7 +456,7 @@ Intrinsics::intrinsic___internal_move__(std::vector<std::shared_ptr<earl::value:
         throw InterpreterException(msg);
     }
 
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
@@ -457,7 +464,6 @@ Intrinsics::intrinsic___internal_ls__(std::vector<std::shared_ptr<earl::value::O
                                       std::shared_ptr<Ctx> &ctx,
                                       Expr *expr) {
     (void)ctx;
-    __INTR_ARGS_MUSTBE_SIZE(params, 1, "__internal_ls__", expr);
     __INTR_ARG_MUSTBE_TYPE_COMPAT(params[0], earl::value::Type::Str, 1, "__internal_ls__", expr);
 
     auto obj = params[0];
@@ -487,7 +493,6 @@ Intrinsics::intrinsic___internal_cd__(std::vector<std::shared_ptr<earl::value::O
                           std::shared_ptr<Ctx> &ctx,
                           Expr *expr) {
     (void)ctx;
-    __INTR_ARGS_MUSTBE_SIZE(params, 1, "__internal_cd__", expr);
     __INTR_ARG_MUSTBE_TYPE_COMPAT(params[0], earl::value::Type::Str, 1,
                                   "__internal_cd__", expr);
     const std::string &new_dir = params[0]->to_cxxstring();
@@ -498,14 +503,13 @@ Intrinsics::intrinsic___internal_cd__(std::vector<std::shared_ptr<earl::value::O
         throw InterpreterException(msg);
     }
 
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
 Intrinsics::intrinsic___internal_unix_system__(std::vector<std::shared_ptr<earl::value::Obj>> &params,
                                                std::shared_ptr<Ctx> &ctx,
                                                Expr *expr) {
-    __INTR_ARGS_MUSTBE_SIZE(params, 1, "__internal_unix_system__", expr);
     __INTR_ARG_MUSTBE_TYPE_COMPAT(params[0], earl::value::Type::Str, 1, "__internal_unix_system__", expr);
     const std::string cmd = params[0]->to_cxxstring();
     int exitcode = system(cmd.c_str());
@@ -521,7 +525,6 @@ std::shared_ptr<earl::value::Obj>
 Intrinsics::intrinsic___internal_unix_system_woutput__(
     std::vector<std::shared_ptr<earl::value::Obj>> &params,
     std::shared_ptr<Ctx> &ctx, Expr *expr) {
-    __INTR_ARGS_MUSTBE_SIZE(params, 1, "__internal_unix_system__woutput_", expr);
     __INTR_ARG_MUSTBE_TYPE_COMPAT(params[0], earl::value::Type::Str, 1, "__internal_unix_system__woutput_", expr);
     const std::string cmd = params[0]->to_cxxstring();
 
@@ -559,7 +562,6 @@ Intrinsics::intrinsic_type(std::vector<std::shared_ptr<earl::value::Obj>> &param
                            std::shared_ptr<Ctx> &ctx,
                            Expr *expr) {
     (void)ctx;
-    __INTR_ARGS_MUSTBE_SIZE(params, 1, "type", expr);
     return std::make_shared<earl::value::Str>(earl::value::type_to_str(params[0]->type()));
 }
 
@@ -568,7 +570,6 @@ Intrinsics::intrinsic_typeof(std::vector<std::shared_ptr<earl::value::Obj>> &par
                              std::shared_ptr<Ctx> &ctx,
                              Expr *expr) {
     (void)ctx;
-    __INTR_ARGS_MUSTBE_SIZE(params, 1, "typeof", expr);
     return std::make_shared<earl::value::TypeKW>(params[0]->type());
 }
 
@@ -608,7 +609,7 @@ Intrinsics::intrinsic_warn(std::vector<std::shared_ptr<earl::value::Obj>> &param
     __INTR_ARG_MUSTBE_TYPE_COMPAT(params[0], earl::value::Type::Str, 1, "warn", expr);
     std::cout << "[EARL] WARN: ";
     Intrinsics::intrinsic_println(params, ctx, expr);
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
@@ -647,25 +648,23 @@ Intrinsics::intrinsic_assert(std::vector<std::shared_ptr<earl::value::Obj>> &par
             throw InterpreterException(msg);
         }
     }
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
 Intrinsics::intrinsic_init_seed(std::vector<std::shared_ptr<earl::value::Obj>> &seed,
                                 std::shared_ptr<Ctx> &ctx,
                                 Expr *expr) {
-    __INTR_ARGS_MUSTBE_SIZE(seed, 1, "seed", expr);
     __INTR_ARG_MUSTBE_TYPE_COMPAT_EXACT(seed[0], earl::value::Type::Int, 1, "seed", expr);
     unsigned s = (unsigned)dynamic_cast<earl::value::Int *>(seed[0].get())->value();
     std::srand(s);
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
 Intrinsics::intrinsic_random(std::vector<std::shared_ptr<earl::value::Obj>> &unused,
                              std::shared_ptr<Ctx> &ctx,
                              Expr *expr) {
-    __INTR_ARGS_MUSTBE_SIZE(unused, 0, "rand", expr);
     return std::make_shared<earl::value::Int>(std::rand());
 }
 
@@ -677,7 +676,7 @@ Intrinsics::intrinsic_print(std::vector<std::shared_ptr<earl::value::Obj>> &para
     (void)ctx;
     for (size_t i = 0; i < params.size(); ++i)
         __intrinsic_print(params[i]);
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
@@ -688,7 +687,7 @@ Intrinsics::intrinsic_println(std::vector<std::shared_ptr<earl::value::Obj>> &pa
     for (size_t i = 0; i < params.size(); ++i)
         __intrinsic_print(params[i]);
     std::cout << '\n';
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
@@ -721,7 +720,7 @@ Intrinsics::intrinsic_fprintln(std::vector<std::shared_ptr<earl::value::Obj>> &p
     for (size_t i = 1; i < params.size(); ++i)
         __intrinsic_print(params[i], stream);
     *stream << '\n';
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
@@ -753,7 +752,7 @@ Intrinsics::intrinsic_fprint(std::vector<std::shared_ptr<earl::value::Obj>> &par
 
     for (size_t i = 1; i < params.size(); ++i)
         __intrinsic_print(params[i], stream);
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
@@ -772,7 +771,6 @@ Intrinsics::intrinsic_datetime(std::vector<std::shared_ptr<earl::value::Obj>> &u
                                std::shared_ptr<Ctx> &ctx,
                                Expr *expr) {
     (void)ctx;
-    __INTR_ARGS_MUSTBE_SIZE(unused, 0, "datetime", expr);
     return std::make_shared<earl::value::Time>(std::time(nullptr));
 }
 
@@ -781,17 +779,15 @@ Intrinsics::intrinsic_sleep(std::vector<std::shared_ptr<earl::value::Obj>> &time
                             std::shared_ptr<Ctx> &ctx,
                             Expr *expr) {
     (void)ctx;
-    __INTR_ARGS_MUSTBE_SIZE(time, 1, "sleep", expr);
     __INTR_ARG_MUSTBE_TYPE_COMPAT_EXACT(time[0], earl::value::Type::Int, 1, "sleep", expr);
     usleep(dynamic_cast<earl::value::Int *>(time[0].get())->value());
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
 Intrinsics::intrinsic_env(std::vector<std::shared_ptr<earl::value::Obj>> &var,
                           std::shared_ptr<Ctx> &ctx, Expr *expr) {
     (void)ctx;
-    __INTR_ARGS_MUSTBE_SIZE(var, 1, "env", expr);
     __INTR_ARG_MUSTBE_TYPE_COMPAT_EXACT(var[0], earl::value::Type::Str, 1,
                                         "env", expr);
     auto str = dynamic_cast<earl::value::Str *>(var[0].get());
@@ -801,12 +797,44 @@ Intrinsics::intrinsic_env(std::vector<std::shared_ptr<earl::value::Obj>> &var,
         : std::make_shared<earl::value::Str>("");
 }
 
+std::shared_ptr<earl::value::Obj>
+Intrinsics::intrinsic_memo_stats(std::vector<std::shared_ptr<earl::value::Obj>> &params,
+                                 std::shared_ptr<Ctx> &ctx,
+                                 Expr *expr) {
+    __INTR_ARG_MUSTBE_TYPE_COMPAT_EXACT(params[0], earl::value::Type::Str, 1,
+                                        "memo_stats", expr);
+
+    const std::string id = dynamic_cast<earl::value::Str *>(params[0].get())->value();
+    if (!ctx->function_exists(id)) {
+        Err::err_wexpr(expr);
+        const std::string msg = "function `"+id+"` does not exist";
+        throw InterpreterException(msg);
+    }
+
+    auto func = ctx->function_get(id);
+    if ((func->attrs() & static_cast<uint32_t>(Attr::Memo)) == 0) {
+        Err::err_wexpr(expr);
+        const std::string msg = "function `"+id+"` does not contain the @memo attribute";
+        throw InterpreterException(msg);
+    }
+
+    // The cache is only made on the first call.
+    Memo::Cache empty;
+    Memo::Cache *cache = func->get_stmtdef()->m_memo ? func->get_stmtdef()->m_memo.get() : &empty;
+
+    std::vector<std::shared_ptr<earl::value::Obj>> values = {
+        std::make_shared<earl::value::Int>(static_cast<int>(cache->m_hits)),
+        std::make_shared<earl::value::Int>(static_cast<int>(cache->m_misses)),
+        std::make_shared<earl::value::Int>(static_cast<int>(cache->size())),
+    };
+    return std::make_shared<earl::value::Tuple>(values);
+}
+
 std::shared_ptr<earl::value::Obj>
 Intrinsics::intrinsic_some(std::vector<std::shared_ptr<earl::value::Obj>> &params,
                            std::shared_ptr<Ctx> &ctx,
                            Expr *expr) {
     (void)ctx;
-    __INTR_ARGS_MUSTBE_SIZE(params, 1, "some", expr);
     return std::make_shared<earl::value::Option>(params[0]);
 }
 
@@ -815,7 +843,6 @@ Intrinsics::intrinsic_open(std::vector<std::shared_ptr<earl::value::Obj>> &param
                            std::shared_ptr<Ctx> &ctx,
                            Expr *expr) {
     (void)ctx;
-    __INTR_ARGS_MUSTBE_SIZE(params, 2, "open", expr);
     __INTR_ARG_MUSTBE_TYPE_COMPAT(params[0], earl::value::Type::Str, 1, "open", expr);
     __INTR_ARG_MUSTBE_TYPE_COMPAT(params[1], earl::value::Type::Str, 2, "open", expr);
 
@@ -0,0 +1,767 @@
+/** @file */
+
+// MIT License
+
+// Copyright (c) 2023 malloc-nbytes
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "jit.hpp"
+#include "ast.hpp"
+#include "ctx.hpp"
+#include "common.hpp"
+#include "earl.hpp"
+
+#if defined(__linux__) && defined(__x86_64__)
+#include <sys/mman.h>
+#define JIT_X86_64
+#endif
+
+// Iterations the interpreter runs before a loop is compiled.
+#define JIT_THRESHOLD 1000
+
+// Bailouts before a region is thrown away for good.
+#define JIT_MAX_BAILOUTS 8
+
+// Operand bytes of the instructions that are used more than once.
+#define JMP   {0xE9}
+#define JZ    {0x0F, 0x84}
+#define JNZ   {0x0F, 0x85}
+#define JL    {0x0F, 0x8C}
+#define JG    {0x0F, 0x8F}
+#define SETE  0x94
+#define SETNE 0x95
+#define SETAE 0x93
+#define SETA  0x97
+#define SETL  0x9C
+#define SETGE 0x9D
+#define SETLE 0x9E
+#define SETG  0x9F
+
+using namespace JIT;
+
+typedef void (*Entry)(int64_t *regs);
+
+static struct {
+    size_t compiled = 0;
+    size_t rejected = 0;
+    size_t runs = 0;
+    size_t bailouts = 0;
+    size_t discarded = 0;
+} stats;
+
+// Given to loops that cannot be compiled (or kept bailing out)
+// so that they are never looked at again.
+static std::shared_ptr<Region> never = std::make_shared<Region>();
+
+Region::~Region() {
+#ifdef JIT_X86_64
+    if (m_code)
+        munmap(m_code, m_size);
+#endif
+}
+
+// Kept local to this file, vm.cpp has a Compiler of its own.
+namespace {
+
+// Thrown while compiling when something is not supported.
+struct Unsupported {};
+
+struct Asm {
+    std::vector<uint8_t> m_code;
+
+    void emit(std::initializer_list<uint8_t> bytes) {
+        m_code.insert(m_code.end(), bytes);
+    }
+
+    void imm32(uint32_t v) {
+        for (int i = 0; i < 4; ++i)
+            m_code.push_back(static_cast<uint8_t>(v >> (i*8)));
+    }
+
+    void imm64(uint64_t v) {
+        for (int i = 0; i < 8; ++i)
+            m_code.push_back(static_cast<uint8_t>(v >> (i*8)));
+    }
+
+    size_t here(void) const {
+        return m_code.size();
+    }
+
+    /// @brief Emit a jump and get where its target goes
+    size_t jump(std::initializer_list<uint8_t> opcode) {
+        emit(opcode);
+        size_t at = here();
+        imm32(0);
+        return at;
+    }
+
+    void patch(size_t at, size_t target) {
+        int32_t rel = static_cast<int32_t>(target) - static_cast<int32_t>(at+4);
+        std::memcpy(&m_code[at], &rel, sizeof(rel));
+    }
+
+    void jump_to(std::initializer_list<uint8_t> opcode, size_t target) {
+        patch(jump(opcode), target);
+    }
+
+    /// @brief `op reg, [rdi+8*r]` where `modrm` already holds the register
+    void mem(std::initializer_list<uint8_t> opcode, uint8_t modrm, size_t r) {
+        emit(opcode);
+        m_code.push_back(modrm);
+        imm32(static_cast<uint32_t>(r*8));
+    }
+
+    void load_eax(size_t r)    { mem({0x8B}, 0x87, r); }
+    void load_ecx(size_t r)    { mem({0x8B}, 0x8F, r); }
+    void load_edx(size_t r)    { mem({0x8B}, 0x97, r); }
+    void store_eax(size_t r)   { mem({0x89}, 0x87, r); }
+    void load_xmm0(size_t r)   { mem({0xF2, 0x0F, 0x10}, 0x87, r); }
+    void load_xmm1(size_t r)   { mem({0xF2, 0x0F, 0x10}, 0x8F, r); }
+    void store_xmm0(size_t r)  { mem({0xF2, 0x0F, 0x11}, 0x87, r); }
+
+    /// @brief `setcc al; movzx eax, al`
+    void setcc(uint8_t cc) {
+        emit({0x0F, cc, 0xC0, 0x0F, 0xB6, 0xC0});
+    }
+};
+
+struct Compiler {
+    Compiler(std::shared_ptr<Ctx> &ctx, Region &region) : m_ctx(ctx), m_region(region) {}
+
+    /// @brief Where a local lives. `m_local` is -1 for the
+    /// enumerators of nested `for` loops that only exist natively.
+    struct Binding {
+        Ty m_ty;
+        size_t m_reg;
+        int m_local;
+    };
+
+    struct Loop {
+        std::vector<size_t> m_brks;
+        std::vector<size_t> m_conts;
+    };
+
+    std::shared_ptr<Ctx> &m_ctx;
+    Region &m_region;
+    Asm m_asm;
+    std::unordered_map<int, Binding> m_bindings;
+    std::vector<Loop> m_loops;
+
+    size_t reg(void) {
+        return m_region.m_nregs++;
+    }
+
+    Binding &local(const Slot &slot) {
+        if (!slot.m_frame || slot.m_frame != m_ctx->m_frame.m_owner)
+            throw Unsupported{};
+
+        auto it = m_bindings.find(slot.m_index);
+        if (it != m_bindings.end())
+            return it->second;
+
+        earl::variable::Obj *var = m_ctx->m_frame.get(slot);
+        if (!var)
+            throw Unsupported{};
+
+        Ty ty;
+        switch (var->value()->type()) {
+        case earl::value::Type::Int:   ty = Ty::Int; break;
+        case earl::value::Type::Float: ty = Ty::Float; break;
+        default: throw Unsupported{};
+        }
+
+        size_t r = reg();
+        m_region.m_locals.push_back(Local{slot, ty, r, false});
+        Binding binding{ty, r, static_cast<int>(m_region.m_locals.size())-1};
+        return m_bindings.emplace(slot.m_index, binding).first->second;
+    }
+
+    Ty infer(Expr *expr) {
+        switch (expr->get_type()) {
+        case ExprType::Term: {
+            auto term = static_cast<ExprTerm *>(expr);
+            switch (term->get_term_type()) {
+            case ExprTermType::Ident:         return local(static_cast<ExprIdent *>(term)->m_slot).m_ty;
+            case ExprTermType::Int_Literal:   return Ty::Int;
+            case ExprTermType::Float_Literal: return Ty::Float;
+            case ExprTermType::Bool:          return Ty::Bool;
+            default: throw Unsupported{};
+            }
+        } break;
+        case ExprType::Unary: {
+            auto unary = static_cast<ExprUnary *>(expr);
+            Ty ty = infer(unary->m_expr.get());
+            switch (unary->m_op->type()) {
+            case TokenType::Minus:          if (ty != Ty::Bool) return ty; break;
+            case TokenType::Backtick_Tilde: if (ty == Ty::Int) return ty; break;
+            case TokenType::Bang:           if (ty == Ty::Bool) return ty; break;
+            default: break;
+            }
+            throw Unsupported{};
+        } break;
+        case ExprType::Binary: {
+            auto bin = static_cast<ExprBinary *>(expr);
+            Ty lt = infer(bin->m_lhs.get()), rt = infer(bin->m_rhs.get());
+            const bool ints = lt == Ty::Int && rt == Ty::Int;
+            const bool nums = lt != Ty::Bool && rt != Ty::Bool;
+            switch (bin->m_op->type()) {
+            case TokenType::Plus:
+            case TokenType::Minus:
+            case TokenType::Asterisk:
+            case TokenType::Forwardslash: {
+                if (nums)
+                    return ints ? Ty::Int : Ty::Float;
+            } break;
+            case TokenType::Percent:
+            case TokenType::Backtick_Pipe:
+            case TokenType::Backtick_Ampersand:
+            case TokenType::Backtick_Caret: {
+                if (ints)
+                    return Ty::Int;
+            } break;
+            case TokenType::Lessthan:
+            case TokenType::Greaterthan:
+            case TokenType::Lessthan_Equals:
+            case TokenType::Greaterthan_Equals:
+            case TokenType::Double_Equals:
+            case TokenType::Bang_Equals: {
+                if (nums)
+                    return Ty::Bool;
+            } break;
+            case TokenType::Double_Ampersand:
+            case TokenType::Double_Pipe: {
+                if (lt == Ty::Bool && rt == Ty::Bool)
+                    return Ty::Bool;
+            } break;
+            default: break;
+            }
+            throw Unsupported{};
+        } break;
+        }
+        throw Unsupported{};
+    }
+
+    /// @brief Emit `expr` with the result in eax (int, bool) or xmm0 (float)
+    Ty emit_expr(Expr *expr) {
+        Ty ty = infer(expr);
+        switch (expr->get_type()) {
+        case ExprType::Term: {
+            auto term = static_cast<ExprTerm *>(expr);
+            switch (term->get_term_type()) {
+            case ExprTermType::Ident: {
+                Binding &b = local(static_cast<ExprIdent *>(term)->m_slot);
+                if (b.m_ty == Ty::Int)
+                    m_asm.load_eax(b.m_reg);
+                else
+                    m_asm.load_xmm0(b.m_reg);
+            } break;
+            case ExprTermType::Int_Literal: {
+                int value = dynamic_cast<earl::value::Int *>(static_cast<ExprIntLit *>(term)->m_value.get())->value();
+                m_asm.emit({0xB8});
+                m_asm.imm32(static_cast<uint32_t>(value));
+            } break;
+            case ExprTermType::Float_Literal: {
+                double value = dynamic_cast<earl::value::Float *>(static_cast<ExprFloatLit *>(term)->m_value.get())->value();
+                uint64_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                m_asm.emit({0x48, 0xB8});
+                m_asm.imm64(bits);
+                m_asm.emit({0x66, 0x48, 0x0F, 0x6E, 0xC0}); // movq xmm0, rax
+            } break;
+            case ExprTermType::Bool: {
+                m_asm.emit({0xB8});
+                m_asm.imm32(static_cast<ExprBool *>(term)->m_value ? 1 : 0);
+            } break;
+            default: throw Unsupported{};
+            }
+        } break;
+        case ExprType::Unary: {
+            auto unary = static_cast<ExprUnary *>(expr);
+            emit_expr(unary->m_expr.get());
+            switch (unary->m_op->type()) {
+            case TokenType::Minus: {
+                if (ty == Ty::Int)
+                    m_asm.emit({0xF7, 0xD8}); // neg eax
+                else
+                    m_asm.emit({0x66, 0x48, 0x0F, 0x7E, 0xC0,  // movq rax, xmm0
+                                0x48, 0x0F, 0xBA, 0xF8, 0x3F,  // btc rax, 63
+                                0x66, 0x48, 0x0F, 0x6E, 0xC0}); // movq xmm0, rax
+            } break;
+            case TokenType::Backtick_Tilde: m_asm.emit({0xF7, 0xD0}); break;       // not eax
+            case TokenType::Bang:           m_asm.emit({0x83, 0xF0, 0x01}); break; // xor eax, 1
+            default: throw Unsupported{};
+            }
+        } break;
+        case ExprType::Binary: {
+            emit_binary(static_cast<ExprBinary *>(expr));
+        } break;
+        }
+        return ty;
+    }
+
+    /// @brief Same as emit_expr but promotes an int to a float if `want` is Float
+    void emit_as(Expr *expr, Ty want) {
+        if (emit_expr(expr) == Ty::Int && want == Ty::Float)
+            m_asm.emit({0xF2, 0x0F, 0x2A, 0xC0}); // cvtsi2sd xmm0, eax
+    }
+
+    void emit_binary(ExprBinary *expr) {
+        const TokenType op = expr->m_op->type();
+
+        if (op == TokenType::Double_Ampersand || op == TokenType::Double_Pipe) {
+            emit_expr(expr->m_lhs.get());
+            m_asm.emit({0x85, 0xC0}); // test eax, eax
+            size_t end = op == TokenType::Double_Ampersand ? m_asm.jump(JZ) : m_asm.jump(JNZ);
+            emit_expr(expr->m_rhs.get());
+            m_asm.patch(end, m_asm.here());
+            return;
+        }
+
+        Ty lt = infer(expr->m_lhs.get()), rt = infer(expr->m_rhs.get());
+        const Ty ty = lt == Ty::Float || rt == Ty::Float ? Ty::Float : Ty::Int;
+
+        // rhs goes to ecx/xmm1 and lhs to eax/xmm0.
+        emit_as(expr->m_rhs.get(), ty);
+        if (ty == Ty::Float)
+            m_asm.emit({0x66, 0x48, 0x0F, 0x7E, 0xC0}); // movq rax, xmm0
+        m_asm.emit({0x50});                             // push rax
+        emit_as(expr->m_lhs.get(), ty);
+        if (ty == Ty::Float)
+            m_asm.emit({0x58, 0x66, 0x48, 0x0F, 0x6E, 0xC8}); // pop rax; movq xmm1, rax
+        else
+            m_asm.emit({0x59});                               // pop rcx
+
+        if (ty == Ty::Int) {
+            switch (op) {
+            case TokenType::Plus:               m_asm.emit({0x01, 0xC8}); break;
+            case TokenType::Minus:              m_asm.emit({0x29, 0xC8}); break;
+            case TokenType::Asterisk:           m_asm.emit({0x0F, 0xAF, 0xC1}); break;
+            case TokenType::Forwardslash:       m_asm.emit({0x99, 0xF7, 0xF9}); break;             // cdq; idiv ecx
+            case TokenType::Percent:            m_asm.emit({0x99, 0xF7, 0xF9, 0x89, 0xD0}); break; // ...; mov eax, edx
+            case TokenType::Backtick_Ampersand: m_asm.emit({0x21, 0xC8}); break;
+            case TokenType::Backtick_Pipe:      m_asm.emit({0x09, 0xC8}); break;
+            case TokenType::Backtick_Caret:     m_asm.emit({0x31, 0xC8}); break;
+            case TokenType::Lessthan:           m_asm.emit({0x39, 0xC8}); m_asm.setcc(SETL); break;
+            case TokenType::Greaterthan:        m_asm.emit({0x39, 0xC8}); m_asm.setcc(SETG); break;
+            case TokenType::Lessthan_Equals:    m_asm.emit({0x39, 0xC8}); m_asm.setcc(SETLE); break;
+            case TokenType::Greaterthan_Equals: m_asm.emit({0x39, 0xC8}); m_asm.setcc(SETGE); break;
+            case TokenType::Double_Equals:      m_asm.emit({0x39, 0xC8}); m_asm.setcc(SETE); break;
+            case TokenType::Bang_Equals:        m_asm.emit({0x39, 0xC8}); m_asm.setcc(SETNE); break;
+            default: throw Unsupported{};
+            }
+            return;
+        }
+
+        // The comparisons must be false when unordered (NaN), like in C++.
+        switch (op) {
+        case TokenType::Plus:               m_asm.emit({0xF2, 0x0F, 0x58, 0xC1}); break;
+        case TokenType::Minus:              m_asm.emit({0xF2, 0x0F, 0x5C, 0xC1}); break;
+        case TokenType::Asterisk:           m_asm.emit({0xF2, 0x0F, 0x59, 0xC1}); break;
+        case TokenType::Forwardslash:       m_asm.emit({0xF2, 0x0F, 0x5E, 0xC1}); break;
+        case TokenType::Lessthan:           m_asm.emit({0x66, 0x0F, 0x2E, 0xC8}); m_asm.setcc(SETA); break;
+        case TokenType::Lessthan_Equals:    m_asm.emit({0x66, 0x0F, 0x2E, 0xC8}); m_asm.setcc(SETAE); break;
+        case TokenType::Greaterthan:        m_asm.emit({0x66, 0x0F, 0x2E, 0xC1}); m_asm.setcc(SETA); break;
+        case TokenType::Greaterthan_Equals: m_asm.emit({0x66, 0x0F, 0x2E, 0xC1}); m_asm.setcc(SETAE); break;
+        case TokenType::Double_Equals: {
+            // sete al; setnp cl; and al, cl
+            m_asm.emit({0x66, 0x0F, 0x2E, 0xC1, 0x0F, 0x94, 0xC0, 0x0F, 0x9B, 0xC1, 0x20, 0xC8, 0x0F, 0xB6, 0xC0});
+        } break;
+        case TokenType::Bang_Equals: {
+            // setne al; setp cl; or al, cl
+            m_asm.emit({0x66, 0x0F, 0x2E, 0xC1, 0x0F, 0x95, 0xC0, 0x0F, 0x9A, 0xC1, 0x08, 0xC8, 0x0F, 0xB6, 0xC0});
+        } break;
+        default: throw Unsupported{};
+        }
+    }
+
+    /// @brief Emit a condition and get the jump taken when it is false
+    size_t emit_cond(Expr *expr) {
+        if (infer(expr) != Ty::Bool)
+            throw Unsupported{};
+        emit_expr(expr);
+        m_asm.emit({0x85, 0xC0}); // test eax, eax
+        return m_asm.jump(JZ);
+    }
+
+    void emit_mut(StmtMut *stmt) {
+        if (stmt->m_left->get_type() != ExprType::Term
+            || static_cast<ExprTerm *>(stmt->m_left.get())->get_term_type() != ExprTermType::Ident)
+            throw Unsupported{};
+
+        Binding &b = local(static_cast<ExprIdent *>(stmt->m_left.get())->m_slot);
+        const TokenType op = stmt->m_equals->type();
+        Ty rt = infer(stmt->m_right.get());
+        if (rt == Ty::Bool)
+            throw Unsupported{};
+
+        if (b.m_ty == Ty::Int) {
+            // Same as Int::mutate and Int::spec_mutate, a float is truncated first.
+            emit_expr(stmt->m_right.get());
+            if (rt == Ty::Float)
+                m_asm.emit({0xF2, 0x0F, 0x2C, 0xC0}); // cvttsd2si eax, xmm0
+            if (op != TokenType::Equals) {
+                m_asm.emit({0x89, 0xC1}); // mov ecx, eax
+                m_asm.load_eax(b.m_reg);
+                switch (op) {
+                case TokenType::Plus_Equals:               m_asm.emit({0x01, 0xC8}); break;
+                case TokenType::Minus_Equals:              m_asm.emit({0x29, 0xC8}); break;
+                case TokenType::Asterisk_Equals:           m_asm.emit({0x0F, 0xAF, 0xC1}); break;
+                case TokenType::Forwardslash_Equals:       m_asm.emit({0x99, 0xF7, 0xF9}); break;
+                case TokenType::Percent_Equals:            m_asm.emit({0x99, 0xF7, 0xF9, 0x89, 0xD0}); break;
+                case TokenType::Backtick_Ampersand_Equals: m_asm.emit({0x21, 0xC8}); break;
+                case TokenType::Backtick_Pipe_Equals:      m_asm.emit({0x09, 0xC8}); break;
+                case TokenType::Backtick_Caret_Equals:     m_asm.emit({0x31, 0xC8}); break;
+                default: throw Unsupported{};
+                }
+            }
+            m_asm.store_eax(b.m_reg);
+        }
+        else {
+            // Float::spec_mutate only behaves as expected for these.
+            emit_as(stmt->m_right.get(), Ty::Float);
+            switch (op) {
+            case TokenType::Equals: break;
+            case TokenType::Plus_Equals:     m_asm.load_xmm1(b.m_reg); m_asm.emit({0xF2, 0x0F, 0x58, 0xC1}); break;
+            case TokenType::Asterisk_Equals: m_asm.load_xmm1(b.m_reg); m_asm.emit({0xF2, 0x0F, 0x59, 0xC1}); break;
+            default: throw Unsupported{};
+            }
+            m_asm.store_xmm0(b.m_reg);
+        }
+
+        if (b.m_local != -1)
+            m_region.m_locals[b.m_local].m_written = true;
+    }
+
+    /// @brief Emit the body of a loop and patch its `break`s and `continue`s
+    void emit_loop_body(StmtBlock *block, size_t top, std::vector<size_t> &exits) {
+        m_loops.emplace_back();
+        emit_block(block);
+        Loop loop = std::move(m_loops.back());
+        m_loops.pop_back();
+        m_asm.jump_to(JMP, top);
+        for (size_t at : loop.m_conts)
+            m_asm.patch(at, top);
+        for (size_t at : loop.m_brks)
+            exits.push_back(at);
+    }
+
+    /// @brief The same steps as eval_stmt_for, `i`, `end` and `up` are registers
+    void emit_for_loop(size_t i, size_t end, size_t up, StmtBlock *block) {
+        std::vector<size_t> exits;
+        size_t top = m_asm.here();
+
+        m_asm.load_edx(up);
+        m_asm.emit({0x85, 0xD2}); // test edx, edx
+        size_t down = m_asm.jump(JZ);
+        m_asm.load_eax(i);
+        m_asm.load_ecx(end);
+        m_asm.emit({0xFF, 0xC9, 0x39, 0xC8}); // dec ecx; cmp eax, ecx
+        exits.push_back(m_asm.jump(JG));
+        size_t body = m_asm.jump(JMP);
+        m_asm.patch(down, m_asm.here());
+        m_asm.load_eax(i);
+        m_asm.load_ecx(end);
+        m_asm.emit({0x39, 0xC8});
+        exits.push_back(m_asm.jump(JL));
+        m_asm.patch(body, m_asm.here());
+
+        // The step is where `continue` goes.
+        size_t skip = m_asm.jump(JMP);
+        size_t step = m_asm.here();
+        m_asm.load_eax(i);
+        m_asm.load_edx(up);
+        m_asm.emit({0x85, 0xD2});
+        size_t dec = m_asm.jump(JZ);
+        m_asm.emit({0xFF, 0xC0}); // inc eax
+        size_t store = m_asm.jump(JMP);
+        m_asm.patch(dec, m_asm.here());
+        m_asm.emit({0xFF, 0xC8}); // dec eax
+        m_asm.patch(store, m_asm.here());
+        m_asm.store_eax(i);
+        m_asm.jump_to(JMP, top);
+        m_asm.patch(skip, m_asm.here());
+
+        emit_loop_body(block, step, exits);
+        for (size_t at : exits)
+            m_asm.patch(at, m_asm.here());
+    }
+
+    /// @brief eval_stmt_for keeps the value of its `end`, so when that
+    /// is a local it sees every write to it. Use its register then.
+    bool end_local(StmtFor *stmt, size_t &end) {
+        Expr *expr = stmt->m_end.get();
+        if (expr->get_type() != ExprType::Term
+            || static_cast<ExprTerm *>(expr)->get_term_type() != ExprTermType::Ident)
+            return false;
+        const Slot &slot = static_cast<ExprIdent *>(expr)->m_slot;
+        if (!slot.m_frame || slot.m_frame != m_ctx->m_frame.m_owner)
+            return false;
+        Binding &b = local(slot);
+        if (b.m_ty != Ty::Int)
+            throw Unsupported{};
+        end = b.m_reg;
+        return true;
+    }
+
+    void emit_for(StmtFor *stmt) {
+        const Slot &slot = stmt->m_slot;
+        if (!slot.m_frame || slot.m_frame != m_ctx->m_frame.m_owner
+            || m_bindings.count(slot.m_index) != 0
+            || m_ctx->variable_exists(stmt->m_enumerator->lexeme()))
+            throw Unsupported{};
+        if (infer(stmt->m_start.get()) != Ty::Int || infer(stmt->m_end.get()) != Ty::Int)
+            throw Unsupported{};
+
+        size_t i = reg(), end = 0, up = reg();
+        emit_expr(stmt->m_start.get());
+        m_asm.store_eax(i);
+        if (!end_local(stmt, end)) {
+            end = reg();
+            emit_expr(stmt->m_end.get());
+            m_asm.store_eax(end);
+        }
+        m_asm.load_eax(end);
+        m_asm.load_ecx(i);
+        m_asm.emit({0x39, 0xC1}); // cmp ecx, eax
+        m_asm.setcc(SETLE);
+        m_asm.store_eax(up);
+
+        m_bindings.emplace(slot.m_index, Binding{Ty::Int, i, -1});
+        emit_for_loop(i, end, up, stmt->m_block.get());
+        m_bindings.erase(slot.m_index);
+    }
+
+    void emit_while(StmtWhile *stmt) {
+        std::vector<size_t> exits;
+        size_t top = m_asm.here();
+        exits.push_back(emit_cond(stmt->m_expr.get()));
+        emit_loop_body(stmt->m_block.get(), top, exits);
+        for (size_t at : exits)
+            m_asm.patch(at, m_asm.here());
+    }
+
+    void emit_loop(StmtLoop *stmt) {
+        std::vector<size_t> exits;
+        emit_loop_body(stmt->m_block.get(), m_asm.here(), exits);
+        for (size_t at : exits)
+            m_asm.patch(at, m_asm.here());
+    }
+
+    void emit_if(StmtIf *stmt) {
+        size_t otherwise = emit_cond(stmt->m_expr.get());
+        emit_block(stmt->m_block.get());
+        if (stmt->m_else.has_value()) {
+            size_t end = m_asm.jump(JMP);
+            m_asm.patch(otherwise, m_asm.here());
+            emit_block(stmt->m_else.value().get());
+            m_asm.patch(end, m_asm.here());
+        }
+        else
+            m_asm.patch(otherwise, m_asm.here());
+    }
+
+    void emit_stmt(Stmt *stmt) {
+        switch (stmt->stmt_type()) {
+        case StmtType::Mut:      emit_mut(static_cast<StmtMut *>(stmt)); break;
+        case StmtType::If:       emit_if(static_cast<StmtIf *>(stmt)); break;
+        case StmtType::Block:    emit_block(static_cast<StmtBlock *>(stmt)); break;
+        case StmtType::While:    emit_while(static_cast<StmtWhile *>(stmt)); break;
+        case StmtType::Loop:     emit_loop(static_cast<StmtLoop *>(stmt)); break;
+        case StmtType::For:      emit_for(static_cast<StmtFor *>(stmt)); break;
+        case StmtType::Break: {
+            if (m_loops.empty())
+                throw Unsupported{};
+            m_loops.back().m_brks.push_back(m_asm.jump(JMP));
+        } break;
+        case StmtType::Continue: {
+            if (m_loops.empty())
+                throw Unsupported{};
+            m_loops.back().m_conts.push_back(m_asm.jump(JMP));
+        } break;
+        default: throw Unsupported{};
+        }
+    }
+
+    void emit_block(StmtBlock *block) {
+        for (auto &stmt : block->m_stmts)
+            emit_stmt(stmt.get());
+    }
+
+    /// @brief Emit the whole loop, entered at the start of an iteration
+    void emit_region(Stmt *loop) {
+        switch (loop->stmt_type()) {
+        case StmtType::While: emit_while(static_cast<StmtWhile *>(loop)); break;
+        case StmtType::Loop:  emit_loop(static_cast<StmtLoop *>(loop)); break;
+        case StmtType::For: {
+            // The enumerator already exists, only the loop itself is compiled.
+            auto stmt = static_cast<StmtFor *>(loop);
+            Binding &i = local(stmt->m_slot);
+            if (i.m_ty != Ty::Int)
+                throw Unsupported{};
+            m_region.m_locals[i.m_local].m_written = true;
+            m_region.m_end_reg = reg();
+            m_region.m_up_reg = reg();
+            size_t end = m_region.m_end_reg;
+            (void)end_local(stmt, end);
+            emit_for_loop(i.m_reg, end, m_region.m_up_reg, stmt->m_block.get());
+        } break;
+        default: throw Unsupported{};
+        }
+        m_asm.emit({0xC3}); // ret
+    }
+};
+
+};
+
+static std::shared_ptr<Region>
+compile(Stmt *loop, std::shared_ptr<Ctx> &ctx) {
+#ifdef JIT_X86_64
+    auto region = std::make_shared<Region>();
+    Compiler compiler(ctx, *region);
+    try {
+        compiler.emit_region(loop);
+    } catch (const Unsupported &) {
+        return nullptr;
+    }
+
+    std::vector<uint8_t> &code = compiler.m_asm.m_code;
+    void *mem = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED)
+        return nullptr;
+    std::memcpy(mem, code.data(), code.size());
+    if (mprotect(mem, code.size(), PROT_READ | PROT_EXEC) != 0) {
+        munmap(mem, code.size());
+        return nullptr;
+    }
+    region->m_code = mem;
+    region->m_size = code.size();
+    return region;
+#else
+    (void)loop;
+    (void)ctx;
+    return nullptr;
+#endif
+}
+
+bool
+JIT::run(Stmt *loop, JitSite &site, std::shared_ptr<Ctx> &ctx, int end, bool up) {
+    if (site.m_hits < JIT_THRESHOLD) {
+        ++site.m_hits;
+        return false;
+    }
+
+    if (!site.m_region) {
+        site.m_region = compile(loop, ctx);
+        if (site.m_region)
+            ++stats.compiled;
+        else {
+            site.m_region = never;
+            ++stats.rejected;
+        }
+    }
+
+    Region *region = site.m_region.get();
+    if (!region->m_code)
+        return false;
+
+    // The guards, every local must still have the type it was
+    // compiled for and must not share its value with another one.
+    std::vector<int64_t> regs(region->m_nregs, 0);
+    std::vector<earl::value::Obj *> values(region->m_locals.size(), nullptr);
+    bool ok = true;
+
+    for (size_t i = 0; ok && i < region->m_locals.size(); ++i) {
+        const Local &local = region->m_locals[i];
+        earl::variable::Obj *var = ctx->m_frame.get(local.m_slot);
+        earl::value::Obj *value = var ? var->value().get() : nullptr;
+
+        if (!value
+            || value->type() != (local.m_ty == Ty::Int ? earl::value::Type::Int : earl::value::Type::Float)
+            || (local.m_written && value->is_const())) {
+            ok = false;
+            break;
+        }
+        for (size_t j = 0; j < i; ++j)
+            if (values[j] == value)
+                ok = false;
+        values[i] = value;
+
+        if (local.m_ty == Ty::Int) {
+            int32_t v = static_cast<earl::value::Int *>(value)->value();
+            std::memcpy(&regs[local.m_reg], &v, sizeof(v));
+        }
+        else {
+            double v = static_cast<earl::value::Float *>(value)->value();
+            std::memcpy(&regs[local.m_reg], &v, sizeof(v));
+        }
+    }
+
+    if (!ok) {
+        ++stats.bailouts;
+        site.m_hits = 0;
+        if (++region->m_bailouts >= JIT_MAX_BAILOUTS) {
+            site.m_region = never;
+            ++stats.discarded;
+        }
+        return false;
+    }
+
+    if (loop->stmt_type() == StmtType::For) {
+        int32_t u = up ? 1 : 0;
+        std::memcpy(&regs[region->m_end_reg], &end, sizeof(end));
+        std::memcpy(&regs[region->m_up_reg], &u, sizeof(u));
+    }
+
+    ++stats.runs;
+    reinterpret_cast<Entry>(region->m_code)(regs.data());
+
+    for (size_t i = 0; i < region->m_locals.size(); ++i) {
+        const Local &local = region->m_locals[i];
+        if (!local.m_written)
+            continue;
+        if (local.m_ty == Ty::Int) {
+            int32_t v;
+            std::memcpy(&v, &regs[local.m_reg], sizeof(v));
+            static_cast<earl::value::Int *>(values[i])->fill(v);
+        }
+        else {
+            double v;
+            std::memcpy(&v, &regs[local.m_reg], sizeof(v));
+            static_cast<earl::value::Float *>(values[i])->fill(v);
+        }
+    }
+
+    return true;
+}
+
+void
+JIT::report(void) {
+    std::cerr << "[EARL] jit: " << stats.compiled << " regions compiled, "
+              << stats.rejected << " rejected, "
+              << stats.runs << " native runs, "
+              << stats.bailouts << " bailouts, "
+              << stats.discarded << " discarded" << std::endl;
+}
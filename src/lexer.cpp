@@ -29,6 +29,7 @@
 #include <string>
 #include <unordered_map>
 #include <functional>
+#include <cstring>
 
 #include "err.hpp"
 #include "token.hpp"
@@ -37,60 +38,46 @@
 #include "common.hpp"
 #include "config.h"
 
-Lexer::Lexer() : m_hd(nullptr), m_tl(nullptr), m_len(0) {}
+Lexer::Lexer() : m_toks(), m_pos(0), m_kept() {}
 
 void Lexer::append(std::shared_ptr<Token> tok) {
-    if (!m_hd) {
-        m_hd = tok;
-        m_tl = m_hd.get();
-    } else {
-        m_tl->m_next = tok;
-        m_tl = m_tl->m_next.get();
-    }
-    ++m_len;
+    if (!m_toks.empty())
+        m_toks.back()->m_next = tok.get();
+    m_toks.push_back(std::move(tok));
 }
 
-void Lexer::append(std::string lexeme, TokenType type, size_t row, size_t col, std::string fp) {
-    auto tok = std::make_shared<Token>(lexeme, type, row, col, fp);
+void Lexer::append(std::string lexeme, TokenType type, size_t row, size_t col, uint32_t file) {
+    auto tok = std::make_shared<Token>(std::move(lexeme), type, row, col, file);
     this->append(std::move(tok));
 }
 
+void Lexer::keep(std::vector<std::shared_ptr<Token>> toks) {
+    for (auto &tok : toks)
+        m_kept.push_back(std::move(tok));
+}
+
 Token *Lexer::peek(size_t n) {
-    Token *tok = m_hd.get();
-    for (size_t i = 0; i < n && tok; ++i) {
-        if (!tok)
-            return nullptr;
-        tok = tok->m_next.get();
-    }
-    return tok;
+    if (m_pos + n >= m_toks.size())
+        return nullptr;
+    return m_toks[m_pos + n].get();
 }
 
 std::shared_ptr<Token> Lexer::next(void) {
-    if (!m_hd)
+    if (m_pos >= m_toks.size())
         return nullptr;
-
-    std::shared_ptr<Token> tok = m_hd;
-    m_hd = tok->m_next;
-
-    if (!m_hd)
-        m_tl = nullptr;
-
-    --m_len;
-    return tok;
+    return m_toks[m_pos++];
 }
 
 void Lexer::discard(void) {
-    if (!m_hd)
-        return;
-    m_hd = m_hd->m_next;
+    if (m_pos < m_toks.size())
+        ++m_pos;
 }
 
 void Lexer::dump(void) {
-    Token *it = m_hd.get();
-    while (it) {
+    for (size_t i = m_pos; i < m_toks.size(); ++i) {
+        Token *it = m_toks[i].get();
         printf("lexeme: \"%s\", type: %s, row: %zu, col: %zu, fp: %s\n",
-               it->m_lexeme.c_str(), tokentype_to_str(it->type()).c_str(), it->m_row, it->m_col, it->m_fp.c_str());
-        it = it->m_next.get();
+               it->m_lexeme.c_str(), tokentype_to_str(it->type()).c_str(), it->m_row, it->m_col, it->fp().c_str());
     }
 }
 
@@ -117,12 +104,119 @@ static size_t find_comment_end(char *s) {
 }
 
 static bool
-is_keyword(char *s, size_t len, std::vector<std::string> &keywords) {
-    std::string word(s, len);
-    for (std::string &kw : keywords)
-        if (word == kw)
-            return true;
-    return false;
+kw_eq(const char *s, size_t len, const char *kw) {
+    return std::strncmp(s, kw, len) == 0 && kw[len] == '\0';
+}
+
+// The keywords are known up front, so they are matched by
+// their length instead of looking through all of them.
+static bool
+is_keyword(const char *s, size_t len) {
+    switch (len) {
+    case 2: return kw_eq(s, len, COMMON_EARLKW_FN) || kw_eq(s, len, COMMON_EARLKW_IF)
+            || kw_eq(s, len, COMMON_EARLKW_IN) || kw_eq(s, len, COMMON_EARLKW_AS)
+            || kw_eq(s, len, COMMON_EARLKW_TO);
+    case 3: return kw_eq(s, len, COMMON_EARLKW_LET) || kw_eq(s, len, COMMON_EARLKW_FOR);
+    case 4: return kw_eq(s, len, COMMON_EARLKW_ELSE) || kw_eq(s, len, COMMON_EARLKW_TRUE)
+            || kw_eq(s, len, COMMON_EARLKW_NONE) || kw_eq(s, len, COMMON_EARLKW_WHEN)
+            || kw_eq(s, len, COMMON_EARLKW_ENUM) || kw_eq(s, len, COMMON_EARLKW_FULL)
+            || kw_eq(s, len, COMMON_EARLKW_LOOP);
+    case 5: return kw_eq(s, len, COMMON_EARLKW_WHILE) || kw_eq(s, len, COMMON_EARLKW_CLASS)
+            || kw_eq(s, len, COMMON_EARLKW_FALSE) || kw_eq(s, len, COMMON_EARLKW_MATCH)
+            || kw_eq(s, len, COMMON_EARLKW_BREAK);
+    case 6: return kw_eq(s, len, COMMON_EARLKW_RETURN) || kw_eq(s, len, COMMON_EARLKW_IMPORT)
+            || kw_eq(s, len, COMMON_EARLKW_MODULE) || kw_eq(s, len, COMMON_EARLKW_ALMOST);
+    case 7: return kw_eq(s, len, COMMON_EARLKW_FOREACH);
+    case 8: return kw_eq(s, len, COMMON_EARLKW_CONTINUE);
+    default: return false;
+    }
+}
+
+// The longest symbol at `s` that is at most `len` characters,
+// or 0 if there is none.
+static size_t
+match_symbol(const char *s, size_t len, TokenType &type) {
+    if (len >= 3 && s[0] == '`' && s[2] == '=') {
+        switch (s[1]) {
+        case '|': type = TokenType::Backtick_Pipe_Equals;      return 3;
+        case '&': type = TokenType::Backtick_Ampersand_Equals; return 3;
+        case '^': type = TokenType::Backtick_Caret_Equals;     return 3;
+        default: break;
+        }
+    }
+
+    if (len >= 2) {
+        type = TokenType::Total_Len;
+        switch (s[0]) {
+        case '&': if (s[1] == '&') type = TokenType::Double_Ampersand; break;
+        case '|': if (s[1] == '|') type = TokenType::Double_Pipe; break;
+        case '>':
+            if (s[1] == '=') type = TokenType::Greaterthan_Equals;
+            else if (s[1] == '>') type = TokenType::Double_Greaterthan;
+            break;
+        case '<':
+            if (s[1] == '=') type = TokenType::Lessthan_Equals;
+            else if (s[1] == '<') type = TokenType::Double_Lessthan;
+            break;
+        case '=': if (s[1] == '=') type = TokenType::Double_Equals; break;
+        case '!': if (s[1] == '=') type = TokenType::Bang_Equals; break;
+        case '+': if (s[1] == '=') type = TokenType::Plus_Equals; break;
+        case '-':
+            if (s[1] == '=') type = TokenType::Minus_Equals;
+            else if (s[1] == '>') type = TokenType::RightArrow;
+            break;
+        case '*':
+            if (s[1] == '=') type = TokenType::Asterisk_Equals;
+            else if (s[1] == '*') type = TokenType::Double_Asterisk;
+            break;
+        case '/': if (s[1] == '=') type = TokenType::Forwardslash_Equals; break;
+        case '%': if (s[1] == '=') type = TokenType::Percent_Equals; break;
+        case '.': if (s[1] == '.') type = TokenType::Double_Period; break;
+        case ':': if (s[1] == ':') type = TokenType::Double_Colon; break;
+        case '`':
+            if (s[1] == '|') type = TokenType::Backtick_Pipe;
+            else if (s[1] == '&') type = TokenType::Backtick_Ampersand;
+            else if (s[1] == '~') type = TokenType::Backtick_Tilde;
+            else if (s[1] == '^') type = TokenType::Backtick_Caret;
+            break;
+        default: break;
+        }
+        if (type != TokenType::Total_Len)
+            return 2;
+    }
+
+    switch (s[0]) {
+    case '(':  type = TokenType::Lparen;        return 1;
+    case ')':  type = TokenType::Rparen;        return 1;
+    case '[':  type = TokenType::Lbracket;      return 1;
+    case ']':  type = TokenType::Rbracket;      return 1;
+    case '{':  type = TokenType::Lbrace;        return 1;
+    case '}':  type = TokenType::Rbrace;        return 1;
+    case '#':  type = TokenType::Hash;          return 1;
+    case '.':  type = TokenType::Period;        return 1;
+    case ';':  type = TokenType::Semicolon;     return 1;
+    case ',':  type = TokenType::Comma;         return 1;
+    case '>':  type = TokenType::Greaterthan;   return 1;
+    case '<':  type = TokenType::Lessthan;      return 1;
+    case '=':  type = TokenType::Equals;        return 1;
+    case '&':  type = TokenType::Ampersand;     return 1;
+    case '*':  type = TokenType::Asterisk;      return 1;
+    case '+':  type = TokenType::Plus;          return 1;
+    case '-':  type = TokenType::Minus;         return 1;
+    case '/':  type = TokenType::Forwardslash;  return 1;
+    case '|':  type = TokenType::Pipe;          return 1;
+    case '^':  type = TokenType::Caret;         return 1;
+    case '?':  type = TokenType::Questionmark;  return 1;
+    case '\\': type = TokenType::Backwardslash; return 1;
+    case '!':  type = TokenType::Bang;          return 1;
+    case '@':  type = TokenType::At;            return 1;
+    case '$':  type = TokenType::Dollarsign;    return 1;
+    case '%':  type = TokenType::Percent;       return 1;
+    case '`':  type = TokenType::Backtick;      return 1;
+    case '~':  type = TokenType::Tilde;         return 1;
+    case ':':  type = TokenType::Colon;         return 1;
+    default:   return 0;
+    }
 }
 
 static bool
@@ -146,22 +240,27 @@ try_comment(char *src, std::string &comment) {
     return false;
 }
 
-char *
-read_file(const char *filepath) {
+std::string
+resolve_filepath(const char *filepath) {
     const char *search_path = PREFIX "/include/EARL/";
 
     char full_path[256];
     snprintf(full_path, sizeof(full_path), "%s%s", search_path, filepath);
 
-    FILE *f = nullptr;
-
     if ((flags & __WITHOUT_STDLIB) == 0) {
-        f = fopen(full_path, "rb");
+        FILE *f = fopen(full_path, "rb");
+        if (f != nullptr) {
+            fclose(f);
+            return full_path;
+        }
     }
 
-    if (f == nullptr) {
-        f = fopen(filepath, "rb");
-    }
+    return filepath;
+}
+
+char *
+read_file(const char *filepath) {
+    FILE *f = fopen(resolve_filepath(filepath).c_str(), "rb");
 
     if (f == nullptr || fseek(f, 0, SEEK_END)) {
         std::string msg = "could not find the specified source filepath: " + std::string(filepath);
@@ -192,72 +291,16 @@ read_file(const char *filepath) {
 std::unique_ptr<Lexer>
 lex_file(std::string &src,
          std::string fp,
-         std::vector<std::string> &keywords,
          std::vector<std::string> &types,
          std::string &comment) {
-    (void)is_keyword;
     (void)is_type;
     (void)issym;
     (void)try_comment;
     (void)types;
     (void)comment;
-    std::unique_ptr<Lexer> lexer = std::make_unique<Lexer>();
 
-    const std::unordered_map<std::string, TokenType> ht = {
-        {"(", TokenType::Lparen},
-        {")", TokenType::Rparen},
-        {"[", TokenType::Lbracket},
-        {"]", TokenType::Rbracket},
-        {"{", TokenType::Lbrace},
-        {"}", TokenType::Rbrace},
-        {"#", TokenType::Hash},
-        {".", TokenType::Period},
-        {";", TokenType::Semicolon},
-        {",", TokenType::Comma},
-        {">", TokenType::Greaterthan},
-        {"<", TokenType::Lessthan},
-        {"=", TokenType::Equals},
-        {"&", TokenType::Ampersand},
-        {"*", TokenType::Asterisk},
-        {"+", TokenType::Plus},
-        {"-", TokenType::Minus},
-        {"/", TokenType::Forwardslash},
-        {"|", TokenType::Pipe},
-        {"^", TokenType::Caret},
-        {"?", TokenType::Questionmark},
-        {"\\", TokenType::Backwardslash},
-        {"!", TokenType::Bang},
-        {"@", TokenType::At},
-        {"$", TokenType::Dollarsign},
-        {"%", TokenType::Percent},
-        {"`", TokenType::Backtick},
-        {"~", TokenType::Tilde},
-        {":", TokenType::Colon},
-        {"&&", TokenType::Double_Ampersand},
-        {"||", TokenType::Double_Pipe},
-        {">=", TokenType::Greaterthan_Equals},
-        {"<=", TokenType::Lessthan_Equals},
-        {"==", TokenType::Double_Equals},
-        {"!=", TokenType::Bang_Equals},
-        {"+=", TokenType::Plus_Equals},
-        {"-=", TokenType::Minus_Equals},
-        {"*=", TokenType::Asterisk_Equals},
-        {"/=", TokenType::Forwardslash_Equals},
-        {"%=", TokenType::Percent_Equals},
-        {"->", TokenType::RightArrow},
-        {"..", TokenType::Double_Period},
-        {"::", TokenType::Double_Colon},
-        {"**", TokenType::Double_Asterisk},
-        {"<<", TokenType::Double_Lessthan},
-        {">>", TokenType::Double_Greaterthan},
-        {"`|", TokenType::Backtick_Pipe},
-        {"`&", TokenType::Backtick_Ampersand},
-        {"`~", TokenType::Backtick_Tilde},
-        {"`^", TokenType::Backtick_Caret},
-        {"`|=", TokenType::Backtick_Pipe_Equals},
-        {"`&=", TokenType::Backtick_Ampersand_Equals},
-        {"`^=", TokenType::Backtick_Caret_Equals},
-    };
+    std::unique_ptr<Lexer> lexer = std::make_unique<Lexer>();
+    const uint32_t file = token_intern_fp(fp);
 
     int row = 1, col = 0;
     size_t i = 0;
@@ -286,7 +329,7 @@ lex_file(std::string &src,
             size_t strlit_len = consume_until(lexeme+1, [](const char c) {
                 return c == '"';
             });
-            std::shared_ptr<Token> tok = token_alloc(*lexer.get(), lexeme+1, strlit_len, TokenType::Strlit, row, col, fp);
+            std::shared_ptr<Token> tok = token_alloc(*lexer.get(), lexeme+1, strlit_len, TokenType::Strlit, row, col, file);
             lexer->append(std::move(tok));
             i += 1 + strlit_len + 1;
             col += 1 + strlit_len + 1;
@@ -303,38 +346,39 @@ lex_file(std::string &src,
             }
             else
                 charlit = std::string(1, src[i]);
-            lexer->append(charlit, TokenType::Charlit, row, col, fp);
+            lexer->append(std::move(charlit), TokenType::Charlit, row, col, file);
             i += 2;
             col += 3;
         }
 
         else if (isalpha(src[i]) || src[i] == '_') {
-            std::string ident = "";
+            size_t start = i;
             while (src[i] == '_' || isalnum(src[i]))
-                ident += src[i++];
-            if (std::find(keywords.begin(), keywords.end(), ident) != keywords.end())
-                lexer->append(ident, TokenType::Keyword, row, col+1, fp);
+                ++i;
+            size_t len = i-start;
+            if (is_keyword(lexeme, len))
+                lexer->append(std::string(lexeme, len), TokenType::Keyword, row, col+1, file);
             else
-                lexer->append(ident, TokenType::Ident, row, col+1, fp);
-            col += ident.size()+1;
+                lexer->append(std::string(lexeme, len), TokenType::Ident, row, col+1, file);
+            col += len+1;
         }
 
         else if (isdigit(src[i])) {
-            std::string digit = "";
+            size_t start = i;
             while (isdigit(src[i]))
-                digit += src[i++];
+                ++i;
+            size_t digit = i-start;
             if (src[i] && src[i+1] && src[i] == '.' && src[i+1] != '.') {
                 ++i;
-                std::string digit2 = ".";
                 while (isdigit(src[i]))
-                    digit2 += src[i++];
-                lexer->append(digit+digit2, TokenType::Floatlit, row, col, fp);
-                // no need for +1 for `.` because its in `digit2`
-                col += digit.size()+digit2.size();
+                    ++i;
+                lexer->append(std::string(lexeme, i-start), TokenType::Floatlit, row, col, file);
+                // no need for +1 for `.` because its in the length
+                col += i-start;
             }
             else {
-                lexer->append(digit, TokenType::Intlit, row, col, fp);
-                col += digit.size()+1;
+                lexer->append(std::string(lexeme, digit), TokenType::Intlit, row, col, file);
+                col += digit+1;
             }
         }
 
@@ -349,31 +393,34 @@ lex_file(std::string &src,
         // }
 
         else {
-            std::string buf = "";
-            while (src[i] && !isalnum(src[i]) && src[i] != '_')
-                buf += src[i++];
-            while (!buf.empty()) {
-                auto it = ht.find(buf);
-                if (it != ht.end()) {
-                    if (buf == "." && src[i] && isdigit(src[i])) {
-                        std::string digit = "";
-                        while (isdigit(src[i]))
-                            digit += src[i++];
-                        lexer->append(buf+digit, TokenType::Floatlit, row, col, fp);
-                        col += digit.size()+1;
-                    }
-                    else
-                        lexer->append(buf, (*it).second, row, col, fp);
-                    break;
-                }
-                else {
-                    buf.pop_back();
-                    --i;
-                }
+            // Symbols are at most three characters, take the
+            // longest one that the upcoming characters make.
+            size_t avail = 0;
+            while (avail < 3 && src[i+avail] && !isalnum(src[i+avail]) && src[i+avail] != '_')
+                ++avail;
+            TokenType type;
+            size_t len = match_symbol(lexeme, avail, type);
+            if (len == 0) {
+                Token tok(lexeme, 1, TokenType::Total_Len, row, col, file);
+                Err::err_wtok(&tok);
+                const std::string msg = isprint(*lexeme)
+                    ? "unknown character `" + tok.lexeme() + "`"
+                    : "unknown character with code " + std::to_string(static_cast<unsigned char>(*lexeme));
+                throw LexerException(msg);
             }
+            i += len;
+            if (len == 1 && type == TokenType::Period && src[i] && isdigit(src[i])) {
+                size_t start = i;
+                while (isdigit(src[i]))
+                    ++i;
+                lexer->append(std::string(lexeme, i-start+1), TokenType::Floatlit, row, col, file);
+                col += i-start+1;
+            }
+            else
+                lexer->append(std::string(lexeme, len), type, row, col, file);
         }
     }
 
-    lexer->append(token_alloc(*lexer.get(), nullptr, 0, TokenType::Eof, row, col, fp));
+    lexer->append(token_alloc(*lexer.get(), nullptr, 0, TokenType::Eof, row, col, file));
     return lexer;
 }
@@ -37,6 +37,10 @@
 #include "config.h"
 #include "hot-reload.hpp"
 #include "earl-to-py.hpp"
+#include "earl-to-cpp.hpp"
+#include "jit.hpp"
+#include "module-cache.hpp"
+#include "prefetch.hpp"
 
 std::vector<std::string> earl_argv = {};
 static std::vector<std::string> watch_files = {};
@@ -46,6 +50,11 @@ static size_t run_count = 1;
 static std::string to_py_formatter = "";
 static std::string to_py_output = "";
 
+// --to-cpp resources
+static std::string to_cpp_output = "";
+static std::string to_cpp_binary = "";
+static std::string to_cpp_cxx = "c++";
+
 uint32_t flags = 0x00;
 
 static void
@@ -66,13 +75,26 @@ usage(void) {
     std::cerr << "  -v, --version                          Print version information" << std::endl;
     std::cerr << "  -c, --check                            Only parse the file given" << std::endl;
     std::cerr << "  -w, --watch [files...]                 Watch files for changes and hot reload on save" << std::endl;
+    std::cerr << "  -O<level>                              Set the optimization level (0 or 1, default 0)" << std::endl;
     std::cerr << "      --without-stdlib                   Do not use standard library" << std::endl;
     std::cerr << "      --repl-nocolor                     Do not use color in the REPL" << std::endl;
     std::cerr << "      --show-funs                        Print every function call evaluated" << std::endl;
+    std::cerr << "      --vm                               Run using the bytecode VM instead of the tree walker" << std::endl;
+    std::cerr << "      --show-passes                      Print what each optimization pass did" << std::endl;
+    std::cerr << "      --jit                              Compile hot numeric loops to native code (x86-64 Linux)" << std::endl;
+    std::cerr << "      --jit-stats                        Same as --jit and print what the JIT did" << std::endl;
+    std::cerr << "      --no-cache                         Do not load or save parsed modules in the .earlc cache" << std::endl;
     std::cerr << "      --to-py output=O [formatter=F]     Convert an EARL file to Python (experimental)" << std::endl;
     std::cerr << "          where" << std::endl;
     std::cerr << "              O = stdout|<file>" << std::endl;
     std::cerr << "              F = <program>" << std::endl;
+    std::cerr << "      --to-cpp output=O [binary=B] [cxx=C]" << std::endl;
+    std::cerr << "                                         Compile an EARL file to C++ and optionally to an executable (experimental)" << std::endl;
+    std::cerr << "          where" << std::endl;
+    std::cerr << "              O = stdout|<file> (default B.cpp)" << std::endl;
+    std::cerr << "              B = <file>" << std::endl;
+    std::cerr << "              C = <C++ compiler> (default c++)" << std::endl;
+    std::cerr << "          B uses the build tree's runtime when earl runs from it, else the installed one" << std::endl;
 
     std::exit(0);
 }
@@ -139,6 +161,68 @@ handle_to_py_flag(std::vector<std::string> &args) {
     }
 }
 
+// Quote `s` as one word for the shell that `system()` uses.
+static std::string
+shell_quote(const std::string &s) {
+    std::string res = "'";
+    for (char c : s) {
+        if (c == '\'')
+            res += "'\\''";
+        else
+            res += c;
+    }
+    return res+"'";
+}
+
+// The runtime headers and library that --to-cpp binaries are built
+// against. An earl running from its build tree, or one that was never
+// installed, uses the build tree's runtime, otherwise the installed one.
+static void
+to_cpp_runtime(std::string &include, std::string &lib) {
+    include = PREFIX "/include/EARL/runtime";
+    lib = PREFIX "/lib/libearlrt.a";
+#if defined(BUILD_RUNTIME_INCLUDE) && defined(BUILD_RUNTIME_LIB)
+    std::error_code ec;
+    std::filesystem::path exe = std::filesystem::read_symlink("/proc/self/exe", ec);
+    bool from_build = !ec && std::filesystem::equivalent(exe.parent_path(),
+                                                         std::filesystem::path(BUILD_RUNTIME_LIB).parent_path(), ec);
+    if ((from_build || !std::filesystem::exists(lib)) && std::filesystem::exists(BUILD_RUNTIME_LIB)) {
+        include = BUILD_RUNTIME_INCLUDE;
+        lib = BUILD_RUNTIME_LIB;
+    }
+#endif
+}
+
+static void
+handle_to_cpp_flag(std::vector<std::string> &args) {
+    std::cout << "[EARL] warning: flag `--" << COMMON_EARL2ARG_TOCPP << "` is experimental and may not work correctly" << std::endl;
+    flags |= __TOCPP;
+    while (args.size() != 0 && args[0][0] != '-') {
+        const std::string &option = args.at(0);
+        std::string left = "", right = "";
+        size_t pos = option.find('=');
+        if (pos != std::string::npos) {
+            left = option.substr(0, pos);
+            right = option.substr(pos+1);
+            if (left == "output")
+                to_cpp_output = right;
+            else if (left == "binary")
+                to_cpp_binary = right;
+            else if (left == "cxx")
+                to_cpp_cxx = right;
+            else {
+                std::cerr << "invalid option `" << left <<  "` for `--" << COMMON_EARL2ARG_TOCPP << "`";
+                std::exit(EXIT_FAILURE);
+            }
+            args.erase(args.begin());
+        }
+        else {
+            std::cerr << "missing `=` in `--" << COMMON_EARL2ARG_TOCPP << "` option" << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+    }
+}
+
 static void
 parse_2hypharg(std::string arg, std::vector<std::string> &args) {
     if (arg == COMMON_EARL2ARG_WITHOUT_STDLIB)
@@ -157,9 +241,22 @@ parse_2hypharg(std::string arg, std::vector<std::string> &args) {
         flags |= __SHOWFUNS;
     else if (arg == COMMON_EARL2ARG_CHECK)
         flags |= __CHECK;
+    else if (arg == COMMON_EARL2ARG_VM)
+        flags |= __VM;
+    else if (arg == COMMON_EARL2ARG_SHOWPASSES)
+        flags |= __SHOWPASSES;
+    else if (arg == COMMON_EARL2ARG_JIT)
+        flags |= __JIT;
+    else if (arg == COMMON_EARL2ARG_JITSTATS)
+        flags |= __JIT | __JITSTATS;
+    else if (arg == COMMON_EARL2ARG_NOCACHE)
+        flags |= __NOCACHE;
     else if (arg == COMMON_EARL2ARG_TOPY) {
         handle_to_py_flag(args);
     }
+    else if (arg == COMMON_EARL2ARG_TOCPP) {
+        handle_to_cpp_flag(args);
+    }
     else {
         std::cerr << "Unrecognised argument: " << arg << std::endl;
         std::cerr << "Did you mean: " << try_guess_wrong_arg(arg) << "?" << std::endl;
@@ -184,6 +281,17 @@ parse_1hypharg(std::string arg, std::vector<std::string> &args) {
             gather_watch_files(args);
             flags |= __WATCH;
         } break;
+        case COMMON_EARL1ARG_OPTIMIZE: {
+            // The rest of the argument is the level.
+            std::string level = arg.substr(i+1);
+            if (level == "0")
+                flags &= ~(__O1);
+            else if (level == "1" || level == "")
+                flags |= __O1;
+            else
+                ERR_WARGS(Err::Type::Fatal, "unsupported optimization level `%s`", level.c_str());
+            i = arg.size();
+        } break;
         default: {
             ERR_WARGS(Err::Type::Fatal, "unrecognised argument `%c`", arg[i]);
         } break;
@@ -249,7 +357,6 @@ main(int argc, char **argv) {
     ++argv; --argc;
     std::string filepath = handlecli(argc, argv);
 
-    std::vector<std::string> keywords = COMMON_EARLKW_ASCPL;
     std::vector<std::string> types = {};
     std::string comment = "#";
 
@@ -266,7 +373,7 @@ main(int argc, char **argv) {
         std::unique_ptr<Program> program = nullptr;
         try {
             std::string src_code = read_file(filepath.c_str());
-            lexer = lex_file(src_code, filepath, keywords, types, comment);
+            lexer = lex_file(src_code, filepath, types, comment);
         } catch (const LexerException &e) {
             std::cerr << "Lexer error: " << e.what() << std::endl;
         }
@@ -306,6 +413,72 @@ main(int argc, char **argv) {
         std::exit(0);
     }
 
+    if ((flags & __TOCPP) != 0) {
+        std::unique_ptr<Lexer> lexer = nullptr;
+        std::unique_ptr<Program> program = nullptr;
+        try {
+            std::string src_code = read_file(filepath.c_str());
+            lexer = lex_file(src_code, filepath, types, comment);
+        } catch (const LexerException &e) {
+            std::cerr << "Lexer error: " << e.what() << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+        try {
+            program = Parser::parse_program(*lexer.get(), filepath);
+        } catch (const ParserException &e) {
+            std::cerr << "Parser error: " << e.what() << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+
+        std::string cppsrc = "";
+        try {
+            cppsrc = earl_to_cpp(std::move(program));
+        } catch (const InterpreterException &e) {
+            std::cerr << "[EARL] error: " << e.what() << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+
+        if (to_cpp_output == "" && to_cpp_binary != "")
+            to_cpp_output = to_cpp_binary+".cpp";
+
+        if (to_cpp_output == "") {
+            std::cerr << "[EARL] error: missing output filepath for flag `--" << COMMON_EARL2ARG_TOCPP << "`" << std::endl;
+            std::exit(EXIT_FAILURE);
+        }
+
+        if (to_cpp_output == "stdout")
+            std::cout << cppsrc << std::endl;
+        else {
+            std::ofstream cppsrc_outfile(to_cpp_output);
+            if (!cppsrc_outfile) {
+                std::cerr << "[EARL] error: opening file: " << to_cpp_output << std::endl;
+                std::exit(EXIT_FAILURE);
+            }
+            cppsrc_outfile << cppsrc;
+            cppsrc_outfile.close();
+        }
+
+        if (to_cpp_binary != "") {
+            if (to_cpp_output == "stdout") {
+                std::cerr << "[EARL] error: cannot build a binary from `output=stdout`" << std::endl;
+                std::exit(EXIT_FAILURE);
+            }
+            // -fwrapv gives signed int overflow in the generated code a defined,
+            // wrapping result instead of leaving it undefined under -O2.
+            std::string include = "", lib = "";
+            to_cpp_runtime(include, lib);
+            std::string cmd = to_cpp_cxx+" -std=c++17 -O2 -fwrapv -pthread -I"+shell_quote(include)+" "
+                +shell_quote(to_cpp_output)+" "+shell_quote(lib)+" -o "+shell_quote(to_cpp_binary);
+            int exit_code = system(cmd.c_str());
+            if (exit_code != 0) {
+                std::cerr << "[EARL] error: compiling failed with code " << exit_code << std::endl;
+                std::exit(1);
+            }
+        }
+
+        std::exit(0);
+    }
+
     if ((flags & __WATCH) != 0)
         std::cout << "[EARL] Now watching files and will hot reload on file save" << std::endl;
 
@@ -324,25 +497,24 @@ main(int argc, char **argv) {
             if ((flags & __WATCH) != 0)
                 std::cout << "=== Run: " << run_count++ << " ======================" << std::endl;
 
+            Interpreter::forget_imports();
+
             std::unique_ptr<Lexer> lexer = nullptr;
             std::unique_ptr<Program> program = nullptr;
             try {
-                std::string src_code = read_file(filepath.c_str());
-                lexer = lex_file(src_code, filepath, keywords, types, comment);
+                program = ModuleCache::parse_file(filepath, lexer);
             } catch (const LexerException &e) {
                 std::cerr << "Lexer error: " << e.what() << std::endl;
                 if ((flags & __WATCH) == 0)
                     return 1;
                 continue;
-            }
-            try {
-                program = Parser::parse_program(*lexer.get(), filepath);
             } catch (const ParserException &e) {
                 std::cerr << "Parser error: " << e.what() << std::endl;
                 if ((flags & __WATCH) == 0)
                     return 1;
                 continue;
             }
+            Prefetch::imports(program.get());
             try {
                 (void)Interpreter::interpret(std::move(program), std::move(lexer));
             } catch (const InterpreterException &e) {
@@ -350,6 +522,8 @@ main(int argc, char **argv) {
                 if ((flags & __WATCH) == 0)
                     return 1;
             }
+            if ((flags & __JITSTATS) != 0)
+                JIT::report();
         } while ((flags & __WATCH) != 0);
     }
     else {
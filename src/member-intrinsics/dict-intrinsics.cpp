@@ -77,7 +77,7 @@ Intrinsics::intrinsic_member_insert(std::shared_ptr<earl::value::Obj> obj,
         throw InterpreterException(msg);
     }
     }
-    return std::make_shared<earl::value::Void>();
+    return earl::value::Void::instance();
 }
 
 std::shared_ptr<earl::value::Obj>
@@ -0,0 +1,145 @@
+/** @file */
+
+// MIT License
+
+// Copyright (c) 2023 malloc-nbytes
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "memo.hpp"
+#include "earl.hpp"
+
+using namespace earl::value;
+
+Memo::Cache::Cache(size_t cap)
+    : m_hits(0), m_misses(0), m_cap(cap) {}
+
+std::shared_ptr<Obj>
+Memo::Cache::get(const std::string &key) {
+    auto it = m_index.find(key);
+    if (it == m_index.end())
+        return nullptr;
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return it->second->second;
+}
+
+void
+Memo::Cache::put(const std::string &key, std::shared_ptr<Obj> value) {
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        it->second->second = std::move(value);
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        return;
+    }
+
+    if (m_cap == 0)
+        return;
+
+    if (m_lru.size() >= m_cap) {
+        m_index.erase(m_lru.back().first);
+        m_lru.pop_back();
+    }
+
+    m_lru.emplace_front(key, std::move(value));
+    m_index.emplace(key, m_lru.begin());
+}
+
+size_t
+Memo::Cache::size(void) const {
+    return m_lru.size();
+}
+
+static bool
+append_key(Obj *value, std::string &key) {
+    switch (value->type()) {
+    case Type::Int: {
+        key += 'i';
+        key += std::to_string(dynamic_cast<Int *>(value)->value());
+    } break;
+    case Type::Float: {
+        // Use the bits so every distinct double gets its own key.
+        double d = dynamic_cast<Float *>(value)->value();
+        uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        key += 'f';
+        key += std::to_string(bits);
+    } break;
+    case Type::Bool: {
+        key += dynamic_cast<Bool *>(value)->value() ? "b1" : "b0";
+    } break;
+    case Type::Char: {
+        key += 'c';
+        key += dynamic_cast<Char *>(value)->value();
+    } break;
+    case Type::Str: {
+        std::string s = dynamic_cast<Str *>(value)->value();
+        key += 's';
+        key += std::to_string(s.size());
+        key += ':';
+        key += s;
+    } break;
+    case Type::Void: {
+        key += 'u';
+    } break;
+    case Type::Option: {
+        auto *opt = dynamic_cast<Option *>(value);
+        if (!opt->is_some()) {
+            key += 'n';
+            break;
+        }
+        key += 'o';
+        if (!append_key(opt->value().get(), key))
+            return false;
+    } break;
+    case Type::List:
+    case Type::Tuple: {
+        const std::vector<std::shared_ptr<Obj>> &elems = value->type() == Type::List
+            ? dynamic_cast<List *>(value)->elems()
+            : dynamic_cast<Tuple *>(value)->elems();
+        key += value->type() == Type::List ? 'l' : 't';
+        key += std::to_string(elems.size());
+        key += '[';
+        for (auto &elem : elems)
+            if (!append_key(elem.get(), key))
+                return false;
+        key += ']';
+    } break;
+    default:
+        return false;
+    }
+    key += ';';
+    return true;
+}
+
+bool
+Memo::make_key(const std::vector<std::shared_ptr<Obj>> &args, std::string &key) {
+    key.clear();
+    for (auto &arg : args)
+        if (!append_key(arg.get(), key))
+            return false;
+    return true;
+}
@@ -0,0 +1,1003 @@
+/** @file */
+
+// MIT License
+
+// Copyright (c) 2023 malloc-nbytes
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MODULE_CACHE_MMAP
+#endif
+
+#include "module-cache.hpp"
+#include "parser.hpp"
+#include "common.hpp"
+#include "config.h"
+#include "err.hpp"
+
+#define MAGIC "EARLC"
+
+// A cache file is
+//   header: MAGIC, MODULE_CACHE_FORMAT, VERSION, source size, source hash
+//   tokens: every token the AST refers to, and the tokens after them
+//           (Token::m_next) so errors can still show the rest of the line
+//   program: the statements, with tokens as indices into the table above
+
+namespace {
+
+struct Corrupt {};
+
+uint64_t
+hash(const std::string &src) {
+    // FNV-1a
+    uint64_t h = 0xcbf29ce484222325ull;
+    auto mix = [&](const char *s, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            h ^= static_cast<unsigned char>(s[i]);
+            h *= 0x100000001b3ull;
+        }
+    };
+    mix(VERSION, sizeof(VERSION));
+    mix(src.data(), src.size());
+    return h;
+}
+
+std::filesystem::path
+cache_dir(void) {
+    if (const char *dir = std::getenv("EARL_CACHE_DIR"))
+        return std::filesystem::path(dir);
+    if (const char *dir = std::getenv("XDG_CACHE_HOME"))
+        return std::filesystem::path(dir) / "earl";
+    if (const char *dir = std::getenv("HOME"))
+        return std::filesystem::path(dir) / ".cache" / "earl";
+    return std::filesystem::path();
+}
+
+std::filesystem::path
+cache_path(uint64_t h) {
+    std::filesystem::path dir = cache_dir();
+    if (dir.empty())
+        return dir;
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.earlc", static_cast<unsigned long long>(h));
+    return dir / name;
+}
+
+struct Writer {
+    std::string m_buf;
+    std::unordered_map<Token *, int32_t> m_ids;
+    std::vector<Token *> m_toks;
+
+    template <typename T> void num(T v) {
+        m_buf.append(reinterpret_cast<const char *>(&v), sizeof(T));
+    }
+
+    void u8(uint8_t v) { num(v); }
+    void u32(uint32_t v) { num(v); }
+
+    void str(const std::string &s) {
+        u32(static_cast<uint32_t>(s.size()));
+        m_buf += s;
+    }
+
+    int32_t tok_id(Token *tok) {
+        if (!tok)
+            return -1;
+        auto it = m_ids.find(tok);
+        if (it != m_ids.end())
+            return it->second;
+        int32_t id = static_cast<int32_t>(m_toks.size());
+        m_ids[tok] = id;
+        m_toks.push_back(tok);
+        return id;
+    }
+
+    void tok(const std::shared_ptr<Token> &tok) { num(tok_id(tok.get())); }
+
+    void opt_tok(const std::optional<std::shared_ptr<Token>> &tok) {
+        this->tok(tok.has_value() ? tok.value() : nullptr);
+    }
+};
+
+struct Reader {
+    const char *m_p;
+    const char *m_end;
+    std::vector<std::shared_ptr<Token>> m_toks;
+    ConstPool *m_consts;
+
+    template <typename T> T num(void) {
+        if (static_cast<size_t>(m_end-m_p) < sizeof(T))
+            throw Corrupt();
+        T v;
+        std::memcpy(&v, m_p, sizeof(T));
+        m_p += sizeof(T);
+        return v;
+    }
+
+    uint8_t u8(void) { return num<uint8_t>(); }
+    uint32_t u32(void) { return num<uint32_t>(); }
+
+    std::string str(void) {
+        uint32_t n = u32();
+        if (static_cast<size_t>(m_end-m_p) < n)
+            throw Corrupt();
+        std::string s(m_p, n);
+        m_p += n;
+        return s;
+    }
+
+    std::shared_ptr<Token> tok(void) {
+        int32_t id = num<int32_t>();
+        if (id == -1)
+            return nullptr;
+        if (id < 0 || static_cast<size_t>(id) >= m_toks.size())
+            throw Corrupt();
+        return m_toks[id];
+    }
+
+    std::optional<std::shared_ptr<Token>> opt_tok(void) {
+        auto t = tok();
+        if (!t)
+            return {};
+        return t;
+    }
+};
+
+/*** Writing ***/
+
+void write_expr(Writer &w, Expr *expr);
+void write_stmt(Writer &w, Stmt *stmt);
+void write_block(Writer &w, StmtBlock *block);
+
+void
+write_exprs(Writer &w, const std::vector<std::unique_ptr<Expr>> &exprs) {
+    w.u32(static_cast<uint32_t>(exprs.size()));
+    for (auto &e : exprs)
+        write_expr(w, e.get());
+}
+
+void
+write_opt_expr(Writer &w, const std::optional<std::unique_ptr<Expr>> &expr) {
+    write_expr(w, expr.has_value() ? expr.value().get() : nullptr);
+}
+
+void
+write_type(Writer &w, const std::optional<std::shared_ptr<__Type>> &ty) {
+    w.u8(ty.has_value() ? 1 : 0);
+    if (ty.has_value()) {
+        w.tok(ty.value()->m_main_ty);
+        w.opt_tok(ty.value()->m_sub_ty);
+    }
+}
+
+void
+write_right(Writer &w, const std::variant<std::unique_ptr<ExprIdent>, std::unique_ptr<ExprFuncCall>> &right) {
+    if (std::holds_alternative<std::unique_ptr<ExprIdent>>(right)) {
+        w.u8(0);
+        w.tok(std::get<std::unique_ptr<ExprIdent>>(right)->m_tok);
+    }
+    else {
+        w.u8(1);
+        write_expr(w, std::get<std::unique_ptr<ExprFuncCall>>(right).get());
+    }
+}
+
+void
+write_term(Writer &w, ExprTerm *expr) {
+    w.u8(static_cast<uint8_t>(expr->get_term_type()));
+    switch (expr->get_term_type()) {
+    case ExprTermType::Ident: w.tok(dynamic_cast<ExprIdent *>(expr)->m_tok); break;
+    case ExprTermType::Int_Literal: w.tok(dynamic_cast<ExprIntLit *>(expr)->m_tok); break;
+    case ExprTermType::Float_Literal: w.tok(dynamic_cast<ExprFloatLit *>(expr)->m_tok); break;
+    case ExprTermType::Str_Literal: w.tok(dynamic_cast<ExprStrLit *>(expr)->m_tok); break;
+    case ExprTermType::Char_Literal: w.tok(dynamic_cast<ExprCharLit *>(expr)->m_tok); break;
+    case ExprTermType::None: w.tok(dynamic_cast<ExprNone *>(expr)->m_tok); break;
+    case ExprTermType::Bool: {
+        auto e = dynamic_cast<ExprBool *>(expr);
+        w.tok(e->m_tok);
+        w.u8(e->m_value ? 1 : 0);
+    } break;
+    case ExprTermType::Tuple: {
+        auto e = dynamic_cast<ExprTuple *>(expr);
+        write_exprs(w, e->m_exprs);
+        w.tok(e->m_tok);
+    } break;
+    case ExprTermType::Dict: {
+        auto e = dynamic_cast<ExprDict *>(expr);
+        w.u32(static_cast<uint32_t>(e->m_values.size()));
+        for (auto &kv : e->m_values) {
+            write_expr(w, kv.first.get());
+            write_expr(w, kv.second.get());
+        }
+        w.tok(e->m_tok);
+    } break;
+    case ExprTermType::Array_Access: {
+        auto e = dynamic_cast<ExprArrayAccess *>(expr);
+        write_expr(w, e->m_left.get());
+        write_expr(w, e->m_expr.get());
+        w.tok(e->m_tok);
+    } break;
+    case ExprTermType::Get: {
+        auto e = dynamic_cast<ExprGet *>(expr);
+        write_expr(w, e->m_left.get());
+        write_right(w, e->m_right);
+        w.tok(e->m_tok);
+    } break;
+    case ExprTermType::Mod_Access: {
+        auto e = dynamic_cast<ExprModAccess *>(expr);
+        w.tok(e->m_expr_ident->m_tok);
+        write_right(w, e->m_right);
+        w.tok(e->m_tok);
+    } break;
+    case ExprTermType::FStr: {
+        auto e = dynamic_cast<ExprFStr *>(expr);
+        w.tok(e->m_tok);
+        w.u32(static_cast<uint32_t>(e->m_parts.size()));
+        for (auto &part : e->m_parts) {
+            if (std::holds_alternative<std::string>(part)) {
+                w.u8(0);
+                w.str(std::get<std::string>(part));
+            }
+            else {
+                w.u8(1);
+                write_expr(w, std::get<std::unique_ptr<Expr>>(part).get());
+            }
+        }
+    } break;
+    case ExprTermType::Closure: {
+        auto e = dynamic_cast<ExprClosure *>(expr);
+        w.u32(static_cast<uint32_t>(e->m_args.size()));
+        for (auto &arg : e->m_args) {
+            w.tok(arg.first);
+            w.u32(arg.second);
+        }
+        write_block(w, e->m_block.get());
+        w.tok(e->m_tok);
+    } break;
+    case ExprTermType::Func_Call: {
+        auto e = dynamic_cast<ExprFuncCall *>(expr);
+        write_expr(w, e->m_left.get());
+        write_exprs(w, e->m_params);
+        w.tok(e->m_tok);
+    } break;
+    case ExprTermType::List_Literal: {
+        auto e = dynamic_cast<ExprListLit *>(expr);
+        write_exprs(w, e->m_elems);
+        w.tok(e->m_tok);
+    } break;
+    case ExprTermType::Range: {
+        auto e = dynamic_cast<ExprRange *>(expr);
+        write_expr(w, e->m_start.get());
+        write_expr(w, e->m_end.get());
+        w.u8(e->m_inclusive ? 1 : 0);
+        w.tok(e->m_tok);
+    } break;
+    case ExprTermType::Slice: {
+        auto e = dynamic_cast<ExprSlice *>(expr);
+        write_opt_expr(w, e->m_start);
+        write_opt_expr(w, e->m_end);
+        w.tok(e->m_tok);
+    } break;
+    default: throw Corrupt();
+    }
+}
+
+void
+write_expr(Writer &w, Expr *expr) {
+    if (!expr) {
+        w.u8(0xff);
+        return;
+    }
+    w.u8(static_cast<uint8_t>(expr->get_type()));
+    switch (expr->get_type()) {
+    case ExprType::Term: write_term(w, dynamic_cast<ExprTerm *>(expr)); break;
+    case ExprType::Unary: {
+        auto e = dynamic_cast<ExprUnary *>(expr);
+        w.tok(e->m_op);
+        write_expr(w, e->m_expr.get());
+    } break;
+    case ExprType::Binary: {
+        auto e = dynamic_cast<ExprBinary *>(expr);
+        write_expr(w, e->m_lhs.get());
+        w.tok(e->m_op);
+        write_expr(w, e->m_rhs.get());
+    } break;
+    default: throw Corrupt();
+    }
+}
+
+void
+write_block(Writer &w, StmtBlock *block) {
+    w.u32(static_cast<uint32_t>(block->m_stmts.size()));
+    for (auto &s : block->m_stmts)
+        write_stmt(w, s.get());
+}
+
+void
+write_opt_block(Writer &w, const std::optional<std::unique_ptr<StmtBlock>> &block) {
+    w.u8(block.has_value() ? 1 : 0);
+    if (block.has_value())
+        write_block(w, block.value().get());
+}
+
+void
+write_def(Writer &w, StmtDef *stmt) {
+    w.tok(stmt->m_id);
+    w.u32(static_cast<uint32_t>(stmt->m_args.size()));
+    for (auto &arg : stmt->m_args) {
+        w.tok(arg.first.first);
+        write_type(w, arg.first.second);
+        w.u32(arg.second);
+    }
+    write_type(w, stmt->m_ty);
+    write_block(w, stmt->m_block.get());
+    w.u32(stmt->m_attrs);
+}
+
+void
+write_let(Writer &w, StmtLet *stmt) {
+    w.u32(static_cast<uint32_t>(stmt->m_ids.size()));
+    for (auto &id : stmt->m_ids)
+        w.tok(id);
+    w.u32(static_cast<uint32_t>(stmt->m_tys.size()));
+    for (auto &ty : stmt->m_tys)
+        write_type(w, ty);
+    write_expr(w, stmt->m_expr.get());
+    w.u32(stmt->m_attrs);
+}
+
+void
+write_stmt(Writer &w, Stmt *stmt) {
+    w.u8(static_cast<uint8_t>(stmt->stmt_type()));
+    switch (stmt->stmt_type()) {
+    case StmtType::Def: write_def(w, dynamic_cast<StmtDef *>(stmt)); break;
+    case StmtType::Let: write_let(w, dynamic_cast<StmtLet *>(stmt)); break;
+    case StmtType::Block: write_block(w, dynamic_cast<StmtBlock *>(stmt)); break;
+    case StmtType::Mut: {
+        auto s = dynamic_cast<StmtMut *>(stmt);
+        write_expr(w, s->m_left.get());
+        write_expr(w, s->m_right.get());
+        w.tok(s->m_equals);
+    } break;
+    case StmtType::Stmt_Expr: write_expr(w, dynamic_cast<StmtExpr *>(stmt)->m_expr.get()); break;
+    case StmtType::If: {
+        auto s = dynamic_cast<StmtIf *>(stmt);
+        write_expr(w, s->m_expr.get());
+        write_block(w, s->m_block.get());
+        write_opt_block(w, s->m_else);
+    } break;
+    case StmtType::Return: {
+        auto s = dynamic_cast<StmtReturn *>(stmt);
+        write_opt_expr(w, s->m_expr);
+        w.tok(s->m_tok);
+    } break;
+    case StmtType::Break: w.tok(dynamic_cast<StmtBreak *>(stmt)->m_tok); break;
+    case StmtType::Continue: w.tok(dynamic_cast<StmtContinue *>(stmt)->m_tok); break;
+    case StmtType::While: {
+        auto s = dynamic_cast<StmtWhile *>(stmt);
+        write_expr(w, s->m_expr.get());
+        write_block(w, s->m_block.get());
+    } break;
+    case StmtType::Loop: {
+        auto s = dynamic_cast<StmtLoop *>(stmt);
+        w.tok(s->m_tok);
+        write_block(w, s->m_block.get());
+    } break;
+    case StmtType::For: {
+        auto s = dynamic_cast<StmtFor *>(stmt);
+        w.tok(s->m_enumerator);
+        write_expr(w, s->m_start.get());
+        write_expr(w, s->m_end.get());
+        write_block(w, s->m_block.get());
+    } break;
+    case StmtType::Foreach: {
+        auto s = dynamic_cast<StmtForeach *>(stmt);
+        w.u32(static_cast<uint32_t>(s->m_enumerators.size()));
+        for (auto &e : s->m_enumerators)
+            w.tok(e);
+        write_expr(w, s->m_expr.get());
+        write_block(w, s->m_block.get());
+        w.u32(s->m_attrs);
+    } break;
+    case StmtType::Import: {
+        auto s = dynamic_cast<StmtImport *>(stmt);
+        write_expr(w, s->m_fp.get());
+        w.opt_tok(s->m_depth);
+        w.opt_tok(s->m_as);
+    } break;
+    case StmtType::Mod: w.tok(dynamic_cast<StmtMod *>(stmt)->m_id); break;
+    case StmtType::Class: {
+        auto s = dynamic_cast<StmtClass *>(stmt);
+        w.tok(s->m_id);
+        w.u32(s->m_attrs);
+        w.u32(static_cast<uint32_t>(s->m_constructor_args.size()));
+        for (auto &arg : s->m_constructor_args) {
+            w.tok(arg.first);
+            write_type(w, arg.second);
+        }
+        w.u32(static_cast<uint32_t>(s->m_members.size()));
+        for (auto &m : s->m_members)
+            write_let(w, m.get());
+        w.u32(static_cast<uint32_t>(s->m_methods.size()));
+        for (auto &m : s->m_methods)
+            write_def(w, m.get());
+    } break;
+    case StmtType::Match: {
+        auto s = dynamic_cast<StmtMatch *>(stmt);
+        write_expr(w, s->m_expr.get());
+        w.u32(static_cast<uint32_t>(s->m_branches.size()));
+        for (auto &b : s->m_branches) {
+            write_exprs(w, b->m_expr);
+            write_opt_expr(w, b->m_when);
+            write_block(w, b->m_block.get());
+        }
+    } break;
+    case StmtType::Enum: {
+        auto s = dynamic_cast<StmtEnum *>(stmt);
+        w.tok(s->m_id);
+        w.u32(static_cast<uint32_t>(s->m_elems.size()));
+        for (auto &e : s->m_elems) {
+            w.tok(e.first);
+            write_expr(w, e.second.get());
+        }
+        w.u32(s->m_attrs);
+    } break;
+    case StmtType::Bash_Literal: write_expr(w, dynamic_cast<StmtBashLiteral *>(stmt)->m_expr.get()); break;
+    default: throw Corrupt();
+    }
+}
+
+/*** Reading ***/
+
+std::unique_ptr<Expr> read_expr(Reader &r);
+std::unique_ptr<Stmt> read_stmt(Reader &r);
+std::unique_ptr<StmtBlock> read_block(Reader &r);
+
+template <typename T> std::unique_ptr<T>
+read_as(std::unique_ptr<Expr> expr) {
+    T *e = dynamic_cast<T *>(expr.get());
+    if (!e)
+        throw Corrupt();
+    (void)expr.release();
+    return std::unique_ptr<T>(e);
+}
+
+std::vector<std::unique_ptr<Expr>>
+read_exprs(Reader &r) {
+    uint32_t n = r.u32();
+    std::vector<std::unique_ptr<Expr>> exprs = {};
+    for (uint32_t i = 0; i < n; ++i)
+        exprs.push_back(read_expr(r));
+    return exprs;
+}
+
+std::optional<std::unique_ptr<Expr>>
+read_opt_expr(Reader &r) {
+    auto e = read_expr(r);
+    if (!e)
+        return {};
+    return e;
+}
+
+std::optional<std::shared_ptr<__Type>>
+read_type(Reader &r) {
+    if (r.u8() == 0)
+        return {};
+    auto main_ty = r.tok();
+    auto sub_ty = r.opt_tok();
+    if (!main_ty)
+        throw Corrupt();
+    return std::make_shared<__Type>(main_ty, sub_ty);
+}
+
+std::variant<std::unique_ptr<ExprIdent>, std::unique_ptr<ExprFuncCall>>
+read_right(Reader &r) {
+    if (r.u8() == 0)
+        return std::make_unique<ExprIdent>(r.tok());
+    return read_as<ExprFuncCall>(read_expr(r));
+}
+
+std::unique_ptr<Expr>
+read_term(Reader &r) {
+    switch (static_cast<ExprTermType>(r.u8())) {
+    case ExprTermType::Ident: return std::make_unique<ExprIdent>(r.tok());
+    case ExprTermType::Int_Literal: {
+        auto tok = r.tok();
+        return std::make_unique<ExprIntLit>(tok, r.m_consts->get_int(tok.get()));
+    }
+    case ExprTermType::Float_Literal: {
+        auto tok = r.tok();
+        return std::make_unique<ExprFloatLit>(tok, r.m_consts->get_float(tok.get()));
+    }
+    case ExprTermType::Str_Literal: {
+        auto tok = r.tok();
+        return std::make_unique<ExprStrLit>(tok, r.m_consts->get_str(tok.get()));
+    }
+    case ExprTermType::Char_Literal: {
+        auto tok = r.tok();
+        return std::make_unique<ExprCharLit>(tok, r.m_consts->get_char(tok.get()));
+    }
+    case ExprTermType::None: return std::make_unique<ExprNone>(r.tok());
+    case ExprTermType::Bool: {
+        auto tok = r.tok();
+        bool value = r.u8() != 0;
+        return std::make_unique<ExprBool>(tok, value, r.m_consts->get_bool(value));
+    }
+    case ExprTermType::Tuple: {
+        auto exprs = read_exprs(r);
+        return std::make_unique<ExprTuple>(std::move(exprs), r.tok());
+    }
+    case ExprTermType::Dict: {
+        uint32_t n = r.u32();
+        std::vector<std::pair<std::unique_ptr<Expr>, std::unique_ptr<Expr>>> values = {};
+        for (uint32_t i = 0; i < n; ++i) {
+            auto key = read_expr(r);
+            auto value = read_expr(r);
+            values.push_back(std::make_pair(std::move(key), std::move(value)));
+        }
+        return std::make_unique<ExprDict>(std::move(values), r.tok());
+    }
+    case ExprTermType::Array_Access: {
+        auto left = read_expr(r);
+        auto expr = read_expr(r);
+        return std::make_unique<ExprArrayAccess>(std::move(left), std::move(expr), r.tok());
+    }
+    case ExprTermType::Get: {
+        auto left = read_expr(r);
+        auto right = read_right(r);
+        return std::make_unique<ExprGet>(std::move(left), std::move(right), r.tok());
+    }
+    case ExprTermType::Mod_Access: {
+        auto ident = std::make_unique<ExprIdent>(r.tok());
+        auto right = read_right(r);
+        return std::make_unique<ExprModAccess>(std::move(ident), std::move(right), r.tok());
+    }
+    case ExprTermType::FStr: {
+        auto tok = r.tok();
+        uint32_t n = r.u32();
+        std::vector<std::variant<std::string, std::unique_ptr<Expr>>> parts = {};
+        for (uint32_t i = 0; i < n; ++i) {
+            if (r.u8() == 0)
+                parts.push_back(r.str());
+            else
+                parts.push_back(read_expr(r));
+        }
+        return std::make_unique<ExprFStr>(tok, std::move(parts));
+    }
+    case ExprTermType::Closure: {
+        uint32_t n = r.u32();
+        std::vector<std::pair<std::shared_ptr<Token>, uint32_t>> args = {};
+        for (uint32_t i = 0; i < n; ++i) {
+            auto tok = r.tok();
+            args.push_back(std::make_pair(tok, r.u32()));
+        }
+        auto block = read_block(r);
+        return std::make_unique<ExprClosure>(std::move(args), std::move(block), r.tok());
+    }
+    case ExprTermType::Func_Call: {
+        auto left = read_expr(r);
+        auto params = read_exprs(r);
+        return std::make_unique<ExprFuncCall>(std::move(left), std::move(params), r.tok());
+    }
+    case ExprTermType::List_Literal: {
+        auto elems = read_exprs(r);
+        return std::make_unique<ExprListLit>(std::move(elems), r.tok());
+    }
+    case ExprTermType::Range: {
+        auto start = read_expr(r);
+        auto end = read_expr(r);
+        bool inclusive = r.u8() != 0;
+        return std::make_unique<ExprRange>(std::move(start), std::move(end), inclusive, r.tok());
+    }
+    case ExprTermType::Slice: {
+        auto start = read_opt_expr(r);
+        auto end = read_opt_expr(r);
+        return std::make_unique<ExprSlice>(std::move(start), std::move(end), r.tok());
+    }
+    default: throw Corrupt();
+    }
+}
+
+std::unique_ptr<Expr>
+read_expr(Reader &r) {
+    uint8_t ty = r.u8();
+    if (ty == 0xff)
+        return nullptr;
+    switch (static_cast<ExprType>(ty)) {
+    case ExprType::Term: return read_term(r);
+    case ExprType::Unary: {
+        auto op = r.tok();
+        return std::make_unique<ExprUnary>(op, read_expr(r));
+    }
+    case ExprType::Binary: {
+        auto lhs = read_expr(r);
+        auto op = r.tok();
+        auto rhs = read_expr(r);
+        return std::make_unique<ExprBinary>(std::move(lhs), op, std::move(rhs));
+    }
+    default: throw Corrupt();
+    }
+}
+
+std::unique_ptr<StmtBlock>
+read_block(Reader &r) {
+    uint32_t n = r.u32();
+    std::vector<std::unique_ptr<Stmt>> stmts = {};
+    for (uint32_t i = 0; i < n; ++i)
+        stmts.push_back(read_stmt(r));
+    return std::make_unique<StmtBlock>(std::move(stmts));
+}
+
+std::optional<std::unique_ptr<StmtBlock>>
+read_opt_block(Reader &r) {
+    if (r.u8() == 0)
+        return {};
+    return read_block(r);
+}
+
+std::unique_ptr<StmtDef>
+read_def(Reader &r) {
+    auto id = r.tok();
+    uint32_t n = r.u32();
+    std::vector<std::pair<std::pair<std::shared_ptr<Token>, std::optional<std::shared_ptr<__Type>>>, uint32_t>> args = {};
+    for (uint32_t i = 0; i < n; ++i) {
+        auto tok = r.tok();
+        auto ty = read_type(r);
+        args.push_back(std::make_pair(std::make_pair(tok, ty), r.u32()));
+    }
+    auto ty = read_type(r);
+    auto block = read_block(r);
+    return std::make_unique<StmtDef>(id, std::move(args), ty, std::move(block), r.u32());
+}
+
+std::unique_ptr<StmtLet>
+read_let(Reader &r) {
+    uint32_t n = r.u32();
+    std::vector<std::shared_ptr<Token>> ids = {};
+    for (uint32_t i = 0; i < n; ++i)
+        ids.push_back(r.tok());
+    n = r.u32();
+    std::vector<std::shared_ptr<__Type>> tys = {};
+    for (uint32_t i = 0; i < n; ++i) {
+        auto ty = read_type(r);
+        tys.push_back(ty.has_value() ? ty.value() : nullptr);
+    }
+    auto expr = read_expr(r);
+    return std::make_unique<StmtLet>(std::move(ids), std::move(tys), std::move(expr), r.u32());
+}
+
+std::unique_ptr<Stmt>
+read_stmt(Reader &r) {
+    switch (static_cast<StmtType>(r.u8())) {
+    case StmtType::Def: return read_def(r);
+    case StmtType::Let: return read_let(r);
+    case StmtType::Block: return read_block(r);
+    case StmtType::Mut: {
+        auto left = read_expr(r);
+        auto right = read_expr(r);
+        return std::make_unique<StmtMut>(std::move(left), std::move(right), r.tok());
+    }
+    case StmtType::Stmt_Expr: return std::make_unique<StmtExpr>(read_expr(r));
+    case StmtType::If: {
+        auto expr = read_expr(r);
+        auto block = read_block(r);
+        return std::make_unique<StmtIf>(std::move(expr), std::move(block), read_opt_block(r));
+    }
+    case StmtType::Return: {
+        auto expr = read_opt_expr(r);
+        return std::make_unique<StmtReturn>(std::move(expr), r.tok());
+    }
+    case StmtType::Break: return std::make_unique<StmtBreak>(r.tok());
+    case StmtType::Continue: return std::make_unique<StmtContinue>(r.tok());
+    case StmtType::While: {
+        auto expr = read_expr(r);
+        return std::make_unique<StmtWhile>(std::move(expr), read_block(r));
+    }
+    case StmtType::Loop: {
+        auto tok = r.tok();
+        return std::make_unique<StmtLoop>(tok, read_block(r));
+    }
+    case StmtType::For: {
+        auto enumerator = r.tok();
+        auto start = read_expr(r);
+        auto end = read_expr(r);
+        return std::make_unique<StmtFor>(enumerator, std::move(start), std::move(end), read_block(r));
+    }
+    case StmtType::Foreach: {
+        uint32_t n = r.u32();
+        std::vector<std::shared_ptr<Token>> enumerators = {};
+        for (uint32_t i = 0; i < n; ++i)
+            enumerators.push_back(r.tok());
+        auto expr = read_expr(r);
+        auto block = read_block(r);
+        return std::make_unique<StmtForeach>(std::move(enumerators), std::move(expr), std::move(block), r.u32());
+    }
+    case StmtType::Import: {
+        std::shared_ptr<Expr> fp = read_expr(r);
+        auto depth = r.opt_tok();
+        return std::make_unique<StmtImport>(fp, depth, r.opt_tok());
+    }
+    case StmtType::Mod: return std::make_unique<StmtMod>(r.tok());
+    case StmtType::Class: {
+        auto id = r.tok();
+        uint32_t attrs = r.u32();
+        uint32_t n = r.u32();
+        std::vector<std::pair<std::shared_ptr<Token>, std::optional<std::shared_ptr<__Type>>>> args = {};
+        for (uint32_t i = 0; i < n; ++i) {
+            auto tok = r.tok();
+            args.push_back(std::make_pair(tok, read_type(r)));
+        }
+        n = r.u32();
+        std::vector<std::unique_ptr<StmtLet>> members = {};
+        for (uint32_t i = 0; i < n; ++i)
+            members.push_back(read_let(r));
+        n = r.u32();
+        std::vector<std::unique_ptr<StmtDef>> methods = {};
+        for (uint32_t i = 0; i < n; ++i)
+            methods.push_back(read_def(r));
+        return std::make_unique<StmtClass>(id, attrs, std::move(args), std::move(members), std::move(methods));
+    }
+    case StmtType::Match: {
+        auto expr = read_expr(r);
+        uint32_t n = r.u32();
+        std::vector<std::unique_ptr<StmtMatch::Branch>> branches = {};
+        for (uint32_t i = 0; i < n; ++i) {
+            auto exprs = read_exprs(r);
+            auto when = read_opt_expr(r);
+            auto block = read_block(r);
+            branches.push_back(std::make_unique<StmtMatch::Branch>(std::move(exprs), std::move(when), std::move(block)));
+        }
+        return std::make_unique<StmtMatch>(std::move(expr), std::move(branches));
+    }
+    case StmtType::Enum: {
+        auto id = r.tok();
+        uint32_t n = r.u32();
+        std::vector<std::pair<std::shared_ptr<Token>, std::unique_ptr<Expr>>> elems = {};
+        for (uint32_t i = 0; i < n; ++i) {
+            auto tok = r.tok();
+            elems.push_back(std::make_pair(tok, read_expr(r)));
+        }
+        return std::make_unique<StmtEnum>(id, std::move(elems), r.u32());
+    }
+    case StmtType::Bash_Literal: return std::make_unique<StmtBashLiteral>(read_expr(r));
+    default: throw Corrupt();
+    }
+}
+
+std::unique_ptr<Program>
+read_program(const char *data, size_t len, const std::string &filepath, const std::string &src, Lexer &lexer) {
+    Reader r = {data, data+len, {}, nullptr};
+
+    if (r.str() != MAGIC || r.u32() != MODULE_CACHE_FORMAT || r.str() != VERSION
+        || r.num<uint64_t>() != src.size() || r.num<uint64_t>() != hash(src))
+        throw Corrupt();
+
+    // Token paths, the first one is the module itself which
+    // may have been cached under a different path.
+    uint32_t nfps = r.u32();
+    std::vector<uint32_t> fps = {token_intern_fp(filepath)};
+    for (uint32_t i = 1; i < nfps; ++i)
+        fps.push_back(token_intern_fp(r.str()));
+
+    uint32_t ntoks = r.u32();
+    std::vector<int32_t> nexts = {};
+    r.m_toks.reserve(ntoks);
+    for (uint32_t i = 0; i < ntoks; ++i) {
+        std::string lexeme = r.str();
+        auto type = static_cast<TokenType>(r.u8());
+        uint32_t row = r.u32(), col = r.u32(), fp = r.u32();
+        if (fp >= fps.size() || type >= TokenType::Total_Len)
+            throw Corrupt();
+        r.m_toks.push_back(std::make_shared<Token>(std::move(lexeme), type, row, col, fps[fp]));
+        nexts.push_back(r.num<int32_t>());
+    }
+    for (uint32_t i = 0; i < ntoks; ++i) {
+        if (nexts[i] >= static_cast<int32_t>(ntoks))
+            throw Corrupt();
+        if (nexts[i] >= 0)
+            r.m_toks[i]->m_next = r.m_toks[nexts[i]].get();
+    }
+
+    auto arena = std::make_unique<Arena>();
+    AstArena scope(arena.get());
+
+    auto consts = std::make_unique<ConstPool>();
+    r.m_consts = consts.get();
+    uint32_t n = r.u32();
+    std::vector<std::unique_ptr<Stmt>> stmts = {};
+    for (uint32_t i = 0; i < n; ++i)
+        stmts.push_back(read_stmt(r));
+    if (r.m_p != r.m_end)
+        throw Corrupt();
+
+    lexer.keep(std::move(r.m_toks));
+    return std::make_unique<Program>(std::move(stmts), filepath, std::move(consts), std::move(arena));
+}
+
+} // namespace
+
+std::unique_ptr<Program>
+ModuleCache::load(const std::string &filepath, const std::string &src, Lexer &lexer) {
+    std::filesystem::path path = cache_path(hash(src));
+    if (path.empty())
+        return nullptr;
+
+    try {
+#ifdef MODULE_CACHE_MMAP
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd == -1)
+            return nullptr;
+        struct stat st;
+        if (fstat(fd, &st) == -1 || st.st_size == 0) {
+            close(fd);
+            return nullptr;
+        }
+        size_t len = static_cast<size_t>(st.st_size);
+        void *data = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED)
+            return nullptr;
+        std::unique_ptr<Program> program = nullptr;
+        try {
+            program = read_program(static_cast<const char *>(data), len, filepath, src, lexer);
+        } catch (...) {
+            munmap(data, len);
+            throw;
+        }
+        munmap(data, len);
+        return program;
+#else
+        std::ifstream f(path, std::ios::binary);
+        if (!f)
+            return nullptr;
+        std::string data((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+        return read_program(data.data(), data.size(), filepath, src, lexer);
+#endif
+    } catch (const Corrupt &) {
+        return nullptr;
+    } catch (const ParserException &) {
+        return nullptr;
+    }
+}
+
+void
+ModuleCache::store(const std::string &src, Program *program) {
+    std::filesystem::path path = cache_path(hash(src));
+    if (path.empty())
+        return;
+
+    Writer body = {};
+    try {
+        body.u32(static_cast<uint32_t>(program->m_stmts.size()));
+        for (auto &stmt : program->m_stmts)
+            write_stmt(body, stmt.get());
+    } catch (const Corrupt &) {
+        return;
+    }
+
+    // Keep the rest of the line (and file) after every
+    // token, Err::err_wtok prints it.
+    for (size_t i = 0; i < body.m_toks.size(); ++i)
+        (void)body.tok_id(body.m_toks[i]->m_next);
+
+    Writer w = {};
+    w.str(MAGIC);
+    w.u32(MODULE_CACHE_FORMAT);
+    w.str(VERSION);
+    w.num<uint64_t>(src.size());
+    w.num<uint64_t>(hash(src));
+
+    std::vector<std::string> fps = {program->m_filepath};
+    std::unordered_map<std::string, uint32_t> fp_ids = {{program->m_filepath, 0}};
+    for (Token *tok : body.m_toks) {
+        if (fp_ids.find(tok->fp()) == fp_ids.end()) {
+            fp_ids[tok->fp()] = static_cast<uint32_t>(fps.size());
+            fps.push_back(tok->fp());
+        }
+    }
+    w.u32(static_cast<uint32_t>(fps.size()));
+    for (size_t i = 1; i < fps.size(); ++i)
+        w.str(fps[i]);
+
+    w.u32(static_cast<uint32_t>(body.m_toks.size()));
+    for (Token *tok : body.m_toks) {
+        w.str(tok->m_lexeme);
+        w.u8(static_cast<uint8_t>(tok->m_type));
+        w.u32(static_cast<uint32_t>(tok->m_row));
+        w.u32(static_cast<uint32_t>(tok->m_col));
+        w.u32(fp_ids[tok->fp()]);
+        w.num<int32_t>(tok->m_next ? body.m_ids.at(tok->m_next) : -1);
+    }
+    w.m_buf += body.m_buf;
+
+    // Write to a temporary first so that another process
+    // never sees half of a cache file.
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    if (ec)
+        return;
+    // The pid keeps processes apart, the counter keeps
+    // stores within one process apart.
+    static std::atomic<unsigned long long> tmp_count{0};
+#ifdef MODULE_CACHE_MMAP
+    const unsigned long long pid = static_cast<unsigned long long>(getpid());
+#else
+    const unsigned long long pid = 0;
+#endif
+    std::filesystem::path tmp = path;
+    tmp += "."+std::to_string(pid)+"."+std::to_string(tmp_count.fetch_add(1));
+    {
+        std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+        if (!f)
+            return;
+        f.write(w.m_buf.data(), static_cast<std::streamsize>(w.m_buf.size()));
+        if (!f) {
+            f.close();
+            std::filesystem::remove(tmp, ec);
+            return;
+        }
+    }
+    std::filesystem::rename(tmp, path, ec);
+    if (ec)
+        std::filesystem::remove(tmp, ec);
+}
+
+std::unique_ptr<Program>
+ModuleCache::parse_file(const std::string &filepath,
+                        std::unique_ptr<Lexer> &lexer,
+                        std::string from) {
+    std::vector<std::string> types    = {};
+    std::string comment               = COMMON_EARL_COMMENT;
+
+    char *buf = read_file(filepath.c_str());
+    std::string src_code = buf ? buf : "";
+    std::free(buf);
+
+    // `--check` is about parsing, so always do it.
+    const bool cached = (flags & (__NOCACHE | __CHECK)) == 0;
+
+    if (cached) {
+        lexer = std::make_unique<Lexer>();
+        if (auto program = load(filepath, src_code, *lexer.get()))
+            return program;
+    }
+
+    lexer = lex_file(src_code, filepath, types, comment);
+    auto program = Parser::parse_program(*lexer.get(), filepath, from);
+
+    if (cached)
+        store(src_code, program.get());
+
+    return program;
+}
@@ -0,0 +1,719 @@
+/** @file */
+
+// MIT License
+
+// Copyright (c) 2023 malloc-nbytes
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <cassert>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "optimizer.hpp"
+#include "ast.hpp"
+#include "earl.hpp"
+#include "common.hpp"
+
+// Passes that expose more work to each other (propagation creates
+// literals to fold, folding creates constants to propagate) are
+// repeated at most this many times.
+#define OPTIMIZER_MAX_ROUNDS 8
+
+// The value of `expr` if it is a literal, nullptr otherwise.
+static std::shared_ptr<earl::value::Obj>
+literal_value(Expr *expr) {
+    if (!expr || expr->get_type() != ExprType::Term)
+        return nullptr;
+    auto term = dynamic_cast<ExprTerm *>(expr);
+    switch (term->get_term_type()) {
+    case ExprTermType::Int_Literal:   return dynamic_cast<ExprIntLit *>(term)->m_value;
+    case ExprTermType::Float_Literal: return dynamic_cast<ExprFloatLit *>(term)->m_value;
+    case ExprTermType::Str_Literal:   return dynamic_cast<ExprStrLit *>(term)->m_value;
+    case ExprTermType::Char_Literal:  return dynamic_cast<ExprCharLit *>(term)->m_value;
+    case ExprTermType::Bool:          return dynamic_cast<ExprBool *>(term)->m_constant;
+    default: return nullptr;
+    }
+}
+
+// Whether a literal condition can be decided without throwing.
+// Other literals (chars) are left to fail when they are reached.
+static bool
+has_boolean(earl::value::Obj *value) {
+    switch (value->type()) {
+    case earl::value::Type::Bool:
+    case earl::value::Type::Int:
+    case earl::value::Type::Float:
+    case earl::value::Type::Str:
+        return true;
+    default: return false;
+    }
+}
+
+// Make a literal node for a constant. `tok` is only used
+// for error reporting.
+static std::unique_ptr<Expr>
+make_literal(std::shared_ptr<Token> tok, std::shared_ptr<earl::value::Obj> value) {
+    switch (value->type()) {
+    case earl::value::Type::Int:   return std::make_unique<ExprIntLit>(tok, value);
+    case earl::value::Type::Float: return std::make_unique<ExprFloatLit>(tok, value);
+    case earl::value::Type::Str:   return std::make_unique<ExprStrLit>(tok, value);
+    case earl::value::Type::Char:  return std::make_unique<ExprCharLit>(tok, value);
+    case earl::value::Type::Bool: {
+        bool b = dynamic_cast<earl::value::Bool *>(value.get())->value();
+        return std::make_unique<ExprBool>(tok, b, value);
+    } break;
+    default: assert(false && "unreachable");
+    }
+    return nullptr;
+}
+
+// The leftmost token of a literal, unary or binary expression.
+static std::shared_ptr<Token>
+leftmost_token(Expr *expr) {
+    switch (expr->get_type()) {
+    case ExprType::Binary: return leftmost_token(dynamic_cast<ExprBinary *>(expr)->m_lhs.get());
+    case ExprType::Unary:  return dynamic_cast<ExprUnary *>(expr)->m_op;
+    default: break;
+    }
+    auto term = dynamic_cast<ExprTerm *>(expr);
+    switch (term->get_term_type()) {
+    case ExprTermType::Int_Literal:   return dynamic_cast<ExprIntLit *>(term)->m_tok;
+    case ExprTermType::Float_Literal: return dynamic_cast<ExprFloatLit *>(term)->m_tok;
+    case ExprTermType::Str_Literal:   return dynamic_cast<ExprStrLit *>(term)->m_tok;
+    case ExprTermType::Char_Literal:  return dynamic_cast<ExprCharLit *>(term)->m_tok;
+    case ExprTermType::Bool:          return dynamic_cast<ExprBool *>(term)->m_tok;
+    default: assert(false && "unreachable");
+    }
+    return nullptr;
+}
+
+static bool
+is_numeric(earl::value::Obj *value) {
+    return value->type() == earl::value::Type::Int || value->type() == earl::value::Type::Float;
+}
+
+static double
+numeric(earl::value::Obj *value) {
+    if (value->type() == earl::value::Type::Int)
+        return dynamic_cast<earl::value::Int *>(value)->value();
+    return dynamic_cast<earl::value::Float *>(value)->value();
+}
+
+// Whether `lhs <op> rhs` is certain to succeed. Anything that
+// would report an error at runtime must be left for the runtime.
+static bool
+can_fold_binary(TokenType op, earl::value::Obj *lhs, earl::value::Obj *rhs) {
+    using earl::value::Type;
+    const bool ints = lhs->type() == Type::Int && rhs->type() == Type::Int;
+    const bool nums = is_numeric(lhs) && is_numeric(rhs);
+    const bool same = lhs->type() == rhs->type();
+
+    switch (op) {
+    case TokenType::Plus:
+        return nums || (lhs->type() == Type::Str && rhs->type() == Type::Str);
+    case TokenType::Minus:
+    case TokenType::Asterisk:
+    case TokenType::Greaterthan:
+    case TokenType::Lessthan:
+    case TokenType::Greaterthan_Equals:
+    case TokenType::Lessthan_Equals:
+        return nums;
+    case TokenType::Forwardslash:
+        return nums && numeric(rhs) != 0;
+    case TokenType::Percent:
+        return ints && numeric(rhs) != 0;
+    case TokenType::Double_Asterisk:
+    case TokenType::Backtick_Pipe:
+    case TokenType::Backtick_Caret:
+    case TokenType::Backtick_Ampersand:
+        return ints;
+    case TokenType::Double_Lessthan:
+    case TokenType::Double_Greaterthan:
+        return ints && numeric(rhs) >= 0 && numeric(rhs) < 32;
+    case TokenType::Double_Equals:
+    case TokenType::Bang_Equals:
+        return nums || (same && (lhs->type() == Type::Bool
+                                 || lhs->type() == Type::Str
+                                 || lhs->type() == Type::Char));
+    case TokenType::Double_Ampersand:
+    case TokenType::Double_Pipe:
+        return same && lhs->type() == Type::Bool;
+    default: return false;
+    }
+}
+
+static bool
+can_fold_unary(TokenType op, earl::value::Obj *value) {
+    using earl::value::Type;
+    switch (op) {
+    case TokenType::Minus:          return is_numeric(value);
+    case TokenType::Bang:           return value->type() == Type::Int || value->type() == Type::Bool;
+    case TokenType::Backtick_Tilde: return value->type() == Type::Int;
+    default: return false;
+    }
+}
+
+// Same as the switch in eval_expr_bin.
+static std::shared_ptr<earl::value::Obj>
+fold_binary(Token *op, earl::value::Obj *lhs, earl::value::Obj *rhs) {
+    switch (op->type()) {
+    case TokenType::Plus:            return lhs->add(op, rhs);
+    case TokenType::Minus:           return lhs->sub(op, rhs);
+    case TokenType::Asterisk:        return lhs->multiply(op, rhs);
+    case TokenType::Forwardslash:    return lhs->divide(op, rhs);
+    case TokenType::Percent:         return lhs->modulo(op, rhs);
+    case TokenType::Double_Asterisk: return lhs->power(op, rhs);
+    case TokenType::Greaterthan:
+    case TokenType::Lessthan:
+    case TokenType::Greaterthan_Equals:
+    case TokenType::Lessthan_Equals:
+        return lhs->gtequality(op, rhs);
+    case TokenType::Double_Equals:
+    case TokenType::Bang_Equals:
+        return lhs->equality(op, rhs);
+    case TokenType::Backtick_Pipe:
+    case TokenType::Backtick_Caret:
+    case TokenType::Backtick_Ampersand:
+        return lhs->bitwise(op, rhs);
+    case TokenType::Double_Lessthan:
+    case TokenType::Double_Greaterthan:
+        return lhs->bitshift(op, rhs);
+    case TokenType::Double_Ampersand:
+        return std::make_shared<earl::value::Bool>(lhs->boolean() && rhs->boolean());
+    case TokenType::Double_Pipe:
+        return std::make_shared<earl::value::Bool>(lhs->boolean() || rhs->boolean());
+    default: assert(false && "unreachable");
+    }
+    return nullptr;
+}
+
+/*** Pass ***/
+
+Optimizer::Pass::Pass(std::string name)
+    : m_name(std::move(name)), m_program(nullptr), m_rewrites(0) {}
+
+size_t
+Optimizer::Pass::run(Program *program) {
+    m_program = program;
+    m_rewrites = 0;
+    walk_stmts(program->m_stmts);
+    return m_rewrites;
+}
+
+void
+Optimizer::Pass::report(const std::string &filepath) const {
+    std::cerr << "[EARL] " << filepath << ": " << m_name << ":";
+    if (m_stats.size() == 0)
+        std::cerr << " nothing to do";
+    for (auto &stat : m_stats)
+        std::cerr << ' ' << stat.first << '=' << stat.second;
+    std::cerr << std::endl;
+}
+
+void
+Optimizer::Pass::count(const std::string &what) {
+    ++m_rewrites;
+    for (auto &stat : m_stats) {
+        if (stat.first == what) {
+            ++stat.second;
+            return;
+        }
+    }
+    m_stats.emplace_back(what, 1);
+}
+
+void
+Optimizer::Pass::visit_stmt(std::unique_ptr<Stmt> &stmt) {
+    walk_stmt(stmt.get());
+}
+
+void
+Optimizer::Pass::visit_expr(std::unique_ptr<Expr> &expr) {
+    walk_expr(expr.get());
+}
+
+void
+Optimizer::Pass::walk_stmts(std::vector<std::unique_ptr<Stmt>> &stmts) {
+    bool removed = false;
+    for (auto &stmt : stmts) {
+        visit_stmt(stmt);
+        removed = removed || !stmt;
+    }
+    if (removed) {
+        std::vector<std::unique_ptr<Stmt>> kept = {};
+        for (auto &stmt : stmts)
+            if (stmt)
+                kept.push_back(std::move(stmt));
+        stmts = std::move(kept);
+    }
+}
+
+void
+Optimizer::Pass::walk_block(StmtBlock *block) {
+    walk_stmts(block->m_stmts);
+}
+
+void
+Optimizer::Pass::walk_expr(Expr *expr) {
+    switch (expr->get_type()) {
+    case ExprType::Binary: {
+        auto bin = dynamic_cast<ExprBinary *>(expr);
+        visit_expr(bin->m_lhs);
+        visit_expr(bin->m_rhs);
+        return;
+    } break;
+    case ExprType::Unary: {
+        visit_expr(dynamic_cast<ExprUnary *>(expr)->m_expr);
+        return;
+    } break;
+    case ExprType::Term: break;
+    default: assert(false && "unreachable");
+    }
+
+    auto term = dynamic_cast<ExprTerm *>(expr);
+    switch (term->get_term_type()) {
+    case ExprTermType::Func_Call: {
+        auto funccall = dynamic_cast<ExprFuncCall *>(term);
+        visit_expr(funccall->m_left);
+        for (auto &param : funccall->m_params)
+            visit_expr(param);
+    } break;
+    case ExprTermType::List_Literal: {
+        for (auto &elem : dynamic_cast<ExprListLit *>(term)->m_elems)
+            visit_expr(elem);
+    } break;
+    case ExprTermType::Range: {
+        auto range = dynamic_cast<ExprRange *>(term);
+        visit_expr(range->m_start);
+        visit_expr(range->m_end);
+    } break;
+    case ExprTermType::Slice: {
+        auto slice = dynamic_cast<ExprSlice *>(term);
+        if (slice->m_start.has_value())
+            visit_expr(slice->m_start.value());
+        if (slice->m_end.has_value())
+            visit_expr(slice->m_end.value());
+    } break;
+    case ExprTermType::Get: {
+        // The right hand side is a member, only its arguments are expressions.
+        auto get = dynamic_cast<ExprGet *>(term);
+        visit_expr(get->m_left);
+        if (std::holds_alternative<std::unique_ptr<ExprFuncCall>>(get->m_right))
+            for (auto &param : std::get<std::unique_ptr<ExprFuncCall>>(get->m_right)->m_params)
+                visit_expr(param);
+    } break;
+    case ExprTermType::Mod_Access: {
+        auto mod_access = dynamic_cast<ExprModAccess *>(term);
+        if (std::holds_alternative<std::unique_ptr<ExprFuncCall>>(mod_access->m_right))
+            for (auto &param : std::get<std::unique_ptr<ExprFuncCall>>(mod_access->m_right)->m_params)
+                visit_expr(param);
+    } break;
+    case ExprTermType::Array_Access: {
+        auto access = dynamic_cast<ExprArrayAccess *>(term);
+        visit_expr(access->m_left);
+        visit_expr(access->m_expr);
+    } break;
+    case ExprTermType::Closure: {
+        walk_block(dynamic_cast<ExprClosure *>(term)->m_block.get());
+    } break;
+    case ExprTermType::Tuple: {
+        for (auto &e : dynamic_cast<ExprTuple *>(term)->m_exprs)
+            visit_expr(e);
+    } break;
+    case ExprTermType::Dict: {
+        for (auto &kv : dynamic_cast<ExprDict *>(term)->m_values) {
+            visit_expr(kv.first);
+            visit_expr(kv.second);
+        }
+    } break;
+    case ExprTermType::FStr: {
+        for (auto &part : dynamic_cast<ExprFStr *>(term)->m_parts)
+            if (std::holds_alternative<std::unique_ptr<Expr>>(part))
+                visit_expr(std::get<std::unique_ptr<Expr>>(part));
+    } break;
+    default: break;
+    }
+}
+
+void
+Optimizer::Pass::walk_stmt(Stmt *stmt) {
+    switch (stmt->stmt_type()) {
+    case StmtType::Def: {
+        walk_block(dynamic_cast<StmtDef *>(stmt)->m_block.get());
+    } break;
+    case StmtType::Let: {
+        visit_expr(dynamic_cast<StmtLet *>(stmt)->m_expr);
+    } break;
+    case StmtType::Block: {
+        walk_block(dynamic_cast<StmtBlock *>(stmt));
+    } break;
+    case StmtType::Mut: {
+        auto mut = dynamic_cast<StmtMut *>(stmt);
+        visit_expr(mut->m_left);
+        visit_expr(mut->m_right);
+    } break;
+    case StmtType::Stmt_Expr: {
+        visit_expr(dynamic_cast<StmtExpr *>(stmt)->m_expr);
+    } break;
+    case StmtType::If: {
+        auto if_ = dynamic_cast<StmtIf *>(stmt);
+        visit_expr(if_->m_expr);
+        walk_block(if_->m_block.get());
+        if (if_->m_else.has_value())
+            walk_block(if_->m_else.value().get());
+    } break;
+    case StmtType::Return: {
+        auto ret = dynamic_cast<StmtReturn *>(stmt);
+        if (ret->m_expr.has_value())
+            visit_expr(ret->m_expr.value());
+    } break;
+    case StmtType::While: {
+        auto while_ = dynamic_cast<StmtWhile *>(stmt);
+        visit_expr(while_->m_expr);
+        walk_block(while_->m_block.get());
+    } break;
+    case StmtType::Loop: {
+        walk_block(dynamic_cast<StmtLoop *>(stmt)->m_block.get());
+    } break;
+    case StmtType::For: {
+        auto for_ = dynamic_cast<StmtFor *>(stmt);
+        visit_expr(for_->m_start);
+        visit_expr(for_->m_end);
+        walk_block(for_->m_block.get());
+    } break;
+    case StmtType::Foreach: {
+        auto foreach = dynamic_cast<StmtForeach *>(stmt);
+        visit_expr(foreach->m_expr);
+        walk_block(foreach->m_block.get());
+    } break;
+    case StmtType::Class: {
+        auto class_ = dynamic_cast<StmtClass *>(stmt);
+        for (auto &member : class_->m_members)
+            walk_stmt(member.get());
+        for (auto &method : class_->m_methods)
+            walk_stmt(method.get());
+    } break;
+    case StmtType::Match: {
+        auto match = dynamic_cast<StmtMatch *>(stmt);
+        visit_expr(match->m_expr);
+        for (auto &branch : match->m_branches) {
+            for (auto &expr : branch->m_expr)
+                visit_expr(expr);
+            if (branch->m_when.has_value())
+                visit_expr(branch->m_when.value());
+            walk_block(branch->m_block.get());
+        }
+    } break;
+    case StmtType::Enum: {
+        for (auto &elem : dynamic_cast<StmtEnum *>(stmt)->m_elems)
+            if (elem.second)
+                visit_expr(elem.second);
+    } break;
+    case StmtType::Bash_Literal: {
+        visit_expr(dynamic_cast<StmtBashLiteral *>(stmt)->m_expr);
+    } break;
+    case StmtType::Import:
+    case StmtType::Mod:
+    case StmtType::Break:
+    case StmtType::Continue:
+        break;
+    default: assert(false && "unreachable");
+    }
+}
+
+/*** ConstFold ***/
+
+Optimizer::ConstFold::ConstFold(void) : Pass("const-fold") {}
+
+void
+Optimizer::ConstFold::visit_expr(std::unique_ptr<Expr> &expr) {
+    walk_expr(expr.get());
+
+    if (expr->get_type() == ExprType::Binary) {
+        auto bin = dynamic_cast<ExprBinary *>(expr.get());
+        auto lhs = literal_value(bin->m_lhs.get());
+        auto rhs = literal_value(bin->m_rhs.get());
+        if (!lhs || !rhs || !can_fold_binary(bin->m_op->type(), lhs.get(), rhs.get()))
+            return;
+        auto value = m_program->m_consts->add(fold_binary(bin->m_op.get(), lhs.get(), rhs.get()));
+        expr = make_literal(leftmost_token(bin->m_lhs.get()), value);
+        count("binary");
+    }
+    else if (expr->get_type() == ExprType::Unary) {
+        auto unary = dynamic_cast<ExprUnary *>(expr.get());
+        auto value = literal_value(unary->m_expr.get());
+        if (!value || !can_fold_unary(unary->m_op->type(), value.get()))
+            return;
+        value = m_program->m_consts->add(value->unaryop(unary->m_op.get()));
+        expr = make_literal(unary->m_op, value);
+        count("unary");
+    }
+}
+
+/*** ConstProp ***/
+
+// Gathers every name that is declared anywhere in a program. A @const
+// binding is only propagated if nothing else could shadow it.
+struct Declarations : public Optimizer::Pass {
+    Declarations(void) : Pass("declarations") {}
+
+    std::unordered_map<std::string, int> m_names;
+
+protected:
+    void visit_stmt(std::unique_ptr<Stmt> &stmt) override {
+        declare_stmt(stmt.get());
+        walk_stmt(stmt.get());
+    }
+
+    void visit_expr(std::unique_ptr<Expr> &expr) override {
+        if (expr->get_type() == ExprType::Term
+            && dynamic_cast<ExprTerm *>(expr.get())->get_term_type() == ExprTermType::Closure)
+            for (auto &arg : dynamic_cast<ExprClosure *>(expr.get())->m_args)
+                declare(arg.first->lexeme());
+        walk_expr(expr.get());
+    }
+
+private:
+    void declare(const std::string &id) {
+        ++m_names[id];
+    }
+
+    // Every identifier in a `match` pattern may be a binding.
+    void declare_pattern(Expr *expr) {
+        if (expr->get_type() != ExprType::Term)
+            return;
+        auto term = dynamic_cast<ExprTerm *>(expr);
+        if (term->get_term_type() == ExprTermType::Ident)
+            declare(dynamic_cast<ExprIdent *>(term)->m_tok->lexeme());
+        else if (term->get_term_type() == ExprTermType::Func_Call)
+            for (auto &param : dynamic_cast<ExprFuncCall *>(term)->m_params)
+                declare_pattern(param.get());
+    }
+
+    void declare_stmt(Stmt *stmt) {
+        switch (stmt->stmt_type()) {
+        case StmtType::Def: {
+            auto def = dynamic_cast<StmtDef *>(stmt);
+            declare(def->m_id->lexeme());
+            for (auto &arg : def->m_args)
+                declare(arg.first.first->lexeme());
+        } break;
+        case StmtType::Let: {
+            for (auto &id : dynamic_cast<StmtLet *>(stmt)->m_ids)
+                declare(id->lexeme());
+        } break;
+        case StmtType::For: {
+            declare(dynamic_cast<StmtFor *>(stmt)->m_enumerator->lexeme());
+        } break;
+        case StmtType::Foreach: {
+            for (auto &enumerator : dynamic_cast<StmtForeach *>(stmt)->m_enumerators)
+                declare(enumerator->lexeme());
+        } break;
+        case StmtType::Class: {
+            auto class_ = dynamic_cast<StmtClass *>(stmt);
+            declare(class_->m_id->lexeme());
+            for (auto &arg : class_->m_constructor_args)
+                declare(arg.first->lexeme());
+            for (auto &member : class_->m_members)
+                declare_stmt(member.get());
+            for (auto &method : class_->m_methods)
+                declare_stmt(method.get());
+        } break;
+        case StmtType::Match: {
+            for (auto &branch : dynamic_cast<StmtMatch *>(stmt)->m_branches)
+                for (auto &expr : branch->m_expr)
+                    declare_pattern(expr.get());
+        } break;
+        case StmtType::Enum: {
+            declare(dynamic_cast<StmtEnum *>(stmt)->m_id->lexeme());
+        } break;
+        default: break;
+        }
+    }
+};
+
+static StmtLet *
+as_const_binding(Stmt *stmt) {
+    if (stmt->stmt_type() != StmtType::Let)
+        return nullptr;
+    auto let = dynamic_cast<StmtLet *>(stmt);
+    if ((let->m_attrs & static_cast<uint32_t>(Attr::Const)) == 0
+        || (let->m_attrs & static_cast<uint32_t>(Attr::Ref)) != 0
+        || let->m_ids.size() != 1)
+        return nullptr;
+    return let;
+}
+
+Optimizer::ConstProp::ConstProp(void) : Pass("const-prop"), m_visible(true) {}
+
+size_t
+Optimizer::ConstProp::run(Program *program) {
+    m_program = program;
+    m_rewrites = 0;
+    m_visible = true;
+    m_known.clear();
+
+    Declarations decls;
+    (void)decls.run(program);
+    m_candidates.clear();
+    for (auto &stmt : program->m_stmts) {
+        StmtLet *let = as_const_binding(stmt.get());
+        if (let && decls.m_names[let->m_ids[0]->lexeme()] == 1)
+            m_candidates.insert(let->m_ids[0]->lexeme());
+    }
+
+    // Uses that come before the binding are left alone.
+    for (auto &stmt : program->m_stmts) {
+        visit_stmt(stmt);
+        StmtLet *let = as_const_binding(stmt.get());
+        if (!let || m_candidates.count(let->m_ids[0]->lexeme()) == 0)
+            continue;
+        auto value = literal_value(let->m_expr.get());
+        if (!value)
+            continue;
+        m_known.emplace(let->m_ids[0]->lexeme(), value);
+        if (m_bound.insert(let->m_ids[0]->lexeme()).second)
+            count("bindings");
+    }
+    return m_rewrites;
+}
+
+void
+Optimizer::ConstProp::visit_stmt(std::unique_ptr<Stmt> &stmt) {
+    bool visible = m_visible;
+    switch (stmt->stmt_type()) {
+    case StmtType::Def: {
+        // Functions only see @world bindings when they are @world.
+        auto def = dynamic_cast<StmtDef *>(stmt.get());
+        m_visible = m_visible && (def->m_attrs & static_cast<uint32_t>(Attr::World)) != 0;
+        walk_stmt(def);
+    } break;
+    case StmtType::Class: break;
+    case StmtType::Let: {
+        // A reference to a constant must keep referring to it.
+        auto let = dynamic_cast<StmtLet *>(stmt.get());
+        if ((let->m_attrs & static_cast<uint32_t>(Attr::Ref)) == 0)
+            walk_stmt(let);
+    } break;
+    case StmtType::Mut: {
+        // Mutating a constant is an error, leave it for the runtime.
+        visit_expr(dynamic_cast<StmtMut *>(stmt.get())->m_right);
+    } break;
+    default: walk_stmt(stmt.get());
+    }
+    m_visible = visible;
+}
+
+void
+Optimizer::ConstProp::visit_expr(std::unique_ptr<Expr> &expr) {
+    if (expr->get_type() != ExprType::Term) {
+        walk_expr(expr.get());
+        return;
+    }
+
+    auto term = dynamic_cast<ExprTerm *>(expr.get());
+    switch (term->get_term_type()) {
+    case ExprTermType::Ident: {
+        auto ident = dynamic_cast<ExprIdent *>(term);
+        auto it = m_known.find(ident->m_tok->lexeme());
+        if (!m_visible || it == m_known.end())
+            return;
+        expr = make_literal(ident->m_tok, it->second);
+        count("uses");
+    } break;
+    case ExprTermType::Func_Call: {
+        // Only the arguments, not the function being called.
+        for (auto &param : dynamic_cast<ExprFuncCall *>(term)->m_params)
+            visit_expr(param);
+    } break;
+    case ExprTermType::Get: {
+        // Methods may mutate the value they are called on.
+        auto get = dynamic_cast<ExprGet *>(term);
+        if (get->m_left->get_type() != ExprType::Term
+            || dynamic_cast<ExprTerm *>(get->m_left.get())->get_term_type() != ExprTermType::Ident)
+            visit_expr(get->m_left);
+        if (std::holds_alternative<std::unique_ptr<ExprFuncCall>>(get->m_right))
+            for (auto &param : std::get<std::unique_ptr<ExprFuncCall>>(get->m_right)->m_params)
+                visit_expr(param);
+    } break;
+    case ExprTermType::Closure: break;
+    default: walk_expr(term);
+    }
+}
+
+/*** DeadBranch ***/
+
+Optimizer::DeadBranch::DeadBranch(void) : Pass("dead-branch") {}
+
+void
+Optimizer::DeadBranch::visit_stmt(std::unique_ptr<Stmt> &stmt) {
+    walk_stmt(stmt.get());
+
+    if (stmt->stmt_type() == StmtType::If) {
+        auto if_ = dynamic_cast<StmtIf *>(stmt.get());
+        auto condition = literal_value(if_->m_expr.get());
+        if (!condition || !has_boolean(condition.get()))
+            return;
+        // The branch that is taken still gets its own scope.
+        if (condition->boolean())
+            stmt = std::move(if_->m_block);
+        else if (if_->m_else.has_value())
+            stmt = std::move(if_->m_else.value());
+        else
+            stmt = nullptr;
+        count("if");
+    }
+    else if (stmt->stmt_type() == StmtType::While) {
+        auto while_ = dynamic_cast<StmtWhile *>(stmt.get());
+        auto condition = literal_value(while_->m_expr.get());
+        if (!condition || !has_boolean(condition.get()) || condition->boolean())
+            return;
+        stmt = nullptr;
+        count("while");
+    }
+}
+
+/*** Pipeline ***/
+
+void
+Optimizer::optimize(Program *program) {
+    if ((flags & __O1) == 0)
+        return;
+
+    ConstFold fold;
+    ConstProp prop;
+    DeadBranch dead_branch;
+
+    (void)fold.run(program);
+    for (int i = 0; i < OPTIMIZER_MAX_ROUNDS; ++i) {
+        if (prop.run(program) == 0)
+            break;
+        (void)fold.run(program);
+    }
+    (void)dead_branch.run(program);
+
+    if ((flags & __SHOWPASSES) != 0) {
+        fold.report(program->m_filepath);
+        prop.report(program->m_filepath);
+        dead_branch.report(program->m_filepath);
+    }
+}
@@ -37,6 +37,10 @@
 std::vector<std::pair<std::pair<std::shared_ptr<Token>, std::optional<std::shared_ptr<__Type>>>, uint32_t>>
 parse_stmt_def_args(Lexer &lexer);
 
+// The constant pool of the program currently being parsed (per
+// thread, imports may be parsed concurrently, see prefetch.hpp).
+static thread_local ConstPool *consts = nullptr;
+
 static Attr
 translate_attr(Lexer &lexer) {
     auto errtok = Parser::parse_expect(lexer, TokenType::At);
@@ -50,6 +54,8 @@ translate_attr(Lexer &lexer) {
         return Attr::Ref;
     if (attr->lexeme() == COMMON_EARLATTR_CONST)
         return Attr::Const;
+    if (attr->lexeme() == COMMON_EARLATTR_MEMO)
+        return Attr::Memo;
     else {
         Err::err_wtok(errtok.get());
         std::string msg = "unknown attribute `" + attr->lexeme() + "`";
@@ -237,6 +243,78 @@ parse_set_values(Lexer &lexer) {
     return values;
 }
 
+// Parse one `{expr}` of an f-string. `offset` is where
+// `src` starts in the string, to place its tokens, which
+// `outer` keeps alive afterwards.
+static std::unique_ptr<Expr>
+parse_fstr_expr(Lexer &outer, Token *fstr, std::string src, size_t offset) {
+    std::vector<std::string> types    = {};
+    std::string comment               = COMMON_EARL_COMMENT;
+    std::unique_ptr<Lexer> lexer      = lex_file(src, fstr->fp(), types, comment);
+
+    for (auto &it : lexer->m_toks) {
+        it->m_row = fstr->m_row;
+        it->m_col = fstr->m_col + offset + it->m_col;
+    }
+
+    if (lexer->peek(0)->type() == TokenType::Eof) {
+        Err::err_wtok(fstr);
+        const std::string msg = "empty `{}` in f-string";
+        throw ParserException(msg);
+    }
+
+    std::unique_ptr<Expr> expr(Parser::parse_expr(*lexer.get()));
+
+    if (lexer->peek(0) && lexer->peek(0)->type() != TokenType::Eof) {
+        Err::err_wtok(lexer->peek(0));
+        const std::string msg = "unexpected `" + lexer->peek(0)->lexeme() + "` in f-string";
+        throw ParserException(msg);
+    }
+
+    outer.keep(std::move(lexer->m_toks));
+    return expr;
+}
+
+// Split an f-string into its text and its `{expr}`s once, so
+// that evaluating it does not have to scan it again.
+static ExprFStr *
+parse_fstr(Lexer &lexer, std::shared_ptr<Token> tok) {
+    const std::string &str = tok->lexeme();
+    std::vector<std::variant<std::string, std::unique_ptr<Expr>>> parts = {};
+    std::string text = "";
+
+    for (size_t i = 0; i < str.size(); ++i) {
+        if (str[i] != '{') {
+            text.push_back(str[i]);
+            continue;
+        }
+
+        size_t start = ++i;
+        int depth = 1;
+        for (; i < str.size(); ++i) {
+            if (str[i] == '{')
+                ++depth;
+            else if (str[i] == '}' && --depth == 0)
+                break;
+        }
+        if (depth != 0) {
+            Err::err_wtok(tok.get());
+            const std::string msg = "unterminated `{` in f-string";
+            throw ParserException(msg);
+        }
+
+        if (!text.empty())
+            parts.emplace_back(std::in_place_index<0>, std::move(text));
+        text = "";
+        parts.emplace_back(std::in_place_index<1>, parse_fstr_expr(lexer, tok.get(), str.substr(start, i-start), start));
+    }
+
+    if (!text.empty())
+        parts.emplace_back(std::in_place_index<0>, std::move(text));
+
+    return new ExprFStr(tok, std::move(parts));
+}
+
 static Expr *
 parse_primary_expr(Lexer &lexer, char fail_on = '\0') {
     Token *tok = nullptr;
@@ -299,18 +377,22 @@ parse_primary_expr(Lexer &lexer, char fail_on = '\0') {
             left = new ExprGet(std::unique_ptr<Expr>(left), parse_identifier_or_funccall(lexer), tok);
         } break;
         case TokenType::Intlit: {
-            left = new ExprIntLit(lexer.next());
+            auto tok = lexer.next();
+            left = new ExprIntLit(tok, consts->get_int(tok.get()));
         } break;
         case TokenType::Floatlit: {
-            left = new ExprFloatLit(lexer.next());
+            auto tok = lexer.next();
+            left = new ExprFloatLit(tok, consts->get_float(tok.get()));
         } break;
         case TokenType::Strlit: {
             if (left && left->get_type() == ExprType::Term) {
                 auto left_term = dynamic_cast<ExprTerm *>(left);
                 if (left_term->get_term_type() == ExprTermType::Ident) {
                     auto left_ident = dynamic_cast<ExprIdent *>(left_term);
-                    if (left_ident->m_tok->lexeme() == "f")
-                        left = new ExprFStr(lexer.next());
+                    if (left_ident->m_tok->lexeme() == "f") {
+                        delete left;
+                        left = parse_fstr(lexer, lexer.next());
+                    }
                     else
                         goto not_fstr;
                 }
@@ -319,11 +401,13 @@ parse_primary_expr(Lexer &lexer, char fail_on = '\0') {
             }
             else {
             not_fstr:
-                left = new ExprStrLit(lexer.next());
+                auto tok = lexer.next();
+                left = new ExprStrLit(tok, consts->get_str(tok.get()));
             }
         } break;
         case TokenType::Charlit: {
-            left = new ExprCharLit(lexer.next());
+            auto tok = lexer.next();
+            left = new ExprCharLit(tok, consts->get_char(tok.get()));
         } break;
         case TokenType::Lbracket: {
             if (left) {
@@ -387,10 +471,10 @@ parse_primary_expr(Lexer &lexer, char fail_on = '\0') {
 
             std::shared_ptr<Token> kw = lexer.next();
             if (kw->lexeme() == COMMON_EARLKW_TRUE) {
-                return new ExprBool(std::move(kw), true);
+                return new ExprBool(std::move(kw), true, consts->get_bool(true));
             }
             else if (kw->lexeme() == COMMON_EARLKW_FALSE) {
-                return new ExprBool(std::move(kw), false);
+                return new ExprBool(std::move(kw), false, consts->get_bool(false));
             }
             else if (kw->lexeme() == COMMON_EARLKW_NONE) {
                 return new ExprNone(std::move(kw));
@@ -703,6 +787,18 @@ Parser::parse_stmt_def(Lexer &lexer, uint32_t attrs) {
 
     auto args = parse_stmt_def_args(lexer);
 
+    // The cached result of a memoized function would skip
+    // the writes it makes through its references.
+    if ((attrs & static_cast<uint32_t>(Attr::Memo)) != 0) {
+        for (auto &arg : args) {
+            if ((arg.second & static_cast<uint32_t>(Attr::Ref)) != 0) {
+                Err::err_wtok(arg.first.first.get());
+                std::string msg = "function `" + id->lexeme() + "` has the @memo attribute and cannot take @ref parameters";
+                throw ParserException(msg);
+            }
+        }
+    }
+
     if (lexer.peek(0) && lexer.peek(0)->type() == TokenType::Colon)
         ty = get_ty(lexer);
 
@@ -867,8 +963,18 @@ parse_stmt_class(Lexer &lexer, uint32_t attrs) {
             if (tok->lexeme() == COMMON_EARLKW_LET) {
                 members.push_back(Parser::parse_stmt_let(lexer, inclass_attrs));
             }
-            else if (tok->lexeme() == COMMON_EARLKW_FN)
+            else if (tok->lexeme() == COMMON_EARLKW_FN) {
+                // The cache of a method would be shared by
+                // every instance, whatever `this` is.
+                if ((inclass_attrs & static_cast<uint32_t>(Attr::Memo)) != 0) {
+                    Token *id = lexer.peek(1) ? lexer.peek(1) : tok;
+                    Err::err_wtok(id);
+                    std::string msg = "method `" + id->lexeme() + "` of class `" + class_id->lexeme()
+                        + "` cannot have the @memo attribute";
+                    throw ParserException(msg);
+                }
                 methods.push_back(Parser::parse_stmt_def(lexer, inclass_attrs));
+            }
             else {
                 Err::err_wtok(tok);
                 std::string msg = "invalid keyword specifier `" + tok->lexeme() + "` in class declaration";
@@ -1095,10 +1201,24 @@ Parser::parse_stmt(Lexer &lexer) {
 
 std::unique_ptr<Program>
 Parser::parse_program(Lexer &lexer, const std::string filepath, std::string from) {
+    // Declared first, the nodes must go before their memory does.
+    auto arena = std::make_unique<Arena>();
+    AstArena scope(arena.get());
+
     std::vector<std::unique_ptr<Stmt>> stmts;
+    auto pool = std::make_unique<ConstPool>();
 
-    while (lexer.peek(0) && lexer.peek()->type() != TokenType::Eof)
-        stmts.push_back(parse_stmt(lexer));
+    ConstPool *prev = consts;
+    consts = pool.get();
+    try {
+        while (lexer.peek(0) && lexer.peek()->type() != TokenType::Eof)
+            stmts.push_back(parse_stmt(lexer));
+    }
+    catch (...) {
+        consts = prev;
+        throw;
+    }
+    consts = prev;
 
     if ((flags & __CHECK) != 0) {
         if (from != "")
@@ -1108,5 +1228,5 @@ Parser::parse_program(Lexer &lexer, const std::string filepath, std::string from
         std::cout << filepath << " .. ok" << std::endl;
     }
 
-    return std::make_unique<Program>(std::move(stmts), filepath);
+    return std::make_unique<Program>(std::move(stmts), filepath, std::move(pool), std::move(arena));
 }
@@ -0,0 +1,159 @@
+/** @file */
+
+// MIT License
+
+// Copyright (c) 2023 malloc-nbytes
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "prefetch.hpp"
+#include "module-cache.hpp"
+#include "common.hpp"
+#include "earl.hpp"
+#include "err.hpp"
+
+/// @brief The most threads used to parse imports
+#define PREFETCH_MAX_WORKERS 16
+
+struct Parsed {
+    std::unique_ptr<Program> m_program;
+    std::unique_ptr<Lexer> m_lexer;
+};
+
+static std::unordered_map<std::string, Parsed> parsed;
+
+std::string
+Prefetch::module_key(const std::string &path) {
+    std::error_code ec;
+    std::filesystem::path file = resolve_filepath(path.c_str());
+    std::filesystem::path canonical = std::filesystem::weakly_canonical(file, ec);
+    if (ec)
+        return file.lexically_normal().string();
+    return canonical.string();
+}
+
+// The files imported by the top level of `program`
+// with a string literal.
+static std::vector<std::string>
+static_imports(Program *program) {
+    std::vector<std::string> paths = {};
+    for (auto &stmt : program->m_stmts) {
+        if (stmt->stmt_type() != StmtType::Import)
+            continue;
+        Expr *fp = dynamic_cast<StmtImport *>(stmt.get())->m_fp.get();
+        if (fp->get_type() != ExprType::Term
+            || dynamic_cast<ExprTerm *>(fp)->get_term_type() != ExprTermType::Str_Literal)
+            continue;
+        paths.push_back(dynamic_cast<ExprStrLit *>(fp)->m_value->to_cxxstring());
+    }
+    return paths;
+}
+
+void
+Prefetch::imports(Program *program) {
+    parsed.clear();
+
+    // `--check` prints every file it parses in order.
+    if ((flags & __CHECK) != 0)
+        return;
+
+    const size_t workers = std::min<size_t>(std::thread::hardware_concurrency(), PREFETCH_MAX_WORKERS);
+    if (workers < 2)
+        return;
+
+    std::mutex mu;
+    std::condition_variable cv;
+    std::deque<std::pair<std::string, std::string>> queue = {};
+    std::unordered_set<std::string> seen = {module_key(program->m_filepath)};
+    size_t busy = 0;
+
+    // Must hold `mu`.
+    auto enqueue = [&](Program *from) {
+        for (auto &path : static_imports(from)) {
+            std::string key = module_key(path);
+            if (seen.insert(key).second)
+                queue.emplace_back(path, key);
+        }
+        cv.notify_all();
+    };
+
+    auto work = [&]() {
+        Err::set_quiet(true);
+        std::unique_lock<std::mutex> lock(mu);
+        while (true) {
+            cv.wait(lock, [&]() { return !queue.empty() || busy == 0; });
+            if (queue.empty())
+                break;
+            auto [path, key] = queue.front();
+            queue.pop_front();
+            ++busy;
+            lock.unlock();
+
+            Parsed module = {nullptr, nullptr};
+            try {
+                module.m_program = ModuleCache::parse_file(path, module.m_lexer);
+            } catch (...) {
+                module.m_program = nullptr;
+            }
+
+            lock.lock();
+            if (module.m_program) {
+                enqueue(module.m_program.get());
+                parsed.emplace(key, std::move(module));
+            }
+            --busy;
+            cv.notify_all();
+        }
+        Err::set_quiet(false);
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        enqueue(program);
+        if (queue.empty())
+            return;
+    }
+
+    std::vector<std::thread> threads = {};
+    for (size_t i = 0; i < workers; ++i)
+        threads.emplace_back(work);
+    for (auto &t : threads)
+        t.join();
+}
+
+std::unique_ptr<Program>
+Prefetch::take(const std::string &key, std::unique_ptr<Lexer> &lexer) {
+    auto it = parsed.find(key);
+    if (it == parsed.end())
+        return nullptr;
+    auto program = std::move(it->second.m_program);
+    lexer = std::move(it->second.m_lexer);
+    parsed.erase(it);
+    return program;
+}
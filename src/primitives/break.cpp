@@ -31,6 +31,12 @@
 
 using namespace earl::value;
 
+std::shared_ptr<Obj>
+Break::instance(void) {
+    static std::shared_ptr<Obj> instance = std::make_shared<Break>();
+    return instance;
+}
+
 Type
 Break::type(void) const {
     return Type::Break;
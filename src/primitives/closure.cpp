@@ -59,6 +59,7 @@ Closure::load_parameters(std::vector<std::shared_ptr<earl::value::Obj>> &values,
         else
             var = std::make_shared<earl::variable::Obj>(id, value->copy());
         ctx->variable_add(var);
+        ctx->m_frame.set(Slot{block(), static_cast<int>(i)}, var);
     }
 }
 
@@ -31,6 +31,12 @@
 
 using namespace earl::value;
 
+std::shared_ptr<Obj>
+Continue::instance(void) {
+    static std::shared_ptr<Obj> instance = std::make_shared<Continue>();
+    return instance;
+}
+
 /*** OVERRIDES ***/
 Type Continue::type(void) const {
     return Type::Continue;
@@ -26,6 +26,7 @@
 #include <iostream>
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <memory>
 
 #include "earl.hpp"
@@ -35,13 +36,56 @@
 using namespace earl::value;
 
 List::List(std::vector<std::shared_ptr<Obj>> value)
-    : m_value(value) {
+    : m_value(std::move(value)) {
     m_iterable = true;
 }
 
+List::List(Cow<std::vector<std::shared_ptr<Obj>>> value)
+    : m_value(std::move(value)) {
+    m_iterable = true;
+}
+
+List::List(Range range)
+    : m_value(std::vector<std::shared_ptr<Obj>>{}), m_range(range) {
+    m_iterable = true;
+}
+
+std::shared_ptr<Obj>
+Range::at(size_t idx) const {
+    if (m_chars)
+        return std::make_shared<Char>(static_cast<char>(m_start+static_cast<int>(idx)));
+    return std::make_shared<Int>(m_start+static_cast<int>(idx));
+}
+
+void
+List::materialize(void) const {
+    if (!m_range.has_value())
+        return;
+    std::vector<std::shared_ptr<Obj>> values = {};
+    values.reserve(m_range->m_size);
+    for (size_t i = 0; i < m_range->m_size; ++i)
+        values.push_back(m_range->at(i));
+    m_value = Cow<std::vector<std::shared_ptr<Obj>>>(std::move(values));
+    m_range.reset();
+}
+
+size_t
+List::size(void) const {
+    if (m_range.has_value())
+        return m_range->m_size;
+    return m_value.get().size();
+}
+
 std::vector<std::shared_ptr<Obj>> &
 List::value(void) {
-    return m_value;
+    materialize();
+    return m_value.leak();
+}
+
+const std::vector<std::shared_ptr<Obj>> &
+List::elems(void) const {
+    materialize();
+    return m_value.get();
 }
 
 Type
@@ -62,9 +106,10 @@ List::slice(Obj *start, Obj *end, Expr *expr) {
         throw InterpreterException(msg);
     }
 
+    std::vector<std::shared_ptr<Obj>> &values = this->value();
     std::vector<std::shared_ptr<Obj>> v = {};
     if (start->type() == Type::Void && end->type() == Type::Void) {
-        std::for_each(m_value.begin(), m_value.end(), [&](auto &k) {v.push_back(k);});
+        std::for_each(values.begin(), values.end(), [&](auto &k) {v.push_back(k);});
         return v;
     }
     int s, e;
@@ -75,33 +120,33 @@ List::slice(Obj *start, Obj *end, Expr *expr) {
         s = dynamic_cast<Int *>(start)->value();
 
     if (end->type() == Type::Void)
-        e = m_value.size();
+        e = values.size();
     else
         e = dynamic_cast<Int *>(end)->value();
 
     for (; s < e; ++s) {
-        if (s >= m_value.size()) {
+        if (s >= values.size()) {
             Err::err_wexpr(expr);
-            std::string msg = "index "+std::to_string(s)+" is out of range for list of length "+std::to_string(m_value.size());
+            std::string msg = "index "+std::to_string(s)+" is out of range for list of length "+std::to_string(values.size());
             throw InterpreterException(msg);
         }
-        v.push_back(m_value.at(s));
+        v.push_back(values.at(s));
     }
 
     return v;
 }
 
 std::shared_ptr<Obj>
-List::nth(std::shared_ptr<Obj> &idx, Expr *expr) {
+List::nth(std::shared_ptr<Obj> &idx, Expr *expr, bool ref) {
     switch (idx->type()) {
     case Type::Int: {
         auto index = dynamic_cast<Int *>(idx.get());
-        if (index->value() < 0 || static_cast<size_t>(index->value()) >= this->value().size()) {
+        if (index->value() < 0 || static_cast<size_t>(index->value()) >= this->size()) {
             Err::err_wexpr(expr);
-            std::string msg = "index "+std::to_string(index->value())+" is out of range of length "+std::to_string(this->value().size());
+            std::string msg = "index "+std::to_string(index->value())+" is out of range of length "+std::to_string(this->size());
             throw InterpreterException(msg);
         }
-        return this->value().at(index->value());
+        return this->at(index->value(), ref);
     } break;
     case Type::Slice: {
         auto slice = dynamic_cast<Slice *>(idx.get());
@@ -117,18 +162,39 @@ List::nth(std::shared_ptr<Obj> &idx, Expr *expr) {
     return nullptr; // unreachable
 }
 
+std::shared_ptr<Obj>
+List::at(size_t idx, bool ref) {
+    if (!ref && m_range.has_value())
+        return m_range->at(idx);
+    return this->value()[idx];
+}
+
 std::shared_ptr<List>
 List::rev(void) {
     auto lst = std::make_shared<List>();
-    for (int i = m_value.size()-1; i >= 0; --i)
-        lst->append(m_value[i]);
+    auto &values = this->value();
+    for (int i = values.size()-1; i >= 0; --i)
+        lst->append(values[i]);
     return lst;
 }
 
 std::shared_ptr<Bool>
 List::contains(Obj *value) {
-    for (size_t i = 0; i < m_value.size(); ++i)
-        if (m_value.at(i)->eq(value))
+    if (m_range.has_value()) {
+        int at;
+        if (m_range->m_chars && value->type() == Type::Char)
+            at = dynamic_cast<Char *>(value)->value();
+        else if (!m_range->m_chars && value->type() == Type::Int)
+            at = dynamic_cast<Int *>(value)->value();
+        else
+            return std::make_shared<Bool>(false);
+        bool in = at >= m_range->m_start
+            && static_cast<size_t>(static_cast<int64_t>(at)-m_range->m_start) < m_range->m_size;
+        return std::make_shared<Bool>(in);
+    }
+    auto &values = m_value.get();
+    for (size_t i = 0; i < values.size(); ++i)
+        if (values.at(i)->eq(value))
             return std::make_shared<Bool>(true);
     return std::make_shared<Bool>(false);
 }
@@ -136,46 +202,53 @@ List::contains(Obj *value) {
 void
 List::pop(Obj *idx) {
     auto *idx1 = dynamic_cast<earl::value::Int *>(idx);
-    m_value.erase(m_value.begin() + idx1->value());
+    materialize();
+    auto &values = m_value.mut();
+    values.erase(values.begin() + idx1->value());
 }
 
 void
 List::append(std::vector<std::shared_ptr<Obj>> &values) {
+    auto &lst = this->value();
     for (size_t i = 0; i < values.size(); ++i) {
-        m_value.push_back(values.at(i));
+        lst.push_back(values.at(i));
     }
 }
 
 void
 List::append(std::shared_ptr<Obj> value) {
-    m_value.push_back(value);
+    this->value().push_back(value);
 }
 
 void
-List::append_copy(std::vector<std::shared_ptr<Obj>> &values) {
+List::append_copy(const std::vector<std::shared_ptr<Obj>> &values) {
+    materialize();
+    auto &lst = m_value.mut();
     for (size_t i = 0; i < values.size(); ++i) {
-        m_value.push_back(values.at(i)->copy());
+        lst.push_back(values.at(i)->copy());
     }
 }
 
 void
 List::append_copy(std::shared_ptr<Obj> value) {
-    m_value.push_back(value->copy());
+    materialize();
+    m_value.mut().push_back(value->copy());
 }
 
 std::shared_ptr<List>
 List::filter(Obj *closure, std::shared_ptr<Ctx> &ctx) {
     Closure *cl = dynamic_cast<Closure *>(closure);
+    auto &lst = this->value();
 
     auto copy = std::make_shared<List>();
     std::vector<std::shared_ptr<Obj>> keep_values={};
 
-    for (size_t i = 0; i < m_value.size(); ++i) {
-        std::vector<std::shared_ptr<Obj>> values = {m_value.at(i)};
+    for (size_t i = 0; i < lst.size(); ++i) {
+        std::vector<std::shared_ptr<Obj>> values = {lst.at(i)};
         std::shared_ptr<Obj> filter_result = cl->call(values, ctx);
         assert(filter_result->type() == Type::Bool);
         if (dynamic_cast<Bool *>(filter_result.get())->boolean())
-            keep_values.push_back(m_value.at(i)->copy());
+            keep_values.push_back(lst.at(i)->copy());
     }
 
     copy->append(keep_values);
@@ -186,8 +259,9 @@ List::filter(Obj *closure, std::shared_ptr<Ctx> &ctx) {
 void
 List::foreach(Obj *closure, std::shared_ptr<Ctx> &ctx) {
     Closure *cl = dynamic_cast<Closure *>(closure);
-    for (size_t i = 0; i < m_value.size(); ++i) {
-        std::vector<std::shared_ptr<Obj>> values = {m_value[i]};
+    auto &lst = this->value();
+    for (size_t i = 0; i < lst.size(); ++i) {
+        std::vector<std::shared_ptr<Obj>> values = {lst[i]};
         cl->call(values, ctx);
     }
 }
@@ -195,8 +269,9 @@ List::foreach(Obj *closure, std::shared_ptr<Ctx> &ctx) {
 std::shared_ptr<List>
 List::map(Closure *closure, std::shared_ptr<Ctx> &ctx) {
     auto mapped = std::make_shared<List>();
-    for (size_t i = 0; i < m_value.size(); ++i) {
-        std::vector<std::shared_ptr<Obj>> params = {m_value.at(i)};
+    auto &lst = this->value();
+    for (size_t i = 0; i < lst.size(); ++i) {
+        std::vector<std::shared_ptr<Obj>> params = {lst.at(i)};
         auto value = closure->call(params, ctx);
         mapped->append(value);
     }
@@ -205,9 +280,15 @@ List::map(Closure *closure, std::shared_ptr<Ctx> &ctx) {
 
 std::shared_ptr<Obj>
 List::back(void) {
-    if (m_value.size() == 0)
+    if (m_range.has_value()) {
+        if (m_range->m_size == 0)
+            return std::make_shared<Option>();
+        return m_range->at(m_range->m_size-1);
+    }
+    auto &values = m_value.get();
+    if (values.size() == 0)
         return std::make_shared<Option>();
-    return m_value.back()->copy();
+    return values.back()->copy();
 }
 
 std::shared_ptr<Obj>
@@ -226,11 +307,11 @@ List::binop(Token *op, Obj *other) {
     } break;
     case TokenType::Double_Equals: {
         int res = 0;
-        if (m_value.size() == other_casted->value().size()) {
+        if (this->elems().size() == other_casted->elems().size()) {
             res = 1;
-            for (size_t i = 0; i < m_value.size(); ++i) {
-                auto o1 = this->value()[i];
-                auto o2 = other_casted->value()[i];
+            for (size_t i = 0; i < this->elems().size(); ++i) {
+                auto o1 = this->elems()[i];
+                auto o2 = other_casted->elems()[i];
                 if (!type_is_compatable(o1.get(), o2.get())) {
                     res = 0;
                     break;
@@ -293,7 +374,7 @@ List::binop(Token *op, Obj *other) {
 
 bool
 List::boolean(void) {
-    return m_value.size() > 0;
+    return this->size() > 0;
 }
 
 void
@@ -302,13 +383,23 @@ List::mutate(Obj *other, StmtMut *stmt) {
     ASSERT_CONSTNESS(this, stmt);
 
     auto *lst = dynamic_cast<List *>(other);
-    m_value = lst->value();
+    if (lst->m_range.has_value()) {
+        m_value = Cow<std::vector<std::shared_ptr<Obj>>>(std::vector<std::shared_ptr<Obj>>{});
+        m_range = lst->m_range;
+        return;
+    }
+    m_value = Cow<std::vector<std::shared_ptr<Obj>>>(lst->value());
+    m_range.reset();
 }
 
 std::shared_ptr<Obj>
 List::copy(void) {
+    if (m_range.has_value())
+        return std::make_shared<List>(m_range.value());
+    if (m_value.shareable())
+        return std::make_shared<List>(m_value.share());
     auto list = std::make_shared<List>();
-    list->append_copy(this->value());
+    list->append_copy(m_value.get());
     return list;
 }
 
@@ -319,11 +410,11 @@ List::eq(Obj *other) {
 
     auto *lst = dynamic_cast<List *>(other);
 
-    if (lst->value().size() != this->value().size())
+    if (lst->elems().size() != this->elems().size())
         return false;
 
-    for (size_t i = 0; i < lst->value().size(); ++i)
-        if (!this->value()[i]->eq(lst->value()[i].get()))
+    for (size_t i = 0; i < lst->elems().size(); ++i)
+        if (!this->elems()[i]->eq(lst->elems()[i].get()))
             return false;
 
     return true;
@@ -331,10 +422,11 @@ List::eq(Obj *other) {
 
 std::string
 List::to_cxxstring(void) {
+    auto &values = this->elems();
     std::string res = "[";
-    for (size_t i = 0; i < m_value.size(); ++i) {
-        res += m_value.at(i)->to_cxxstring();
-        if (i != m_value.size()-1)
+    for (size_t i = 0; i < values.size(); ++i) {
+        res += values.at(i)->to_cxxstring();
+        if (i != values.size()-1)
             res += ", ";
     }
     res += "]";
@@ -348,8 +440,10 @@ List::spec_mutate(Token *op, Obj *other, StmtMut *stmt) {
 
     switch (op->type()) {
     case TokenType::Plus_Equals: {
-        auto otherlst = dynamic_cast<const List *>(other);
-        m_value.insert(m_value.end(), otherlst->m_value.begin(), otherlst->m_value.end());
+        auto otherlst = dynamic_cast<List *>(other);
+        auto &others = otherlst->value();
+        auto &values = this->value();
+        values.insert(values.end(), others.begin(), others.end());
     } break;
     default: {
         Err::err_wtok(op);
@@ -361,12 +455,16 @@ List::spec_mutate(Token *op, Obj *other, StmtMut *stmt) {
 
 Iterator
 List::iter_begin(void) {
-    return m_value.begin();
+    if (m_range.has_value())
+        return RangeIterator{m_range.value(), 0};
+    return m_value.leak().begin();
 }
 
 Iterator
 List::iter_end(void) {
-    return m_value.end();
+    if (m_range.has_value())
+        return RangeIterator{m_range.value(), m_range->m_size};
+    return m_value.leak().end();
 }
 
 void
@@ -392,11 +490,11 @@ List::equality(Token *op, Obj *other) {
     ASSERT_BINOP_COMPAT(this, other, op);
     auto other_casted = dynamic_cast<List *>(other);
     int res = 0;
-    if (m_value.size() == other_casted->value().size()) {
+    if (this->elems().size() == other_casted->elems().size()) {
         res = 1;
-        for (size_t i = 0; i < m_value.size(); ++i) {
-            auto o1 = this->value()[i];
-            auto o2 = other_casted->value()[i];
+        for (size_t i = 0; i < this->elems().size(); ++i) {
+            auto o1 = this->elems()[i];
+            auto o2 = other_casted->elems()[i];
             if (!type_is_compatable(o1.get(), o2.get())) {
                 res = 0;
                 break;
@@ -448,3 +546,9 @@ List::equality(Token *op, Obj *other) {
     return std::make_shared<Int>(res);
 }
 
+bool
+List::shareable(void) {
+    if (m_range.has_value())
+        return true;
+    return m_value.shareable();
+}
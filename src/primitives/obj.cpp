@@ -205,3 +205,14 @@ Obj::bitshift(Token *op, Obj *other) {
     throw InterpreterException(msg);
 }
 
+bool
+Obj::shareable(void) {
+    switch (this->type()) {
+    case Type::Int:
+    case Type::Float:
+    case Type::Bool:
+    case Type::Char:
+    case Type::Void: return true;
+    default: return false;
+    }
+}
@@ -31,10 +31,16 @@
 
 using namespace earl::value;
 
+std::shared_ptr<Obj>
+Return::instance(void) {
+    static std::shared_ptr<Obj> instance = std::make_shared<Return>();
+    return instance;
+}
+
 /*** OVERRIDES ***/
 Type Return::type(void) const {
     return Type::Return;
 }
 std::shared_ptr<Obj> Return::copy(void) {
-    return std::make_shared<Void>();
+    return Void::instance();
 }
@@ -32,9 +32,12 @@
 
 using namespace earl::value;
 
-Str::Str(std::string value) {
-    m_value = value;
-    m_chars = std::vector<std::shared_ptr<Char>>(value.size(), nullptr);
+Str::Str(std::string value) : m_value(std::move(value)) {
+    m_changed = {};
+    m_iterable = true;
+}
+
+Str::Str(Cow<std::string> value) : m_value(std::move(value)) {
     m_changed = {};
     m_iterable = true;
 }
@@ -46,14 +49,14 @@ Str::Str(std::vector<std::shared_ptr<Char>> chars) {
 void
 Str::update_changed(void) {
     for (int i : m_changed)
-        m_value[i] = m_chars[i]->value();
+        m_value.mut()[i] = chars()[i]->value();
     m_changed.clear();
 }
 
 std::string
 Str::value(void) {
     this->update_changed();
-    return m_value;
+    return m_value.get();
 }
 
 std::shared_ptr<Char>
@@ -66,22 +69,22 @@ Str::nth(Obj *idx, Expr *expr) {
 
     auto index = dynamic_cast<Int *>(idx);
     int I = index->value();
-    if (I < 0 || static_cast<size_t>(I) >= m_value.size()) {
+    if (I < 0 || static_cast<size_t>(I) >= m_value.get().size()) {
         Err::err_wexpr(expr);
         std::string msg = "index "+std::to_string(index->value())+" is out of str range of length "+std::to_string(this->value().size());
         throw InterpreterException(msg);
     }
 
-    if (m_chars.at(I)) {
-        m_value.at(I) = m_chars.at(I)->value();
-        return m_chars.at(I);
+    if (chars().at(I)) {
+        m_value.mut().at(I) = chars().at(I)->value();
+        return chars().at(I);
     }
 
-    auto c = std::make_shared<Char>(m_value.at(I));
-    m_chars.at(I) = std::move(c);
+    auto c = std::make_shared<Char>(m_value.get().at(I));
+    chars().at(I) = std::move(c);
     m_changed.push_back(I);
 
-    return m_chars.at(I);
+    return chars().at(I);
 }
 
 // TODO: Adhere to new string optimization
@@ -125,7 +128,7 @@ Str::substr(Obj *idx1, Obj *idx2, Expr *expr) {
     int S = dynamic_cast<Int *>(idx1)->value();
     int N = dynamic_cast<Int *>(idx2)->value();
 
-    return std::make_shared<Str>(m_value.substr(S, N));
+    return std::make_shared<Str>(m_value.get().substr(S, N));
 }
 
 void
@@ -134,62 +137,59 @@ Str::pop(Obj *idx, Expr *expr) {
     auto *idx1 = dynamic_cast<earl::value::Int *>(idx);
     int I = idx1->value();
     this->update_changed();
-    m_value.erase(m_value.begin() + I);
-    m_chars.erase(m_chars.begin() + I);
+    auto &value = m_value.mut();
+    value.erase(value.begin() + I);
+    if (static_cast<size_t>(I) < m_chars.size())
+        m_chars.erase(m_chars.begin() + I);
 }
 
 std::shared_ptr<Obj>
 Str::back(void) {
     this->update_changed();
 
-    if (m_value.size() == 0)
+    if (m_value.get().size() == 0)
         return std::make_shared<Option>();
 
-    if (m_chars.back()) {
-        m_value.back() = m_chars.back()->value();
-        return m_chars.back();
+    if (chars().back()) {
+        m_value.mut().back() = chars().back()->value();
+        return chars().back();
     }
 
-    auto c = std::make_shared<Char>(m_value.back());
-    m_chars.back() = std::move(c);
-    return m_chars.back();
+    auto c = std::make_shared<Char>(m_value.get().back());
+    chars().back() = std::move(c);
+    return chars().back();
 }
 
 std::shared_ptr<Str>
 Str::rev(void) {
     this->update_changed();
     auto str = std::make_shared<Str>();
-    for (int i = m_value.size()-1; i >= 0; --i)
-        str->append(m_value[i]);
+    for (int i = m_value.get().size()-1; i >= 0; --i)
+        str->append(m_value.get()[i]);
     return str;
 }
 
 void
 Str::append(const std::string &value) {
     for (size_t i = 0; i < value.size(); ++i) {
-        m_value.push_back(value.at(i));
-        m_chars.push_back(nullptr);
+        m_value.mut().push_back(value.at(i));
     }
 }
 
 void
 Str::append(char c) {
-    m_value.push_back(c);
-    m_chars.push_back(nullptr);
+    m_value.mut().push_back(c);
 }
 
 void
 Str::append(Obj *c) {
     if (c->type() == Type::Char) {
         auto cx = dynamic_cast<Char *>(c);
-        m_value.push_back(cx->value());
-        m_chars.push_back(nullptr);
+        m_value.mut().push_back(cx->value());
     }
     else {
         auto s = dynamic_cast<Str *>(c);
-        m_value += s->value();
-        for (int i=0; i < s->value().size(); ++i)
-            m_chars.push_back(nullptr);
+        m_value.mut() += s->value();
     }
 }
 
@@ -213,16 +213,16 @@ Str::filter(Obj *closure, std::shared_ptr<Ctx> &ctx) {
 
     auto acc = std::make_shared<Str>();
 
-    for (int i = 0; i < m_value.size(); ++i) {
+    for (int i = 0; i < m_value.get().size(); ++i) {
         std::shared_ptr<Char> cx = nullptr;
-        if (m_chars.at(i)) {
-            m_value.at(i) = m_chars.at(i)->value();
-            cx = m_chars.at(i);
+        if (chars().at(i)) {
+            m_value.mut().at(i) = chars().at(i)->value();
+            cx = chars().at(i);
         }
         else {
-            auto tmpc = std::make_shared<Char>(m_value.at(i));
-            m_chars.at(i) = std::move(tmpc);
-            cx = m_chars.at(i);
+            auto tmpc = std::make_shared<Char>(m_value.get().at(i));
+            chars().at(i) = std::move(tmpc);
+            cx = chars().at(i);
             m_changed.push_back(i);
         }
         std::vector<std::shared_ptr<Obj>> values = {cx};
@@ -236,11 +236,11 @@ Str::filter(Obj *closure, std::shared_ptr<Ctx> &ctx) {
 
 std::shared_ptr<Bool>
 Str::contains(Char *value) {
-    for (size_t i = 0; i < m_value.size(); ++i) {
-        if (m_chars.at(i) && m_chars.at(i)->value() != m_value.at(i))
-            m_value.at(i) = m_chars.at(i)->value();
+    for (size_t i = 0; i < m_value.get().size(); ++i) {
+        if (chars().at(i) && chars().at(i)->value() != m_value.get().at(i))
+            m_value.mut().at(i) = chars().at(i)->value();
 
-        if (m_value.at(i) == value->value())
+        if (m_value.get().at(i) == value->value())
             return std::make_shared<Bool>(true);
     }
     return std::make_shared<Bool>(false);
@@ -250,16 +250,16 @@ void
 Str::foreach(Obj *closure, std::shared_ptr<Ctx> &ctx) {
     this->update_changed();
     Closure *cl = dynamic_cast<Closure *>(closure);
-    for (size_t i = 0; i < m_value.size(); ++i) {
+    for (size_t i = 0; i < m_value.get().size(); ++i) {
         std::shared_ptr<Char> cx = nullptr;
-        if (m_chars.at(i)) {
-            m_value.at(i) = m_chars.at(i)->value();
-            cx = m_chars.at(i);
+        if (chars().at(i)) {
+            m_value.mut().at(i) = chars().at(i)->value();
+            cx = chars().at(i);
         }
         else {
-            auto tmpc = std::make_shared<Char>(m_value.at(i));
-            m_chars.at(i) = std::move(tmpc);
-            cx = m_chars.at(i);
+            auto tmpc = std::make_shared<Char>(m_value.get().at(i));
+            chars().at(i) = std::move(tmpc);
+            cx = chars().at(i);
             m_changed.push_back(i);
         }
         std::vector<std::shared_ptr<Obj>> values = {cx};
@@ -296,13 +296,13 @@ Str::binop(Token *op, Obj *other) {
 
 bool
 Str::boolean(void) {
-    return m_value.size() > 0;
+    return m_value.get().size() > 0;
 }
 
 std::vector<std::shared_ptr<Char>>
 Str::value_as_earlchar(void) {
     std::vector<std::shared_ptr<Char>> values = {};
-    std::for_each(m_value.begin(), m_value.end(), [&](char c){
+    std::for_each(m_value.get().begin(), m_value.get().end(), [&](char c){
         auto cx = std::make_shared<Char>(c);
         values.push_back(std::move(cx));
     });
@@ -314,14 +314,14 @@ Str::__get_elem(size_t idx) {
     this->update_changed();
     int I = idx;
     std::shared_ptr<Char> c = nullptr;
-    if (m_chars.at(I)) {
-        m_value.at(I) = m_chars.at(I)->value();
-        c = m_chars.at(I);
+    if (chars().at(I)) {
+        m_value.mut().at(I) = chars().at(I)->value();
+        c = chars().at(I);
     }
     else {
-        auto tmpc = std::make_shared<Char>(m_value.at(I));
-        m_chars.at(I) = std::move(tmpc);
-        c = m_chars.at(I);
+        auto tmpc = std::make_shared<Char>(m_value.get().at(I));
+        chars().at(I) = std::move(tmpc);
+        c = chars().at(I);
         m_changed.push_back(I);
     }
     return c;
@@ -333,14 +333,14 @@ Str::mutate(Obj *other, StmtMut *stmt) {
     ASSERT_CONSTNESS(this, stmt);
 
     Str *otherstr = dynamic_cast<Str *>(other);
-    m_value = otherstr->m_value;
+    m_value = otherstr->m_value.share();
     m_chars = otherstr->m_chars;
 }
 
 std::shared_ptr<Obj>
 Str::copy(void) {
     this->update_changed();
-    return std::make_shared<Str>(m_value);
+    return std::make_shared<Str>(m_value.share());
 }
 
 bool
@@ -376,10 +376,10 @@ Str::spec_mutate(Token *op, Obj *other, StmtMut *stmt) {
 
 Iterator
 Str::iter_begin(void) {
-    auto it = m_chars.begin();
+    auto it = chars().begin();
 
     if (!*it) {
-        auto c = std::make_shared<Char>(m_value.at(0));
+        auto c = std::make_shared<Char>(m_value.get().at(0));
         *it = std::move(c);
         m_changed.push_back(0);
     }
@@ -389,7 +389,7 @@ Str::iter_begin(void) {
 
 Iterator
 Str::iter_end(void) {
-    return m_chars.end();
+    return chars().end();
 }
 
 void
@@ -400,13 +400,13 @@ Str::iter_next(Iterator &it) {
         if constexpr (std::is_same_v<IteratorType, std::vector<std::shared_ptr<Char>>::iterator>) {
             std::advance(iter, 1);
 
-            if (iter == m_chars.end())
+            if (iter == chars().end())
                 return;
 
-            size_t index = std::distance(m_chars.begin(), iter);
+            size_t index = std::distance(chars().begin(), iter);
 
-            if (index < m_value.size()) {
-                auto c = std::make_shared<Char>(m_value.at(index));
+            if (index < m_value.get().size()) {
+                auto c = std::make_shared<Char>(m_value.get().at(index));
                 *iter = std::move(c);
                 m_changed.push_back(index);
             }
@@ -453,3 +453,18 @@ Str::equality(Token *op, Obj *other) {
     }
     return nullptr; // unreachable
 }
+
+bool
+Str::shareable(void) {
+    for (auto &c : m_chars)
+        if (c && c.use_count() > 1)
+            return false;
+    return true;
+}
+
+std::vector<std::shared_ptr<Char>> &
+Str::chars(void) {
+    if (m_chars.size() < m_value.get().size())
+        m_chars.resize(m_value.get().size(), nullptr);
+    return m_chars;
+}
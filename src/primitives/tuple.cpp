@@ -32,13 +32,23 @@
 
 using namespace earl::value;
 
-Tuple::Tuple(std::vector<std::shared_ptr<Obj>> values) : m_values(values) {
+// Copies of a tuple share its elements, so the storage never needs a deep copy.
+Tuple::Tuple(std::vector<std::shared_ptr<Obj>> values) : m_values(std::move(values), /*deep=*/false) {
+    m_iterable = true;
+}
+
+Tuple::Tuple(Cow<std::vector<std::shared_ptr<Obj>>> values) : m_values(std::move(values)) {
     m_iterable = true;
 }
 
 std::vector<std::shared_ptr<Obj>> &
 Tuple::value(void) {
-    return m_values;
+    return m_values.mut();
+}
+
+const std::vector<std::shared_ptr<Obj>> &
+Tuple::elems(void) const {
+    return m_values.get();
 }
 
 std::shared_ptr<Obj>
@@ -63,9 +73,9 @@ Tuple::nth(Obj *idx, Expr *expr) {
 
 std::shared_ptr<Obj>
 Tuple::back(void) {
-    if (m_values.size() == 0)
+    if (m_values.get().size() == 0)
         return std::make_shared<Option>();
-    return m_values.back()->copy();
+    return m_values.get().back()->copy();
 }
 
 std::shared_ptr<Tuple>
@@ -75,31 +85,31 @@ Tuple::filter(Obj *closure, std::shared_ptr<Ctx> &ctx) {
     auto copy = std::make_shared<Tuple>();
     std::vector<std::shared_ptr<Obj>> keep_values = {};
 
-    for (size_t i = 0; i < m_values.size(); ++i) {
-        std::vector<std::shared_ptr<Obj>> values = {m_values.at(i)};
+    for (size_t i = 0; i < m_values.get().size(); ++i) {
+        std::vector<std::shared_ptr<Obj>> values = {m_values.get().at(i)};
         std::shared_ptr<Obj> filter_result = cl->call(values, ctx);
         assert(filter_result->type() == Type::Bool);
         if (dynamic_cast<Bool *>(filter_result.get())->boolean())
-            keep_values.push_back(m_values.at(i)->copy());
+            keep_values.push_back(m_values.get().at(i)->copy());
     }
 
-    std::for_each(keep_values.begin(), keep_values.end(), [&](auto &v) {copy->m_values.push_back(v);});
+    std::for_each(keep_values.begin(), keep_values.end(), [&](auto &v) {copy->m_values.mut().push_back(v);});
     return copy;
 }
 
 void
 Tuple::foreach(Obj *closure, std::shared_ptr<Ctx> &ctx) {
     Closure *cl = dynamic_cast<Closure *>(closure);
-    for (size_t i = 0; i < m_values.size(); ++i) {
-        std::vector<std::shared_ptr<Obj>> values = {m_values[i]};
+    for (size_t i = 0; i < m_values.get().size(); ++i) {
+        std::vector<std::shared_ptr<Obj>> values = {m_values.get()[i]};
         cl->call(values, ctx);
     }
 }
 
 std::shared_ptr<Bool>
 Tuple::contains(Obj *value) {
-    for (size_t i = 0; i < m_values.size(); ++i)
-        if (m_values.at(i)->eq(value))
+    for (size_t i = 0; i < m_values.get().size(); ++i)
+        if (m_values.get().at(i)->eq(value))
             return std::make_shared<Bool>(true);
     return std::make_shared<Bool>(false);
 }
@@ -107,8 +117,8 @@ Tuple::contains(Obj *value) {
 std::shared_ptr<Tuple>
 Tuple::rev(void) {
     auto tuple = std::make_shared<Tuple>();
-    for (int i = m_values.size()-1; i >= 0; --i)
-        tuple->m_values.push_back(m_values.at(i)->copy());
+    for (int i = m_values.get().size()-1; i >= 0; --i)
+        tuple->m_values.mut().push_back(m_values.get().at(i)->copy());
     return tuple;
 }
 
@@ -126,15 +136,15 @@ Tuple::binop(Token *op, Obj *other) {
     switch (op->type()) {
     case TokenType::Plus: {
         std::vector<std::shared_ptr<Obj>> values = {};
-        std::for_each(m_values.begin(), m_values.end(), [&](auto &v){values.push_back(v);});
-        std::for_each(other_tuple->value().begin(), other_tuple->value().end(), [&](auto &v){values.push_back(v);});
+        std::for_each(m_values.get().begin(), m_values.get().end(), [&](auto &v){values.push_back(v);});
+        std::for_each(other_tuple->elems().begin(), other_tuple->elems().end(), [&](auto &v){values.push_back(v);});
         return std::make_shared<Tuple>(values);
     } break;
     case TokenType::Double_Equals: {
-        if (m_values.size() != other_tuple->value().size())
+        if (m_values.get().size() != other_tuple->elems().size())
             return std::make_shared<Bool>(false);
-        for (size_t i = 0; i < m_values.size(); ++i) {
-            if (!m_values[i]->eq(other_tuple->value()[i].get()))
+        for (size_t i = 0; i < m_values.get().size(); ++i) {
+            if (!m_values.get()[i]->eq(other_tuple->elems()[i].get()))
                 return std::make_shared<Bool>(false);
         }
         return std::make_shared<Bool>(true);
@@ -151,14 +161,12 @@ Tuple::binop(Token *op, Obj *other) {
 
 bool
 Tuple::boolean(void) {
-    return m_values.size() > 0;
+    return m_values.get().size() > 0;
 }
 
 std::shared_ptr<Obj>
 Tuple::copy(void) {
-    std::vector<std::shared_ptr<Obj>> values = {};
-    std::for_each(m_values.begin(), m_values.end(), [&](auto &v){values.push_back(v);});
-    return std::make_shared<Tuple>(values);
+    return std::make_shared<Tuple>(m_values.share());
 }
 
 bool
@@ -167,11 +175,11 @@ Tuple::eq(Obj *other) {
         return false;
 
     auto other_tuple = dynamic_cast<Tuple *>(other);
-    if (m_values.size() != other_tuple->value().size())
+    if (m_values.get().size() != other_tuple->elems().size())
         return false;
 
-    for (size_t i = 0; i < m_values.size(); ++i) {
-        if (!m_values[i]->eq(other_tuple->value()[i].get()))
+    for (size_t i = 0; i < m_values.get().size(); ++i) {
+        if (!m_values.get()[i]->eq(other_tuple->elems()[i].get()))
             return false;
     }
     return true;
@@ -180,9 +188,9 @@ Tuple::eq(Obj *other) {
 std::string
 Tuple::to_cxxstring(void) {
     std::string res = "(";
-    for (size_t i = 0; i < m_values.size(); ++i) {
-        res += m_values.at(i)->to_cxxstring();
-        if (i != m_values.size()-1)
+    for (size_t i = 0; i < m_values.get().size(); ++i) {
+        res += m_values.get().at(i)->to_cxxstring();
+        if (i != m_values.get().size()-1)
             res += ", ";
     }
     res += ")";
@@ -191,12 +199,12 @@ Tuple::to_cxxstring(void) {
 
 Iterator
 Tuple::iter_begin(void) {
-    return m_values.begin();
+    return m_values.mut().begin();
 }
 
 Iterator
 Tuple::iter_end(void) {
-    return m_values.end();
+    return m_values.mut().end();
 }
 
 void
@@ -211,8 +219,8 @@ Tuple::add(Token *op, Obj *other) {
     ASSERT_BINOP_COMPAT(this, other, op);
     auto other_tuple = dynamic_cast<Tuple *>(other);
     std::vector<std::shared_ptr<Obj>> values = {};
-    std::for_each(m_values.begin(), m_values.end(), [&](auto &v){values.push_back(v);});
-    std::for_each(other_tuple->value().begin(), other_tuple->value().end(), [&](auto &v){values.push_back(v);});
+    std::for_each(m_values.get().begin(), m_values.get().end(), [&](auto &v){values.push_back(v);});
+    std::for_each(other_tuple->elems().begin(), other_tuple->elems().end(), [&](auto &v){values.push_back(v);});
     return std::make_shared<Tuple>(values);
 }
 
@@ -222,10 +230,10 @@ Tuple::equality(Token *op, Obj *other) {
     auto other_tuple = dynamic_cast<Tuple *>(other);
     switch (op->type()) {
     case TokenType::Double_Equals: {
-        if (m_values.size() != other_tuple->value().size())
+        if (m_values.get().size() != other_tuple->elems().size())
             return std::make_shared<Bool>(false);
-        for (size_t i = 0; i < m_values.size(); ++i) {
-            if (!m_values[i]->eq(other_tuple->value()[i].get()))
+        for (size_t i = 0; i < m_values.get().size(); ++i) {
+            if (!m_values.get()[i]->eq(other_tuple->elems()[i].get()))
                 return std::make_shared<Bool>(false);
         }
         return std::make_shared<Bool>(true);
@@ -242,4 +250,7 @@ Tuple::equality(Token *op, Obj *other) {
     return nullptr; // unreachable
 }
 
-
+bool
+Tuple::shareable(void) {
+    return true;
+}
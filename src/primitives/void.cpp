@@ -30,6 +30,16 @@
 
 using namespace earl::value;
 
+std::shared_ptr<Obj>
+Void::instance(void) {
+    static std::shared_ptr<Obj> instance = std::make_shared<Void>();
+    return instance;
+}
+
+// The unit value is shared, so it can never become constant.
+void
+Void::set_const(void) {}
+
 Type
 Void::type(void) const {
     return Type::Void;
@@ -54,7 +64,7 @@ Void::boolean(void) {
 
 std::shared_ptr<Obj>
 Void::copy(void) {
-    return std::make_shared<Void>();
+    return Void::instance();
 }
 
 bool
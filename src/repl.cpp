@@ -45,6 +45,7 @@
 #include "common.hpp"
 #include "earl.hpp"
 #include "lexer.hpp"
+#include "resolver.hpp"
 
 #define EARL_REPL_HISTORY_FILENAME ".earl_history"
 #define REPL_HISTORY_MAX_FILESZ 1024 * 1024
@@ -502,6 +503,9 @@ reset(std::shared_ptr<Ctx> &ctx) {
     std::cout << "]" << std::endl;
     noc();
 
+    // Imported modules are shared between imports, so forget
+    // them too, or re-importing an edited module gets the old one.
+    Interpreter::forget_imports();
     ctx = std::make_shared<WorldCtx>();
 }
 
@@ -548,7 +552,6 @@ repl::run(void) {
 
     repled::RawInput ri;
 
-    std::vector<std::string> keywords = COMMON_EARLKW_ASCPL;
     std::vector<std::string> types    = {};
     std::string comment               = COMMON_EARL_COMMENT;
 
@@ -600,7 +603,7 @@ repl::run(void) {
 
         std::unique_ptr<Program> program = nullptr;
         std::unique_ptr<Lexer> lexer = nullptr;
-        lexer = lex_file(combined, "", keywords, types, comment);
+        lexer = lex_file(combined, "", types, comment);
 
         try {
             program = Parser::parse_program(*lexer.get(), "EARL-Builtin-REPLv" VERSION);
@@ -609,6 +612,10 @@ repl::run(void) {
             continue;
         }
 
+        // The functions that it defines need their frames sized, its
+        // top level is never in the world frame and goes by name.
+        Resolver::resolve(program.get());
+
         WorldCtx *wctx = dynamic_cast<WorldCtx*>(ctx.get());
         wctx->add_repl_lexer(std::move(lexer));
         wctx->add_repl_program(std::move(program));
@@ -0,0 +1,347 @@
+/** @file */
+
+// MIT License
+
+// Copyright (c) 2023 malloc-nbytes
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cassert>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "resolver.hpp"
+#include "ast.hpp"
+
+// Marks a name that is bound by something the resolver does
+// not assign slots for, so that it shadows outer locals.
+#define RESOLVER_DYNAMIC -1
+
+struct FrameScopes {
+    const void *owner;
+    std::vector<std::unordered_map<std::string, int>> scopes;
+    int next;
+};
+
+static std::vector<FrameScopes> frames = {};
+
+static void resolve_stmt(Stmt *stmt);
+static void resolve_expr(Expr *expr);
+static void resolve_block(StmtBlock *block);
+
+static void
+push_frame(const void *owner) {
+    frames.push_back(FrameScopes{owner, {}, 0});
+    frames.back().scopes.emplace_back();
+}
+
+static size_t
+pop_frame(void) {
+    size_t size = static_cast<size_t>(frames.back().next);
+    frames.pop_back();
+    return size;
+}
+
+static void
+push_scope(void) {
+    frames.back().scopes.emplace_back();
+}
+
+static void
+pop_scope(void) {
+    frames.back().scopes.pop_back();
+}
+
+static Slot
+declare(const std::string &id) {
+    if (id == "_")
+        return Slot{};
+    FrameScopes &frame = frames.back();
+    int index = frame.next++;
+    frame.scopes.back()[id] = index;
+    return Slot{frame.owner, index};
+}
+
+// Function arguments are loaded by their index (see
+// earl::function::Obj::load_parameters), so a `_` one still
+// takes up a slot. Closures leave `_` out of their arguments.
+static void
+declare_param(const std::string &id) {
+    FrameScopes &frame = frames.back();
+    int index = frame.next++;
+    if (id != "_")
+        frame.scopes.back()[id] = index;
+}
+
+static void
+declare_dynamic(const std::string &id) {
+    frames.back().scopes.back()[id] = RESOLVER_DYNAMIC;
+}
+
+static Slot
+lookup(const std::string &id) {
+    FrameScopes &frame = frames.back();
+    for (auto it = frame.scopes.rbegin(); it != frame.scopes.rend(); ++it) {
+        auto found = it->find(id);
+        if (found == it->end())
+            continue;
+        if (found->second == RESOLVER_DYNAMIC)
+            return Slot{};
+        return Slot{frame.owner, found->second};
+    }
+    return Slot{};
+}
+
+// The identifiers in `some(x)` patterns are bound at runtime.
+static void
+declare_match_bindings(Expr *expr) {
+    if (expr->get_type() != ExprType::Term)
+        return;
+    auto term = dynamic_cast<ExprTerm *>(expr);
+    if (term->get_term_type() != ExprTermType::Func_Call)
+        return;
+    for (auto &param : dynamic_cast<ExprFuncCall *>(term)->m_params) {
+        if (param->get_type() == ExprType::Term
+            && dynamic_cast<ExprTerm *>(param.get())->get_term_type() == ExprTermType::Ident)
+            declare_dynamic(dynamic_cast<ExprIdent *>(param.get())->m_tok->lexeme());
+    }
+}
+
+static void
+resolve_funccall_params(ExprFuncCall *expr) {
+    for (auto &param : expr->m_params)
+        resolve_expr(param.get());
+}
+
+static void
+resolve_closure(ExprClosure *expr) {
+    push_frame(expr->m_block.get());
+    for (auto &arg : expr->m_args)
+        (void)declare(arg.first->lexeme());
+    resolve_block(expr->m_block.get());
+    expr->m_block->m_frame_size = pop_frame();
+}
+
+static void
+resolve_expr_term(ExprTerm *expr) {
+    switch (expr->get_term_type()) {
+    case ExprTermType::Ident: {
+        auto ident = dynamic_cast<ExprIdent *>(expr);
+        ident->m_slot = lookup(ident->m_tok->lexeme());
+    } break;
+    case ExprTermType::Func_Call: {
+        auto funccall = dynamic_cast<ExprFuncCall *>(expr);
+        resolve_expr(funccall->m_left.get());
+        resolve_funccall_params(funccall);
+    } break;
+    case ExprTermType::List_Literal: {
+        for (auto &elem : dynamic_cast<ExprListLit *>(expr)->m_elems)
+            resolve_expr(elem.get());
+    } break;
+    case ExprTermType::Range: {
+        auto range = dynamic_cast<ExprRange *>(expr);
+        resolve_expr(range->m_start.get());
+        resolve_expr(range->m_end.get());
+    } break;
+    case ExprTermType::Slice: {
+        auto slice = dynamic_cast<ExprSlice *>(expr);
+        if (slice->m_start.has_value())
+            resolve_expr(slice->m_start.value().get());
+        if (slice->m_end.has_value())
+            resolve_expr(slice->m_end.value().get());
+    } break;
+    case ExprTermType::Get: {
+        // The right hand side is a member, only its arguments are ours.
+        auto get = dynamic_cast<ExprGet *>(expr);
+        resolve_expr(get->m_left.get());
+        if (std::holds_alternative<std::unique_ptr<ExprFuncCall>>(get->m_right))
+            resolve_funccall_params(std::get<std::unique_ptr<ExprFuncCall>>(get->m_right).get());
+    } break;
+    case ExprTermType::Mod_Access: {
+        auto mod_access = dynamic_cast<ExprModAccess *>(expr);
+        if (std::holds_alternative<std::unique_ptr<ExprFuncCall>>(mod_access->m_right))
+            resolve_funccall_params(std::get<std::unique_ptr<ExprFuncCall>>(mod_access->m_right).get());
+    } break;
+    case ExprTermType::Array_Access: {
+        auto access = dynamic_cast<ExprArrayAccess *>(expr);
+        resolve_expr(access->m_left.get());
+        resolve_expr(access->m_expr.get());
+    } break;
+    case ExprTermType::Closure: {
+        resolve_closure(dynamic_cast<ExprClosure *>(expr));
+    } break;
+    case ExprTermType::Tuple: {
+        for (auto &e : dynamic_cast<ExprTuple *>(expr)->m_exprs)
+            resolve_expr(e.get());
+    } break;
+    case ExprTermType::Dict: {
+        for (auto &kv : dynamic_cast<ExprDict *>(expr)->m_values) {
+            resolve_expr(kv.first.get());
+            resolve_expr(kv.second.get());
+        }
+    } break;
+    case ExprTermType::FStr: {
+        for (auto &part : dynamic_cast<ExprFStr *>(expr)->m_parts)
+            if (std::holds_alternative<std::unique_ptr<Expr>>(part))
+                resolve_expr(std::get<std::unique_ptr<Expr>>(part).get());
+    } break;
+    default: break;
+    }
+}
+
+static void
+resolve_expr(Expr *expr) {
+    switch (expr->get_type()) {
+    case ExprType::Term: {
+        resolve_expr_term(dynamic_cast<ExprTerm *>(expr));
+    } break;
+    case ExprType::Binary: {
+        auto bin = dynamic_cast<ExprBinary *>(expr);
+        resolve_expr(bin->m_lhs.get());
+        resolve_expr(bin->m_rhs.get());
+    } break;
+    case ExprType::Unary: {
+        resolve_expr(dynamic_cast<ExprUnary *>(expr)->m_expr.get());
+    } break;
+    default: assert(false && "unreachable");
+    }
+}
+
+static void
+resolve_block(StmtBlock *block) {
+    push_scope();
+    for (auto &stmt : block->m_stmts)
+        resolve_stmt(stmt.get());
+    pop_scope();
+}
+
+static void
+resolve_def(StmtDef *stmt) {
+    push_frame(stmt->m_block.get());
+    for (auto &arg : stmt->m_args)
+        declare_param(arg.first.first->lexeme());
+    resolve_block(stmt->m_block.get());
+    stmt->m_block->m_frame_size = pop_frame();
+}
+
+static void
+resolve_stmt(Stmt *stmt) {
+    switch (stmt->stmt_type()) {
+    case StmtType::Def: {
+        resolve_def(dynamic_cast<StmtDef *>(stmt));
+    } break;
+    case StmtType::Let: {
+        auto let = dynamic_cast<StmtLet *>(stmt);
+        resolve_expr(let->m_expr.get());
+        let->m_slots.clear();
+        for (auto &id : let->m_ids)
+            let->m_slots.push_back(declare(id->lexeme()));
+    } break;
+    case StmtType::Block: {
+        resolve_block(dynamic_cast<StmtBlock *>(stmt));
+    } break;
+    case StmtType::Mut: {
+        auto mut = dynamic_cast<StmtMut *>(stmt);
+        resolve_expr(mut->m_left.get());
+        resolve_expr(mut->m_right.get());
+    } break;
+    case StmtType::Stmt_Expr: {
+        resolve_expr(dynamic_cast<StmtExpr *>(stmt)->m_expr.get());
+    } break;
+    case StmtType::If: {
+        auto if_ = dynamic_cast<StmtIf *>(stmt);
+        resolve_expr(if_->m_expr.get());
+        resolve_block(if_->m_block.get());
+        if (if_->m_else.has_value())
+            resolve_block(if_->m_else.value().get());
+    } break;
+    case StmtType::Return: {
+        auto ret = dynamic_cast<StmtReturn *>(stmt);
+        if (ret->m_expr.has_value())
+            resolve_expr(ret->m_expr.value().get());
+    } break;
+    case StmtType::While: {
+        auto while_ = dynamic_cast<StmtWhile *>(stmt);
+        resolve_expr(while_->m_expr.get());
+        resolve_block(while_->m_block.get());
+    } break;
+    case StmtType::Loop: {
+        resolve_block(dynamic_cast<StmtLoop *>(stmt)->m_block.get());
+    } break;
+    case StmtType::For: {
+        auto for_ = dynamic_cast<StmtFor *>(stmt);
+        resolve_expr(for_->m_start.get());
+        resolve_expr(for_->m_end.get());
+        push_scope();
+        for_->m_slot = declare(for_->m_enumerator->lexeme());
+        resolve_block(for_->m_block.get());
+        pop_scope();
+    } break;
+    case StmtType::Foreach: {
+        auto foreach = dynamic_cast<StmtForeach *>(stmt);
+        resolve_expr(foreach->m_expr.get());
+        push_scope();
+        foreach->m_slots.clear();
+        for (auto &enumerator : foreach->m_enumerators)
+            foreach->m_slots.push_back(declare(enumerator->lexeme()));
+        resolve_block(foreach->m_block.get());
+        pop_scope();
+    } break;
+    case StmtType::Class: {
+        // Members live in the class context, only the methods get frames.
+        for (auto &method : dynamic_cast<StmtClass *>(stmt)->m_methods)
+            resolve_def(method.get());
+    } break;
+    case StmtType::Match: {
+        auto match = dynamic_cast<StmtMatch *>(stmt);
+        resolve_expr(match->m_expr.get());
+        for (auto &branch : match->m_branches) {
+            push_scope();
+            for (auto &expr : branch->m_expr) {
+                declare_match_bindings(expr.get());
+                resolve_expr(expr.get());
+            }
+            if (branch->m_when.has_value())
+                resolve_expr(branch->m_when.value().get());
+            resolve_block(branch->m_block.get());
+            pop_scope();
+        }
+    } break;
+    case StmtType::Bash_Literal: {
+        resolve_expr(dynamic_cast<StmtBashLiteral *>(stmt)->m_expr.get());
+    } break;
+    case StmtType::Import:
+    case StmtType::Mod:
+    case StmtType::Enum:
+    case StmtType::Break:
+    case StmtType::Continue:
+        break;
+    default: assert(false && "unreachable");
+    }
+}
+
+void
+Resolver::resolve(Program *program) {
+    push_frame(program);
+    for (auto &stmt : program->m_stmts)
+        resolve_stmt(stmt.get());
+    program->m_frame_size = pop_frame();
+    assert(frames.size() == 0);
+}
@@ -4,3 +4,21 @@ set -xe
 
 earl testmgr.earl -- gen true true
 earl < cmds.txt
+earl test.earl --vm
+earl test.earl -O1
+earl test.earl --jit
+
+# Programs in to-cpp/ are compiled with --to-cpp and must print the same
+# as the interpreter. Given a build directory (as `make test` does), its
+# earl is used, which links against that build tree's libearlrt.a.
+earlc=earl
+if [ -n "$1" ]; then
+    earlc="$1/earl"
+fi
+tmp=$(mktemp -d)
+trap 'rm -rf "$tmp"' EXIT
+for prog in to-cpp/*.earl; do
+    name=$(basename "$prog" .earl)
+    "$earlc" "$prog" --to-cpp binary="$tmp/$name"
+    diff <("$earlc" "$prog") <("$tmp/$name")
+done
@@ -25,6 +25,9 @@
 #include <iostream>
 #include <algorithm>
 #include <string>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
 
 #include <stdio.h>
 #include <assert.h>
@@ -106,16 +109,47 @@ tokentype_to_str(TokenType type) {
     return nullptr;
 }
 
+// Every filepath that a token has come from. The prefetch
+// workers lex concurrently, hence the lock.
+struct FpTable {
+    std::mutex m_lock;
+    std::deque<std::string> m_fps;
+    std::unordered_map<std::string, uint32_t> m_ids;
+};
+
+static FpTable &
+fp_table(void) {
+    static FpTable *table = new FpTable();
+    return *table;
+}
+
+uint32_t
+token_intern_fp(const std::string &fp) {
+    FpTable &table = fp_table();
+    std::lock_guard<std::mutex> guard(table.m_lock);
+    auto it = table.m_ids.find(fp);
+    if (it != table.m_ids.end())
+        return it->second;
+    uint32_t id = static_cast<uint32_t>(table.m_fps.size());
+    table.m_fps.push_back(fp);
+    table.m_ids.emplace(fp, id);
+    return id;
+}
+
+Token::Token(std::string lexeme, TokenType type, size_t row, size_t col, uint32_t file)
+    : m_lexeme(std::move(lexeme)), m_type(type), m_row(row), m_col(col), m_file(file), m_next(nullptr) {}
+
 Token::Token(std::string lexeme, TokenType type, size_t row, size_t col, std::string fp)
-    : m_lexeme(std::move(lexeme)), m_type(type), m_row(row), m_col(col), m_fp(fp) {}
+    : Token(std::move(lexeme), type, row, col, token_intern_fp(fp)) {}
 
-Token::Token(char *start, size_t len, TokenType type, size_t row, size_t col, std::string &fp)
-    : m_type(type), m_row(row), m_col(col), m_fp(std::move(fp)), m_next(nullptr) {
-    std::for_each(start, start+len, [&](char c) {this->m_lexeme.push_back(c);});
+Token::Token(char *start, size_t len, TokenType type, size_t row, size_t col, uint32_t file)
+    : m_type(type), m_row(row), m_col(col), m_file(file), m_next(nullptr) {
+    if (len != 0)
+        m_lexeme.assign(start, len);
 }
 
 std::shared_ptr<Token>
-token_alloc(Lexer &lexer, char *start, size_t len, TokenType type, size_t row, size_t col, std::string fp) {
+token_alloc(Lexer &lexer, char *start, size_t len, TokenType type, size_t row, size_t col, uint32_t file) {
     (void)lexer;
     if (type == TokenType::Strlit || type == TokenType::Bashlit) {
         std::string s = "";
@@ -141,7 +175,7 @@ token_alloc(Lexer &lexer, char *start, size_t len, TokenType type, size_t row, s
                 ++i;
             }
             else if (*(start+i) == '\\' && *(start+i+1)) {
-                auto err = std::make_shared<Token>(start, len, type, row, col, fp);
+                auto err = std::make_shared<Token>(start, len, type, row, col, file);
                 const std::string msg = "unknown escape sequence: `\\" + std::string(1, *(start+i+1));
                 Err::err_wtok(err.get());
                 throw ParserException(msg);
@@ -150,9 +184,9 @@ token_alloc(Lexer &lexer, char *start, size_t len, TokenType type, size_t row, s
                 s += *(start+i);
             }
         }
-        return std::make_shared<Token>(s, type, row, col, fp);
+        return std::make_shared<Token>(std::move(s), type, row, col, file);
     }
-    return std::make_shared<Token>(start, len, type, row, col, fp);
+    return std::make_shared<Token>(start, len, type, row, col, file);
 }
 
 std::string &
@@ -165,6 +199,13 @@ Token::type(void) const {
     return m_type;
 }
 
+const std::string &
+Token::fp(void) const {
+    FpTable &table = fp_table();
+    std::lock_guard<std::mutex> guard(table.m_lock);
+    return table.m_fps[m_file];
+}
+
 void
 token_dump_until_eol(Token *tok, int padding) {
     for (int i = 0; i < padding; ++i)
@@ -176,7 +217,7 @@ token_dump_until_eol(Token *tok, int padding) {
             std::cout << ' ';
         }
 
-        tok = tok->m_next.get();
+        tok = tok->m_next;
     }
 
     std::cout << std::endl;
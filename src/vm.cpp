@@ -0,0 +1,972 @@
+/** @file */
+
+// MIT License
+
+// Copyright (c) 2023 malloc-nbytes
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "vm.hpp"
+#include "interpreter.hpp"
+#include "err.hpp"
+#include "ast.hpp"
+#include "ctx.hpp"
+#include "common.hpp"
+#include "earl.hpp"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define VM_COMPUTED_GOTO
+#endif
+
+#define VM_NO_LOOP UINT32_MAX
+
+// Bits for the `b` operand of Opcode::Expr.
+#define VM_EXPR_UNPACK_REF 1 << 0
+#define VM_EXPR_LET        1 << 1
+
+// Opcode::Return with the value already in the result (set by Opcode::Stmt)
+#define VM_RETURN_RESULT 2
+
+using namespace VM;
+
+struct Compiler {
+    Compiler(std::shared_ptr<Ctx> &ctx) : m_chunk(std::make_shared<Chunk>()), m_ctx(ctx) {}
+
+    std::shared_ptr<Chunk> m_chunk;
+    std::shared_ptr<Ctx> &m_ctx;
+    std::vector<uint32_t> m_labels;
+    std::vector<uint32_t> m_loops;
+    uint32_t m_scope_depth = 0;
+    uint32_t m_for_depth = 0;
+    uint32_t m_exit = 0;
+
+    uint32_t
+    label(void) {
+        m_labels.push_back(UINT32_MAX);
+        return static_cast<uint32_t>(m_labels.size()-1);
+    }
+
+    void
+    bind(uint32_t label) {
+        m_labels[label] = static_cast<uint32_t>(m_chunk->code.size());
+    }
+
+    void
+    emit(Opcode op, uint32_t a = 0, uint32_t b = 0, void *p = nullptr) {
+        m_chunk->code.push_back(Instr{op, a, b, p});
+    }
+
+    uint32_t
+    innermost_loop(void) {
+        return m_loops.size() == 0 ? VM_NO_LOOP : m_loops.back();
+    }
+
+    // Replace label ids with the actual instruction offsets.
+    void
+    resolve(void) {
+        for (auto &instr : m_chunk->code) {
+            switch (instr.op) {
+            case Opcode::And:
+            case Opcode::Or:
+            case Opcode::Jump:
+            case Opcode::JumpFalse:
+            case Opcode::ForTest: {
+                instr.a = m_labels[instr.a];
+            } break;
+            case Opcode::Propagate:
+            case Opcode::Return:
+            case Opcode::Signal: {
+                instr.b = m_labels[instr.b];
+            } break;
+            default: break;
+            }
+        }
+        for (auto &loop : m_chunk->loops) {
+            loop.brk = m_labels[loop.brk];
+            loop.cont = m_labels[loop.cont];
+        }
+    }
+
+    // Literals do not depend on the context, so evaluate
+    // them once and copy the value every time it is used.
+    bool
+    try_constant(Expr *expr) {
+        try {
+            Interpreter::ER er = Interpreter::eval_expr(expr, m_ctx, false);
+            if (!er.is_literal() || !er.value)
+                return false;
+            Value value = Value::unboxed(er.value.get());
+            m_chunk->consts.push_back(value.tag == Value::Tag::Obj ? Value(er.value) : value);
+        } catch (...) {
+            return false;
+        }
+        emit(Opcode::Const, static_cast<uint32_t>(m_chunk->consts.size()-1));
+        return true;
+    }
+
+    void
+    compile_expr(Expr *expr, bool eval_ref, bool unpack_ref, uint32_t extra = 0) {
+        switch (expr->get_type()) {
+        case ExprType::Term: {
+            auto term = dynamic_cast<ExprTerm *>(expr);
+            switch (term->get_term_type()) {
+            case ExprTermType::Ident: {
+                if (dynamic_cast<ExprIdent *>(term)->m_tok->lexeme() != "_") {
+                    emit(Opcode::Load, 0, unpack_ref, expr);
+                    return;
+                }
+            } break;
+            case ExprTermType::Int_Literal:
+            case ExprTermType::Str_Literal:
+            case ExprTermType::Char_Literal:
+            case ExprTermType::Float_Literal:
+            case ExprTermType::Bool: {
+                if (try_constant(expr))
+                    return;
+            } break;
+            default: break;
+            }
+        } break;
+        case ExprType::Binary: {
+            auto bin = dynamic_cast<ExprBinary *>(expr);
+            TokenType ty = bin->m_op->type();
+            compile_expr(bin->m_lhs.get(), eval_ref, true);
+            if (ty == TokenType::Double_Ampersand || ty == TokenType::Double_Pipe) {
+                // The tree walker hands back the left ER when short-circuiting,
+                // which copies identifiers when not taken by reference.
+                bool copy = !unpack_ref
+                    && bin->m_lhs->get_type() == ExprType::Term
+                    && dynamic_cast<ExprTerm *>(bin->m_lhs.get())->get_term_type() == ExprTermType::Ident;
+                uint32_t end = label();
+                emit(ty == TokenType::Double_Ampersand ? Opcode::And : Opcode::Or, end, copy);
+                compile_expr(bin->m_rhs.get(), eval_ref, eval_ref);
+                bind(end);
+                return;
+            }
+            compile_expr(bin->m_rhs.get(), eval_ref, eval_ref);
+            emit(Opcode::Binop, 0, 0, bin->m_op.get());
+            return;
+        } break;
+        case ExprType::Unary: {
+            auto unary = dynamic_cast<ExprUnary *>(expr);
+            compile_expr(unary->m_expr.get(), eval_ref, eval_ref);
+            emit(Opcode::Unary, 0, 0, unary->m_op.get());
+            return;
+        } break;
+        default: break;
+        }
+
+        uint32_t b = extra;
+        if (unpack_ref)
+            b |= VM_EXPR_UNPACK_REF;
+        emit(Opcode::Expr, eval_ref, b, expr);
+    }
+
+    void
+    compile_fallback(Stmt *stmt) {
+        emit(Opcode::Stmt, 0, 0, stmt);
+        emit(Opcode::Propagate, innermost_loop(), m_exit);
+    }
+
+    void
+    compile_block(StmtBlock *block) {
+        emit(Opcode::PushScope);
+        ++m_scope_depth;
+        for (auto &stmt : block->m_stmts)
+            compile_stmt(stmt.get());
+        emit(Opcode::PopScope);
+        --m_scope_depth;
+    }
+
+    uint32_t
+    push_loop(uint32_t brk, uint32_t cont) {
+        m_chunk->loops.push_back(LoopInfo{brk, cont, m_scope_depth, m_for_depth});
+        m_loops.push_back(static_cast<uint32_t>(m_chunk->loops.size()-1));
+        return m_loops.back();
+    }
+
+    void
+    compile_signal(bool is_continue) {
+        uint32_t loop = innermost_loop();
+        if (loop == VM_NO_LOOP) {
+            // Let whatever loop is outside of this chunk handle it.
+            emit(Opcode::Signal, is_continue, m_exit);
+            return;
+        }
+        LoopInfo &info = m_chunk->loops[loop];
+        emit(Opcode::Unwind, info.scope_depth, info.for_depth);
+        emit(Opcode::Jump, is_continue ? info.cont : info.brk);
+    }
+
+    void
+    compile_stmt(Stmt *stmt) {
+        switch (stmt->stmt_type()) {
+        case StmtType::Let: {
+            auto let = dynamic_cast<StmtLet *>(stmt);
+            if (let->m_ids.size() != 1) {
+                compile_fallback(stmt);
+                break;
+            }
+            bool ref = (let->m_attrs & static_cast<uint32_t>(Attr::Ref)) != 0;
+            emit(Opcode::LetCheck, 0, 0, stmt);
+            compile_expr(let->m_expr.get(), ref, ref, VM_EXPR_LET);
+            emit(Opcode::Let, 0, 0, stmt);
+        } break;
+        case StmtType::Mut: {
+            auto mut = dynamic_cast<StmtMut *>(stmt);
+            Expr *left = mut->m_left.get();
+            if (left->get_type() == ExprType::Term
+                && dynamic_cast<ExprTerm *>(left)->get_term_type() == ExprTermType::Ident
+                && dynamic_cast<ExprIdent *>(left)->m_tok->lexeme() != "_")
+                emit(Opcode::Load, 0, /*ref=*/1, left);
+            else
+                emit(Opcode::LValue, 0, 0, stmt);
+            compile_expr(mut->m_right.get(), false, false);
+            emit(Opcode::Mut, 0, 0, stmt);
+        } break;
+        case StmtType::Stmt_Expr: {
+            compile_expr(dynamic_cast<StmtExpr *>(stmt)->m_expr.get(), false, false);
+            emit(Opcode::ExprStmt, 0, 0, stmt);
+            emit(Opcode::Propagate, innermost_loop(), m_exit);
+        } break;
+        case StmtType::Block: {
+            compile_block(dynamic_cast<StmtBlock *>(stmt));
+        } break;
+        case StmtType::If: {
+            auto if_ = dynamic_cast<StmtIf *>(stmt);
+            uint32_t else_ = label();
+            compile_expr(if_->m_expr.get(), false, true);
+            emit(Opcode::JumpFalse, else_);
+            compile_block(if_->m_block.get());
+            if (if_->m_else.has_value()) {
+                uint32_t end = label();
+                emit(Opcode::Jump, end);
+                bind(else_);
+                compile_block(if_->m_else.value().get());
+                bind(end);
+            }
+            else
+                bind(else_);
+        } break;
+        case StmtType::Return: {
+            auto ret = dynamic_cast<StmtReturn *>(stmt);
+            // Possible tail calls are left to the interpreter.
+            if (ret->tail_call()) {
+                emit(Opcode::Stmt, 0, 0, stmt);
+                emit(Opcode::Return, VM_RETURN_RESULT, m_exit);
+            }
+            else {
+                if (ret->m_expr.has_value())
+                    compile_expr(ret->m_expr.value().get(), false, false);
+                emit(Opcode::Return, ret->m_expr.has_value(), m_exit);
+            }
+        } break;
+        case StmtType::Break: {
+            compile_signal(false);
+        } break;
+        case StmtType::Continue: {
+            compile_signal(true);
+        } break;
+        case StmtType::While: {
+            auto while_ = dynamic_cast<StmtWhile *>(stmt);
+            uint32_t cont = label(), brk = label();
+            bind(cont);
+            compile_expr(while_->m_expr.get(), false, true);
+            emit(Opcode::JumpFalse, brk);
+            push_loop(brk, cont);
+            compile_block(while_->m_block.get());
+            m_loops.pop_back();
+            emit(Opcode::Jump, cont);
+            bind(brk);
+        } break;
+        case StmtType::Loop: {
+            auto loop = dynamic_cast<StmtLoop *>(stmt);
+            uint32_t cont = label(), brk = label();
+            bind(cont);
+            push_loop(brk, cont);
+            compile_block(loop->m_block.get());
+            m_loops.pop_back();
+            emit(Opcode::Jump, cont);
+            bind(brk);
+        } break;
+        case StmtType::For: {
+            auto for_ = dynamic_cast<StmtFor *>(stmt);
+            uint32_t test = label(), cont = label(), brk = label();
+            compile_expr(for_->m_start.get(), false, false);
+            compile_expr(for_->m_end.get(), false, true);
+            emit(Opcode::ForInit, 0, 0, stmt);
+            ++m_for_depth;
+            bind(test);
+            emit(Opcode::ForTest, brk);
+            push_loop(brk, cont);
+            compile_block(for_->m_block.get());
+            m_loops.pop_back();
+            bind(cont);
+            emit(Opcode::ForStep);
+            emit(Opcode::Jump, test);
+            bind(brk);
+            emit(Opcode::ForEnd);
+            --m_for_depth;
+        } break;
+        default: {
+            compile_fallback(stmt);
+        } break;
+        }
+    }
+};
+
+std::shared_ptr<Chunk>
+VM::compile(std::vector<Stmt *> &stmts, std::shared_ptr<Ctx> &ctx, bool toplevel) {
+    Compiler compiler(ctx);
+
+    if (toplevel) {
+        // Results of top-level statements are discarded, so
+        // every statement gets its own exit.
+        for (Stmt *stmt : stmts) {
+            compiler.m_exit = compiler.label();
+            compiler.compile_stmt(stmt);
+            compiler.bind(compiler.m_exit);
+        }
+    }
+    else {
+        compiler.m_exit = compiler.label();
+        compiler.emit(Opcode::PushScope);
+        ++compiler.m_scope_depth;
+        for (Stmt *stmt : stmts)
+            compiler.compile_stmt(stmt);
+        compiler.emit(Opcode::PopScope);
+        --compiler.m_scope_depth;
+        compiler.bind(compiler.m_exit);
+    }
+    compiler.emit(Opcode::Exit);
+    compiler.resolve();
+
+    return compiler.m_chunk;
+}
+
+Value
+Value::unboxed(earl::value::Obj *obj) {
+    switch (obj->type()) {
+    case earl::value::Type::Int:   return Value(static_cast<earl::value::Int *>(obj)->value());
+    case earl::value::Type::Float: return Value(static_cast<earl::value::Float *>(obj)->value());
+    case earl::value::Type::Bool:  return Value(static_cast<earl::value::Bool *>(obj)->value());
+    case earl::value::Type::Char:  return Value(static_cast<earl::value::Char *>(obj)->value());
+    default: break;
+    }
+    return Value();
+}
+
+std::shared_ptr<earl::value::Obj>
+Value::box(void) const {
+    switch (tag) {
+    case Tag::Int:   return std::make_shared<earl::value::Int>(i);
+    case Tag::Float: return std::make_shared<earl::value::Float>(f);
+    case Tag::Bool:  return std::make_shared<earl::value::Bool>(b);
+    case Tag::Char:  return std::make_shared<earl::value::Char>(c);
+    default: break;
+    }
+    return obj;
+}
+
+bool
+Value::boolean(void) const {
+    switch (tag) {
+    case Tag::Int:   return i;
+    case Tag::Float: return f;
+    case Tag::Bool:  return b;
+    case Tag::Char:  return box()->boolean(); // reports the error
+    default: break;
+    }
+    return obj->boolean();
+}
+
+// Look through a boxed scalar without copying it. Gives
+// back a Tag::Obj value (with no object) if `value` is not
+// a scalar.
+static inline Value
+scalar(const Value &value) {
+    if (value.tag != Value::Tag::Obj)
+        return value;
+    return value.obj ? Value::unboxed(value.obj.get()) : Value();
+}
+
+// Binary operators on inline scalars. These mirror the Int, Float
+// and Bool primitives exactly (Int <op> Float is a Float, `%`, `**`
+// and the bitwise operators are Int only etc.). Returns false when
+// the boxed operator is needed, which also takes care of errors.
+static bool
+fast_binop(TokenType ty, const Value &l, const Value &r, Value &out) {
+    using Tag = Value::Tag;
+
+    if (l.tag == Tag::Int && r.tag == Tag::Int) {
+        switch (ty) {
+        case TokenType::Plus:               out = Value(l.i + r.i); return true;
+        case TokenType::Minus:              out = Value(l.i - r.i); return true;
+        case TokenType::Asterisk:           out = Value(l.i * r.i); return true;
+        case TokenType::Forwardslash:       out = Value(l.i / r.i); return true;
+        case TokenType::Percent:            out = Value(l.i % r.i); return true;
+        case TokenType::Double_Asterisk: {
+            out = Value(static_cast<int>(std::pow(static_cast<float>(l.i), static_cast<float>(r.i))));
+            return true;
+        }
+        case TokenType::Lessthan:           out = Value(l.i < r.i); return true;
+        case TokenType::Greaterthan:        out = Value(l.i > r.i); return true;
+        case TokenType::Lessthan_Equals:    out = Value(l.i <= r.i); return true;
+        case TokenType::Greaterthan_Equals: out = Value(l.i >= r.i); return true;
+        case TokenType::Double_Equals:      out = Value(l.i == r.i); return true;
+        case TokenType::Bang_Equals:        out = Value(l.i != r.i); return true;
+        case TokenType::Backtick_Pipe:      out = Value(l.i | r.i); return true;
+        case TokenType::Backtick_Caret:     out = Value(l.i ^ r.i); return true;
+        case TokenType::Backtick_Ampersand: out = Value(l.i & r.i); return true;
+        case TokenType::Double_Lessthan:    out = Value(l.i << r.i); return true;
+        case TokenType::Double_Greaterthan: out = Value(l.i >> r.i); return true;
+        default: return false;
+        }
+    }
+
+    if ((l.tag == Tag::Int || l.tag == Tag::Float) && (r.tag == Tag::Int || r.tag == Tag::Float)) {
+        double x = l.tag == Tag::Int ? l.i : l.f;
+        double y = r.tag == Tag::Int ? r.i : r.f;
+        switch (ty) {
+        case TokenType::Plus:               out = Value(x + y); return true;
+        case TokenType::Minus:              out = Value(x - y); return true;
+        case TokenType::Asterisk:           out = Value(x * y); return true;
+        case TokenType::Forwardslash:       out = Value(x / y); return true;
+        case TokenType::Lessthan:           out = Value(x < y); return true;
+        case TokenType::Greaterthan:        out = Value(x > y); return true;
+        case TokenType::Lessthan_Equals:    out = Value(x <= y); return true;
+        case TokenType::Greaterthan_Equals: out = Value(x >= y); return true;
+        case TokenType::Double_Equals:      out = Value(x == y); return true;
+        case TokenType::Bang_Equals:        out = Value(x != y); return true;
+        default: return false;
+        }
+    }
+
+    if (l.tag == Tag::Bool && r.tag == Tag::Bool) {
+        switch (ty) {
+        case TokenType::Double_Equals: out = Value(l.b == r.b); return true;
+        case TokenType::Bang_Equals:   out = Value(l.b != r.b); return true;
+        default: return false;
+        }
+    }
+
+    return false;
+}
+
+static bool
+fast_unary(TokenType ty, const Value &v, Value &out) {
+    switch (v.tag) {
+    case Value::Tag::Int: {
+        switch (ty) {
+        case TokenType::Minus:          out = Value(-v.i); return true;
+        case TokenType::Bang:           out = Value(!v.i); return true;
+        case TokenType::Backtick_Tilde: out = Value(~v.i); return true;
+        default: return false;
+        }
+    } break;
+    case Value::Tag::Float: {
+        if (ty != TokenType::Minus)
+            return false;
+        out = Value(-v.f);
+        return true;
+    } break;
+    case Value::Tag::Bool: {
+        if (ty != TokenType::Bang)
+            return false;
+        out = Value(!v.b);
+        return true;
+    } break;
+    default: break;
+    }
+    return false;
+}
+
+// Mutate an Int or Float in place from an inline scalar, following
+// Int::mutate/spec_mutate and Float::mutate. Returns false when the
+// boxed path is needed (constness, other types, errors).
+static bool
+fast_mutate(StmtMut *stmt, earl::value::Obj *l, const Value &r) {
+    Value rv = scalar(r);
+    if (!l || (rv.tag != Value::Tag::Int && rv.tag != Value::Tag::Float) || l->is_const())
+        return false;
+
+    TokenType ty = stmt->m_equals->type();
+
+    if (l->type() == earl::value::Type::Float) {
+        if (ty != TokenType::Equals)
+            return false;
+        static_cast<earl::value::Float *>(l)->fill(rv.tag == Value::Tag::Int ? static_cast<double>(rv.i) : rv.f);
+        stmt->m_evald = true;
+        return true;
+    }
+
+    if (l->type() != earl::value::Type::Int)
+        return false;
+
+    auto lhs = static_cast<earl::value::Int *>(l);
+    int x = lhs->value();
+    int y = rv.tag == Value::Tag::Int ? rv.i : static_cast<int>(rv.f);
+
+    switch (ty) {
+    case TokenType::Equals:                    x = y; break;
+    case TokenType::Plus_Equals:               x += y; break;
+    case TokenType::Minus_Equals:              x -= y; break;
+    case TokenType::Asterisk_Equals:           x *= y; break;
+    case TokenType::Forwardslash_Equals:       x /= y; break;
+    case TokenType::Percent_Equals:            x %= y; break;
+    case TokenType::Backtick_Pipe_Equals:      x |= y; break;
+    case TokenType::Backtick_Ampersand_Equals: x &= y; break;
+    case TokenType::Backtick_Caret_Equals:     x ^= y; break;
+    default: return false;
+    }
+
+    lhs->fill(x);
+    stmt->m_evald = true;
+    return true;
+}
+
+struct ForState {
+    std::shared_ptr<earl::variable::Obj> var;
+    std::shared_ptr<earl::value::Obj> end_value;
+    earl::value::Int *start;
+    earl::value::Int *end;
+    bool lt;
+    bool gt;
+    uint32_t scope_depth;
+};
+
+static std::shared_ptr<earl::value::Obj>
+binop(Token *op, std::shared_ptr<earl::value::Obj> &lhs, std::shared_ptr<earl::value::Obj> &rhs) {
+    switch (op->type()) {
+    case TokenType::Plus:            return lhs->add(op, rhs.get());
+    case TokenType::Minus:           return lhs->sub(op, rhs.get());
+    case TokenType::Asterisk:        return lhs->multiply(op, rhs.get());
+    case TokenType::Forwardslash:    return lhs->divide(op, rhs.get());
+    case TokenType::Percent:         return lhs->modulo(op, rhs.get());
+    case TokenType::Double_Asterisk: return lhs->power(op, rhs.get());
+    case TokenType::Greaterthan:
+    case TokenType::Lessthan:
+    case TokenType::Greaterthan_Equals:
+    case TokenType::Lessthan_Equals: return lhs->gtequality(op, rhs.get());
+    case TokenType::Double_Equals:
+    case TokenType::Bang_Equals:     return lhs->equality(op, rhs.get());
+    case TokenType::Backtick_Pipe:
+    case TokenType::Backtick_Caret:
+    case TokenType::Backtick_Ampersand: return lhs->bitwise(op, rhs.get());
+    case TokenType::Double_Lessthan:
+    case TokenType::Double_Greaterthan: return lhs->bitshift(op, rhs.get());
+    default: {
+        Err::err_wtok(op);
+        const std::string msg = "invalid operator";
+        throw InterpreterException(msg);
+    } break;
+    }
+    return nullptr; // unreachable
+}
+
+static void
+let_check(StmtLet *stmt, std::shared_ptr<Ctx> &ctx) {
+    const std::string &id = stmt->m_ids.at(0)->lexeme();
+    if (ctx->type() == CtxType::Closure)
+        // Special case for when we declare a variable in a recursive closure.
+        dynamic_cast<ClosureCtx *>(ctx.get())->assert_variable_does_not_exist_for_recursive_cl(id);
+    else if (ctx->variable_exists(id)) {
+        std::string msg = "variable `"+id+"` is already declared";
+        auto conflict = ctx->variable_get(id);
+        Err::err_wconflict(stmt->m_ids.at(0).get(), conflict->gettok());
+        throw InterpreterException(msg);
+    }
+}
+
+static void
+let_bind(StmtLet *stmt, std::shared_ptr<earl::value::Obj> value, std::shared_ptr<Ctx> &ctx) {
+    if (stmt->m_ids.at(0)->lexeme() == "_")
+        return;
+
+    bool _const = (stmt->m_attrs & static_cast<uint32_t>(Attr::Const)) != 0;
+    if (_const || value->type() == earl::value::Type::Tuple)
+        value->set_const();
+
+    if (stmt->m_tys.size() > 0)
+        Interpreter::typecheck(stmt->m_tys[0].get(), value.get(), ctx);
+
+    auto var = std::make_shared<earl::variable::Obj>(stmt->m_ids.at(0).get(), value, stmt->m_attrs);
+    ctx->variable_add(var);
+    if (stmt->m_slots.size() != 0)
+        ctx->m_frame.set(stmt->m_slots.at(0), var);
+    stmt->m_evald = true;
+}
+
+static void
+mutate(StmtMut *stmt, std::shared_ptr<earl::value::Obj> &l, std::shared_ptr<earl::value::Obj> &r) {
+    switch (stmt->m_equals->type()) {
+    case TokenType::Equals: {
+        l->mutate(r.get(), stmt);
+    } break;
+    case TokenType::Plus_Equals:
+    case TokenType::Minus_Equals:
+    case TokenType::Asterisk_Equals:
+    case TokenType::Forwardslash_Equals:
+    case TokenType::Percent_Equals:
+    case TokenType::Backtick_Pipe_Equals:
+    case TokenType::Backtick_Ampersand_Equals:
+    case TokenType::Backtick_Caret_Equals: {
+        l->spec_mutate(stmt->m_equals.get(), r.get(), stmt);
+    } break;
+    default: {
+        Err::err_wtok(stmt->m_equals.get());
+        std::string msg = "invalid mutation operation `"+stmt->m_equals->lexeme()+"`";
+        throw InterpreterException(msg);
+    } break;
+    }
+    stmt->m_evald = true;
+}
+
+static ForState
+for_init(StmtFor *stmt,
+         std::shared_ptr<earl::value::Obj> start_expr,
+         std::shared_ptr<earl::value::Obj> end_expr,
+         uint32_t scope_depth,
+         std::shared_ptr<Ctx> &ctx) {
+    auto enumerator = std::make_shared<earl::variable::Obj>(stmt->m_enumerator.get(), start_expr);
+
+    if (ctx->variable_exists(enumerator->id())) {
+        std::string msg = "variable `"+stmt->m_enumerator->lexeme()+"` is already declared";
+        auto conflict = ctx->variable_get(enumerator->id());
+        Err::err_wconflict(stmt->m_enumerator.get(), conflict->gettok());
+        throw InterpreterException(msg);
+    }
+    ctx->variable_add(enumerator);
+    ctx->m_frame.set(stmt->m_slot, enumerator);
+
+    auto start = dynamic_cast<earl::value::Int *>(start_expr.get());
+    auto end = dynamic_cast<earl::value::Int *>(end_expr.get());
+
+    return ForState{
+        enumerator,
+        end_expr,
+        start,
+        end,
+        start->value() <= end->value(),
+        start->value() > end->value(),
+        scope_depth,
+    };
+}
+
+std::shared_ptr<earl::value::Obj>
+VM::run(Chunk &chunk, std::shared_ptr<Ctx> &ctx) {
+    std::vector<Value> stack;
+    std::vector<ForState> fors;
+    std::shared_ptr<earl::value::Obj> result = nullptr;
+    uint32_t scope_depth = 0;
+
+    const Instr *code = chunk.code.data();
+    const Instr *ip = code;
+
+    stack.reserve(8);
+
+    // Pop scopes and `for` enumerators (innermost first)
+    // until we are back at the given depths.
+    auto unwind = [&](uint32_t to_scope_depth, uint32_t to_for_depth) {
+        while (scope_depth > to_scope_depth || fors.size() > to_for_depth) {
+            if (fors.size() > to_for_depth
+                && (fors.back().scope_depth == scope_depth || scope_depth <= to_scope_depth)) {
+                ctx->variable_remove(fors.back().var->id());
+                fors.pop_back();
+            }
+            else {
+                ctx->pop_scope();
+                --scope_depth;
+            }
+        }
+    };
+
+    auto pop = [&](void) {
+        auto value = std::move(stack.back());
+        stack.pop_back();
+        return value;
+    };
+
+    // Taking a variable by value only copies it if it is not a scalar.
+    auto load = [&](std::shared_ptr<earl::value::Obj> value, bool ref) {
+        if (ref)
+            return Value(std::move(value));
+        Value v = Value::unboxed(value.get());
+        return v.tag == Value::Tag::Obj ? Value(value->copy()) : v;
+    };
+
+#ifdef VM_COMPUTED_GOTO
+    static void *dispatch[] = {
+        &&L_Const, &&L_Load, &&L_Expr, &&L_LValue, &&L_Binop, &&L_Unary,
+        &&L_And, &&L_Or, &&L_Jump, &&L_JumpFalse, &&L_PushScope, &&L_PopScope,
+        &&L_LetCheck, &&L_Let, &&L_Mut, &&L_ExprStmt, &&L_Stmt, &&L_Propagate,
+        &&L_Return, &&L_Unwind, &&L_Signal, &&L_ForInit, &&L_ForTest, &&L_ForStep,
+        &&L_ForEnd, &&L_Exit,
+    };
+    static_assert(sizeof(dispatch)/sizeof(*dispatch) == static_cast<size_t>(Opcode::Count),
+                  "VM dispatch table is out of sync with VM::Opcode");
+#define VM_CASE(op) L_##op:
+#define VM_DISPATCH() goto *dispatch[static_cast<uint8_t>(ip->op)]
+#define VM_NEXT() do { ++ip; VM_DISPATCH(); } while (0)
+#define VM_JUMP(to) do { ip = code+(to); VM_DISPATCH(); } while (0)
+    VM_DISPATCH();
+#else
+#define VM_CASE(op) case Opcode::op:
+#define VM_NEXT() do { ++ip; goto next; } while (0)
+#define VM_JUMP(to) do { ip = code+(to); goto next; } while (0)
+ next:
+    switch (ip->op) {
+#endif
+
+    VM_CASE(Const) {
+        const Value &k = chunk.consts[ip->a];
+        stack.push_back(k.tag == Value::Tag::Obj ? Value(k.obj->copy()) : k);
+        VM_NEXT();
+    }
+    VM_CASE(Load) {
+        auto expr = static_cast<ExprIdent *>(ip->p);
+        const std::string &id = expr->m_tok->lexeme();
+        if (earl::variable::Obj *local = ctx->m_frame.get(expr->m_slot))
+            stack.push_back(load(local->value(), ip->b));
+        else if (ctx->variable_exists(id))
+            stack.push_back(load(ctx->variable_get(id)->value(), ip->b));
+        else {
+            // Enums, types as values, builtin identifiers and errors.
+            Interpreter::ER er = Interpreter::eval_expr(expr, ctx, ip->b);
+            stack.push_back(Interpreter::unpack(er, ctx, ip->b));
+        }
+        VM_NEXT();
+    }
+    VM_CASE(Expr) {
+        bool unpack_ref = (ip->b & VM_EXPR_UNPACK_REF) != 0;
+        Interpreter::ER er = Interpreter::eval_expr(static_cast<Expr *>(ip->p), ctx, ip->a);
+        auto value = Interpreter::unpack(er, ctx, unpack_ref);
+        if ((ip->b & VM_EXPR_LET) != 0 && !unpack_ref && !er.is_class_instant() && er.is_list_access())
+            value = value->copy();
+        stack.push_back(value);
+        VM_NEXT();
+    }
+    VM_CASE(LValue) {
+        auto stmt = static_cast<StmtMut *>(ip->p);
+        Interpreter::ER er = Interpreter::eval_expr(stmt->m_left.get(), ctx, true);
+        if (er.is_tuple_access()) {
+            Err::err_wexpr(stmt->m_left.get());
+            Err::err_wexpr(stmt->m_right.get());
+            std::string msg = "cannot mutate tuple type as they are immutable";
+            throw InterpreterException(msg);
+        }
+        stack.push_back(Interpreter::unpack(er, ctx, true));
+        VM_NEXT();
+    }
+    VM_CASE(Binop) {
+        auto op = static_cast<Token *>(ip->p);
+        Value rhs = pop();
+        Value &lhs = stack.back();
+        if (!fast_binop(op->type(), scalar(lhs), scalar(rhs), lhs)) {
+            auto l = lhs.box(), r = rhs.box();
+            lhs = Value(binop(op, l, r));
+        }
+        VM_NEXT();
+    }
+    VM_CASE(Unary) {
+        auto op = static_cast<Token *>(ip->p);
+        Value &value = stack.back();
+        if (!fast_unary(op->type(), scalar(value), value))
+            value = Value(value.box()->unaryop(op));
+        VM_NEXT();
+    }
+    VM_CASE(And) {
+        Value &lhs = stack.back();
+        if (!lhs.boolean()) {
+            if (ip->b && lhs.tag == Value::Tag::Obj)
+                lhs = Value(lhs.obj->copy());
+            VM_JUMP(ip->a);
+        }
+        stack.pop_back();
+        VM_NEXT();
+    }
+    VM_CASE(Or) {
+        Value &lhs = stack.back();
+        if (lhs.boolean()) {
+            if (ip->b && lhs.tag == Value::Tag::Obj)
+                lhs = Value(lhs.obj->copy());
+            VM_JUMP(ip->a);
+        }
+        stack.pop_back();
+        VM_NEXT();
+    }
+    VM_CASE(Jump) {
+        VM_JUMP(ip->a);
+    }
+    VM_CASE(JumpFalse) {
+        if (!pop().boolean())
+            VM_JUMP(ip->a);
+        VM_NEXT();
+    }
+    VM_CASE(PushScope) {
+        ctx->push_scope();
+        ++scope_depth;
+        VM_NEXT();
+    }
+    VM_CASE(PopScope) {
+        ctx->pop_scope();
+        --scope_depth;
+        VM_NEXT();
+    }
+    VM_CASE(LetCheck) {
+        let_check(static_cast<StmtLet *>(ip->p), ctx);
+        VM_NEXT();
+    }
+    VM_CASE(Let) {
+        let_bind(static_cast<StmtLet *>(ip->p), pop().box(), ctx);
+        VM_NEXT();
+    }
+    VM_CASE(Mut) {
+        auto stmt = static_cast<StmtMut *>(ip->p);
+        Value r = pop();
+        Value l = pop();
+        if (!fast_mutate(stmt, l.obj.get(), r)) {
+            auto lo = l.box(), ro = r.box();
+            mutate(stmt, lo, ro);
+        }
+        VM_NEXT();
+    }
+    VM_CASE(ExprStmt) {
+        auto stmt = static_cast<StmtExpr *>(ip->p);
+        result = pop().box();
+        stmt->m_evald = true;
+        if (result && result->type() != earl::value::Type::Void && ctx->type() != CtxType::World) {
+            Err::err_wexpr(stmt->m_expr.get());
+            Err::warn("Inplace expression will be evaluated and returned. Either explicitly `return` or assign the unused value to a unit binding: `let _ = <expr>;`");
+        }
+        VM_NEXT();
+    }
+    VM_CASE(Stmt) {
+        result = Interpreter::eval_stmt(static_cast<Stmt *>(ip->p), ctx);
+        VM_NEXT();
+    }
+    VM_CASE(Propagate) {
+        if (!result || result->type() == earl::value::Type::Void)
+            VM_NEXT();
+        if (ip->a != VM_NO_LOOP) {
+            const LoopInfo &loop = chunk.loops[ip->a];
+            if (result->type() == earl::value::Type::Break) {
+                unwind(loop.scope_depth, loop.for_depth);
+                result = nullptr;
+                VM_JUMP(loop.brk);
+            }
+            if (result->type() == earl::value::Type::Continue) {
+                unwind(loop.scope_depth, loop.for_depth);
+                result = nullptr;
+                VM_JUMP(loop.cont);
+            }
+        }
+        unwind(0, 0);
+        VM_JUMP(ip->b);
+    }
+    VM_CASE(Return) {
+        if (ip->a != VM_RETURN_RESULT)
+            result = ip->a ? pop().box() : nullptr;
+        if (!result || result->type() == earl::value::Type::Void)
+            result = earl::value::Return::instance();
+        unwind(0, 0);
+        VM_JUMP(ip->b);
+    }
+    VM_CASE(Unwind) {
+        unwind(ip->a, ip->b);
+        VM_NEXT();
+    }
+    VM_CASE(Signal) {
+        if (ip->a)
+            result = earl::value::Continue::instance();
+        else
+            result = earl::value::Break::instance();
+        unwind(0, 0);
+        VM_JUMP(ip->b);
+    }
+    VM_CASE(ForInit) {
+        auto end = pop().box();
+        auto start = pop().box();
+        fors.push_back(for_init(static_cast<StmtFor *>(ip->p), start, end, scope_depth, ctx));
+        VM_NEXT();
+    }
+    VM_CASE(ForTest) {
+        const ForState &f = fors.back();
+        if ((f.lt && f.start->value() > f.end->value()-1)
+            || (f.gt && f.start->value() < f.end->value()))
+            VM_JUMP(ip->a);
+        VM_NEXT();
+    }
+    VM_CASE(ForStep) {
+        ForState &f = fors.back();
+        if (f.lt)
+            f.start->fill(f.start->value()+1);
+        else if (f.gt)
+            f.start->fill(f.start->value()-1);
+        VM_NEXT();
+    }
+    VM_CASE(ForEnd) {
+        ctx->variable_remove(fors.back().var->id());
+        fors.pop_back();
+        VM_NEXT();
+    }
+    VM_CASE(Exit) {
+        if (!result)
+            result = earl::value::Void::instance();
+        return result;
+    }
+
+#ifndef VM_COMPUTED_GOTO
+    default: break;
+    }
+#endif
+
+#undef VM_CASE
+#undef VM_DISPATCH
+#undef VM_NEXT
+#undef VM_JUMP
+
+    assert(false && "unreachable");
+    return nullptr;
+}
+
+std::shared_ptr<earl::value::Obj>
+VM::exec_block(StmtBlock *block, std::shared_ptr<Ctx> &ctx) {
+    if (!block->m_chunk) {
+        std::vector<Stmt *> stmts;
+        for (auto &stmt : block->m_stmts)
+            stmts.push_back(stmt.get());
+        block->m_chunk = VM::compile(stmts, ctx, /*toplevel=*/false);
+    }
+    auto result = VM::run(*block->m_chunk, ctx);
+    block->m_evald = true;
+    return result;
+}
+
+void
+VM::exec_toplevel(std::vector<Stmt *> &stmts, std::shared_ptr<Ctx> &ctx) {
+    auto chunk = VM::compile(stmts, ctx, /*toplevel=*/true);
+    (void)VM::run(*chunk, ctx);
+}
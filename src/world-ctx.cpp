@@ -32,15 +32,11 @@
 WorldCtx::WorldCtx(std::unique_ptr<Lexer> lexer, std::unique_ptr<Program> program)
     : m_lexer(std::move(lexer)), m_program(std::move(program)) {
     m_filepath = m_program->m_filepath;
+    m_frame.init(m_program.get(), m_program->m_frame_size);
 }
 
 WorldCtx::WorldCtx() : m_lexer(nullptr), m_program(nullptr) {}
 
-void
-WorldCtx::set_module_alias(const std::string &id) {
-    m_module_alias = id;
-}
-
 Program *
 WorldCtx::get_repl_program(size_t i) {
     if (i >= m_repl_programs.size())
@@ -87,8 +83,8 @@ WorldCtx::set_mod(std::string id) {
 }
 
 void
-WorldCtx::add_import(std::shared_ptr<Ctx> ctx) {
-    m_imports.push_back(std::move(ctx));
+WorldCtx::add_import(std::shared_ptr<Ctx> ctx, std::optional<std::string> alias, uint32_t depth) {
+    m_imports.push_back(Import{std::move(ctx), std::move(alias), depth});
 }
 
 const std::string &
@@ -99,28 +95,18 @@ WorldCtx::get_mod(void) const {
 bool
 WorldCtx::import_is_defined(const std::string &id) {
     for (auto &im : m_imports)
-        if (dynamic_cast<WorldCtx *>(im.get())->get_mod() == id)
+        if (dynamic_cast<WorldCtx *>(im.m_ctx.get())->get_mod() == id)
             return true;
     return false;
 }
 
-bool
-WorldCtx::has_module_alias(void) const {
-    return m_module_alias.has_value();
-}
-
-const std::string &
-WorldCtx::get_module_alias(void) const {
-    return m_module_alias.value();
-}
-
-std::shared_ptr<Ctx> *
+WorldCtx::Import *
 WorldCtx::get_import(const std::string &id) {
     for (auto &im : m_imports) {
-        auto wctx = dynamic_cast<WorldCtx *>(im.get());
+        auto wctx = dynamic_cast<WorldCtx *>(im.m_ctx.get());
         if (wctx->get_mod() == id)
             return &im;
-        if (wctx->has_module_alias() && wctx->get_module_alias() == id)
+        if (im.m_alias.has_value() && im.m_alias.value() == id)
             return &im;
     }
 
@@ -244,12 +230,6 @@ WorldCtx::get_world(void) {
     UNIMPLEMENTED("WorldCtx::get_world");
 }
 
-void
-WorldCtx::strip_funs_and_classes(void) {
-    m_funcs.clear();
-    m_defined_classes.clear();
-}
-
 std::vector<std::string>
 WorldCtx::get_available_function_names(void) {
     std::vector<std::shared_ptr<earl::function::Obj>> funcs = m_funcs.extract_tovec();